@@ -0,0 +1,578 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    cbor_data.c
+ * \brief   Implements CBOR _data layer_ encoders and decoders [see cbor_data.h]
+ */
+
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "cbor_data.h"
+#include "data_layer.h"
+#include "xi_macros.h"
+#include "xi_err.h"
+#include "xi_consts.h"
+
+static char XI_CBOR_LOCAL_BUFFER[ XI_CBOR_BUFFER_SIZE ];
+static size_t XI_CBOR_ENCODED_SIZE = 0;
+
+// major types, as they are in the top three bits of the first byte
+#define XI_CBOR_UINT    0
+#define XI_CBOR_NINT    1
+#define XI_CBOR_TEXT    3
+#define XI_CBOR_ARRAY   4
+#define XI_CBOR_SIMPLE  7
+
+// the argument follows the first byte in 1, 2, 4 or 8 bytes
+#define XI_CBOR_ARG_8   24
+#define XI_CBOR_ARG_16  25
+#define XI_CBOR_ARG_32  26
+#define XI_CBOR_ARG_64  27
+
+// like XI_CHECK_S, but the data is binary and doesn't need a terminating zero
+#define XI_CBOR_CHECK_S( s, o, e ) { XI_CHECK_CND( ( s ) < 0, ( e ) ) else { ( o ) += ( s ); } }
+
+//-----------------------------------------------------------------------
+// ENCODERS
+//-----------------------------------------------------------------------
+
+// writes the first byte and `arg_size` bytes of the argument, big-endian
+static int cbor_put_head_n( char* buffer, size_t size
+    , uint8_t major, uint8_t info, uint64_t arg, size_t arg_size )
+{
+    if( size < arg_size + 1 ) { return -1; }
+
+    buffer[ 0 ] = ( char ) ( ( major << 5 ) | info );
+
+    for( size_t i = arg_size; i > 0; --i, arg >>= 8 )
+    {
+        buffer[ i ] = ( char ) ( arg & 0xFF );
+    }
+
+    return arg_size + 1;
+}
+
+// the head in its shortest form
+static int cbor_put_head( char* buffer, size_t size, uint8_t major, uint64_t arg )
+{
+    if( arg < XI_CBOR_ARG_8 )   { return cbor_put_head_n( buffer, size, major, ( uint8_t ) arg, 0, 0 ); }
+    if( arg <= 0xFF )           { return cbor_put_head_n( buffer, size, major, XI_CBOR_ARG_8, arg, 1 ); }
+    if( arg <= 0xFFFF )         { return cbor_put_head_n( buffer, size, major, XI_CBOR_ARG_16, arg, 2 ); }
+    if( arg <= 0xFFFFFFFF )     { return cbor_put_head_n( buffer, size, major, XI_CBOR_ARG_32, arg, 4 ); }
+
+    return cbor_put_head_n( buffer, size, major, XI_CBOR_ARG_64, arg, 8 );
+}
+
+static int cbor_put_text( char* buffer, size_t size, const char* str )
+{
+    size_t str_size = strlen( str );
+    int s           = cbor_put_head( buffer, size, XI_CBOR_TEXT, str_size );
+
+    if( s < 0 || size - s < str_size ) { return -1; }
+
+    memcpy( buffer + s, str, str_size );
+
+    return s + str_size;
+}
+
+static int cbor_put_value( char* buffer, size_t size, const xi_datapoint_t* p )
+{
+    switch( p->value_type )
+    {
+        case XI_VALUE_TYPE_I32:
+            if( p->value.i32_value >= 0 )
+            {
+                return cbor_put_head( buffer, size, XI_CBOR_UINT, ( uint32_t ) p->value.i32_value );
+            }
+            // -1 - n, which can't overflow the way -n can
+            return cbor_put_head( buffer, size, XI_CBOR_NINT, ~( uint32_t ) p->value.i32_value );
+        case XI_VALUE_TYPE_F32:
+        {
+            uint32_t bits;
+            memcpy( &bits, &p->value.f32_value, sizeof( bits ) );
+            return cbor_put_head_n( buffer, size, XI_CBOR_SIMPLE, XI_CBOR_ARG_32, bits, 4 );
+        }
+        case XI_VALUE_TYPE_STR:
+            return cbor_put_text( buffer, size, p->value.str_value );
+        default:
+            return -1;
+    }
+}
+
+// the seconds take 32 bits whenever they fit, so a datapoint is always as long
+static int cbor_put_seconds( char* buffer, size_t size, time_t timestamp )
+{
+    int64_t seconds = ( int64_t ) timestamp;
+    uint8_t major   = seconds < 0 ? XI_CBOR_NINT : XI_CBOR_UINT;
+    uint64_t arg    = seconds < 0 ? ( uint64_t ) ( -1 - seconds ) : ( uint64_t ) seconds;
+
+    if( arg <= 0xFFFFFFFF )
+    {
+        return cbor_put_head_n( buffer, size, major, XI_CBOR_ARG_32, arg, 4 );
+    }
+
+    return cbor_put_head_n( buffer, size, major, XI_CBOR_ARG_64, arg, 8 );
+}
+
+int cbor_encode_datapoint_in_place(
+      char* buffer, size_t buffer_size
+    , const xi_datapoint_t* p )
+{
+    // PRECONDITIONS
+    assert( buffer != 0 );
+    assert( p != 0 );
+
+    int has_timestamp   = p->timestamp.timestamp != 0;
+    size_t offset       = 0;
+    int s               = 0;
+
+    s = cbor_put_head( buffer, buffer_size, XI_CBOR_ARRAY, has_timestamp ? 3 : 1 );
+    XI_CBOR_CHECK_S( s, offset, XI_CBOR_ENCODE_DATAPOINT_BUFFER_OVERRUN );
+
+    s = cbor_put_value( buffer + offset, buffer_size - offset, p );
+    XI_CBOR_CHECK_S( s, offset, XI_CBOR_ENCODE_DATAPOINT_BUFFER_OVERRUN );
+
+    if( has_timestamp )
+    {
+        s = cbor_put_seconds( buffer + offset, buffer_size - offset, p->timestamp.timestamp );
+        XI_CBOR_CHECK_S( s, offset, XI_CBOR_ENCODE_DATAPOINT_BUFFER_OVERRUN );
+
+        s = cbor_put_head_n( buffer + offset, buffer_size - offset
+            , XI_CBOR_UINT, XI_CBOR_ARG_32, ( uint32_t ) p->timestamp.micro, 4 );
+        XI_CBOR_CHECK_S( s, offset, XI_CBOR_ENCODE_DATAPOINT_BUFFER_OVERRUN );
+    }
+
+    return offset;
+
+err_handling:
+    return -1;
+}
+
+const char* cbor_encode_datapoint( const xi_datapoint_t* data )
+{
+    // PRECONDITIONS
+    assert( data != 0 );
+
+    int s = cbor_encode_datapoint_in_place( XI_CBOR_LOCAL_BUFFER, sizeof( XI_CBOR_LOCAL_BUFFER ), data );
+
+    if( s < 0 ) { return 0; }
+
+    XI_CBOR_ENCODED_SIZE = s;
+
+    return XI_CBOR_LOCAL_BUFFER;
+}
+
+// the datastream with its datapoints, the error is set by the caller
+static int cbor_put_datastream( char* buffer, size_t size
+    , const char* datastream_id, const xi_datapoint_t* datapoints, size_t datapoint_count )
+{
+    size_t offset   = 0;
+    int s           = 0;
+
+    s = cbor_put_head( buffer, size, XI_CBOR_ARRAY, datapoint_count + 1 );
+    if( s < 0 ) { return -1; }
+    offset += s;
+
+    s = cbor_put_text( buffer + offset, size - offset, datastream_id );
+    if( s < 0 ) { return -1; }
+    offset += s;
+
+    for( size_t i = 0; i < datapoint_count; ++i )
+    {
+        s = cbor_encode_datapoint_in_place( buffer + offset, size - offset, &datapoints[ i ] );
+        if( s < 0 ) { return -1; }
+        offset += s;
+    }
+
+    return offset;
+}
+
+const char* cbor_encode_create_datastream(
+          const char* datastream_id
+        , const xi_datapoint_t* data )
+{
+    // PRECONDITIONS
+    assert( datastream_id != 0 );
+    assert( data != 0 );
+
+    size_t size     = sizeof( XI_CBOR_LOCAL_BUFFER );
+    size_t offset   = 0;
+    int s           = 0;
+
+    s = cbor_put_head( XI_CBOR_LOCAL_BUFFER, size, XI_CBOR_ARRAY, 1 );
+    XI_CBOR_CHECK_S( s, offset, XI_CBOR_ENCODE_DATASTREAM_BUFFER_OVERRUN );
+
+    s = cbor_put_datastream( XI_CBOR_LOCAL_BUFFER + offset, size - offset, datastream_id, data, 1 );
+    XI_CBOR_CHECK_S( s, offset, XI_CBOR_ENCODE_DATASTREAM_BUFFER_OVERRUN );
+
+    XI_CBOR_ENCODED_SIZE = offset;
+
+    return XI_CBOR_LOCAL_BUFFER;
+
+err_handling:
+    return 0;
+}
+
+int cbor_encode_feed( char* buffer, size_t buffer_size, const xi_feed_t* feed )
+{
+    // PRECONDITIONS
+    assert( buffer != 0 );
+    assert( feed != 0 );
+    assert( feed->datastream_count <= XI_MAX_DATASTREAMS );
+
+    size_t offset   = 0;
+    int s           = 0;
+
+    s = cbor_put_head( buffer, buffer_size, XI_CBOR_ARRAY, feed->datastream_count );
+    XI_CBOR_CHECK_S( s, offset, XI_CBOR_ENCODE_FEED_BUFFER_OVERRUN );
+
+    for( size_t i = 0; i < feed->datastream_count; ++i )
+    {
+        const xi_datastream_t* d = &feed->datastreams[ i ];
+
+        s = cbor_put_datastream( buffer + offset, buffer_size - offset
+            , d->datastream_id, d->datapoints, d->datapoint_count );
+        XI_CBOR_CHECK_S( s, offset, XI_CBOR_ENCODE_FEED_BUFFER_OVERRUN );
+    }
+
+    return offset;
+
+err_handling:
+    return -1;
+}
+
+size_t cbor_get_encoded_size( void )
+{
+    return XI_CBOR_ENCODED_SIZE;
+}
+
+//-----------------------------------------------------------------------
+// DECODERS
+//-----------------------------------------------------------------------
+
+typedef struct
+{
+    const uint8_t*  data;
+    size_t          size;
+    size_t          offset;
+} cbor_reader_t;
+
+// reads the first byte and the argument that follows it
+static int cbor_read_head( cbor_reader_t* r, uint8_t* major, uint8_t* info, uint64_t* arg )
+{
+    if( r->offset >= r->size ) { return -1; }
+
+    uint8_t b = r->data[ r->offset++ ];
+
+    *major  = b >> 5;
+    *info   = b & 0x1F;
+    *arg    = *info;
+
+    if( *info < XI_CBOR_ARG_8 ) { return 0; }
+
+    // indefinite lengths and the reserved values
+    if( *info > XI_CBOR_ARG_64 ) { return -1; }
+
+    size_t arg_size = ( size_t ) 1 << ( *info - XI_CBOR_ARG_8 );
+
+    if( r->size - r->offset < arg_size ) { return -1; }
+
+    *arg = 0;
+
+    for( size_t i = 0; i < arg_size; ++i )
+    {
+        *arg = ( *arg << 8 ) | r->data[ r->offset++ ];
+    }
+
+    return 0;
+}
+
+static int cbor_read_text( cbor_reader_t* r, char* buffer, size_t buffer_size )
+{
+    uint8_t major   = 0;
+    uint8_t info    = 0;
+    uint64_t size   = 0;
+
+    if( cbor_read_head( r, &major, &info, &size ) == -1
+        || major != XI_CBOR_TEXT
+        || size >= buffer_size
+        || size > r->size - r->offset )
+    {
+        return -1;
+    }
+
+    memcpy( buffer, r->data + r->offset, size );
+    buffer[ size ] = '\0';
+
+    r->offset += size;
+
+    return 0;
+}
+
+// widens the bits of a half precision float, every one of them fits in single precision
+static float cbor_half_to_float( uint16_t half )
+{
+    uint32_t sign       = ( uint32_t ) ( half & 0x8000 ) << 16;
+    uint32_t exponent   = ( half >> 10 ) & 0x1F;
+    uint32_t mantissa   = half & 0x3FF;
+    uint32_t bits       = 0;
+    float f             = 0;
+
+    if( exponent == 0 )
+    {
+        // subnormal, the value is exact as a float
+        f = ( float ) mantissa * ( 1.0f / 16777216.0f );
+        return sign ? -f : f;
+    }
+
+    exponent = exponent == 0x1F ? 0xFF : exponent - 15 + 127;
+    bits     = sign | ( exponent << 23 ) | ( mantissa << 13 );
+
+    memcpy( &f, &bits, sizeof( f ) );
+
+    return f;
+}
+
+static int cbor_read_value( cbor_reader_t* r, xi_datapoint_t* p )
+{
+    uint8_t major   = 0;
+    uint8_t info    = 0;
+    uint64_t arg    = 0;
+
+    size_t start    = r->offset;
+
+    if( cbor_read_head( r, &major, &info, &arg ) == -1 ) { return -1; }
+
+    switch( major )
+    {
+        case XI_CBOR_UINT:
+        case XI_CBOR_NINT:
+            if( arg > INT32_MAX ) { return -1; }
+            p->value.i32_value  = major == XI_CBOR_UINT ? ( int32_t ) arg : -1 - ( int32_t ) arg;
+            p->value_type       = XI_VALUE_TYPE_I32;
+            return 0;
+        case XI_CBOR_TEXT:
+            r->offset = start;
+            if( cbor_read_text( r, p->value.str_value, XI_VALUE_STRING_MAX_SIZE ) == -1 ) { return -1; }
+            p->value_type = XI_VALUE_TYPE_STR;
+            return 0;
+        case XI_CBOR_SIMPLE:
+            break;
+        default:
+            return -1;
+    }
+
+    switch( info )
+    {
+        case XI_CBOR_ARG_16:
+            p->value.f32_value = cbor_half_to_float( ( uint16_t ) arg );
+            break;
+        case XI_CBOR_ARG_32:
+        {
+            uint32_t bits = ( uint32_t ) arg;
+            memcpy( &p->value.f32_value, &bits, sizeof( bits ) );
+            break;
+        }
+        case XI_CBOR_ARG_64:
+        {
+            double d = 0;
+            memcpy( &d, &arg, sizeof( d ) );
+            p->value.f32_value = ( float ) d;
+            break;
+        }
+        default:
+            // false, true, null and the like aren't values of a datapoint
+            return -1;
+    }
+
+    p->value_type = XI_VALUE_TYPE_F32;
+
+    return 0;
+}
+
+static int cbor_read_datapoint( cbor_reader_t* r, xi_datapoint_t* p )
+{
+    uint8_t major   = 0;
+    uint8_t info    = 0;
+    uint64_t arg    = 0;
+
+    memset( p, 0, sizeof( xi_datapoint_t ) );
+
+    if( cbor_read_head( r, &major, &info, &arg ) == -1
+        || major != XI_CBOR_ARRAY
+        || ( arg != 1 && arg != 3 )
+        || cbor_read_value( r, p ) == -1 )
+    {
+        return -1;
+    }
+
+    if( arg == 1 ) { return 0; }
+
+    uint64_t seconds = 0;
+
+    if( cbor_read_head( r, &major, &info, &seconds ) == -1
+        || ( major != XI_CBOR_UINT && major != XI_CBOR_NINT ) )
+    {
+        return -1;
+    }
+
+    time_t timestamp = ( time_t ) seconds;
+
+    // it has to fit in time_t, whatever its size is
+    if( timestamp < 0 || ( uint64_t ) timestamp != seconds ) { return -1; }
+
+    p->timestamp.timestamp = major == XI_CBOR_UINT ? timestamp : -1 - timestamp;
+
+    if( cbor_read_head( r, &major, &info, &arg ) == -1
+        || major != XI_CBOR_UINT
+        || arg >= 1000000 )
+    {
+        return -1;
+    }
+
+    p->timestamp.micro = ( time_t ) arg;
+
+    return 0;
+}
+
+// returns 0 if the whole feed had been read, 1 if the visitor stopped or -1 if it's invalid
+static int cbor_read_feed( cbor_reader_t* r, const xi_feed_visitor_t* visitor, void* user_data )
+{
+    uint8_t major   = 0;
+    uint8_t info    = 0;
+    uint64_t count  = 0;
+
+    char datastream_id[ XI_MAX_DATASTREAM_NAME ];
+    xi_datapoint_t datapoint;
+
+    if( cbor_read_head( r, &major, &info, &count ) == -1 || major != XI_CBOR_ARRAY ) { return -1; }
+
+    for( uint64_t i = 0; i < count; ++i )
+    {
+        uint64_t size = 0;
+
+        if( cbor_read_head( r, &major, &info, &size ) == -1
+            || major != XI_CBOR_ARRAY
+            || size == 0
+            || cbor_read_text( r, datastream_id, sizeof( datastream_id ) ) == -1 )
+        {
+            return -1;
+        }
+
+        if( visitor->on_datastream && visitor->on_datastream( datastream_id, user_data ) ) { return 1; }
+
+        for( uint64_t j = 1; j < size; ++j )
+        {
+            if( cbor_read_datapoint( r, &datapoint ) == -1 ) { return -1; }
+
+            if( visitor->on_datapoint && visitor->on_datapoint( datastream_id, &datapoint, user_data ) ) { return 1; }
+        }
+    }
+
+    return 0;
+}
+
+xi_feed_t* cbor_decode_feed_n(
+      const char* data, size_t data_size
+    , xi_feed_t* feed )
+{
+    // PRECONDITIONS
+    assert( data != 0 );
+    assert( feed != 0 );
+
+    cbor_reader_t reader = { ( const uint8_t* ) data, data_size, 0 };
+
+    feed->datastream_count = 0;
+
+    // the visitor stops only when the feed is full
+    XI_CHECK_CND( cbor_read_feed( &reader, &data_layer_feed_filler, feed ) != 0
+        || reader.offset != data_size
+        , XI_CBOR_DECODE_FEED_PARSER_ERROR );
+
+    return feed;
+
+err_handling:
+    return 0;
+}
+
+xi_feed_t* cbor_decode_feed(
+      const char* buffer
+    , xi_feed_t* feed )
+{
+    // PRECONDITIONS
+    assert( buffer != 0 );
+    assert( feed != 0 );
+
+    cbor_reader_t reader = { ( const uint8_t* ) buffer, XI_CBOR_DECODE_MAX_SIZE, 0 };
+
+    feed->datastream_count = 0;
+
+    XI_CHECK_CND( cbor_read_feed( &reader, &data_layer_feed_filler, feed ) != 0
+        , XI_CBOR_DECODE_FEED_PARSER_ERROR );
+
+    return feed;
+
+err_handling:
+    return 0;
+}
+
+int cbor_visit_feed(
+      const char* buffer
+    , const xi_feed_visitor_t* visitor, void* user_data )
+{
+    // PRECONDITIONS
+    assert( buffer != 0 );
+    assert( visitor != 0 );
+
+    cbor_reader_t reader = { ( const uint8_t* ) buffer, XI_CBOR_DECODE_MAX_SIZE, 0 };
+
+    int s = cbor_read_feed( &reader, visitor, user_data );
+
+    XI_CHECK_CND( s == -1, XI_CBOR_DECODE_FEED_PARSER_ERROR );
+
+    return s;
+
+err_handling:
+    return -1;
+}
+
+xi_datapoint_t* cbor_decode_datapoint_n(
+      const char* data, size_t data_size
+    , xi_datapoint_t* datapoint )
+{
+    // PRECONDITIONS
+    assert( data != 0 );
+    assert( datapoint != 0 );
+
+    cbor_reader_t reader = { ( const uint8_t* ) data, data_size, 0 };
+
+    XI_CHECK_CND( cbor_read_datapoint( &reader, datapoint ) == -1 || reader.offset != data_size
+        , XI_CBOR_DECODE_DATAPOINT_PARSER_ERROR );
+
+    return datapoint;
+
+err_handling:
+    return 0;
+}
+
+xi_datapoint_t* cbor_decode_datapoint(
+      const char* buffer
+    , xi_datapoint_t* datapoint )
+{
+    // PRECONDITIONS
+    assert( buffer != 0 );
+    assert( datapoint != 0 );
+
+    cbor_reader_t reader = { ( const uint8_t* ) buffer, XI_CBOR_DECODE_MAX_SIZE, 0 };
+
+    XI_CHECK_CND( cbor_read_datapoint( &reader, datapoint ) == -1
+        , XI_CBOR_DECODE_DATAPOINT_PARSER_ERROR );
+
+    return datapoint;
+
+err_handling:
+    return 0;
+}
@@ -0,0 +1,90 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    cbor_data.h
+ * \brief   Implements CBOR _data layer_ encoders and decoders for links where both ends are ours
+ *
+ *    Xively itself doesn't speak CBOR (RFC 7049), it's meant for gateways talking
+ *    to a relay, so nothing is formatted as text on the device. The layout is:
+ *
+ *        datapoint  = [ value ] or [ value, seconds, micro ]
+ *        datastream = [ id, datapoint, ... ]
+ *        feed       = [ datastream, ... ]
+ *
+ *    Integers are written in their shortest form, floats as single precision and
+ *    strings as text. `seconds` and `micro` always take 5 bytes (a 32-bit head),
+ *    unless the seconds don't fit in 32 bits. Creating a datastream sends a feed
+ *    with that datastream only. The decoders take any integer width and half,
+ *    single or double precision floats, but not indefinite lengths or tags.
+ *
+ * \note    The encoded data has zeros in it, so the size has to be taken from
+ *          `cbor_get_encoded_size()` or from what the in-place encoders return.
+ */
+
+#ifndef __CBOR_DATA_H__
+#define __CBOR_DATA_H__
+
+#include "xively.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+const char* cbor_encode_datapoint( const xi_datapoint_t* dp );
+
+int cbor_encode_datapoint_in_place(
+      char* buffer, size_t buffer_size
+    , const xi_datapoint_t* datapoint );
+
+const char* cbor_encode_create_datastream(
+          const char* datastream_id
+        , const xi_datapoint_t* dp );
+
+/**
+ * \brief   Encodes every datapoint of every datastream of the feed
+ *
+ * \return  Size of the encoded feed or -1 if it didn't fit.
+ */
+int cbor_encode_feed( char* buffer, size_t buffer_size, const xi_feed_t* feed );
+
+/**
+ * \return  Size of what `cbor_encode_datapoint` or `cbor_encode_create_datastream`
+ *          encoded last.
+ */
+size_t cbor_get_encoded_size( void );
+
+/**
+ * \brief   These are the decoders of the _data layer_, which isn't given the size
+ *          of the data, the data must hold the whole item then
+ *
+ *    Nothing past `XI_CBOR_DECODE_MAX_SIZE` bytes is read though, so a truncated
+ *    or forged item in a buffer of that size (e.g. `http_content`) is an error.
+ */
+xi_feed_t* cbor_decode_feed(
+      const char* buffer
+    , xi_feed_t* feed );
+
+xi_datapoint_t* cbor_decode_datapoint( const char* data, xi_datapoint_t* dp );
+
+int cbor_visit_feed(
+      const char* buffer
+    , const xi_feed_visitor_t* visitor, void* user_data );
+
+/**
+ * \brief   Decode the item that takes all of the `data_size` bytes, nothing is
+ *          read past them
+ */
+xi_feed_t* cbor_decode_feed_n(
+      const char* data, size_t data_size
+    , xi_feed_t* feed );
+
+xi_datapoint_t* cbor_decode_datapoint_n(
+      const char* data, size_t data_size
+    , xi_datapoint_t* dp );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __CBOR_DATA_H__
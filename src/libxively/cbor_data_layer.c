@@ -0,0 +1,23 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    cbor_data_layer.c
+ * \brief   Implements CBOR _data layer_ abstration interface [see cbor_data_layer.h and data_layer.h]
+ */
+
+#include "cbor_data_layer.h"
+
+const data_layer_t* get_cbor_data_layer()
+{
+    static const data_layer_t __cbor_data_layer = {
+          cbor_encode_datapoint
+        , cbor_encode_datapoint_in_place
+        , cbor_encode_create_datastream
+        , cbor_decode_feed
+        , cbor_decode_datapoint
+        , cbor_visit_feed
+    };
+
+    return &__cbor_data_layer;
+}
@@ -0,0 +1,35 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    cbor_data_layer.h
+ * \brief   Implements CBOR _data layer_ abstration interface
+ */
+
+#ifndef __CBOR_DATA_LAYER_H__
+#define __CBOR_DATA_LAYER_H__
+
+#include "xively.h"
+#include "data_layer.h"
+#include "cbor_data.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief   Initialise CBOR implementation of the _data layer_
+ *
+ *    Nothing is allocated, but the encoded data isn't a string, so it can go
+ *    only where its size is taken from `cbor_get_encoded_size()`, not `strlen`.
+ *
+ * \return  Structure with function pointers for CBOR encoders and decoders
+ *          which had been implemented in `cbor_data.c`.
+ */
+const data_layer_t* get_cbor_data_layer( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __CBOR_DATA_LAYER_H__
@@ -63,6 +63,26 @@ typedef struct {
      *          number of connections is expected in a typical use-case.
      */
     void ( *close_connection )( connection_t* conn );
+
+    /**
+     * \brief   Milliseconds since an arbitrary point in time, used to pace requests
+     * \note    It may wrap around, only differences between two readings are used.
+     */
+    uint32_t ( *get_time_ms )( void );
+
+    /**
+     * \brief   Block for the given number of milliseconds
+     */
+    void ( *sleep_ms )( uint32_t ms );
+
+    /**
+     * \brief   Fill the buffer from the platform's entropy source, e.g. `/dev/urandom`
+     *          or a hardware TRNG, used for the WebSocket masking keys
+     * \note    May be left `0` where there is no such source.
+     *
+     * \return  `0` on success or `-1` when the whole buffer couldn't be filled.
+     */
+    int ( *get_random )( uint8_t* buffer, size_t size );
 } comm_layer_t;
 
 
@@ -12,6 +12,10 @@
 #include <stdint.h>
 #include <assert.h>
 
+#include "mbed.h"
+#if DEVICE_TRNG
+#include "hal/trng_api.h"
+#endif
 #include "mbed_comm.h"
 #include "comm_layer.h"
 #include "xi_helpers.h"
@@ -181,4 +185,55 @@ err_handling:
     return;
 }
 
+uint32_t mbed_get_time_ms( void )
+{
+    // the ticker wraps around in microseconds, so it's accumulated to wrap in milliseconds
+    static uint32_t last_us     = 0;
+    static uint32_t pending_us  = 0;
+    static uint32_t ms          = 0;
+
+    uint32_t now_us = us_ticker_read();
+
+    pending_us  += now_us - last_us;
+    last_us     = now_us;
+    ms          += pending_us / 1000;
+    pending_us  %= 1000;
+
+    return ms;
+}
+
+void mbed_sleep_ms( uint32_t ms )
+{
+    wait_ms( ms );
+}
+
+int mbed_get_random( uint8_t* buffer, size_t size )
+{
+#if DEVICE_TRNG
+    trng_t trng;
+    size_t got = 0;
+
+    trng_init( &trng );
+
+    while( got < size )
+    {
+        size_t n = 0;
+
+        if( trng_get_bytes( &trng, buffer + got, size - got, &n ) != 0 ) { break; }
+
+        got += n;
+    }
+
+    trng_free( &trng );
+
+    return got == size ? 0 : -1;
+#else
+    // targets without a TRNG have nothing better than the software generator
+    XI_UNUSED( buffer );
+    XI_UNUSED( size );
+
+    return -1;
+#endif
+}
+
 }
@@ -24,6 +24,12 @@ int mbed_read_data( connection_t* conn, char* buffer, size_t buffer_size );
 
 void mbed_close_connection( connection_t* conn );
 
+uint32_t mbed_get_time_ms( void );
+
+void mbed_sleep_ms( uint32_t ms );
+
+int mbed_get_random( uint8_t* buffer, size_t size );
+
 #ifdef __cplusplus
 }
 #endif
@@ -21,6 +21,9 @@ const comm_layer_t* get_comm_layer()
         , &mbed_send_data
         , &mbed_read_data
         , &mbed_close_connection
+        , &mbed_get_time_ms
+        , &mbed_sleep_ms
+        , &mbed_get_random
     };
 
     return &__mbed_comm_layer;
@@ -10,9 +10,12 @@
 #include <stdio.h>
 #include <netdb.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <sys/socket.h>
 #include <string.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
 #include <stdint.h>
 #include <assert.h>
 
@@ -86,6 +89,19 @@ connection_t* posix_open_connection( const char* address, int32_t port )
         }
     }
 
+    // every message is written with a single call, so there is nothing for Nagle's
+    // algorithm to coalesce, it would only hold back requests sent while others are in flight
+    {
+        int flag = 1;
+
+        if ( setsockopt( pos_comm_data->socket_fd, IPPROTO_TCP
+                , TCP_NODELAY, ( char * )&flag, sizeof( flag ) ) < 0 )
+        {
+            xi_set_err( XI_SOCKET_INITIALIZATION_ERROR );
+            goto err_handling;
+        }
+    }
+
 
     // remember the layer specific part
     conn->layer_specific = ( void* ) pos_comm_data;
@@ -214,3 +230,41 @@ err_handling:
 
     return;
 }
+
+uint32_t posix_get_time_ms( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+
+    return ( uint32_t ) ( ts.tv_sec * 1000 + ts.tv_nsec / 1000000 );
+}
+
+void posix_sleep_ms( uint32_t ms )
+{
+    struct timespec ts = { ms / 1000, ( ms % 1000 ) * 1000000L };
+
+    // carry on sleeping if a signal has woken us up
+    while( nanosleep( &ts, &ts ) == -1 ) { ; }
+}
+
+int posix_get_random( uint8_t* buffer, size_t size )
+{
+    size_t got = 0;
+    int fd     = open( "/dev/urandom", O_RDONLY );
+
+    if( fd == -1 ) { return -1; }
+
+    while( got < size )
+    {
+        ssize_t r = read( fd, buffer + got, size - got );
+
+        if( r <= 0 ) { break; }
+
+        got += ( size_t ) r;
+    }
+
+    close( fd );
+
+    return got == size ? 0 : -1;
+}
@@ -20,4 +20,10 @@ int posix_read_data( connection_t* conn, char* buffer, size_t buffer_size );
 
 void posix_close_connection( connection_t* conn );
 
+uint32_t posix_get_time_ms( void );
+
+void posix_sleep_ms( uint32_t ms );
+
+int posix_get_random( uint8_t* buffer, size_t size );
+
 #endif // __POSIX_COMM_H__
@@ -20,6 +20,9 @@ const comm_layer_t* get_comm_layer()
         , &posix_send_data
         , &posix_read_data
         , &posix_close_connection
+        , &posix_get_time_ms
+        , &posix_sleep_ms
+        , &posix_get_random
     };
 
     return &__posix_comm_layer;
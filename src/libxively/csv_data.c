@@ -9,9 +9,15 @@
 
 #include <assert.h>
 #include <stdio.h>
+#include <string.h>
 #include <time.h>
 
+#if defined( __SSE2__ )
+#include <emmintrin.h>
+#endif
+
 #include "csv_data.h"
+#include "data_layer.h"
 #include "xi_macros.h"
 #include "xi_helpers.h"
 #include "xi_err.h"
@@ -32,9 +38,9 @@ inline static int csv_encode_value(
     switch( p->value_type )
     {
         case XI_VALUE_TYPE_I32:
-            return snprintf( buffer, buffer_size, "%d", p->value.i32_value );
+            return xi_int_to_str( buffer, buffer_size, p->value.i32_value );
         case XI_VALUE_TYPE_F32:
-            return snprintf( buffer, buffer_size, "%f", p->value.f32_value );
+            return xi_float_to_str( buffer, buffer_size, p->value.f32_value );
         case XI_VALUE_TYPE_STR:
             return snprintf( buffer, buffer_size, "%s", p->value.str_value );
         default:
@@ -42,68 +48,53 @@ inline static int csv_encode_value(
     }
 }
 
+// bytes that are told apart by the value decoder, letters, blanks
+// and the rest make a value a string the same way
 typedef enum
 {
-    XI_CHAR_UNKNOWN = 0,
+    XI_CHAR_OTHER = 0,
     XI_CHAR_NUMBER,
-    XI_CHAR_LETTER,
     XI_CHAR_DOT,
-    XI_CHAR_SPACE,
+    XI_CHAR_MINUS,
     XI_CHAR_NEWLINE,
-    XI_CHAR_TAB,
-    XI_CHAR_MINUS
+    XI_CHAR_END,
+    XI_CHAR_COUNT
 } xi_char_type_t;
 
-inline static xi_char_type_t csv_classify_char( char c )
+#define O XI_CHAR_OTHER
+#define N XI_CHAR_NUMBER
+#define D XI_CHAR_DOT
+#define M XI_CHAR_MINUS
+#define L XI_CHAR_NEWLINE
+#define E XI_CHAR_END
+
+// classes of all the bytes, the value ends at `\0`, `\n` or `\r`
+static const uint8_t XI_CSV_CHAR_CLASS[ 256 ] =
 {
-    switch( c )
-    {
-        case 13:
-        case 11:
-            return XI_CHAR_NEWLINE;
-        case 9:
-            return XI_CHAR_TAB;
-        case 32:
-            return XI_CHAR_SPACE;
-        case 33: case 34: case 35: case 36: case 37: case 38: case 39:
-        case 40: case 41: case 42: case 43: case 44:
-            return XI_CHAR_UNKNOWN;
-        case 45:
-            return XI_CHAR_MINUS;
-        case 46:
-            return XI_CHAR_DOT;
-        case 47:
-            return XI_CHAR_UNKNOWN;
-        case 48: case 49: case 50: case 51: case 52: case 53: case 54:
-        case 55: case 56:
-        case 57:
-            return XI_CHAR_NUMBER;
-        case 58: case 59: case 60: case 61: case 62: case 63:
-        case 64:
-            return XI_CHAR_UNKNOWN;
-        case 65: case 66: case 67: case 68: case 69: case 70: case 71:
-        case 72: case 73: case 74: case 75: case 76: case 77: case 78:
-        case 79: case 80: case 81: case 82: case 83: case 84: case 85:
-        case 86: case 87: case 88: case 89:
-        case 90:
-            return XI_CHAR_LETTER;
-        case 91: case 92: case 93: case 94: case 95:
-        case 96:
-            return XI_CHAR_UNKNOWN;
-        case 97: case 98: case 99: case 100: case 101: case 102: case 103:
-        case 104: case 105: case 106: case 107: case 108: case 109: case 110:
-        case 111: case 112: case 113: case 114: case 115: case 116: case 117:
-        case 118: case 119: case 120: case 121:
-        case 122:
-            return XI_CHAR_LETTER;
-        case 123:
-        case 124:
-        case 125:
-            return XI_CHAR_UNKNOWN;
-        default:
-            return XI_CHAR_UNKNOWN;
-    }
-}
+    E, O, O, O, O, O, O, O, O, O, E, L, O, E, O, O, // 0x00
+    O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, // 0x10
+    O, O, O, O, O, O, O, O, O, O, O, O, O, M, D, O, // 0x20
+    N, N, N, N, N, N, N, N, N, N, O, O, O, O, O, O, // 0x30
+    O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, // 0x40
+    O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, // 0x50
+    O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, // 0x60
+    O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, // 0x70
+    O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, // 0x80
+    O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, // 0x90
+    O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, // 0xA0
+    O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, // 0xB0
+    O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, // 0xC0
+    O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, // 0xD0
+    O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, // 0xE0
+    O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O  // 0xF0
+};
+
+#undef O
+#undef N
+#undef D
+#undef M
+#undef L
+#undef E
 
 typedef enum
 {
@@ -115,6 +106,21 @@ typedef enum
     XI_STATE_STRING
 } xi_dfa_state_t;
 
+// states are kept as offsets of their rows, so a step is a single lookup
+#define XI_ROW( s ) ( ( s ) * XI_CHAR_COUNT )
+
+// the transition function, rows are states and columns classes of `XI_CSV_CHAR_CLASS`
+static const uint8_t XI_CSV_TRANSITIONS[] =
+{
+    //  other                           number                          dot                             minus                           newline                         end
+    XI_ROW( XI_STATE_STRING ),  XI_ROW( XI_STATE_NUMBER ),  XI_ROW( XI_STATE_DOT ),     XI_ROW( XI_STATE_MINUS ),   XI_ROW( XI_STATE_INITIAL ), 0, // initial
+    XI_ROW( XI_STATE_STRING ),  XI_ROW( XI_STATE_NUMBER ),  XI_ROW( XI_STATE_DOT ),     XI_ROW( XI_STATE_STRING ),  XI_ROW( XI_STATE_INITIAL ), 0, // minus
+    XI_ROW( XI_STATE_STRING ),  XI_ROW( XI_STATE_NUMBER ),  XI_ROW( XI_STATE_DOT ),     XI_ROW( XI_STATE_STRING ),  XI_ROW( XI_STATE_INITIAL ), 0, // number
+    XI_ROW( XI_STATE_STRING ),  XI_ROW( XI_STATE_FLOAT ),   XI_ROW( XI_STATE_STRING ),  XI_ROW( XI_STATE_STRING ),  XI_ROW( XI_STATE_INITIAL ), 0, // float
+    XI_ROW( XI_STATE_STRING ),  XI_ROW( XI_STATE_FLOAT ),   XI_ROW( XI_STATE_STRING ),  XI_ROW( XI_STATE_STRING ),  XI_ROW( XI_STATE_INITIAL ), 0, // dot
+    XI_ROW( XI_STATE_STRING ),  XI_ROW( XI_STATE_STRING ),  XI_ROW( XI_STATE_STRING ),  XI_ROW( XI_STATE_STRING ),  XI_ROW( XI_STATE_INITIAL ), 0  // string
+};
+
 xi_datapoint_t* csv_decode_value(
     const char* buffer, xi_datapoint_t* p )
 {
@@ -127,25 +133,10 @@ xi_datapoint_t* csv_decode_value(
 
     // clean the counter
     size_t  counter = 0;
+    uint8_t s       = XI_ROW( XI_STATE_INITIAL );
+    uint8_t ct      = XI_CSV_CHAR_CLASS[ ( uint8_t ) buffer[ 0 ] ];
 
-    // the transition function
-    static const short states[][6][2] =
-    {
-          // state initial                          // state minus                            // state number                           // state float                            // state dot                              // string
-        { { XI_CHAR_UNKNOWN   , XI_STATE_STRING  }, { XI_CHAR_UNKNOWN   , XI_STATE_STRING  }, { XI_CHAR_UNKNOWN   , XI_STATE_STRING  }, { XI_CHAR_UNKNOWN   , XI_STATE_STRING  }, { XI_CHAR_UNKNOWN   , XI_STATE_STRING  }, { XI_CHAR_UNKNOWN   , XI_STATE_STRING  } },
-        { { XI_CHAR_NUMBER    , XI_STATE_NUMBER  }, { XI_CHAR_NUMBER    , XI_STATE_NUMBER  }, { XI_CHAR_NUMBER    , XI_STATE_NUMBER  }, { XI_CHAR_NUMBER    , XI_STATE_FLOAT   }, { XI_CHAR_NUMBER    , XI_STATE_FLOAT   }, { XI_CHAR_NUMBER    , XI_STATE_STRING  } },
-        { { XI_CHAR_LETTER    , XI_STATE_STRING  }, { XI_CHAR_LETTER    , XI_STATE_STRING  }, { XI_CHAR_LETTER    , XI_STATE_STRING  }, { XI_CHAR_LETTER    , XI_STATE_STRING  }, { XI_CHAR_LETTER    , XI_STATE_STRING  }, { XI_CHAR_LETTER    , XI_STATE_STRING  } },
-        { { XI_CHAR_DOT       , XI_STATE_DOT     }, { XI_CHAR_DOT       , XI_STATE_DOT     }, { XI_CHAR_DOT       , XI_STATE_DOT     }, { XI_CHAR_DOT       , XI_STATE_STRING  }, { XI_CHAR_DOT       , XI_STATE_STRING  }, { XI_CHAR_DOT       , XI_STATE_STRING  } },
-        { { XI_CHAR_SPACE     , XI_STATE_STRING  }, { XI_CHAR_SPACE     , XI_STATE_STRING  }, { XI_CHAR_SPACE     , XI_STATE_STRING  }, { XI_CHAR_SPACE     , XI_STATE_STRING  }, { XI_CHAR_SPACE     , XI_STATE_STRING  }, { XI_CHAR_SPACE     , XI_STATE_STRING  } },
-        { { XI_CHAR_NEWLINE   , XI_STATE_INITIAL }, { XI_CHAR_NEWLINE   , XI_STATE_INITIAL }, { XI_CHAR_NEWLINE   , XI_STATE_INITIAL }, { XI_CHAR_NEWLINE   , XI_STATE_INITIAL }, { XI_CHAR_NEWLINE   , XI_STATE_INITIAL }, { XI_CHAR_NEWLINE   , XI_STATE_INITIAL } },
-        { { XI_CHAR_TAB       , XI_STATE_STRING  }, { XI_CHAR_TAB       , XI_STATE_STRING  }, { XI_CHAR_TAB       , XI_STATE_STRING  }, { XI_CHAR_TAB       , XI_STATE_STRING  }, { XI_CHAR_TAB       , XI_STATE_STRING  }, { XI_CHAR_TAB       , XI_STATE_STRING  } },
-        { { XI_CHAR_MINUS     , XI_STATE_MINUS   }, { XI_CHAR_MINUS     , XI_STATE_STRING  }, { XI_CHAR_MINUS     , XI_STATE_STRING  }, { XI_CHAR_MINUS     , XI_STATE_STRING  }, { XI_CHAR_MINUS     , XI_STATE_STRING  }, { XI_CHAR_MINUS     , XI_STATE_STRING  } }
-    };
-
-    char    c = *buffer;
-    short   s = XI_STATE_INITIAL;
-
-    while( c != '\n' && c !='\0' && c!='\r' )
+    while( ct != XI_CHAR_END )
     {
         if( counter >= XI_VALUE_STRING_MAX_SIZE - 1 )
         {
@@ -153,24 +144,15 @@ xi_datapoint_t* csv_decode_value(
             return 0;
         }
 
-        xi_char_type_t ct = csv_classify_char( c );
-        s = states[ ct ][ s ][ 1 ];
+        s = XI_CSV_TRANSITIONS[ s + ct ];
 
-        switch( s )
-        {
-            case XI_STATE_MINUS:
-            case XI_STATE_NUMBER:
-            case XI_STATE_FLOAT:
-            case XI_STATE_DOT:
-            case XI_STATE_STRING:
-                p->value.str_value[ counter ] = c;
-                break;
-        }
+        p->value.str_value[ counter ] = buffer[ counter ];
 
-        c = *( ++buffer );
-        ++counter;
+        ct = XI_CSV_CHAR_CLASS[ ( uint8_t ) buffer[ ++counter ] ];
     }
 
+    s /= XI_CHAR_COUNT;
+
     // set the guard
     p->value.str_value[ counter ] = '\0';
 
@@ -191,7 +173,7 @@ xi_datapoint_t* csv_decode_value(
             p->value_type       = XI_VALUE_TYPE_I32;
             break;
         case XI_STATE_FLOAT:
-            p->value.f32_value  = atof( p->value.str_value );
+            p->value.f32_value  = strtof( p->value.str_value, 0 );
             p->value_type       = XI_VALUE_TYPE_F32;
             break;
         case XI_STATE_STRING:
@@ -225,27 +207,20 @@ int csv_encode_datapoint_in_place(
 
     if( datapoint->timestamp.timestamp != 0 )
     {
-        time_t stamp = datapoint->timestamp.timestamp;
-        struct tm* gmtinfo = xi_gmtime( &stamp );
-
-        s = snprintf( in, size
-            , "%04d-%02d-%02dT%02d:%02d:%02d.%06dZ,"
-            , gmtinfo->tm_year + 1900
-            , gmtinfo->tm_mon + 1
-            , gmtinfo->tm_mday
-            , gmtinfo->tm_hour
-            , gmtinfo->tm_min
-            , gmtinfo->tm_sec
-            , ( int ) datapoint->timestamp.micro );
-
+        s = xi_timestamp_to_str( in, size
+            , datapoint->timestamp.timestamp, datapoint->timestamp.micro );
         XI_CHECK_S( s, size, offset, XI_CSV_ENCODE_DATAPOINT_BUFFER_OVERRUN );
+
+        XI_CHECK_SIZE( 1, size - offset, XI_CSV_ENCODE_DATAPOINT_BUFFER_OVERRUN );
+        in[ offset++ ] = ',';
     }
 
     s = csv_encode_value( in + offset, size - offset, datapoint );
     XI_CHECK_S( s, size, offset, XI_CSV_ENCODE_DATAPOINT_BUFFER_OVERRUN );
 
-    s = snprintf( in + offset, size - offset, "%s", "\n" );
-    XI_CHECK_S( s, size, offset, XI_CSV_ENCODE_DATAPOINT_BUFFER_OVERRUN );
+    XI_CHECK_SIZE( 1, size - offset, XI_CSV_ENCODE_DATAPOINT_BUFFER_OVERRUN );
+    in[ offset++ ] = '\n';
+    in[ offset ] = '\0';
 
     return offset;
 
@@ -277,109 +252,225 @@ err_handling:
     return 0;
 }
 
-xi_feed_t* csv_decode_feed(
-      const char* buffer
-    , xi_feed_t* feed )
+size_t csv_scan_delimiters(
+      const char* data, size_t data_size
+    , uint32_t* index, size_t index_size
+    , size_t* scanned )
 {
-    const char* current     = buffer;
-    int32_t counter         = 0;
+    // PRECONDITIONS
+    assert( data != 0 );
+    assert( index != 0 );
+    assert( scanned != 0 );
+
+    size_t count    = 0;
+    size_t i        = 0;
 
-    // find occurence of newline
-    char* end_of_line = ( char* ) 1;
+#if defined( __SSE2__ )
+    const __m128i comma     = _mm_set1_epi8( ',' );
+    const __m128i newline   = _mm_set1_epi8( '\n' );
 
-    // while we didn't jump out of the buffer
-    while( end_of_line )
+    // a block is only taken if all its bytes could be delimiters and still fit
+    for( ; i + 16 <= data_size && count + 16 <= index_size; i += 16 )
     {
-        // get current datapoint
-        xi_datastream_t* d    = &feed->datastreams[ counter ];
-        d->datapoint_count    = 0;
-        xi_datapoint_t* p     = &d->datapoints[ 0 ];
-        memset( p, 0, sizeof( xi_datapoint_t ) );
+        __m128i block = _mm_loadu_si128( ( const __m128i* ) ( data + i ) );
+        unsigned mask = ( unsigned ) _mm_movemask_epi8( _mm_or_si128(
+            _mm_cmpeq_epi8( block, comma ), _mm_cmpeq_epi8( block, newline ) ) );
 
-        end_of_line = strstr( current, "\n" );
+        while( mask )
+        {
+            index[ count++ ] = ( uint32_t ) ( i + __builtin_ctz( mask ) );
+            mask &= mask - 1;
+        }
+    }
+#endif
 
-        const char* end_of_datastream_id  = strstr( current, "," );
-        const char* beg_of_datapoint      = end_of_datastream_id + 1;
+    for( ; i < data_size && count < index_size; ++i )
+    {
+        if( data[ i ] == ',' || data[ i ] == '\n' )
+        {
+            index[ count++ ] = ( uint32_t ) i;
+        }
+    }
 
-        XI_CHECK_ZERO( beg_of_datapoint, XI_CSV_DECODE_FEED_PARSER_ERROR );
-        XI_CHECK_ZERO( end_of_datastream_id, XI_CSV_DECODE_FEED_PARSER_ERROR );
+    *scanned = i;
 
-        int size = sizeof( d->datastream_id );
+    return count;
+}
 
-        int s = xi_str_copy_untiln( d->datastream_id, size
-            , current, ',' );
-        XI_CHECK_SIZE( s, size, XI_CSV_DECODE_FEED_PARSER_ERROR );
+// walks the delimiters of a buffer, scanning it a chunk at a time
+typedef struct {
+    const char* data;
+    size_t      size;
+    size_t      base;       //!< where the indexed chunk starts
+    size_t      scanned;    //!< where the indexed chunk ends
+    size_t      count;
+    size_t      next;
+    uint32_t    index[ XI_CSV_SCAN_INDEX_SIZE ];
+} csv_scanner_t;
+
+static const char* csv_next_delimiter( csv_scanner_t* scanner )
+{
+    if( scanner->next == scanner->count )
+    {
+        size_t scanned = 0;
 
-        xi_datapoint_t* ret = csv_decode_datapoint( beg_of_datapoint, p );
-        XI_CHECK_ZERO( ret, XI_CSV_DECODE_FEED_PARSER_ERROR )
+        if( scanner->scanned == scanner->size ) { return 0; }
 
-        d->datapoint_count = 1;
-        current = end_of_line + 1;
+        scanner->base       = scanner->scanned;
+        scanner->count      = csv_scan_delimiters( scanner->data + scanner->base
+            , scanner->size - scanner->base, scanner->index, XI_CSV_SCAN_INDEX_SIZE, &scanned );
+        scanner->scanned    = scanner->base + scanned;
+        scanner->next       = 0;
 
-        XI_CHECK_CND( ++counter == XI_MAX_DATASTREAMS
-            , XI_CSV_DECODE_FEED_PARSER_ERROR );
+        // the chunk only ends early once the index is full
+        if( scanner->count == 0 ) { return 0; }
     }
 
-    feed->datastream_count = counter;
-    return feed;
+    return scanner->data + scanner->base + scanner->index[ scanner->next++ ];
+}
+
+// timestamp and value of a datapoint whose fields have already been found
+static xi_datapoint_t* csv_decode_datapoint_fields(
+      const char* timestamp
+    , const char* value
+    , xi_datapoint_t* datapoint )
+{
+    {
+        int n = xi_str_to_timestamp( timestamp
+            , &datapoint->timestamp.timestamp, &datapoint->timestamp.micro );
+
+        XI_CHECK_CND( n == -1, XI_CSV_TIME_CONVERTION_ERROR );
+
+        // the whole field has to be the timestamp
+        XI_CHECK_CND( n == -2 || timestamp + n + 1 != value
+            , XI_CSV_DECODE_DATAPOINT_PARSER_ERROR );
+    }
+
+    xi_datapoint_t* r = csv_decode_value( value
+        , datapoint );
+
+
+    XI_CHECK_ZERO( r, XI_CSV_DECODE_DATAPOINT_PARSER_ERROR );
+
+    return datapoint;
 
 err_handling:
     return 0;
 }
 
-xi_datapoint_t* csv_decode_datapoint(
+int csv_visit_feed(
       const char* buffer
-    , xi_datapoint_t* datapoint )
+    , const xi_feed_visitor_t* visitor, void* user_data )
 {
     // PRECONDITIONS
     assert( buffer != 0 );
-    assert( datapoint != 0 );
+    assert( visitor != 0 );
 
-    int ye, mo, da, h, m, s, ms;
+    const char* current     = buffer;
 
-    const char* beg_of_value = strstr( buffer, "," );
+    // all the delimiters are found in one pass, lines are then walked along them
+    csv_scanner_t scanner;
+    scanner.data    = buffer;
+    scanner.size    = strlen( buffer );
+    scanner.base    = 0;
+    scanner.scanned = 0;
+    scanner.count   = 0;
+    scanner.next    = 0;
 
-    // check continuation condition
-    XI_CHECK_ZERO( beg_of_value, XI_CSV_DECODE_DATAPOINT_PARSER_ERROR );
+    const char* end_of_line = 0;
+
+    // the id of this line and of the previous one take turns
+    char datastream_ids[ 2 ][ XI_MAX_DATASTREAM_NAME ];
+    int this_id     = 0;
+    int first_line  = 1;
 
-    // move to pointer to the proper position
-    beg_of_value += 1;
+    xi_datapoint_t datapoint;
 
+    // every line is `datastream_id,timestamp,value`, the value may have commas of its own
+    do
     {
-        int n = sscanf( buffer
-            , "%04d-%02d-%02dT%02d:%02d:%02d.%06dZ"
-            , &ye, &mo, &da, &h, &m, &s, &ms );
+        const char* end_of_datastream_id  = csv_next_delimiter( &scanner );
+
+        XI_CHECK_CND( end_of_datastream_id == 0 || *end_of_datastream_id != ','
+            , XI_CSV_DECODE_FEED_PARSER_ERROR );
+
+        const char* end_of_timestamp      = csv_next_delimiter( &scanner );
 
-        // check if the parser worked correctly
-        XI_CHECK_CND( n != 7, XI_CSV_DECODE_DATAPOINT_PARSER_ERROR );
+        XI_CHECK_CND( end_of_timestamp == 0 || *end_of_timestamp != ','
+            , XI_CSV_DECODE_FEED_PARSER_ERROR );
 
-        // copy parsed data
+        for( end_of_line = end_of_timestamp; end_of_line && *end_of_line != '\n'; )
         {
-            struct tm timeinfo;
+            end_of_line = csv_next_delimiter( &scanner );
+        }
 
-            timeinfo.tm_year   = ye - 1900;
-            timeinfo.tm_mon    = mo - 1;
-            timeinfo.tm_mday   = da;
-            timeinfo.tm_hour   = h;
-            timeinfo.tm_min    = m;
-            timeinfo.tm_sec    = s;
+        char* datastream_id = datastream_ids[ this_id ];
+        int size            = XI_MAX_DATASTREAM_NAME;
 
-            time_t timestamp = xi_mktime( &timeinfo );
+        int s = xi_str_copy_untiln( datastream_id, size
+            , current, ',' );
+        XI_CHECK_SIZE( s, size, XI_CSV_DECODE_FEED_PARSER_ERROR );
 
-            XI_CHECK_CND( ( int )timestamp == -1, XI_CSV_TIME_CONVERTION_ERROR );
+        memset( &datapoint, 0, sizeof( xi_datapoint_t ) );
 
-            datapoint->timestamp.timestamp  = timestamp;
-            datapoint->timestamp.micro      = ms;
+        xi_datapoint_t* ret = csv_decode_datapoint_fields(
+            end_of_datastream_id + 1, end_of_timestamp + 1, &datapoint );
+        XI_CHECK_ZERO( ret, XI_CSV_DECODE_FEED_PARSER_ERROR )
+
+        // the lines of a datastream follow each other, so its datapoints go together
+        if( first_line || strcmp( datastream_id, datastream_ids[ this_id ^ 1 ] ) != 0 )
+        {
+            if( visitor->on_datastream && visitor->on_datastream( datastream_id, user_data ) ) { return 1; }
+
+            first_line  = 0;
+            this_id    ^= 1;
         }
-    }
 
-    xi_datapoint_t* r = csv_decode_value( beg_of_value
-        , datapoint );
+        if( visitor->on_datapoint && visitor->on_datapoint( datastream_id, &datapoint, user_data ) ) { return 1; }
 
+        current = end_of_line + 1;
+    } while( end_of_line );
 
-    XI_CHECK_ZERO( r, XI_CSV_DECODE_DATAPOINT_PARSER_ERROR );
+    return 0;
 
-    return datapoint;
+err_handling:
+    return -1;
+}
+
+xi_feed_t* csv_decode_feed(
+      const char* buffer
+    , xi_feed_t* feed )
+{
+    // PRECONDITIONS
+    assert( feed != 0 );
+
+    feed->datastream_count = 0;
+
+    int s = csv_visit_feed( buffer, &data_layer_feed_filler, feed );
+
+    // the visitor stops only when the feed is full
+    XI_CHECK_CND( s == 1, XI_CSV_DECODE_FEED_PARSER_ERROR );
+
+    return s == 0 ? feed : 0;
+
+err_handling:
+    return 0;
+}
+
+xi_datapoint_t* csv_decode_datapoint(
+      const char* buffer
+    , xi_datapoint_t* datapoint )
+{
+    // PRECONDITIONS
+    assert( buffer != 0 );
+    assert( datapoint != 0 );
+
+    const char* beg_of_value = strstr( buffer, "," );
+
+    // check continuation condition
+    XI_CHECK_ZERO( beg_of_value, XI_CSV_DECODE_DATAPOINT_PARSER_ERROR );
+
+    return csv_decode_datapoint_fields( buffer, beg_of_value + 1, datapoint );
 
 err_handling:
     return 0;
@@ -31,8 +31,34 @@ xi_feed_t* csv_decode_feed(
       const char* buffer
     , xi_feed_t* feed );
 
+int csv_visit_feed(
+      const char* buffer
+    , const xi_feed_visitor_t* visitor, void* user_data );
+
 xi_datapoint_t* csv_decode_datapoint( const char* data, xi_datapoint_t* dp );
 
+/**
+ * \brief   Copies the value up to the end of the line into the datapoint
+ *          and tells whether it is an integer, a float or a string
+ *
+ * \return  The datapoint or null if the value doesn't fit.
+ */
+xi_datapoint_t* csv_decode_value( const char* buffer, xi_datapoint_t* p );
+
+/**
+ * \brief   Finds commas and newlines in a single pass over the data
+ *
+ *   Offsets of the delimiters are put in `index` in order, until there is no
+ *   more room in it. With SSE2 sixteen bytes are looked at in one go.
+ *
+ * \param   scanned how many bytes of the data have been looked at
+ * \return  The number of delimiters found.
+ */
+size_t csv_scan_delimiters(
+      const char* data, size_t data_size
+    , uint32_t* index, size_t index_size
+    , size_t* scanned );
+
 #ifdef __cplusplus
 }
 #endif
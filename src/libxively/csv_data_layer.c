@@ -17,6 +17,7 @@ const data_layer_t* get_csv_data_layer()
         , csv_encode_create_datastream
         , csv_decode_feed
         , csv_decode_datapoint
+        , csv_visit_feed
     };
 
     return &__csv_data_layer;
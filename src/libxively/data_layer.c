@@ -0,0 +1,55 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    data_layer.c
+ * \brief   Implements what the _data layers_ have in common [see data_layer.h]
+ */
+
+#include <string.h>
+
+#include "xively.h"
+#include "data_layer.h"
+#include "xi_macros.h"
+
+static int data_layer_fill_datastream( const char* datastream_id, void* user_data )
+{
+    xi_feed_t* feed = ( xi_feed_t* ) user_data;
+    size_t size     = strlen( datastream_id ) + 1;
+
+    if( feed->datastream_count == XI_MAX_DATASTREAMS ) { return 1; }
+
+    xi_datastream_t* d = &feed->datastreams[ feed->datastream_count ];
+
+    if( size > sizeof( d->datastream_id ) ) { return 1; }
+
+    memcpy( d->datastream_id, datastream_id, size );
+    d->datapoint_count = 0;
+
+    feed->datastream_count += 1;
+
+    return 0;
+}
+
+static int data_layer_fill_datapoint( const char* datastream_id, const xi_datapoint_t* dp, void* user_data )
+{
+    XI_UNUSED( datastream_id );
+
+    xi_feed_t* feed = ( xi_feed_t* ) user_data;
+
+    // a datapoint always comes after its datastream
+    if( feed->datastream_count == 0 ) { return 1; }
+
+    xi_datastream_t* d = &feed->datastreams[ feed->datastream_count - 1 ];
+
+    if( d->datapoint_count == XI_MAX_DATAPOINTS ) { return 1; }
+
+    memcpy( &d->datapoints[ d->datapoint_count++ ], dp, sizeof( xi_datapoint_t ) );
+
+    return 0;
+}
+
+const xi_feed_visitor_t data_layer_feed_filler = {
+      data_layer_fill_datastream
+    , data_layer_fill_datapoint
+};
@@ -77,8 +77,27 @@ typedef struct {
 
      */
     xi_datapoint_t* ( *decode_datapoint )( const char* data, xi_datapoint_t* dp );
+
+    /**
+     * \brief   This function decodes a feed in an implementation-specific format and hands
+     *          each datastream and datapoint to the visitor as soon as it has been decoded,
+     *          none of them is kept.
+     *
+     * \return  0 if the whole feed had been visited, 1 if the visitor stopped or -1 if
+     *          an error occurred.
+     */
+    int ( *visit_feed )( const char* data, const xi_feed_visitor_t* visitor, void* user_data );
 } data_layer_t;
 
+/**
+ * \brief   Visitor that appends whatever it is given to the `xi_feed_t` passed as `user_data`,
+ *          it's how `decode_feed` is implemented on top of `visit_feed`
+ *
+ *    Datastreams are added after the `datastream_count` ones already there, the visitor
+ *    stops when there's no room for another datastream or datapoint.
+ */
+extern const xi_feed_visitor_t data_layer_feed_filler;
+
 #ifdef __cplusplus
 }
 #endif
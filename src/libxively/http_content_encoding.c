@@ -0,0 +1,397 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    http_content_encoding.c
+ * \brief   HTTP content codings (`gzip`, `deflate`) backed by zlib [see http_content_encoding.h]
+ */
+
+#include <string.h>
+#include <strings.h>
+#include <assert.h>
+
+#include "http_content_encoding.h"
+#include "xi_allocator.h"
+#include "xi_macros.h"
+#include "xi_err.h"
+#include "xi_consts.h"
+
+#ifdef XI_ZLIB
+#include <zlib.h>
+
+// zlib is told to use our allocator, so the custom memory management applies to it too
+static voidpf http_zlib_alloc( voidpf opaque, uInt items, uInt size )
+{
+    XI_UNUSED( opaque );
+    return xi_alloc( ( size_t ) items * size );
+}
+
+static void http_zlib_free( voidpf opaque, voidpf address )
+{
+    XI_UNUSED( opaque );
+    xi_free( address );
+}
+#endif
+
+http_content_coding_t http_classify_content_coding( const char* value )
+{
+    if( value == 0 || *value == '\0' || strcasecmp( value, "identity" ) == 0 )
+    {
+        return XI_HTTP_CODING_IDENTITY;
+    }
+
+    if( strcasecmp( value, "gzip" ) == 0 || strcasecmp( value, "x-gzip" ) == 0 )
+    {
+        return XI_HTTP_CODING_GZIP;
+    }
+
+    if( strcasecmp( value, "deflate" ) == 0 )
+    {
+        return XI_HTTP_CODING_DEFLATE;
+    }
+
+    return XI_HTTP_CODING_UNKNOWN;
+}
+
+// the one inflater, see `http_inflate_begin()`
+static struct
+{
+#ifdef XI_ZLIB
+    z_stream                strm;
+    int                     started;    // whether `inflateEnd()` is due
+    int                     ended;      // whether the compressed stream is over
+#endif
+    http_content_coding_t   coding;
+    char*                   dst;
+    size_t                  dst_size;
+    size_t                  size;
+    int                     failed;
+} XI_HTTP_INFLATER;
+
+#ifdef XI_ZLIB
+// the first piece of the content tells the framing: 15 + 32 detects gzip or zlib header, -15 is raw deflate
+static int http_inflate_start( const char* src, size_t src_size )
+{
+    int window_bits = 15 + 32;
+
+    // RFC 2616 says zlib format for `deflate`, however some servers send raw deflate
+    if( XI_HTTP_INFLATER.coding == XI_HTTP_CODING_DEFLATE && src_size >= 2 )
+    {
+        unsigned int cmf = ( unsigned char ) src[ 0 ];
+        unsigned int flg = ( unsigned char ) src[ 1 ];
+
+        if( ( cmf & 0x0f ) != Z_DEFLATED || ( cmf * 256 + flg ) % 31 != 0 ) { window_bits = -15; }
+    }
+
+    XI_HTTP_INFLATER.strm.zalloc    = &http_zlib_alloc;
+    XI_HTTP_INFLATER.strm.zfree     = &http_zlib_free;
+
+    XI_CHECK_CND( inflateInit2( &XI_HTTP_INFLATER.strm, window_bits ) != Z_OK
+        , XI_HTTP_CONTENT_ENCODING_ERROR );
+
+    XI_HTTP_INFLATER.started = 1;
+
+    return 0;
+
+err_handling:
+    return -1;
+}
+
+// inflates all the input that's there, one byte past `dst` tells whether the content is too large
+static int http_inflate_run( void )
+{
+    z_stream* strm = &XI_HTTP_INFLATER.strm;
+    char overflow  = '\0';
+
+    while( !XI_HTTP_INFLATER.ended )
+    {
+        size_t room = XI_HTTP_INFLATER.dst_size - 1 - XI_HTTP_INFLATER.size;
+
+        strm->next_out  = ( Bytef* ) ( room ? XI_HTTP_INFLATER.dst + XI_HTTP_INFLATER.size : &overflow );
+        strm->avail_out = ( uInt ) ( room ? room : 1 );
+
+        int ret = inflate( strm, Z_NO_FLUSH );
+
+        XI_CHECK_CND( ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR
+            , XI_HTTP_CONTENT_ENCODING_ERROR );
+        XI_CHECK_CND( room == 0 && strm->avail_out == 0, XI_HTTP_CONTENT_TOO_LARGE );
+
+        XI_HTTP_INFLATER.size          += room ? room - strm->avail_out : 0;
+        XI_HTTP_INFLATER.ended          = ret == Z_STREAM_END;
+
+        // with room left all of the input has been inflated
+        if( strm->avail_out != 0 ) { break; }
+    }
+
+    return 0;
+
+err_handling:
+    return -1;
+}
+#endif
+
+int http_inflate_begin( http_content_coding_t coding, char* dst, size_t dst_size )
+{
+    // PRECONDITIONS
+    assert( dst != 0 );
+    assert( dst_size > 1 );
+
+#ifdef XI_ZLIB
+    if( XI_HTTP_INFLATER.started ) { inflateEnd( &XI_HTTP_INFLATER.strm ); }
+#endif
+
+    memset( &XI_HTTP_INFLATER, 0, sizeof( XI_HTTP_INFLATER ) );
+
+    XI_HTTP_INFLATER.coding     = coding;
+    XI_HTTP_INFLATER.dst        = dst;
+    XI_HTTP_INFLATER.dst_size   = dst_size;
+
+    dst[ 0 ] = '\0';
+
+    switch( coding )
+    {
+        case XI_HTTP_CODING_IDENTITY:
+#ifdef XI_ZLIB
+        case XI_HTTP_CODING_GZIP:
+        case XI_HTTP_CODING_DEFLATE:
+#endif
+            return 0;
+        default:
+            break;
+    }
+
+    XI_HTTP_INFLATER.failed = 1;
+
+    xi_set_err( XI_HTTP_CONTENT_ENCODING_ERROR );
+
+    return -1;
+}
+
+int http_inflate_write( const char* src, size_t src_size )
+{
+    // PRECONDITIONS
+    assert( src != 0 || src_size == 0 );
+
+    if( XI_HTTP_INFLATER.failed ) { return -1; }
+
+    if( XI_HTTP_INFLATER.coding == XI_HTTP_CODING_IDENTITY )
+    {
+        // uncompressed content is truncated, the way it always was
+        size_t s = XI_MIN( src_size, XI_HTTP_INFLATER.dst_size - 1 - XI_HTTP_INFLATER.size );
+
+        memcpy( XI_HTTP_INFLATER.dst + XI_HTTP_INFLATER.size, src, s );
+        XI_HTTP_INFLATER.size += s;
+    }
+#ifdef XI_ZLIB
+    else if( src_size > 0 )
+    {
+        if( XI_HTTP_INFLATER.started == 0 && http_inflate_start( src, src_size ) == -1 )
+        {
+            XI_HTTP_INFLATER.failed = 1;
+        }
+        else
+        {
+            XI_HTTP_INFLATER.strm.next_in   = ( Bytef* ) src;
+            XI_HTTP_INFLATER.strm.avail_in  = ( uInt ) src_size;
+
+            XI_HTTP_INFLATER.failed = http_inflate_run() == -1;
+        }
+    }
+#endif
+
+    XI_HTTP_INFLATER.dst[ XI_HTTP_INFLATER.size ] = '\0';
+
+    return XI_HTTP_INFLATER.failed ? -1 : 0;
+}
+
+int http_inflate_end( void )
+{
+    int s = XI_HTTP_INFLATER.failed ? -1 : ( int ) XI_HTTP_INFLATER.size;
+
+#ifdef XI_ZLIB
+    // a stream that has begun, but didn't end is not all there, no content at all is fine
+    if( s != -1 && XI_HTTP_INFLATER.started && XI_HTTP_INFLATER.ended == 0 )
+    {
+        xi_set_err( XI_HTTP_CONTENT_ENCODING_ERROR );
+        s = -1;
+    }
+
+    if( XI_HTTP_INFLATER.started ) { inflateEnd( &XI_HTTP_INFLATER.strm ); }
+
+    XI_HTTP_INFLATER.started = 0;
+#endif
+
+    // nothing more goes in
+    XI_HTTP_INFLATER.failed = 1;
+
+    return s;
+}
+
+#ifdef XI_ZLIB
+// the one deflater, see `http_deflate_begin()`
+static struct
+{
+    z_stream                strm;
+    char*                   window;
+    size_t                  window_size;
+    http_deflate_sink_t*    sink;
+    void*                   user_data;
+    int                     started;    // whether `deflateEnd()` is due
+    int                     failed;
+} XI_HTTP_DEFLATER;
+
+// hands whatever is in the window to the sink and makes it empty again
+static int http_deflate_drain( void )
+{
+    z_stream* strm  = &XI_HTTP_DEFLATER.strm;
+    size_t size     = XI_HTTP_DEFLATER.window_size - strm->avail_out;
+
+    strm->next_out  = ( Bytef* ) XI_HTTP_DEFLATER.window;
+    strm->avail_out = ( uInt ) XI_HTTP_DEFLATER.window_size;
+
+    if( size == 0 ) { return 0; }
+
+    return XI_HTTP_DEFLATER.sink( XI_HTTP_DEFLATER.window, size, XI_HTTP_DEFLATER.user_data );
+}
+
+// deflates all the input, with `Z_FINISH` up to the end of the stream
+static int http_deflate_run( int flush )
+{
+    z_stream* strm  = &XI_HTTP_DEFLATER.strm;
+    int done        = 0;
+
+    while( !done )
+    {
+        int ret = deflate( strm, flush );
+
+        if( ret == Z_STREAM_ERROR || ( flush == Z_FINISH && ret == Z_BUF_ERROR ) )
+        {
+            xi_set_err( XI_HTTP_CONTENT_ENCODING_ERROR );
+            return -1;
+        }
+
+        // without room left in the window there may be more output to come
+        done = flush == Z_FINISH ? ret == Z_STREAM_END : strm->avail_out != 0;
+
+        if( ( strm->avail_out == 0 || ( done && flush == Z_FINISH ) )
+         && http_deflate_drain() == -1 )
+        {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+#endif
+
+int http_deflate_begin(
+      http_content_coding_t coding
+    , char* window, size_t window_size
+    , http_deflate_sink_t* sink, void* user_data )
+{
+    // PRECONDITIONS
+    assert( window != 0 );
+    assert( window_size > 0 );
+    assert( sink != 0 );
+
+#ifdef XI_ZLIB
+    assert( XI_HTTP_DEFLATER.started == 0 );
+
+    int window_bits = 0;
+
+    memset( &XI_HTTP_DEFLATER, 0, sizeof( XI_HTTP_DEFLATER ) );
+
+    XI_HTTP_DEFLATER.window         = window;
+    XI_HTTP_DEFLATER.window_size    = window_size;
+    XI_HTTP_DEFLATER.sink           = sink;
+    XI_HTTP_DEFLATER.user_data      = user_data;
+    XI_HTTP_DEFLATER.failed         = 1;
+
+    switch( coding )
+    {
+        case XI_HTTP_CODING_GZIP:
+            window_bits = XI_ZLIB_DEFLATE_WINDOW_BITS + 16;
+            break;
+        case XI_HTTP_CODING_DEFLATE:
+            window_bits = XI_ZLIB_DEFLATE_WINDOW_BITS;
+            break;
+        default:
+            break;
+    }
+
+    XI_CHECK_CND( window_bits == 0, XI_HTTP_CONTENT_ENCODING_ERROR );
+
+    z_stream* strm  = &XI_HTTP_DEFLATER.strm;
+
+    strm->zalloc    = &http_zlib_alloc;
+    strm->zfree     = &http_zlib_free;
+    strm->next_out  = ( Bytef* ) window;
+    strm->avail_out = ( uInt ) window_size;
+
+    XI_CHECK_CND( deflateInit2( strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED
+        , window_bits, XI_ZLIB_DEFLATE_MEM_LEVEL, Z_DEFAULT_STRATEGY ) != Z_OK
+        , XI_HTTP_CONTENT_ENCODING_ERROR );
+
+    XI_HTTP_DEFLATER.started    = 1;
+    XI_HTTP_DEFLATER.failed     = 0;
+
+    return 0;
+#else
+    XI_UNUSED( coding );
+    XI_UNUSED( window );
+    XI_UNUSED( window_size );
+    XI_UNUSED( sink );
+    XI_UNUSED( user_data );
+
+    xi_set_err( XI_HTTP_CONTENT_ENCODING_ERROR );
+    goto err_handling;
+#endif
+
+err_handling:
+    return -1;
+}
+
+int http_deflate_write( const char* data, size_t data_size )
+{
+    // PRECONDITIONS
+    assert( data != 0 || data_size == 0 );
+
+#ifdef XI_ZLIB
+    if( XI_HTTP_DEFLATER.failed ) { return -1; }
+
+    XI_HTTP_DEFLATER.strm.next_in   = ( Bytef* ) data;
+    XI_HTTP_DEFLATER.strm.avail_in  = ( uInt ) data_size;
+
+    // errors of the sink are its own to report
+    XI_HTTP_DEFLATER.failed = http_deflate_run( Z_NO_FLUSH ) == -1;
+
+    return XI_HTTP_DEFLATER.failed ? -1 : 0;
+#else
+    XI_UNUSED( data );
+    XI_UNUSED( data_size );
+
+    return -1;
+#endif
+}
+
+int http_deflate_end( void )
+{
+#ifdef XI_ZLIB
+    if( XI_HTTP_DEFLATER.started == 0 ) { return -1; }
+
+    if( !XI_HTTP_DEFLATER.failed )
+    {
+        XI_HTTP_DEFLATER.failed = http_deflate_run( Z_FINISH ) == -1;
+    }
+
+    int out = ( int ) XI_HTTP_DEFLATER.strm.total_out;
+
+    deflateEnd( &XI_HTTP_DEFLATER.strm );
+
+    XI_HTTP_DEFLATER.started = 0;
+
+    return XI_HTTP_DEFLATER.failed ? -1 : out;
+#else
+    return -1;
+#endif
+}
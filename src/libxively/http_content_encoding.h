@@ -0,0 +1,113 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    http_content_encoding.h
+ * \brief   HTTP content codings (`gzip`, `deflate`) backed by zlib
+ *
+ *    The functions below are only available when the library had been built
+ *    with `XI_ZLIB=1`, otherwise every content coding other than `identity`
+ *    is reported as unsupported.
+ */
+
+#ifndef __HTTP_CONTENT_ENCODING_H__
+#define __HTTP_CONTENT_ENCODING_H__
+
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief   Content codings we know about
+ */
+typedef enum
+{
+    XI_HTTP_CODING_IDENTITY = 0,
+    XI_HTTP_CODING_GZIP,
+    XI_HTTP_CODING_DEFLATE,
+    XI_HTTP_CODING_UNKNOWN
+} http_content_coding_t;
+
+/**
+ * \brief   Classifies the value of `Content-Encoding` header
+ */
+http_content_coding_t http_classify_content_coding( const char* value );
+
+/**
+ * \brief   Starts copying or inflating content that comes in pieces handed over by
+ *          `http_inflate_write()` straight into `dst`, so it can be handed to the _data layer_
+ *
+ *    There is no intermediate buffer, every piece is inflated into `dst` right away and
+ *    `dst` is kept terminated with `\0`. Content that inflates past `dst_size - 1` bytes
+ *    is an error (`XI_HTTP_CONTENT_TOO_LARGE`), while content that isn't compressed is
+ *    truncated to fit. There is only one inflater, a call to this function drops the
+ *    content started before if `http_inflate_end()` wasn't called for it.
+ *
+ * \return  0 or -1 if the coding isn't supported.
+ */
+int http_inflate_begin( http_content_coding_t coding, char* dst, size_t dst_size );
+
+/**
+ * \brief   Copies or inflates the next `src_size` bytes of the content
+ *
+ *    With `deflate` coding the first piece tells the zlib format, which RFC 2616
+ *    asks for, from raw deflate some servers send, so it should be at least 2 bytes.
+ *
+ * \return  0 or -1 if an error occurred, in this or any earlier call
+ */
+int http_inflate_write( const char* src, size_t src_size );
+
+/**
+ * \brief   Finishes the content, a compressed stream that didn't end is an error
+ *
+ * \return  Number of bytes written to `dst` (without the terminator) or -1 if an error
+ *          occurred, in this or any earlier call
+ */
+int http_inflate_end( void );
+
+/**
+ * \brief   Takes the deflated content as it comes out of the deflater
+ *
+ * \return  0 or -1 to stop deflating
+ */
+typedef int ( http_deflate_sink_t )( const char* data, size_t data_size, void* user_data );
+
+/**
+ * \brief   Starts deflating content that is handed over in pieces by `http_deflate_write()`
+ *
+ *    The output is gathered in `window` and handed to `sink` each time the window
+ *    fills up and once more by `http_deflate_end()`, so neither the content nor its
+ *    deflated form have to be kept whole. Window size and memory usage of zlib are
+ *    limited by `XI_ZLIB_DEFLATE_WINDOW_BITS` and `XI_ZLIB_DEFLATE_MEM_LEVEL`. The same
+ *    content handed over in the same pieces deflates to the same bytes, so it may be
+ *    deflated once to measure it and once more to send it. There is only one deflater,
+ *    every call to this function has to be followed by `http_deflate_end()`.
+ *
+ * \return  0 or -1 if an error occurred
+ */
+int http_deflate_begin(
+      http_content_coding_t coding
+    , char* window, size_t window_size
+    , http_deflate_sink_t* sink, void* user_data );
+
+/**
+ * \brief   Deflates the next `data_size` bytes of the content
+ *
+ * \return  0 or -1 if an error occurred, in this or any earlier call
+ */
+int http_deflate_write( const char* data, size_t data_size );
+
+/**
+ * \brief   Finishes the deflated stream, hands the rest of it to the sink and frees the deflater
+ *
+ * \return  Size of the whole deflated content or -1 if an error occurred, in this or any earlier call
+ */
+int http_deflate_end( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __HTTP_CONTENT_ENCODING_H__
@@ -10,11 +10,13 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <assert.h>
 
 #include "xively.h"
 #include "xi_macros.h"
 #include "http_consts.h"
 #include "http_layer_parser.h"
+#include "http_content_encoding.h"
 #include "xi_debug.h"
 #include "xi_err.h"
 
@@ -23,6 +25,9 @@ static const char XI_HTTP_STATUS_PATTERN[] =
 
 #define SET_HTTP_STATUS_PATTERN(a,b,c,d) XI_HTTP_STATUS_PATTERN, &a, &b, &c, d
 
+// the lazy parser keeps the header lines where the parsed headers would go
+#define XI_HTTP_HEADERS_RAW( r ) ( ( char* ) ( r )->http_headers )
+
 static const char XI_HTTP_TOKEN_NAMES[ XI_HTTP_HEADERS_COUNT ][ XI_HTTP_HEADER_NAME_MAX_SIZE ] =
     {
           "date"            // XI_HTTP_HEADER_DATE
@@ -31,14 +36,19 @@ static const char XI_HTTP_TOKEN_NAMES[ XI_HTTP_HEADERS_COUNT ][ XI_HTTP_HEADER_N
         , "connection"      // XI_HTTP_HEADER_CONNECTION
         , "x-request-id"    // XI_HTTP_HEADER_X_REQUEST_ID
         , "cache-control"   // XI_HTTP_HEADER_CACHE_CONTROL
-        , "age"             // XI_HTTP_HEADER_AGE
         , "vary"            // XI_HTTP_HEADER_VARY
+        , "count"           // XI_HTTP_HEADER_COUNT
+        , "age"             // XI_HTTP_HEADER_AGE
+        , "content-encoding" // XI_HTTP_HEADER_CONTENT_ENCODING
+        , "etag"            // XI_HTTP_HEADER_ETAG
+        , "last-modified"   // XI_HTTP_HEADER_LAST_MODIFIED
+        , "retry-after"     // XI_HTTP_HEADER_RETRY_AFTER
         , "unknown"         // XI_HTTP_HEADER_UNKNOWN, //!< !!!! this must be always on the last position
     };
 
 static inline http_header_type_t classify_header( const char* header )
 {
-    for( unsigned short i = 0; i < XI_HTTP_HEADER_COUNT - 1; ++i )
+    for( unsigned short i = 0; i < XI_HTTP_HEADER_UNKNOWN; ++i )
     {
         if( strcasecmp( header, XI_HTTP_TOKEN_NAMES[ i ] ) == 0 )
             return ( http_header_type_t ) i;
@@ -155,7 +165,57 @@ err_handling:
     return 0;
 }
 
+// the content of the last parsed response that is yet to come, see `parse_http_content()`
+static size_t XI_HTTP_CONTENT_LEFT = 0;
+
+// copies or inflates what there is of the content straight into the buffer that the data
+// layer reads from, `Content-Length` tells how much of it is left for `parse_http_content()`
+static int http_parse_first_content( http_response_t* response, const char* coding
+    , const char* payload, size_t payload_size, const char* content_length )
+{
+    int length = content_length ? atoi( content_length ) : -1;
+
+    XI_HTTP_CONTENT_LEFT = 0;
+
+    if( http_inflate_begin( http_classify_content_coding( coding )
+        , response->http_content, sizeof( response->http_content ) ) == -1 )
+    {
+        return -1;
+    }
+
+    XI_HTTP_CONTENT_LEFT = length >= 0 ? ( size_t ) length : payload_size;
+
+    return parse_http_content( payload, payload_size );
+}
+
+int parse_http_content( const char* data, size_t data_size )
+{
+    size_t size = XI_MIN( data_size, XI_HTTP_CONTENT_LEFT );
+
+    XI_HTTP_CONTENT_LEFT -= size;
+
+    if( http_inflate_write( data, size ) == -1 )
+    {
+        XI_HTTP_CONTENT_LEFT = 0;
+        http_inflate_end();
+        return -1;
+    }
+
+    return XI_HTTP_CONTENT_LEFT == 0 && http_inflate_end() == -1 ? -1 : 0;
+}
+
+size_t http_content_left( void )
+{
+    return XI_HTTP_CONTENT_LEFT;
+}
+
 http_response_t* parse_http( http_response_t* response, const char* content )
+{
+    return parse_http_sized( response, content, strlen( content ) );
+}
+
+http_response_t* parse_http_sized( http_response_t* response
+    , const char* content, size_t content_size )
 {
     memset( response, 0, sizeof( http_response_t ) );
 
@@ -186,11 +246,256 @@ http_response_t* parse_http( http_response_t* response, const char* content )
     xi_err_t e = xi_get_last_error();
     XI_CHECK_CND( e != XI_NO_ERR, e );
 
-    // just copy the content
-    strncpy( response->http_content, payload_begin, sizeof( response->http_content ) );
+    // copy or inflate the content straight into the buffer that data layer reads from
+    {
+        const http_header_t* length_header
+            = response->http_headers_checklist[ XI_HTTP_HEADER_CONTENT_LENGTH ];
+        const http_header_t* coding_header
+            = response->http_headers_checklist[ XI_HTTP_HEADER_CONTENT_ENCODING ];
+
+        if( http_parse_first_content( response, coding_header ? coding_header->value : 0
+            , payload_begin, content_size - ( payload_begin - content )
+            , length_header ? length_header->value : 0 ) == -1 )
+        {
+            goto err_handling;
+        }
+    }
 
     return response;
 
 err_handling:
     return 0;
 }
+
+// finds the header among the lines in [ begin, end ), all of them end with CRLF
+static const char* http_find_header( const char* begin, const char* end
+    , http_header_type_t type, size_t* value_size )
+{
+    const char* name = XI_HTTP_TOKEN_NAMES[ type ];
+    size_t name_size = strlen( name );
+
+    while( begin < end )
+    {
+        const char* line_end = memchr( begin, '\r', end - begin );
+
+        if( line_end == 0 ) { line_end = end; }
+
+        if( ( size_t ) ( line_end - begin ) > name_size
+            && begin[ name_size ] == ':'
+            && strncasecmp( begin, name, name_size ) == 0 )
+        {
+            const char* value = begin + name_size + 1;
+
+            while( value < line_end && *value == ' ' ) { ++value; }
+
+            *value_size = line_end - value;
+            return value;
+        }
+
+        begin = line_end + sizeof( XI_HTTP_CRLF ) - 1;
+    }
+
+    return 0;
+}
+
+// the same as XI_HTTP_STATUS_PATTERN without going through sscanf
+static const char* http_parse_status_line( http_response_t* response, const char* content )
+{
+    const char* p = content;
+
+    XI_CHECK_CND( strncmp( p, "HTTP/", 5 ) != 0, XI_HTTP_STATUS_PARSE_ERROR );
+    p += 5;
+
+    XI_CHECK_CND( p[ 0 ] < '0' || p[ 0 ] > '9' || p[ 1 ] != '.'
+        || p[ 2 ] < '0' || p[ 2 ] > '9' || p[ 3 ] != ' ', XI_HTTP_STATUS_PARSE_ERROR );
+
+    response->http_version1 = p[ 0 ] - '0';
+    response->http_version2 = p[ 2 ] - '0';
+    p += 4;
+
+    response->http_status = 0;
+
+    for( int i = 0; i < 3; ++i, ++p )
+    {
+        XI_CHECK_CND( *p < '0' || *p > '9', XI_HTTP_STATUS_PARSE_ERROR );
+        response->http_status = response->http_status * 10 + ( *p - '0' );
+    }
+
+    XI_CHECK_CND( *p != ' ', XI_HTTP_STATUS_PARSE_ERROR );
+
+    {
+        const char* reason = ++p;
+
+        while( *p != '\r' && *p != '\0' ) { ++p; }
+
+        XI_CHECK_CND( p[ 0 ] != '\r' || p[ 1 ] != '\n', XI_HTTP_STATUS_PARSE_ERROR );
+
+        size_t size = XI_MIN( ( size_t ) ( p - reason ), sizeof( response->http_status_string ) - 1 );
+
+        memcpy( response->http_status_string, reason, size );
+        response->http_status_string[ size ] = '\0';
+    }
+
+    return p + sizeof( XI_HTTP_CRLF ) - 1;
+
+err_handling:
+    return 0;
+}
+
+http_response_t* parse_http_lazy( http_response_t* response
+    , const char* content, size_t content_size )
+{
+    // only what's read by the accessors is reset, the rest is left as it was
+    response->http_headers_size     = 0;
+    response->http_headers_raw_size = 0;
+    XI_HTTP_HEADERS_RAW( response )[ 0 ] = '\0';
+    memset( response->http_headers_checklist, 0, sizeof( response->http_headers_checklist ) );
+
+    const char* headers_end = strstr( content, XI_HTTP_CRLFX2 );
+
+    XI_CHECK_ZERO( headers_end, XI_HTTP_PARSE_ERROR );
+
+    // the last header keeps its CRLF
+    headers_end += sizeof( XI_HTTP_CRLF ) - 1;
+
+    const char* payload_begin = headers_end + sizeof( XI_HTTP_CRLF ) - 1;
+
+    const char* headers_begin = http_parse_status_line( response, content );
+
+    XI_CHECK_ZERO( headers_begin, XI_HTTP_PARSE_ERROR );
+
+    // keep as many whole lines as fit, the ones past that just won't be found
+    {
+        size_t size = headers_end - headers_begin;
+
+        if( size > sizeof( response->http_headers ) - 1 )
+        {
+            size = sizeof( response->http_headers ) - 1;
+
+            while( size > 0 && headers_begin[ size - 1 ] != '\n' ) { --size; }
+        }
+
+        memcpy( XI_HTTP_HEADERS_RAW( response ), headers_begin, size );
+        XI_HTTP_HEADERS_RAW( response )[ size ] = '\0';
+        response->http_headers_raw_size = size;
+    }
+
+    // copy or inflate the content straight into the buffer that data layer reads from
+    {
+        size_t value_size   = 0;
+        char coding[ 16 ]   = { '\0' };
+
+        // the number ends at CR anyway
+        const char* length = http_find_header( headers_begin, headers_end
+            , XI_HTTP_HEADER_CONTENT_LENGTH, &value_size );
+
+        const char* value = http_find_header( headers_begin, headers_end
+            , XI_HTTP_HEADER_CONTENT_ENCODING, &value_size );
+
+        if( value )
+        {
+            // anything longer than what we know is unknown anyway
+            value_size = XI_MIN( value_size, sizeof( coding ) - 1 );
+            memcpy( coding, value, value_size );
+            coding[ value_size ] = '\0';
+        }
+
+        if( http_parse_first_content( response, coding
+            , payload_begin, content_size - ( payload_begin - content ), length ) == -1 )
+        {
+            goto err_handling;
+        }
+    }
+
+    return response;
+
+err_handling:
+    return 0;
+}
+
+const char* http_response_header( const http_response_t* response
+    , http_header_type_t type, char* buffer, size_t buffer_size )
+{
+    // PRECONDITIONS
+    assert( buffer != 0 );
+    assert( buffer_size > 0 );
+
+    buffer[ 0 ] = '\0';
+
+    if( type >= XI_HTTP_HEADER_UNKNOWN ) { return 0; }
+
+    size_t value_size = 0;
+    const char* value = 0;
+
+    // parsed eagerly
+    if( response->http_headers_checklist[ type ] )
+    {
+        value       = response->http_headers_checklist[ type ]->value;
+        value_size  = strlen( value );
+    }
+    // the raw lines share their space with the parsed headers
+    else if( response->http_headers_size == 0 )
+    {
+        const char* raw = ( const char* ) response->http_headers;
+
+        value = http_find_header( raw, raw + response->http_headers_raw_size, type, &value_size );
+    }
+
+    if( value == 0 ) { return 0; }
+
+    value_size = XI_MIN( value_size, buffer_size - 1 );
+    memcpy( buffer, value, value_size );
+    buffer[ value_size ] = '\0';
+
+    return buffer;
+}
+
+int parse_http_reply_size( const char* content, size_t content_size )
+{
+    const char* end         = content + content_size;
+    const char* headers_end = 0;
+
+    for( const char* p = content; p + 4 <= end; ++p )
+    {
+        p = memchr( p, '\r', end - p - 3 );
+
+        if( p == 0 ) { break; }
+
+        if( memcmp( p, XI_HTTP_CRLFX2, 4 ) == 0 )
+        {
+            headers_end = p + 2;
+            break;
+        }
+    }
+
+    if( headers_end == 0 ) { return 0; }
+
+    const char* status_end = memchr( content, '\n', headers_end - content );
+
+    XI_CHECK_CND( status_end == 0 || headers_end - content < 12, XI_HTTP_PARSE_ERROR );
+
+    {
+        // "HTTP/1.1 " is followed by the status code
+        int status          = atoi( content + 9 );
+        size_t value_size   = 0;
+        size_t size         = headers_end + 2 - content;
+
+        const char* value = http_find_header( status_end + 1, headers_end
+            , XI_HTTP_HEADER_CONTENT_LENGTH, &value_size );
+
+        if( value )
+        {
+            size += atoi( value );
+        }
+        else
+        {
+            // these never have content
+            XI_CHECK_CND( status >= 200 && status != 204 && status != 304, XI_HTTP_PARSE_ERROR );
+        }
+
+        return size > content_size ? 0 : ( int ) size;
+    }
+
+err_handling:
+    return -1;
+}
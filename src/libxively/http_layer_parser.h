@@ -29,6 +29,68 @@ extern "C" {
  */
 http_response_t* parse_http( http_response_t* response, const char* data );
 
+/**
+ * \brief  Same as `parse_http()`, but for a buffer of known size, which may contain
+ *         binary content such as a compressed body.
+ *
+ *    Content encoded with `gzip` or `deflate` is inflated into `http_content`, it's
+ *    an error if it doesn't fit there, while any other content is truncated to fit.
+ *    If `Content-Length` says there is more content than the buffer has, the rest of
+ *    it may follow with `parse_http_content()`.
+ */
+http_response_t* parse_http_sized( http_response_t* response
+    , const char* data, size_t data_size );
+
+/**
+ * \brief  Same as `parse_http_sized()`, but only the status line and the headers
+ *         needed to read the content are parsed.
+ *
+ *    The header lines are kept as they came in the space of `http_headers`, so
+ *    any of them can be looked up later with `http_response_header()`, while
+ *    `http_headers_size` stays 0 and `http_headers_checklist` is left empty.
+ */
+http_response_t* parse_http_lazy( http_response_t* response
+    , const char* data, size_t data_size );
+
+/**
+ * \brief  Copies or inflates the next piece of the content of the last parsed
+ *         response into its `http_content`, the same way the parser did with the
+ *         part of the content it was given
+ *
+ *    Only `http_content_left()` bytes of the data are taken, once it gets to 0
+ *    the content is complete.
+ *
+ * \return 0 or -1 if an error occurred, e.g. `XI_HTTP_CONTENT_TOO_LARGE`.
+ */
+int parse_http_content( const char* data, size_t data_size );
+
+/**
+ * \brief  Tells how many bytes of the content of the last parsed response are yet
+ *         to come, when `Content-Length` says more than the parser was given
+ */
+size_t http_content_left( void );
+
+/**
+ * \brief  Tells where the reply at the beginning of the buffer ends, the buffer
+ *         needn't be null terminated.
+ *
+ * \return Size of the whole reply, 0 if more data is needed or -1 if it can't
+ *         be told (e.g. there is content, but no `Content-Length`).
+ */
+int parse_http_reply_size( const char* data, size_t data_size );
+
+/**
+ * \brief  Finds the value of the header either among the parsed headers or in the
+ *         raw header lines of the response and copies it to the given buffer.
+ *
+ *    A value longer than `buffer_size - 1` is truncated, the buffer is left
+ *    empty if the response has no such header.
+ *
+ * \return The buffer or null if the response has no such header.
+ */
+const char* http_response_header( const http_response_t* response
+    , http_header_type_t type, char* buffer, size_t buffer_size );
+
 #ifdef __cplusplus
 }
 #endif
@@ -8,27 +8,41 @@
  */
 
 #include <stdio.h>
+#include <string.h>
 #include <assert.h>
 
 #include "http_layer_queries.h"
 #include "xi_macros.h"
 #include "xi_err.h"
 #include "xi_consts.h"
+#include "xi_globals.h"
+#include "xi_helpers.h"
 
 
 static const char XI_HTTP_TEMPLATE_FEED[] = "%s /v2/feeds%s.csv%s HTTP/1.1\r\n"
                                   "Host: %s\r\n"
                                   "User-Agent: %s\r\n"
                                   "Accept: */*\r\n"
-                                  "X-ApiKey: %s\r\n";
+                                  "X-ApiKey: %s\r\n"
+                                  "%s%s";
+
+#ifdef XI_ZLIB
+static const char XI_HTTP_ACCEPT_ENCODING[] = "Accept-Encoding: gzip, deflate\r\n";
+#endif
 
 static const char XI_HTTP_ID_TEMPLATE[]    = "/%s";
-static const char XI_HTTP_ID_TEMPLATE_D[]  = "/%d";
 
-static const char XI_HTTP_CONTENT_TEMPLATE[] = "Content-Type: text/plain\r\n"
-                                            "Content-Length: %d\r\n";
+// the length is put right behind, then either of the endings
+static const char XI_HTTP_CONTENT_LENGTH[]  = "Content-Type: text/plain\r\n"
+                                            "Content-Length: ";
+static const char XI_HTTP_CONTENT_END[]     = "\r\n";
+static const char XI_HTTP_CONTENT_CODING[]  = "\r\nContent-Encoding: ";
+
+static const char XI_HTTP_IF_NONE_MATCH_TEMPLATE[]        = "If-None-Match: %s\r\n";
+static const char XI_HTTP_IF_MODIFIED_SINCE_TEMPLATE[]    = "If-Modified-Since: %s\r\n";
 
 static char XI_QUERY_BUFFER[ XI_QUERY_BUFFER_SIZE ];
+static char XI_CONDITIONAL_BUFFER[ 2 * XI_HTTP_HEADER_VALUE_MAX_SIZE + 40 ];
 static char XI_CONTENT_BUFFER[ XI_CONTENT_BUFFER_SIZE ];
 static char XI_ID_BUFFER[ XI_ID_BUFFER_SIZE ];
 
@@ -70,8 +84,10 @@ inline static int http_construct_int(
 
     if( int_id )
     {
-        s = snprintf( buffer, size
-            , XI_HTTP_ID_TEMPLATE_D, *int_id );
+        XI_CHECK_SIZE( 1, size, XI_HTTP_CONSTRUCT_REQUEST_BUFFER_OVERRUN );
+
+        buffer[ 0 ] = '/';
+        s = xi_int_to_str( buffer + 1, size - 1, *int_id ) + 1;
 
         XI_CHECK_SIZE( s, size, XI_HTTP_CONSTRUCT_REQUEST_BUFFER_OVERRUN )
     }
@@ -121,10 +137,13 @@ inline static int http_construct_datastream(
 
     if( datastream_id )
     {
-        return http_construct_string( buffer + offset, buffer_size - offset
-            , datastream_id == 0 ? "" : datastream_id );
+        s = http_construct_string( buffer + offset, buffer_size - offset
+            , datastream_id );
+
+        XI_CHECK_S( s, size, offset, XI_HTTP_CONSTRUCT_REQUEST_BUFFER_OVERRUN );
     }
 
+    // the whole size, callers may append to it
     return offset;
 
 err_handling:
@@ -157,8 +176,11 @@ inline static int http_construct_datapoint(
 
     if( datapoint )
     {
-        return http_construct_string( buffer + offset, buffer_size - offset
-            , datapoint == 0 ? "" : datapoint );
+        s = http_construct_string( buffer + offset, buffer_size - offset
+            , datapoint );
+
+        XI_CHECK_S( s, size, offset
+            , XI_HTTP_CONSTRUCT_REQUEST_BUFFER_OVERRUN );
     }
 
     return offset;
@@ -177,9 +199,24 @@ inline static const char* http_construct_http_query(
     assert( http_method     != 0 );
     assert( x_api_key   != 0 );
 
+    // optional headers
+    const char* extra_headers = "";
+
+#ifdef XI_ZLIB
+    if( xi_globals.response_compression )
+    {
+        extra_headers = XI_HTTP_ACCEPT_ENCODING;
+    }
+#endif
+
+    // the validators only make sense for a GET and they are used up by it
+    const char* conditional_headers = strcmp( http_method, "GET" ) == 0 ? XI_CONDITIONAL_BUFFER : "";
+
     int s = snprintf( XI_QUERY_BUFFER, XI_QUERY_BUFFER_SIZE, XI_HTTP_TEMPLATE_FEED
         , http_method, id == 0 ? "" : id, query_suffix == 0 ? "" : query_suffix
-        , XI_HOST, XI_USER_AGENT, x_api_key );
+        , XI_HOST, XI_USER_AGENT, x_api_key, extra_headers, conditional_headers );
+
+    if( *conditional_headers ) { XI_CONDITIONAL_BUFFER[ 0 ] = '\0'; }
 
     XI_CHECK_SIZE( s, XI_QUERY_BUFFER_SIZE
         , XI_HTTP_CONSTRUCT_REQUEST_BUFFER_OVERRUN );
@@ -190,6 +227,36 @@ err_handling:
     return 0;
 }
 
+int http_set_conditional_headers(
+          const char* etag
+        , const char* last_modified )
+{
+    int offset  = 0;
+    int size    = sizeof( XI_CONDITIONAL_BUFFER );
+    int s       = 0;
+
+    XI_CONDITIONAL_BUFFER[ 0 ] = '\0';
+
+    if( etag && *etag )
+    {
+        s = snprintf( XI_CONDITIONAL_BUFFER, size, XI_HTTP_IF_NONE_MATCH_TEMPLATE, etag );
+        XI_CHECK_S( s, size, offset, XI_HTTP_CONSTRUCT_REQUEST_BUFFER_OVERRUN );
+    }
+
+    if( last_modified && *last_modified )
+    {
+        s = snprintf( XI_CONDITIONAL_BUFFER + offset, size - offset
+            , XI_HTTP_IF_MODIFIED_SINCE_TEMPLATE, last_modified );
+        XI_CHECK_S( s, size, offset, XI_HTTP_CONSTRUCT_REQUEST_BUFFER_OVERRUN );
+    }
+
+    return 0;
+
+err_handling:
+    XI_CONDITIONAL_BUFFER[ 0 ] = '\0';
+    return -1;
+}
+
 const char* http_construct_request_datapoint(
           const char* http_method
         , const int32_t* feed_id
@@ -215,6 +282,31 @@ err_handling:
     return 0;
 }
 
+const char* http_construct_request_datapoints(
+          const char* http_method
+        , const int32_t* feed_id
+        , const char* datastream
+        , const char* query_suffix
+        , const char* x_api_key )
+{
+    // PRECONDITIONS
+    assert( http_method != 0 );
+    assert( feed_id != 0 );
+    assert( datastream != 0 );
+    assert( x_api_key != 0 );
+
+    int s = http_construct_datapoint( XI_ID_BUFFER, XI_ID_BUFFER_SIZE
+        , feed_id, datastream, 0 );
+
+    XI_CHECK_SIZE( s, XI_ID_BUFFER_SIZE
+        , XI_HTTP_CONSTRUCT_CONTENT_BUFFER_OVERRUN );
+
+    return http_construct_http_query( http_method, XI_ID_BUFFER, query_suffix, x_api_key );
+
+err_handling:
+    return 0;
+}
+
 const char* http_construct_request_datastream(
           const char* http_method
         , const int32_t* feed_id
@@ -259,16 +351,66 @@ err_handling:
     return 0;
 }
 
+// writes the content headers up to the length, returns where the rest goes or -1
+static int http_construct_content_length( int32_t content_size )
+{
+    int offset = sizeof( XI_HTTP_CONTENT_LENGTH ) - 1;
+
+    memcpy( XI_CONTENT_BUFFER, XI_HTTP_CONTENT_LENGTH, offset );
+
+    int s = xi_int_to_str( XI_CONTENT_BUFFER + offset, XI_CONTENT_BUFFER_SIZE - offset
+        , content_size );
+
+    XI_CHECK_S( s, XI_CONTENT_BUFFER_SIZE, offset
+        , XI_HTTP_CONSTRUCT_CONTENT_BUFFER_OVERRUN );
+
+    return offset;
+
+err_handling:
+    return -1;
+}
+
 const char* http_construct_content(
           int32_t content_size )
 {
+    int offset = http_construct_content_length( content_size );
 
-    int s = snprintf( XI_CONTENT_BUFFER, XI_CONTENT_BUFFER_SIZE
-      , XI_HTTP_CONTENT_TEMPLATE, content_size );
+    if( offset == -1 ) { return 0; }
 
-    XI_CHECK_SIZE( s, XI_CONTENT_BUFFER_SIZE
+    XI_CHECK_SIZE( offset + ( int ) sizeof( XI_HTTP_CONTENT_END ) - 1, XI_CONTENT_BUFFER_SIZE
         , XI_HTTP_CONSTRUCT_CONTENT_BUFFER_OVERRUN );
 
+    memcpy( XI_CONTENT_BUFFER + offset, XI_HTTP_CONTENT_END, sizeof( XI_HTTP_CONTENT_END ) );
+
+    return XI_CONTENT_BUFFER;
+
+err_handling:
+    return 0;
+}
+
+const char* http_construct_content_coding(
+          int32_t content_size
+        , const char* content_coding )
+{
+    // PRECONDITIONS
+    assert( content_coding != 0 );
+
+    int offset = http_construct_content_length( content_size );
+
+    if( offset == -1 ) { return 0; }
+
+    size_t coding_size = strlen( content_coding );
+
+    XI_CHECK_SIZE( offset + ( int ) ( sizeof( XI_HTTP_CONTENT_CODING ) - 1 + coding_size
+        + sizeof( XI_HTTP_CONTENT_END ) - 1 ), XI_CONTENT_BUFFER_SIZE
+        , XI_HTTP_CONSTRUCT_CONTENT_BUFFER_OVERRUN );
+
+    memcpy( XI_CONTENT_BUFFER + offset, XI_HTTP_CONTENT_CODING, sizeof( XI_HTTP_CONTENT_CODING ) - 1 );
+    offset += sizeof( XI_HTTP_CONTENT_CODING ) - 1;
+    memcpy( XI_CONTENT_BUFFER + offset, content_coding, coding_size );
+    offset += coding_size;
+    memcpy( XI_CONTENT_BUFFER + offset, XI_HTTP_CONTENT_END, sizeof( XI_HTTP_CONTENT_END ) );
+
     return XI_CONTENT_BUFFER;
 
 err_handling:
@@ -28,6 +28,13 @@ const char* http_construct_request_datapoint(
         , const char* dp_ts_str
         , const char* x_api_key );
 
+const char* http_construct_request_datapoints(
+          const char* http_method
+        , const int32_t* feed_id
+        , const char* datastream_id
+        , const char* query_suffix
+        , const char* x_api_key );
+
 const char* http_construct_request_datastream(
           const char* http_method
         , const int32_t* feed_id
@@ -40,9 +47,23 @@ const char* http_construct_request_feed(
         , const char* x_api_key
         , const char* query_suffix );
 
+/**
+ * \brief   Sets `If-None-Match` and `If-Modified-Since` headers (either may be null)
+ *          for the next `GET` request constructed
+ *
+ * \return  0 on success or -1 if they didn't fit.
+ */
+int http_set_conditional_headers(
+          const char* etag
+        , const char* last_modified );
+
 const char* http_construct_content(
           int32_t content_size );
 
+const char* http_construct_content_coding(
+          int32_t content_size
+        , const char* content_coding );
+
 #ifdef __cplusplus
 }
 #endif
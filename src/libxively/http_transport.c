@@ -22,8 +22,46 @@ transport_layer_t* get_http_transport_layer( void )
         , &http_encode_delete_datastream
         , &http_encode_delete_datapoint
         , &http_encode_datapoint_delete_range
+        , &http_encode_get_datastream_history
         , &http_decode_reply
+        , &http_get_encoded_size
+        , 0 // replies come in order
+        , 0 // one reply per connection
+        , 0 // no session
+        , 0
+        , 0 // every request gets a reply
+        , &http_set_request_validators
+        , &http_send_body
+        , &http_read_body
     };
 
     return &__http_transport_layer;
 }
+
+transport_layer_t* get_http_pipelined_transport_layer( void )
+{
+    static transport_layer_t __http_pipelined_transport_layer =
+    {
+          &http_encode_update_feed
+        , &http_encode_get_feed
+        , &http_encode_create_datastream
+        , &http_encode_update_datastream
+        , &http_encode_get_datastream
+        , &http_encode_delete_datastream
+        , &http_encode_delete_datapoint
+        , &http_encode_datapoint_delete_range
+        , &http_encode_get_datastream_history
+        , &http_decode_reply
+        , &http_get_encoded_size
+        , 0 // replies come in order
+        , &http_reply_size
+        , 0 // no session
+        , 0
+        , 0 // every request gets a reply
+        , &http_set_request_validators
+        , &http_send_body
+        , 0 // replies are read whole
+    };
+
+    return &__http_pipelined_transport_layer;
+}
@@ -28,6 +28,12 @@ extern "C" {
  */
 transport_layer_t* get_http_transport_layer( void );
 
+/**
+ * \brief   Same as `get_http_transport_layer()`, but replies are framed by `Content-Length`,
+ *          so many of them can be read from one connection
+ */
+transport_layer_t* get_http_pipelined_transport_layer( void );
+
 #ifdef __cplusplus
 }
 #endif
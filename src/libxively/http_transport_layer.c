@@ -18,13 +18,41 @@
 #include "xi_macros.h"
 #include "xi_helpers.h"
 #include "xi_err.h"
+#include "xi_globals.h"
+#include "http_content_encoding.h"
 
 static char XI_HTTP_QUERY_BUFFER[ XI_QUERY_BUFFER_SIZE + XI_CONTENT_BUFFER_SIZE ];
 static char XI_HTTP_QUERY_DATA[ XI_CONTENT_BUFFER_SIZE ];
+static size_t XI_HTTP_QUERY_SIZE = 0;
+
+// the body sent after the request, see `http_send_body()`: either the update of a feed
+// too big for `XI_HTTP_QUERY_DATA` or a buffered body that is deflated on its way out
+static const xi_feed_t* XI_HTTP_STREAMED_FEED = 0;
+static const data_layer_t* XI_HTTP_STREAMED_DATA_LAYER = 0;
+static const char* XI_HTTP_DEFLATED_DATA = 0;
+static size_t XI_HTTP_DEFLATED_DATA_SIZE = 0;
+static int XI_HTTP_DEFLATED_BODY = 0;
+
+// where the body sent after the request goes, without a connection it's only measured
+typedef struct
+{
+    const comm_layer_t*     comm_layer;
+    connection_t*           conn;
+    int                     size;
+    int                     content_size;   // before compression
+} http_body_sink_t;
 
+inline static void http_clear_body( void )
+{
+    XI_HTTP_STREAMED_FEED   = 0;
+    XI_HTTP_DEFLATED_DATA   = 0;
+    XI_HTTP_DEFLATED_BODY   = 0;
+}
 
+// `data` may be binary, hence the size, it may also live in `buffer` past the headers
 inline static char* http_encode_concat( char* buffer, size_t buffer_size
-    , const char* query, const char* content, const char* data )
+    , const char* query, const char* content
+    , const char* data, size_t data_size )
 {
     int offset  = 0;
     int size    = ( int ) buffer_size;
@@ -49,10 +77,10 @@ inline static char* http_encode_concat( char* buffer, size_t buffer_size
 
     if( content != 0 && data != 0 )
     {
-        s = snprintf( buffer + offset
-                          , XI_MAX( size - offset, 0 )
-                          , "%s", data );
-        XI_CHECK_S( s, size, offset, XI_HTTP_ENCODE_CREATE_DATASTREAM );
+        s = ( int ) data_size;
+        XI_CHECK_SIZE( s, size - offset, XI_HTTP_ENCODE_CREATE_DATASTREAM );
+        memmove( buffer + offset, data, data_size );
+        offset += s;
     }
 
     s = snprintf( buffer + offset
@@ -61,12 +89,133 @@ inline static char* http_encode_concat( char* buffer, size_t buffer_size
 
     XI_CHECK_S( s, size, offset, XI_HTTP_ENCODE_CREATE_DATASTREAM );
 
+    XI_HTTP_QUERY_SIZE      = offset;
+
+    http_clear_body();
+
     return buffer;
 
 err_handling:
     return 0;
 }
 
+static int http_body_sink( const char* data, size_t data_size, void* user_data )
+{
+    http_body_sink_t* sink = ( http_body_sink_t* ) user_data;
+
+    if( sink->comm_layer && sink->comm_layer->send_data( sink->conn, data, data_size ) == -1 )
+    {
+        return -1;
+    }
+
+    sink->size += ( int ) data_size;
+
+    return 0;
+}
+
+// a piece of the body, which goes through the deflater if the body is compressed
+static int http_body_write( http_body_sink_t* sink, const char* data, size_t data_size )
+{
+    sink->content_size += ( int ) data_size;
+
+    if( XI_HTTP_DEFLATED_BODY ) { return http_deflate_write( data, data_size ); }
+
+    return http_body_sink( data, data_size, sink );
+}
+
+static int http_stream_feed_body( http_body_sink_t* sink
+    , const data_layer_t* data_layer, const xi_feed_t* feed );
+
+// sends the body or only measures it, the deflater, if any, gives its output away in windows
+// of `XI_HTTP_STREAM_CHUNK_SIZE` bytes, so the deflated body is never in memory as a whole
+static int http_put_body( http_body_sink_t* sink )
+{
+    char window[ XI_HTTP_STREAM_CHUNK_SIZE ];
+    int s = 0;
+
+    if( XI_HTTP_DEFLATED_BODY )
+    {
+        s = http_deflate_begin( XI_HTTP_CODING_GZIP, window, sizeof( window ), &http_body_sink, sink );
+    }
+
+    if( s != -1 )
+    {
+        s = XI_HTTP_STREAMED_FEED
+            ? http_stream_feed_body( sink, XI_HTTP_STREAMED_DATA_LAYER, XI_HTTP_STREAMED_FEED )
+            : http_body_write( sink, XI_HTTP_DEFLATED_DATA, XI_HTTP_DEFLATED_DATA_SIZE );
+    }
+
+    if( XI_HTTP_DEFLATED_BODY && http_deflate_end() == -1 ) { s = -1; }
+
+    return s == -1 ? -1 : sink->size;
+}
+
+// only the request line and the headers, the body is sent by `http_send_body()`
+static const char* http_encode_headers( const char* query, const char* content, xi_err_t err )
+{
+    int size    = sizeof( XI_HTTP_QUERY_BUFFER );
+    int s       = snprintf( XI_HTTP_QUERY_BUFFER, size, "%s%s%s", query, content, XI_HTTP_CRLF );
+
+    XI_CHECK_SIZE( s, size, err );
+
+    XI_HTTP_QUERY_SIZE = s;
+
+    return XI_HTTP_QUERY_BUFFER;
+
+err_handling:
+    return 0;
+}
+
+// puts together the request with a body, which gets compressed if it's big enough
+inline static const char* http_encode_concat_body(
+    const char* query, const char* data )
+{
+    size_t data_size        = strlen( data );
+    const char* content     = 0;
+
+#ifdef XI_ZLIB
+    if( xi_globals.request_compression != 0
+     && data_size >= xi_globals.request_compression )
+    {
+        // the body is deflated now only to learn its size, it's deflated
+        // once more by `http_send_body()`, straight into the connection
+        http_body_sink_t sink = { 0, 0, 0, 0 };
+
+        http_clear_body();
+
+        XI_HTTP_DEFLATED_DATA       = data;
+        XI_HTTP_DEFLATED_DATA_SIZE  = data_size;
+        XI_HTTP_DEFLATED_BODY       = 1;
+
+        int s = http_put_body( &sink );
+
+        // it's not worth it if the body didn't shrink
+        if( s != -1 && ( size_t ) s < data_size )
+        {
+            content = http_construct_content_coding( s, "gzip" );
+
+            if( content == 0 || http_encode_headers( query, content, XI_HTTP_ENCODE_CREATE_DATASTREAM ) == 0 )
+            {
+                http_clear_body();
+                return 0;
+            }
+
+            return XI_HTTP_QUERY_BUFFER;
+        }
+
+        // otherwise the body goes uncompressed
+        xi_set_err( XI_NO_ERR );
+    }
+#endif
+
+    content = http_construct_content( data_size );
+
+    if( content == 0 ) { return 0; }
+
+    return http_encode_concat( XI_HTTP_QUERY_BUFFER, sizeof( XI_HTTP_QUERY_BUFFER )
+        , query, content, data, data_size );
+}
+
 const char* http_encode_create_datastream(
           const data_layer_t* data_transport
         , const char* x_api_key
@@ -87,10 +236,7 @@ const char* http_encode_create_datastream(
 
     if( query == 0 ) { return 0; }
 
-    const char* content = http_construct_content( strlen( data ) );
-
-    return http_encode_concat( XI_HTTP_QUERY_BUFFER, sizeof( XI_HTTP_QUERY_BUFFER )
-        , query, content, data );
+    return http_encode_concat_body( query, data );
 }
 
 const char* http_encode_update_datastream(
@@ -114,10 +260,7 @@ const char* http_encode_update_datastream(
 
     if( query == 0 ) { return 0; }
 
-    const char* content = http_construct_content( strlen( data ) );
-
-    return http_encode_concat( XI_HTTP_QUERY_BUFFER, sizeof( XI_HTTP_QUERY_BUFFER )
-        , query, content, data );
+    return http_encode_concat_body( query, data );
 }
 
 const char* http_encode_get_datastream(
@@ -138,7 +281,7 @@ const char* http_encode_get_datastream(
     if( query == 0 ) { return 0; }
 
     return http_encode_concat( XI_HTTP_QUERY_BUFFER, sizeof( XI_HTTP_QUERY_BUFFER )
-        , query, 0, 0 );
+        , query, 0, 0, 0 );
 }
 
 const char* http_encode_delete_datastream(
@@ -159,7 +302,7 @@ const char* http_encode_delete_datastream(
     if( query == 0 ) { return 0; }
 
     return http_encode_concat( XI_HTTP_QUERY_BUFFER, sizeof( XI_HTTP_QUERY_BUFFER )
-        , query, 0, 0 );
+        , query, 0, 0, 0 );
 }
 
 const char* http_encode_delete_datapoint(
@@ -171,23 +314,16 @@ const char* http_encode_delete_datapoint(
 {
     XI_UNUSED( data_transport );
 
-    struct tm* ptm = xi_gmtime(
-        ( time_t* ) &o->timestamp.timestamp );
+    int offset  = 0;
+    int size    = sizeof( XI_HTTP_QUERY_BUFFER );
+
+    int s = snprintf( XI_HTTP_QUERY_BUFFER, size, "%s/datapoints/", datastream_id );
+    XI_CHECK_S( s, size, offset, XI_HTTP_ENCODE_DELETE_DATAPOINT );
 
-    int s = snprintf( XI_HTTP_QUERY_BUFFER
-        , sizeof( XI_HTTP_QUERY_BUFFER )
-        , "%s/datapoints/%04d-%02d-%02dT%02d:%02d:%02d.%06ldZ"
-        , datastream_id
-        , ptm->tm_year + 1900
-        , ptm->tm_mon + 1
-        , ptm->tm_mday
-        , ptm->tm_hour
-        , ptm->tm_min
-        , ptm->tm_sec
-        , o->timestamp.micro );
+    s = xi_timestamp_to_str( XI_HTTP_QUERY_BUFFER + offset, size - offset
+        , o->timestamp.timestamp, o->timestamp.micro );
 
-    XI_CHECK_SIZE( s, ( int ) sizeof( XI_HTTP_QUERY_BUFFER )
-        , XI_HTTP_ENCODE_DELETE_DATAPOINT );
+    XI_CHECK_SIZE( s, size - offset, XI_HTTP_ENCODE_DELETE_DATAPOINT );
 
     {
         // prepare parts
@@ -200,13 +336,126 @@ const char* http_encode_delete_datapoint(
         if( query == 0 ) { return 0; }
 
         return http_encode_concat( XI_HTTP_QUERY_BUFFER, sizeof( XI_HTTP_QUERY_BUFFER )
-            , query, 0, 0 );
+            , query, 0, 0, 0 );
     }
 
 err_handling:
     return 0;
 }
 
+// a line of the feed update body, the same as a line of a feed
+static int http_encode_feed_line( char* buffer, int size
+    , const data_layer_t* data_layer
+    , const char* datastream_id, const xi_datapoint_t* datapoint )
+{
+    int offset  = 0;
+    int s       = 0;
+
+    s = snprintf( buffer, XI_MAX( size, 0 ), "%s,", datastream_id );
+    XI_CHECK_S( s, size, offset, XI_HTTP_ENCODE_UPDATE_FEED );
+
+    s = data_layer->encode_datapoint_in_place( buffer + offset, XI_MAX( size - offset, 0 ), datapoint );
+    XI_CHECK_S( s, size, offset, XI_HTTP_ENCODE_UPDATE_FEED );
+
+    return offset;
+
+err_handling:
+    return -1;
+}
+
+// puts the lines of the feed update body in a chunk and writes it out whenever the next line doesn't fit
+static int http_stream_feed_body( http_body_sink_t* sink
+    , const data_layer_t* data_layer, const xi_feed_t* feed )
+{
+    char chunk[ XI_HTTP_STREAM_CHUNK_SIZE ];
+    int offset  = 0;
+
+    for( size_t i = 0; i < feed->datastream_count; ++i )
+    {
+        const xi_datastream_t* curr_datastream = &feed->datastreams[ i ];
+
+        for( size_t j = 0; j < curr_datastream->datapoint_count; ++j )
+        {
+            const xi_datapoint_t* curr_datapoint = &curr_datastream->datapoints[ j ];
+
+            int s = http_encode_feed_line( chunk + offset, sizeof( chunk ) - offset
+                , data_layer, curr_datastream->datastream_id, curr_datapoint );
+
+            if( s == -1 && offset > 0 )
+            {
+                // the line goes at the beginning of the next chunk
+                xi_set_err( XI_NO_ERR );
+
+                if( http_body_write( sink, chunk, offset ) == -1 ) { return -1; }
+
+                offset = 0;
+
+                s = http_encode_feed_line( chunk, sizeof( chunk )
+                    , data_layer, curr_datastream->datastream_id, curr_datapoint );
+            }
+
+            if( s == -1 ) { return -1; }
+
+            offset += s;
+        }
+    }
+
+    return http_body_write( sink, chunk, offset );
+}
+
+// only the request line and the headers, the body is measured now and sent by `http_send_body()`
+static const char* http_encode_streamed_update_feed(
+          const char* query
+        , const data_layer_t* data_layer
+        , const xi_feed_t* feed )
+{
+    http_body_sink_t sink = { 0, 0, 0, 0 };
+
+    http_clear_body();
+
+    XI_HTTP_STREAMED_FEED       = feed;
+    XI_HTTP_STREAMED_DATA_LAYER = data_layer;
+
+#ifdef XI_ZLIB
+    // the feed is deflated as it's measured, the size before compression comes with it
+    XI_HTTP_DEFLATED_BODY       = xi_globals.request_compression != 0;
+#endif
+
+    int body_size = http_put_body( &sink );
+
+#ifdef XI_ZLIB
+    if( XI_HTTP_DEFLATED_BODY && body_size == -1 )
+    {
+        // the body goes uncompressed then
+        xi_set_err( XI_NO_ERR );
+
+        XI_HTTP_DEFLATED_BODY   = 0;
+        sink.size               = 0;
+        body_size               = http_put_body( &sink );
+    }
+    else if( XI_HTTP_DEFLATED_BODY
+     && ( ( uint32_t ) sink.content_size < xi_globals.request_compression
+       || body_size >= sink.content_size ) )
+    {
+        // it's not worth it if the body didn't shrink
+        XI_HTTP_DEFLATED_BODY   = 0;
+        body_size               = sink.content_size;
+    }
+#endif
+
+    const char* content = body_size == -1 ? 0
+        : XI_HTTP_DEFLATED_BODY ? http_construct_content_coding( body_size, "gzip" )
+        : http_construct_content( body_size );
+
+    if( content == 0 || http_encode_headers( query, content, XI_HTTP_ENCODE_UPDATE_FEED ) == 0 )
+    {
+        http_clear_body();
+        return 0;
+    }
+
+    return XI_HTTP_QUERY_BUFFER;
+}
+
 const char* http_encode_update_feed(
           const data_layer_t* data_layer
         , const char* x_api_key
@@ -221,39 +470,26 @@ const char* http_encode_update_feed(
     assert( feed != 0 );
 
     // variables initialization
-    const char* content = 0;
     const char* query = 0;
+    int s             = 0;
 
     { // data part preparation
         int offset  = 0;
         int size    = sizeof( XI_HTTP_QUERY_DATA );
-        int s       = 0;
 
         // for each datastream
         //      generate the list of datapoints that you want to update
-        for( size_t i = 0; i < feed->datastream_count; ++i )
+        for( size_t i = 0; i < feed->datastream_count && s != -1; ++i )
         {
             const xi_datastream_t* curr_datastream = &feed->datastreams[ i ];
 
             // for each datapoint
-            for( size_t j = 0; j < curr_datastream->datapoint_count; ++j )
+            for( size_t j = 0; j < curr_datastream->datapoint_count && s != -1; ++j )
             {
-                const xi_datapoint_t* curr_datapoint
-                    = &curr_datastream->datapoints[ j ];
+                s = http_encode_feed_line( XI_HTTP_QUERY_DATA + offset, size - offset
+                    , data_layer, curr_datastream->datastream_id, &curr_datastream->datapoints[ j ] );
 
-                // add the datastream id to the buffer
-                s = snprintf(
-                      XI_HTTP_QUERY_DATA + offset, XI_MAX( size - offset, 0 ), "%s,"
-                    , curr_datastream->datastream_id );
-
-                XI_CHECK_S( s, size, offset, XI_HTTP_ENCODE_UPDATE_FEED );
-
-                // add the datapoint data to the buffer
-                s = data_layer->encode_datapoint_in_place(
-                      XI_HTTP_QUERY_DATA + offset, XI_MAX( size - offset, 0 )
-                    , curr_datapoint );
-
-                XI_CHECK_S( s, size, offset, XI_HTTP_ENCODE_UPDATE_FEED );
+                if( s != -1 ) { offset += s; }
             }
         }
     }
@@ -267,15 +503,57 @@ const char* http_encode_update_feed(
 
     if( query == 0 ) { goto err_handling; }
 
-    content = http_construct_content( strlen( XI_HTTP_QUERY_DATA ) );
+    if( s != -1 ) { return http_encode_concat_body( query, XI_HTTP_QUERY_DATA ); }
 
-    return http_encode_concat( XI_HTTP_QUERY_BUFFER, sizeof( XI_HTTP_QUERY_BUFFER )
-        , query, content, XI_HTTP_QUERY_DATA );
+    // the body doesn't fit in the buffer, so it follows the request in chunks
+    xi_set_err( XI_NO_ERR );
+
+    return http_encode_streamed_update_feed( query, data_layer, feed );
 
 err_handling:
     return 0;
 }
 
+int http_send_body( const comm_layer_t* comm_layer, connection_t* conn )
+{
+    // PRECONDITIONS
+    assert( comm_layer != 0 );
+    assert( conn != 0 );
+
+    if( XI_HTTP_STREAMED_FEED == 0 && XI_HTTP_DEFLATED_DATA == 0 ) { return 0; }
+
+    http_body_sink_t sink = { comm_layer, conn, 0, 0 };
+
+    if( http_put_body( &sink ) == -1 ) { return -1; }
+
+    // the request ends the way the buffered ones do
+    return comm_layer->send_data( conn, XI_HTTP_CRLF, sizeof( XI_HTTP_CRLF ) - 1 ) == -1 ? -1 : 0;
+}
+
+int http_read_body( const comm_layer_t* comm_layer, connection_t* conn
+    , char* buffer, size_t buffer_size )
+{
+    // PRECONDITIONS
+    assert( comm_layer != 0 );
+    assert( conn != 0 );
+    assert( buffer != 0 );
+
+    while( http_content_left() > 0 )
+    {
+        // not a byte past the content, the next reply may follow it
+        int recv = comm_layer->read_data( conn, buffer, XI_MIN( buffer_size, http_content_left() ) );
+
+        XI_CHECK_CND( recv <= 0, XI_SOCKET_READ_ERROR );
+
+        if( parse_http_content( buffer, recv ) == -1 ) { return -1; }
+    }
+
+    return 0;
+
+err_handling:
+    return -1;
+}
+
 const char* http_encode_get_feed(
         const data_layer_t* data_layer
       , const char* x_api_key
@@ -322,7 +600,7 @@ const char* http_encode_get_feed(
     if( query == 0 ) { goto err_handling; }
 
     return http_encode_concat( XI_HTTP_QUERY_BUFFER, sizeof( XI_HTTP_QUERY_BUFFER )
-        , query, 0, 0 );
+        , query, 0, 0, 0 );
 
 err_handling:
     return 0;
@@ -338,95 +616,254 @@ const char* http_encode_datapoint_delete_range(
 {
     XI_UNUSED( data_layer );
 
-    struct tm stm;
-    struct tm etm;
+    int offset  = 0;
+    int size    = sizeof( XI_HTTP_QUERY_BUFFER );
+    int s       = 0;
 
-    {
-        struct tm* tmp = start ? xi_gmtime(
-            ( time_t* ) &start->timestamp ) : 0;
-        memcpy( &stm, tmp, sizeof( struct tm ) );
-    }
+    XI_CHECK_CND( start == 0 && end == 0, XI_HTTP_ENCODE_DELETE_RANGE_DATAPOINT );
+
+    s = snprintf( XI_HTTP_QUERY_BUFFER, size, "%s/datapoints?%s", datastream_id
+        , start ? "start=" : "end=" );
+    XI_CHECK_S( s, size, offset, XI_HTTP_ENCODE_DELETE_RANGE_DATAPOINT );
 
+    if( start )
     {
-        struct tm* tmp = end ? xi_gmtime(
-            ( time_t* ) &end->timestamp ) : 0;
-        memcpy( &etm, tmp, sizeof( struct tm ) );
-    }
+        s = xi_timestamp_to_str( XI_HTTP_QUERY_BUFFER + offset, size - offset
+            , start->timestamp, start->micro );
+        XI_CHECK_S( s, size, offset, XI_HTTP_ENCODE_DELETE_RANGE_DATAPOINT );
 
-    int s = 0;
+        if( end )
+        {
+            s = snprintf( XI_HTTP_QUERY_BUFFER + offset, size - offset, "&end=" );
+            XI_CHECK_S( s, size, offset, XI_HTTP_ENCODE_DELETE_RANGE_DATAPOINT );
+        }
+    }
 
-    if( start && end )
+    if( end )
     {
-        s = snprintf( XI_HTTP_QUERY_BUFFER
-            , sizeof( XI_HTTP_QUERY_BUFFER )
-            , "%s/datapoints?start=%04d-%02d-%02dT%02d:%02d:%02d.%06ldZ&end=%04d-%02d-%02dT%02d:%02d:%02d.%06ldZ"
-            , datastream_id
-            , stm.tm_year + 1900, stm.tm_mon + 1, stm.tm_mday
-            , stm.tm_hour, stm.tm_min, stm.tm_sec, start->micro
-            , etm.tm_year + 1900, etm.tm_mon + 1, etm.tm_mday
-            , etm.tm_hour, etm.tm_min, etm.tm_sec, end->micro );
+        s = xi_timestamp_to_str( XI_HTTP_QUERY_BUFFER + offset, size - offset
+            , end->timestamp, end->micro );
+        XI_CHECK_S( s, size, offset, XI_HTTP_ENCODE_DELETE_RANGE_DATAPOINT );
     }
-    else if( start )
+
     {
-        s = snprintf( XI_HTTP_QUERY_BUFFER
-            , sizeof( XI_HTTP_QUERY_BUFFER )
-            , "%s/datapoints?start=%04d-%02d-%02dT%02d:%02d:%02d.%06ldZ"
-            , datastream_id
-            , stm.tm_year + 1900, stm.tm_mon + 1, stm.tm_mday
-            , stm.tm_hour, stm.tm_min, stm.tm_sec, start->micro );
+        // prepare parts
+        const char* query = http_construct_request_datastream(
+                  XI_HTTP_QUERY_DELETE
+                , &feed_id
+                , XI_HTTP_QUERY_BUFFER
+                , x_api_key );
+
+        if( query == 0 ) { return 0; }
+
+        return http_encode_concat( XI_HTTP_QUERY_BUFFER, sizeof( XI_HTTP_QUERY_BUFFER )
+            , query, 0, 0, 0 );
     }
-    else if( end )
+
+err_handling:
+    return 0;
+}
+
+const char* http_encode_get_datastream_history(
+        const data_layer_t* data_layer
+      , const char* x_api_key
+      , int32_t feed_id
+      , const char* datastream_id
+      , const xi_timestamp_t* start
+      , const xi_timestamp_t* end
+      , uint32_t interval
+      , uint32_t limit )
+{
+    XI_UNUSED( data_layer );
+
+    // PRECONDITIONS
+    assert( start != 0 );
+
+    int offset  = 0;
+    int size    = sizeof( XI_HTTP_QUERY_BUFFER );
+    int s       = 0;
+
+    // the query string is rendered first, it is then copied into the request line
+    s = snprintf( XI_HTTP_QUERY_BUFFER, size, "?start=" );
+    XI_CHECK_S( s, size, offset, XI_HTTP_ENCODE_GET_DATASTREAM );
+
+    s = xi_timestamp_to_str( XI_HTTP_QUERY_BUFFER + offset, size - offset
+        , start->timestamp, start->micro );
+    XI_CHECK_S( s, size, offset, XI_HTTP_ENCODE_GET_DATASTREAM );
+
+    if( end )
     {
-        s = snprintf( XI_HTTP_QUERY_BUFFER
-            , sizeof( XI_HTTP_QUERY_BUFFER )
-            , "%s/datapoints?end=%04d-%02d-%02dT%02d:%02d:%02d.%06ldZ"
-            , datastream_id
-            , etm.tm_year + 1900, etm.tm_mon + 1, etm.tm_mday
-            , etm.tm_hour, etm.tm_min, etm.tm_sec, end->micro );
+        s = snprintf( XI_HTTP_QUERY_BUFFER + offset, size - offset, "&end=" );
+        XI_CHECK_S( s, size, offset, XI_HTTP_ENCODE_GET_DATASTREAM );
+
+        s = xi_timestamp_to_str( XI_HTTP_QUERY_BUFFER + offset, size - offset
+            , end->timestamp, end->micro );
+        XI_CHECK_S( s, size, offset, XI_HTTP_ENCODE_GET_DATASTREAM );
     }
-    else
+
+    if( interval )
     {
-        // just set an error
-        XI_CHECK_CND( 1 == 0, XI_HTTP_ENCODE_DELETE_RANGE_DATAPOINT );
+        s = snprintf( XI_HTTP_QUERY_BUFFER + offset, size - offset
+            , "&interval=%lu", ( unsigned long ) interval );
+        XI_CHECK_S( s, size, offset, XI_HTTP_ENCODE_GET_DATASTREAM );
     }
 
-    XI_CHECK_SIZE( s, ( int ) sizeof( XI_HTTP_QUERY_BUFFER )
-        , XI_HTTP_ENCODE_DELETE_RANGE_DATAPOINT );
+    s = snprintf( XI_HTTP_QUERY_BUFFER + offset, size - offset
+        , "&limit=%lu", ( unsigned long ) limit );
+    XI_CHECK_S( s, size, offset, XI_HTTP_ENCODE_GET_DATASTREAM );
 
     {
         // prepare parts
-        const char* query = http_construct_request_datastream(
-                  XI_HTTP_QUERY_DELETE
+        const char* query = http_construct_request_datapoints(
+                  XI_HTTP_QUERY_GET
                 , &feed_id
+                , datastream_id
                 , XI_HTTP_QUERY_BUFFER
                 , x_api_key );
 
         if( query == 0 ) { return 0; }
 
         return http_encode_concat( XI_HTTP_QUERY_BUFFER, sizeof( XI_HTTP_QUERY_BUFFER )
-            , query, 0, 0 );
+            , query, 0, 0, 0 );
     }
 
 err_handling:
     return 0;
 }
 
+// everything between the request line and the values known only at run time
+static const char XI_HTTP_STATIC_HEADERS[] =
+    "Host: " XI_HOST "\r\n"
+    "User-Agent: " XI_USER_AGENT "\r\n"
+    "Accept: */*\r\n"
+    "X-ApiKey: ";
+
+#ifdef XI_ZLIB
+static const char XI_HTTP_STATIC_ACCEPT_ENCODING[] =
+    "\r\nAccept-Encoding: gzip, deflate";
+#endif
+
+static const char XI_HTTP_STATIC_CONTENT_HEADERS[] =
+    "\r\nContent-Type: text/plain\r\n"
+    "Content-Length: ";
+
+inline static char* http_append( char* dst, const char* src, size_t size )
+{
+    memcpy( dst, src, size );
+    return dst + size;
+}
+
+const char* http_encode_update_datastream_static(
+        const data_layer_t* data_layer
+      , const char* x_api_key
+      , const xi_static_request_t* request
+      , const xi_datapoint_t* datapoint )
+{
+    // PRECONDITIONS
+    assert( request != 0 );
+    assert( request->request_line != 0 );
+
+    const char* data = data_layer->encode_datapoint( datapoint );
+
+    if( data == 0 ) { return 0; }
+
+    size_t data_size        = strlen( data );
+    size_t api_key_size     = x_api_key ? strlen( x_api_key ) : 0;
+    size_t extra_size       = 0;
+    char length[ 12 ];
+
+#ifdef XI_ZLIB
+    // a body worth compressing gets its headers put together at run time
+    if( xi_globals.request_compression != 0
+     && data_size >= xi_globals.request_compression )
+    {
+        int32_t feed_id = request->feed_id;
+
+        const char* query = http_construct_request_datastream(
+                  XI_HTTP_QUERY_PUT
+                , &feed_id
+                , request->datastream_id
+                , x_api_key );
+
+        if( query == 0 ) { return 0; }
+
+        return http_encode_concat_body( query, data );
+    }
+
+    if( xi_globals.response_compression )
+    {
+        extra_size = sizeof( XI_HTTP_STATIC_ACCEPT_ENCODING ) - 1;
+    }
+#endif
+
+    size_t length_size      = xi_int_to_str( length, sizeof( length ), ( int32_t ) data_size );
+
+    XI_CHECK_CND( request->request_line_size + sizeof( XI_HTTP_STATIC_HEADERS ) + api_key_size
+        + extra_size + sizeof( XI_HTTP_STATIC_CONTENT_HEADERS ) + length_size + 4 + data_size + 2
+        >= sizeof( XI_HTTP_QUERY_BUFFER ), XI_HTTP_CONSTRUCT_REQUEST_BUFFER_OVERRUN );
+
+    {
+        char* p = XI_HTTP_QUERY_BUFFER;
+
+        p = http_append( p, request->request_line, request->request_line_size );
+        p = http_append( p, XI_HTTP_STATIC_HEADERS, sizeof( XI_HTTP_STATIC_HEADERS ) - 1 );
+        p = http_append( p, x_api_key, api_key_size );
+#ifdef XI_ZLIB
+        p = http_append( p, XI_HTTP_STATIC_ACCEPT_ENCODING, extra_size );
+#endif
+        p = http_append( p, XI_HTTP_STATIC_CONTENT_HEADERS, sizeof( XI_HTTP_STATIC_CONTENT_HEADERS ) - 1 );
+        p = http_append( p, length, length_size );
+        p = http_append( p, "\r\n\r\n", 4 );
+        p = http_append( p, data, data_size );
+        p = http_append( p, XI_HTTP_CRLF, 2 );
+        *p = '\0';
+
+        XI_HTTP_QUERY_SIZE      = p - XI_HTTP_QUERY_BUFFER;
+
+        http_clear_body();
+    }
+
+    return XI_HTTP_QUERY_BUFFER;
+
+err_handling:
+    return 0;
+}
+
+int http_set_request_validators(
+        const char* etag
+      , const char* last_modified )
+{
+    return http_set_conditional_headers( etag, last_modified );
+}
 
 const xi_response_t* http_decode_reply(
           const data_layer_t* data_layer
-        , const char* response )
+        , const char* response
+        , size_t response_size )
 {
     XI_UNUSED( data_layer );
 
-    static xi_response_t  __tmp;
-    static http_response_t* __response = &__tmp.http;
+    xi_response_t* __tmp = get_transport_response();
 
     // just pass it further
-    if( parse_http( __response, response ) == 0 )
+    if( parse_http_lazy( &__tmp->http, response, response_size ) == 0 )
     {
         return 0;
     }
 
+    // over HTTP there is nothing to match it with
+    __tmp->request_id = 0;
+
     // pass it to the data_layer
-    return &__tmp;
+    return __tmp;
+}
+
+int http_reply_size( const char* data, size_t data_size )
+{
+    return parse_http_reply_size( data, data_size );
+}
+
+size_t http_get_encoded_size( void )
+{
+    return XI_HTTP_QUERY_SIZE;
 }
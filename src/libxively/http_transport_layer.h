@@ -12,6 +12,7 @@
 
 #include "xively.h"
 #include "data_layer.h"
+#include "comm_layer.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -68,9 +69,66 @@ const char* http_encode_datapoint_delete_range(
       , const xi_timestamp_t* start
       , const xi_timestamp_t* end );
 
+const char* http_encode_get_datastream_history(
+        const data_layer_t*
+      , const char* x_api_key
+      , int32_t feed_id
+      , const char* datastream_id
+      , const xi_timestamp_t* start
+      , const xi_timestamp_t* end
+      , uint32_t interval
+      , uint32_t limit );
+
+/**
+ * \brief   Encodes datastream update behind the request line made by `XI_STATIC_DATASTREAM_UPDATE()`
+ *
+ *    The rest of the headers are the same for every such request, so apart from
+ *    the value only the API key, `Content-Length` and `Accept-Encoding` (when
+ *    asking for compressed responses) are put in at run time. A body big enough
+ *    to be compressed goes through `http_encode_update_datastream()` instead, so
+ *    the request is the same as the one of `xi_datastream_update()`.
+ */
+const char* http_encode_update_datastream_static(
+        const data_layer_t*
+      , const char* x_api_key
+      , const xi_static_request_t* request
+      , const xi_datapoint_t* value );
+
+int http_set_request_validators(
+        const char* etag
+      , const char* last_modified );
+
+int http_reply_size( const char* data, size_t data_size );
+
 const xi_response_t* http_decode_reply(
           const data_layer_t*
-        , const char* data );
+        , const char* data
+        , size_t data_size );
+
+size_t http_get_encoded_size( void );
+
+/**
+ * \brief   Sends the body of a feed update that didn't fit in `XI_CONTENT_BUFFER_SIZE`
+ *          or of a request compressed as `xi_set_request_compression()` says
+ *
+ *    The encoders put only the headers of such requests in the buffer, with
+ *    `Content-Length` of the whole body, and the body is then encoded again in
+ *    chunks of `XI_HTTP_STREAM_CHUNK_SIZE` bytes which are sent one by one, so the
+ *    feed must not change in between. A compressed body is deflated once by the
+ *    encoder to measure it and once more here, a window of the same size at a time,
+ *    which goes for the feed update body as well.
+ */
+int http_send_body( const comm_layer_t*, connection_t* );
+
+/**
+ * \brief   Reads the rest of the content of the reply decoded last, which is copied or
+ *          inflated straight into its `http_content` a buffer at a time
+ *
+ *    The reply buffer is not big enough for every compressed body, so the part of the
+ *    body that came with the headers is inflated by `http_decode_reply()` and the rest
+ *    of it, as long as `Content-Length` tells, is read here.
+ */
+int http_read_body( const comm_layer_t*, connection_t*, char* buffer, size_t buffer_size );
 
 #ifdef __cplusplus
 }
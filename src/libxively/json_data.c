@@ -0,0 +1,826 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    json_data.c
+ * \brief   Implements JSON _data layer_ encoders and decoders specific to Xively JSON data format [see json_data.h]
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "json_data.h"
+#include "csv_data.h"
+#include "data_layer.h"
+#include "xi_macros.h"
+#include "xi_helpers.h"
+#include "xi_err.h"
+#include "xi_consts.h"
+
+static char XI_JSON_LOCAL_BUFFER[ XI_JSON_BUFFER_SIZE ];
+
+// what may come next in the document
+typedef enum
+{
+    XI_JSON_EXPECT_VALUE = 0,
+    XI_JSON_EXPECT_VALUE_OR_END,
+    XI_JSON_EXPECT_KEY,
+    XI_JSON_EXPECT_KEY_OR_END,
+    XI_JSON_EXPECT_COMMA_OR_END,
+    XI_JSON_EXPECT_DONE,
+    XI_JSON_EXPECT_NOTHING
+} json_expect_t;
+
+#define XI_JSON_MAX_DEPTH 32
+
+#define XI_JSON_IN_OBJECT( t ) ( ( t )->objects & 1u )
+
+#define XI_JSON_KEY_IS( token, key ) \
+    ( ( token )->size == sizeof( key ) - 1 && memcmp( ( token )->value, key, sizeof( key ) - 1 ) == 0 )
+
+//-----------------------------------------------------------------------
+// TOKENIZER
+//-----------------------------------------------------------------------
+
+void json_tokenizer_init( json_tokenizer_t* tokenizer, const char* data, size_t data_size )
+{
+    // PRECONDITIONS
+    assert( tokenizer != 0 );
+    assert( data != 0 );
+
+    tokenizer->data     = data;
+    tokenizer->size     = data_size;
+    tokenizer->offset   = 0;
+    tokenizer->depth    = 0;
+    tokenizer->objects  = 0;
+    tokenizer->expect   = XI_JSON_EXPECT_VALUE;
+}
+
+inline static int json_is_digit( char c )
+{
+    return ( unsigned char ) ( c - '0' ) < 10;
+}
+
+static void json_skip_blanks( json_tokenizer_t* t )
+{
+    while( t->offset < t->size )
+    {
+        char c = t->data[ t->offset ];
+
+        if( c != ' ' && c != '\t' && c != '\n' && c != '\r' ) { break; }
+
+        ++t->offset;
+    }
+}
+
+static json_token_type_t json_fail( json_tokenizer_t* t, json_token_t* token )
+{
+    t->expect   = XI_JSON_EXPECT_NOTHING;
+    token->type = XI_JSON_TOKEN_ERROR;
+
+    return token->type;
+}
+
+static void json_value_done( json_tokenizer_t* t )
+{
+    t->expect = t->depth ? XI_JSON_EXPECT_COMMA_OR_END : XI_JSON_EXPECT_DONE;
+}
+
+// the string starts at the quote, escapes are only stepped over
+static int json_read_string( json_tokenizer_t* t, json_token_t* token )
+{
+    size_t i = t->offset + 1;
+
+    for( ; i < t->size; ++i )
+    {
+        char c = t->data[ i ];
+
+        if( c == '"' )
+        {
+            token->value    = t->data + t->offset + 1;
+            token->size     = i - t->offset - 1;
+            t->offset       = i + 1;
+
+            return 0;
+        }
+
+        if( ( unsigned char ) c < 0x20 ) { return -1; }
+
+        if( c == '\\' ) { ++i; }
+    }
+
+    return -1;
+}
+
+static int json_read_number( json_tokenizer_t* t, json_token_t* token )
+{
+    const char* p   = t->data;
+    size_t i        = t->offset;
+    size_t size     = t->size;
+
+    if( i < size && p[ i ] == '-' ) { ++i; }
+
+    if( i < size && p[ i ] == '0' )
+    {
+        ++i;
+    }
+    else
+    {
+        if( i == size || !json_is_digit( p[ i ] ) ) { return -1; }
+        while( i < size && json_is_digit( p[ i ] ) ) { ++i; }
+    }
+
+    if( i < size && p[ i ] == '.' )
+    {
+        if( ++i == size || !json_is_digit( p[ i ] ) ) { return -1; }
+        while( i < size && json_is_digit( p[ i ] ) ) { ++i; }
+    }
+
+    if( i < size && ( p[ i ] == 'e' || p[ i ] == 'E' ) )
+    {
+        if( ++i < size && ( p[ i ] == '+' || p[ i ] == '-' ) ) { ++i; }
+        if( i == size || !json_is_digit( p[ i ] ) ) { return -1; }
+        while( i < size && json_is_digit( p[ i ] ) ) { ++i; }
+    }
+
+    token->value    = p + t->offset;
+    token->size     = i - t->offset;
+    t->offset       = i;
+
+    return 0;
+}
+
+static int json_read_literal( json_tokenizer_t* t, json_token_t* token )
+{
+    static const char* const literals[] = { "true", "false", "null" };
+
+    for( size_t i = 0; i < sizeof( literals ) / sizeof( literals[ 0 ] ); ++i )
+    {
+        size_t size = strlen( literals[ i ] );
+
+        if( t->size - t->offset >= size && memcmp( t->data + t->offset, literals[ i ], size ) == 0 )
+        {
+            token->value    = t->data + t->offset;
+            token->size     = size;
+            t->offset      += size;
+
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+static json_token_type_t json_close( json_tokenizer_t* t, json_token_t* token )
+{
+    token->type     = XI_JSON_IN_OBJECT( t ) ? XI_JSON_TOKEN_OBJECT_END : XI_JSON_TOKEN_ARRAY_END;
+    token->size     = 1;
+    t->objects    >>= 1;
+    t->offset      += 1;
+    t->depth       -= 1;
+
+    json_value_done( t );
+
+    return token->type;
+}
+
+json_token_type_t json_next_token( json_tokenizer_t* t, json_token_t* token )
+{
+    // PRECONDITIONS
+    assert( t != 0 );
+    assert( token != 0 );
+
+    json_skip_blanks( t );
+
+    token->value    = t->data + t->offset;
+    token->size     = 0;
+
+    if( t->expect == XI_JSON_EXPECT_NOTHING ) { return json_fail( t, token ); }
+
+    if( t->offset == t->size )
+    {
+        if( t->expect != XI_JSON_EXPECT_DONE ) { return json_fail( t, token ); }
+
+        token->type = XI_JSON_TOKEN_END;
+        return token->type;
+    }
+
+    char c = t->data[ t->offset ];
+
+    switch( t->expect )
+    {
+        case XI_JSON_EXPECT_DONE:
+            return json_fail( t, token );
+        case XI_JSON_EXPECT_COMMA_OR_END:
+            if( c == ( XI_JSON_IN_OBJECT( t ) ? '}' : ']' ) ) { return json_close( t, token ); }
+            if( c != ',' ) { return json_fail( t, token ); }
+
+            ++t->offset;
+            json_skip_blanks( t );
+
+            if( t->offset == t->size ) { return json_fail( t, token ); }
+
+            c               = t->data[ t->offset ];
+            token->value    = t->data + t->offset;
+            t->expect       = XI_JSON_IN_OBJECT( t ) ? XI_JSON_EXPECT_KEY : XI_JSON_EXPECT_VALUE;
+            break;
+        case XI_JSON_EXPECT_KEY_OR_END:
+            if( c == '}' ) { return json_close( t, token ); }
+            break;
+        case XI_JSON_EXPECT_VALUE_OR_END:
+            if( c == ']' ) { return json_close( t, token ); }
+            break;
+        default:
+            break;
+    }
+
+    if( t->expect == XI_JSON_EXPECT_KEY || t->expect == XI_JSON_EXPECT_KEY_OR_END )
+    {
+        if( c != '"' || json_read_string( t, token ) == -1 ) { return json_fail( t, token ); }
+
+        json_skip_blanks( t );
+
+        if( t->offset == t->size || t->data[ t->offset ] != ':' ) { return json_fail( t, token ); }
+
+        ++t->offset;
+        t->expect   = XI_JSON_EXPECT_VALUE;
+        token->type = XI_JSON_TOKEN_KEY;
+
+        return token->type;
+    }
+
+    switch( c )
+    {
+        case '{':
+        case '[':
+            if( t->depth == XI_JSON_MAX_DEPTH ) { return json_fail( t, token ); }
+
+            t->objects  = ( t->objects << 1 ) | ( c == '{' );
+            t->depth   += 1;
+            t->offset  += 1;
+            t->expect   = c == '{' ? XI_JSON_EXPECT_KEY_OR_END : XI_JSON_EXPECT_VALUE_OR_END;
+            token->size = 1;
+            token->type = c == '{' ? XI_JSON_TOKEN_OBJECT_BEGIN : XI_JSON_TOKEN_ARRAY_BEGIN;
+
+            return token->type;
+        case '"':
+            if( json_read_string( t, token ) == -1 ) { return json_fail( t, token ); }
+            token->type = XI_JSON_TOKEN_STRING;
+            break;
+        case 't':
+        case 'f':
+        case 'n':
+            if( json_read_literal( t, token ) == -1 ) { return json_fail( t, token ); }
+            token->type = XI_JSON_TOKEN_LITERAL;
+            break;
+        default:
+            if( json_read_number( t, token ) == -1 ) { return json_fail( t, token ); }
+            token->type = XI_JSON_TOKEN_NUMBER;
+            break;
+    }
+
+    json_value_done( t );
+
+    return token->type;
+}
+
+static int32_t json_read_hex4( const char* p, size_t available )
+{
+    int32_t value = 0;
+
+    if( available < 4 ) { return -1; }
+
+    for( int i = 0; i < 4; ++i )
+    {
+        char c = p[ i ];
+
+        value <<= 4;
+
+        if( json_is_digit( c ) )            { value |= c - '0'; }
+        else if( c >= 'a' && c <= 'f' )     { value |= c - 'a' + 10; }
+        else if( c >= 'A' && c <= 'F' )     { value |= c - 'A' + 10; }
+        else                                { return -1; }
+    }
+
+    return value;
+}
+
+int json_copy_string( char* buffer, size_t buffer_size, const json_token_t* token )
+{
+    // PRECONDITIONS
+    assert( buffer != 0 );
+    assert( buffer_size != 0 );
+    assert( token != 0 );
+
+    const char* p   = token->value;
+    size_t size     = token->size;
+    size_t n        = 0;
+
+    for( size_t i = 0; i < size; ++i )
+    {
+        char c = p[ i ];
+
+        if( c == '\\' )
+        {
+            if( ++i == size ) { return -1; }
+
+            switch( p[ i ] )
+            {
+                case '"':   c = '"';    break;
+                case '\\':  c = '\\';   break;
+                case '/':   c = '/';    break;
+                case 'b':   c = '\b';   break;
+                case 'f':   c = '\f';   break;
+                case 'n':   c = '\n';   break;
+                case 'r':   c = '\r';   break;
+                case 't':   c = '\t';   break;
+                case 'u':
+                {
+                    int32_t cp = json_read_hex4( p + i + 1, size - i - 1 );
+
+                    if( cp == -1 ) { return -1; }
+
+                    i += 4;
+
+                    // a character beyond the first plane comes as a pair of surrogates
+                    if( cp >= 0xD800 && cp <= 0xDBFF )
+                    {
+                        if( size - i - 1 < 6 || p[ i + 1 ] != '\\' || p[ i + 2 ] != 'u' ) { return -1; }
+
+                        int32_t low = json_read_hex4( p + i + 3, 4 );
+
+                        if( low < 0xDC00 || low > 0xDFFF ) { return -1; }
+
+                        cp = 0x10000 + ( ( cp - 0xD800 ) << 10 ) + ( low - 0xDC00 );
+                        i += 6;
+                    }
+                    else if( cp >= 0xDC00 && cp <= 0xDFFF )
+                    {
+                        return -1;
+                    }
+
+                    {
+                        char utf8[ 4 ];
+                        size_t count = 0;
+
+                        if( cp < 0x80 )
+                        {
+                            utf8[ count++ ] = ( char ) cp;
+                        }
+                        else if( cp < 0x800 )
+                        {
+                            utf8[ count++ ] = ( char ) ( 0xC0 | ( cp >> 6 ) );
+                            utf8[ count++ ] = ( char ) ( 0x80 | ( cp & 0x3F ) );
+                        }
+                        else if( cp < 0x10000 )
+                        {
+                            utf8[ count++ ] = ( char ) ( 0xE0 | ( cp >> 12 ) );
+                            utf8[ count++ ] = ( char ) ( 0x80 | ( ( cp >> 6 ) & 0x3F ) );
+                            utf8[ count++ ] = ( char ) ( 0x80 | ( cp & 0x3F ) );
+                        }
+                        else
+                        {
+                            utf8[ count++ ] = ( char ) ( 0xF0 | ( cp >> 18 ) );
+                            utf8[ count++ ] = ( char ) ( 0x80 | ( ( cp >> 12 ) & 0x3F ) );
+                            utf8[ count++ ] = ( char ) ( 0x80 | ( ( cp >> 6 ) & 0x3F ) );
+                            utf8[ count++ ] = ( char ) ( 0x80 | ( cp & 0x3F ) );
+                        }
+
+                        if( n + count >= buffer_size ) { return -1; }
+
+                        memcpy( buffer + n, utf8, count );
+                        n += count;
+                    }
+
+                    continue;
+                }
+                default:
+                    return -1;
+            }
+        }
+
+        if( n + 1 >= buffer_size ) { return -1; }
+
+        buffer[ n++ ] = c;
+    }
+
+    buffer[ n ] = '\0';
+
+    return ( int ) n;
+}
+
+//-----------------------------------------------------------------------
+// ENCODERS
+//-----------------------------------------------------------------------
+
+// like snprintf( buffer, size, "%s", str ), but the size is known
+static int json_put( char* buffer, int size, const char* str, int str_size )
+{
+    if( str_size < size )
+    {
+        memcpy( buffer, str, str_size );
+        buffer[ str_size ] = '\0';
+    }
+
+    return str_size;
+}
+
+#define XI_JSON_PUT( buffer, size, str ) json_put( ( buffer ), ( size ), ( str ), sizeof( str ) - 1 )
+
+// writes `str` as a quoted JSON string, returns the size or -1 if it didn't fit
+static int json_encode_string( char* buffer, int size, const char* str )
+{
+    static const char hex[] = "0123456789abcdef";
+
+    int offset = 0;
+
+    if( size < 2 ) { return -1; }
+
+    buffer[ offset++ ] = '"';
+
+    for( ; *str != '\0'; ++str )
+    {
+        unsigned char c = ( unsigned char ) *str;
+        char escape     = 0;
+
+        switch( c )
+        {
+            case '"':   escape = '"';  break;
+            case '\\':  escape = '\\'; break;
+            case '\n':  escape = 'n';  break;
+            case '\r':  escape = 'r';  break;
+            case '\t':  escape = 't';  break;
+            default:    break;
+        }
+
+        if( escape )
+        {
+            if( offset + 2 >= size ) { return -1; }
+            buffer[ offset++ ] = '\\';
+            buffer[ offset++ ] = escape;
+        }
+        else if( c < 0x20 )
+        {
+            if( offset + 6 >= size ) { return -1; }
+            memcpy( buffer + offset, "\\u00", 4 );
+            buffer[ offset + 4 ] = hex[ c >> 4 ];
+            buffer[ offset + 5 ] = hex[ c & 0xF ];
+            offset += 6;
+        }
+        else
+        {
+            if( offset + 1 >= size ) { return -1; }
+            buffer[ offset++ ] = ( char ) c;
+        }
+    }
+
+    if( offset + 1 >= size ) { return -1; }
+
+    buffer[ offset++ ] = '"';
+    buffer[ offset ]   = '\0';
+
+    return offset;
+}
+
+// values are given as strings, the same way Xively gives them
+static int json_encode_value( char* buffer, int size, const xi_datapoint_t* p )
+{
+    int s = 0;
+
+    switch( p->value_type )
+    {
+        case XI_VALUE_TYPE_I32:
+            if( size < 3 ) { return -1; }
+            s = xi_int_to_str( buffer + 1, size - 1, p->value.i32_value );
+            break;
+        case XI_VALUE_TYPE_F32:
+            if( size < 3 ) { return -1; }
+            s = xi_float_to_str( buffer + 1, size - 1, p->value.f32_value );
+            break;
+        case XI_VALUE_TYPE_STR:
+            return json_encode_string( buffer, size, p->value.str_value );
+        default:
+            return -1;
+    }
+
+    if( s + 3 > size ) { return -1; }
+
+    buffer[ 0 ]         = '"';
+    buffer[ s + 1 ]     = '"';
+    buffer[ s + 2 ]     = '\0';
+
+    return s + 2;
+}
+
+// the fields of a datastream that carry the datapoint, without the braces
+static int json_encode_datapoint_fields( char* buffer, int size, const xi_datapoint_t* p )
+{
+    int offset  = 0;
+    int s       = 0;
+
+    s = XI_JSON_PUT( buffer, size, "\"current_value\":" );
+    XI_CHECK_S( s, size, offset, XI_JSON_ENCODE_DATAPOINT_BUFFER_OVERRUN );
+
+    s = json_encode_value( buffer + offset, size - offset, p );
+    XI_CHECK_S( s, size, offset, XI_JSON_ENCODE_DATAPOINT_BUFFER_OVERRUN );
+
+    if( p->timestamp.timestamp != 0 )
+    {
+        s = XI_JSON_PUT( buffer + offset, size - offset, ",\"at\":\"" );
+        XI_CHECK_S( s, size, offset, XI_JSON_ENCODE_DATAPOINT_BUFFER_OVERRUN );
+
+        s = xi_timestamp_to_str( buffer + offset, size - offset
+            , p->timestamp.timestamp, p->timestamp.micro );
+        XI_CHECK_S( s, size, offset, XI_JSON_ENCODE_DATAPOINT_BUFFER_OVERRUN );
+
+        s = XI_JSON_PUT( buffer + offset, size - offset, "\"" );
+        XI_CHECK_S( s, size, offset, XI_JSON_ENCODE_DATAPOINT_BUFFER_OVERRUN );
+    }
+
+    return offset;
+
+err_handling:
+    return -1;
+}
+
+int json_encode_datapoint_in_place(
+      char* in, size_t in_size
+    , const xi_datapoint_t* datapoint )
+{
+    // PRECONDITIONS
+    assert( in != 0 );
+    assert( datapoint != 0 );
+
+    int s       = 0;
+    int size    = in_size;
+    int offset  = 0;
+
+    s = XI_JSON_PUT( in, size, "{" );
+    XI_CHECK_S( s, size, offset, XI_JSON_ENCODE_DATAPOINT_BUFFER_OVERRUN );
+
+    s = json_encode_datapoint_fields( in + offset, size - offset, datapoint );
+    XI_CHECK_S( s, size, offset, XI_JSON_ENCODE_DATAPOINT_BUFFER_OVERRUN );
+
+    s = XI_JSON_PUT( in + offset, size - offset, "}" );
+    XI_CHECK_S( s, size, offset, XI_JSON_ENCODE_DATAPOINT_BUFFER_OVERRUN );
+
+    return offset;
+
+err_handling:
+    return -1;
+}
+
+const char* json_encode_datapoint( const xi_datapoint_t* data )
+{
+    // PRECONDITIONS
+    assert( data != 0 );
+
+    return json_encode_datapoint_in_place( XI_JSON_LOCAL_BUFFER, sizeof( XI_JSON_LOCAL_BUFFER ), data ) == -1 ? 0 : XI_JSON_LOCAL_BUFFER;
+}
+
+const char* json_encode_create_datastream(
+          const char* datastream_id
+        , const xi_datapoint_t* data )
+{
+    // PRECONDITIONS
+    assert( datastream_id != 0 );
+    assert( data != 0 );
+
+    int s       = 0;
+    int size    = sizeof( XI_JSON_LOCAL_BUFFER );
+    int offset  = 0;
+
+    s = XI_JSON_PUT( XI_JSON_LOCAL_BUFFER, size, "{\"version\":\"1.0.0\",\"datastreams\":[{\"id\":" );
+    XI_CHECK_S( s, size, offset, XI_JSON_ENCODE_DATASTREAM_BUFFER_OVERRUN );
+
+    s = json_encode_string( XI_JSON_LOCAL_BUFFER + offset, size - offset, datastream_id );
+    XI_CHECK_S( s, size, offset, XI_JSON_ENCODE_DATASTREAM_BUFFER_OVERRUN );
+
+    s = XI_JSON_PUT( XI_JSON_LOCAL_BUFFER + offset, size - offset, "," );
+    XI_CHECK_S( s, size, offset, XI_JSON_ENCODE_DATASTREAM_BUFFER_OVERRUN );
+
+    s = json_encode_datapoint_fields( XI_JSON_LOCAL_BUFFER + offset, size - offset, data );
+    XI_CHECK_S( s, size, offset, XI_JSON_ENCODE_DATASTREAM_BUFFER_OVERRUN );
+
+    s = XI_JSON_PUT( XI_JSON_LOCAL_BUFFER + offset, size - offset, "}]}" );
+    XI_CHECK_S( s, size, offset, XI_JSON_ENCODE_DATASTREAM_BUFFER_OVERRUN );
+
+    return XI_JSON_LOCAL_BUFFER;
+
+err_handling:
+    return 0;
+}
+
+//-----------------------------------------------------------------------
+// DECODERS
+//-----------------------------------------------------------------------
+
+// Xively sends values as strings, their type is told the same way as in CSV
+static int json_decode_value( const json_token_t* token, xi_datapoint_t* p )
+{
+    switch( token->type )
+    {
+        case XI_JSON_TOKEN_STRING:
+            if( json_copy_string( p->value.str_value, XI_VALUE_STRING_MAX_SIZE, token ) == -1 ) { return -1; }
+            break;
+        case XI_JSON_TOKEN_NUMBER:
+        case XI_JSON_TOKEN_LITERAL:
+            if( token->size >= XI_VALUE_STRING_MAX_SIZE ) { return -1; }
+            memcpy( p->value.str_value, token->value, token->size );
+            p->value.str_value[ token->size ] = '\0';
+            break;
+        default:
+            return -1;
+    }
+
+    if( csv_decode_value( p->value.str_value, p ) == 0 ) { return -1; }
+
+    // numbers with an exponent are floats as well
+    if( token->type == XI_JSON_TOKEN_NUMBER && p->value_type == XI_VALUE_TYPE_STR )
+    {
+        p->value.f32_value  = strtof( p->value.str_value, 0 );
+        p->value_type       = XI_VALUE_TYPE_F32;
+    }
+
+    return 0;
+}
+
+// steps over the value that comes next, however deep it is
+static int json_skip_value( json_tokenizer_t* t )
+{
+    json_token_t token;
+    uint32_t depth = t->depth;
+
+    do
+    {
+        json_token_type_t type = json_next_token( t, &token );
+
+        if( type == XI_JSON_TOKEN_ERROR || type == XI_JSON_TOKEN_END ) { return -1; }
+    } while( t->depth > depth );
+
+    return 0;
+}
+
+// reads the rest of an object whose `{` has been read, `id` is null if it isn't wanted
+// returns 1 if there was a value, 0 if there wasn't or -1 if an error occurred
+static int json_decode_object( json_tokenizer_t* t
+    , char* id, size_t id_size, xi_datapoint_t* p )
+{
+    json_token_t token;
+    int found = 0;
+
+    memset( p, 0, sizeof( xi_datapoint_t ) );
+
+    for( ;; )
+    {
+        json_token_type_t type = json_next_token( t, &token );
+
+        if( type == XI_JSON_TOKEN_OBJECT_END ) { return found; }
+        if( type != XI_JSON_TOKEN_KEY ) { return -1; }
+
+        if( XI_JSON_KEY_IS( &token, "current_value" ) || XI_JSON_KEY_IS( &token, "value" ) )
+        {
+            json_next_token( t, &token );
+
+            if( json_decode_value( &token, p ) == -1 ) { return -1; }
+
+            found = 1;
+        }
+        else if( XI_JSON_KEY_IS( &token, "at" ) )
+        {
+            if( json_next_token( t, &token ) != XI_JSON_TOKEN_STRING ) { return -1; }
+
+            int n = xi_str_to_timestamp( token.value, &p->timestamp.timestamp, &p->timestamp.micro );
+
+            if( n < 0 || ( size_t ) n != token.size ) { return -1; }
+        }
+        else if( id && XI_JSON_KEY_IS( &token, "id" ) )
+        {
+            if( json_next_token( t, &token ) != XI_JSON_TOKEN_STRING
+                || json_copy_string( id, id_size, &token ) == -1 )
+            {
+                return -1;
+            }
+        }
+        else if( json_skip_value( t ) == -1 )
+        {
+            return -1;
+        }
+    }
+}
+
+int json_visit_feed(
+      const char* buffer
+    , const xi_feed_visitor_t* visitor, void* user_data )
+{
+    // PRECONDITIONS
+    assert( buffer != 0 );
+    assert( visitor != 0 );
+
+    json_tokenizer_t tokenizer;
+    json_token_t token;
+
+    char datastream_id[ XI_MAX_DATASTREAM_NAME ];
+    xi_datapoint_t datapoint;
+
+    json_tokenizer_init( &tokenizer, buffer, strlen( buffer ) );
+
+    XI_CHECK_CND( json_next_token( &tokenizer, &token ) != XI_JSON_TOKEN_OBJECT_BEGIN
+        , XI_JSON_DECODE_FEED_PARSER_ERROR );
+
+    for( ;; )
+    {
+        json_token_type_t type = json_next_token( &tokenizer, &token );
+
+        if( type == XI_JSON_TOKEN_OBJECT_END ) { break; }
+
+        XI_CHECK_CND( type != XI_JSON_TOKEN_KEY, XI_JSON_DECODE_FEED_PARSER_ERROR );
+
+        if( !XI_JSON_KEY_IS( &token, "datastreams" ) )
+        {
+            XI_CHECK_CND( json_skip_value( &tokenizer ) == -1, XI_JSON_DECODE_FEED_PARSER_ERROR );
+            continue;
+        }
+
+        XI_CHECK_CND( json_next_token( &tokenizer, &token ) != XI_JSON_TOKEN_ARRAY_BEGIN
+            , XI_JSON_DECODE_FEED_PARSER_ERROR );
+
+        while( ( type = json_next_token( &tokenizer, &token ) ) != XI_JSON_TOKEN_ARRAY_END )
+        {
+            XI_CHECK_CND( type != XI_JSON_TOKEN_OBJECT_BEGIN, XI_JSON_DECODE_FEED_PARSER_ERROR );
+
+            datastream_id[ 0 ] = '\0';
+
+            // the id may come after the value, so the datastream is told of once it's over
+            int s = json_decode_object( &tokenizer
+                , datastream_id, sizeof( datastream_id ), &datapoint );
+
+            XI_CHECK_CND( s == -1, XI_JSON_DECODE_FEED_PARSER_ERROR );
+
+            if( visitor->on_datastream && visitor->on_datastream( datastream_id, user_data ) ) { return 1; }
+
+            if( s == 1 && visitor->on_datapoint
+                && visitor->on_datapoint( datastream_id, &datapoint, user_data ) )
+            {
+                return 1;
+            }
+        }
+    }
+
+    XI_CHECK_CND( json_next_token( &tokenizer, &token ) != XI_JSON_TOKEN_END
+        , XI_JSON_DECODE_FEED_PARSER_ERROR );
+
+    return 0;
+
+err_handling:
+    return -1;
+}
+
+xi_feed_t* json_decode_feed(
+      const char* buffer
+    , xi_feed_t* feed )
+{
+    // PRECONDITIONS
+    assert( feed != 0 );
+
+    feed->datastream_count = 0;
+
+    int s = json_visit_feed( buffer, &data_layer_feed_filler, feed );
+
+    // the visitor stops only when the feed is full
+    XI_CHECK_CND( s == 1, XI_JSON_DECODE_FEED_PARSER_ERROR );
+
+    return s == 0 ? feed : 0;
+
+err_handling:
+    return 0;
+}
+
+xi_datapoint_t* json_decode_datapoint(
+      const char* buffer
+    , xi_datapoint_t* datapoint )
+{
+    // PRECONDITIONS
+    assert( buffer != 0 );
+    assert( datapoint != 0 );
+
+    json_tokenizer_t tokenizer;
+    json_token_t token;
+
+    json_tokenizer_init( &tokenizer, buffer, strlen( buffer ) );
+
+    XI_CHECK_CND( json_next_token( &tokenizer, &token ) != XI_JSON_TOKEN_OBJECT_BEGIN
+        , XI_JSON_DECODE_DATAPOINT_PARSER_ERROR );
+
+    XI_CHECK_CND( json_decode_object( &tokenizer, 0, 0, datapoint ) != 1
+        , XI_JSON_DECODE_DATAPOINT_PARSER_ERROR );
+
+    XI_CHECK_CND( json_next_token( &tokenizer, &token ) != XI_JSON_TOKEN_END
+        , XI_JSON_DECODE_DATAPOINT_PARSER_ERROR );
+
+    return datapoint;
+
+err_handling:
+    return 0;
+}
@@ -0,0 +1,103 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    json_data.h
+ * \brief   Implements JSON _data layer_ encoders and decoders specific to Xively JSON data format
+ *
+ *    Datapoints are written the way a datastream is updated, i.e.
+ *    `{"current_value":"21.5","at":"2013-04-14T20:20:01.000000Z"}`, and
+ *    datastreams are created with `{"version":"1.0.0","datastreams":[...]}`.
+ *    The decoders pull tokens one by one and write the fields they know straight
+ *    into the given structures, anything else is skipped over.
+ */
+
+#ifndef __JSON_DATA_H__
+#define __JSON_DATA_H__
+
+#include "xively.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+const char* json_encode_datapoint( const xi_datapoint_t* dp );
+
+int json_encode_datapoint_in_place(
+      char* buffer, size_t buffer_size
+    , const xi_datapoint_t* datapoint );
+
+const char* json_encode_create_datastream(
+          const char* datastream_id
+        , const xi_datapoint_t* dp );
+
+xi_feed_t* json_decode_feed(
+      const char* buffer
+    , xi_feed_t* feed );
+
+int json_visit_feed(
+      const char* buffer
+    , const xi_feed_visitor_t* visitor, void* user_data );
+
+xi_datapoint_t* json_decode_datapoint( const char* data, xi_datapoint_t* dp );
+
+typedef enum
+{
+    XI_JSON_TOKEN_ERROR = 0,
+    XI_JSON_TOKEN_END,
+    XI_JSON_TOKEN_OBJECT_BEGIN,
+    XI_JSON_TOKEN_OBJECT_END,
+    XI_JSON_TOKEN_ARRAY_BEGIN,
+    XI_JSON_TOKEN_ARRAY_END,
+    XI_JSON_TOKEN_KEY,
+    XI_JSON_TOKEN_STRING,
+    XI_JSON_TOKEN_NUMBER,
+    XI_JSON_TOKEN_LITERAL
+} json_token_type_t;
+
+/**
+ * \brief   A token points into the data, strings are given without the quotes
+ *          and with their escapes as they are
+ */
+typedef struct
+{
+    json_token_type_t   type;
+    const char*         value;
+    size_t              size;
+} json_token_t;
+
+/**
+ * \brief   State of the tokenizer, nesting is kept as one bit per level
+ */
+typedef struct
+{
+    const char* data;
+    size_t      size;
+    size_t      offset;
+    uint32_t    depth;
+    uint32_t    objects;
+    uint8_t     expect;
+} json_tokenizer_t;
+
+void json_tokenizer_init( json_tokenizer_t* tokenizer, const char* data, size_t data_size );
+
+/**
+ * \brief   Reads the next token and checks it may come where it is
+ *
+ *    Nesting is limited to 32 levels. Once `XI_JSON_TOKEN_END` or
+ *    `XI_JSON_TOKEN_ERROR` is returned, the same is returned again.
+ */
+json_token_type_t json_next_token( json_tokenizer_t* tokenizer, json_token_t* token );
+
+/**
+ * \brief   Copies the string of a token into `buffer` with the escapes resolved
+ *
+ * \return  Size of the string or -1 if it didn't fit or has an invalid escape.
+ */
+int json_copy_string( char* buffer, size_t buffer_size, const json_token_t* token );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __JSON_DATA_H__
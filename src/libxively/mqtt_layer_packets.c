@@ -0,0 +1,193 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    mqtt_layer_packets.c
+ * \brief   MQTT v3.1 packets needed by a publishing client [see mqtt_layer_packets.h]
+ */
+
+#include <string.h>
+#include <assert.h>
+
+#include "mqtt_layer_packets.h"
+#include "xi_macros.h"
+#include "xi_err.h"
+
+#ifdef XI_TRANSPORT_MQTT
+
+// remaining length is encoded in up to 4 bytes, 7 bits each
+#define XI_MQTT_MAX_REMAINING_LENGTH 268435455
+
+static int mqtt_write_fixed_header( char* buffer, size_t buffer_size
+    , uint8_t first, size_t remaining )
+{
+    size_t offset = 0;
+
+    XI_CHECK_CND( remaining > XI_MQTT_MAX_REMAINING_LENGTH, XI_MQTT_PACKET_ERROR );
+    XI_CHECK_CND( buffer_size < 5, XI_MQTT_PACKET_ERROR );
+
+    buffer[ offset++ ] = ( char ) first;
+
+    do
+    {
+        uint8_t digit = remaining & 0x7F;
+        remaining >>= 7;
+        buffer[ offset++ ] = ( char ) ( remaining ? digit | 0x80 : digit );
+    } while( remaining );
+
+    return ( int ) offset;
+
+err_handling:
+    return -1;
+}
+
+static size_t mqtt_write_string( char* buffer, const char* str, size_t size )
+{
+    buffer[ 0 ] = ( char ) ( size >> 8 );
+    buffer[ 1 ] = ( char ) size;
+    memcpy( buffer + 2, str, size );
+
+    return size + 2;
+}
+
+int mqtt_construct_connect(
+      char* buffer, size_t buffer_size
+    , const char* client_id
+    , const char* user_name
+    , uint16_t keep_alive )
+{
+    // PRECONDITIONS
+    assert( buffer != 0 );
+    assert( client_id != 0 );
+
+    static const char protocol[] = "MQIsdp";
+
+    size_t client_id_size   = strlen( client_id );
+    size_t user_name_size   = user_name ? strlen( user_name ) : 0;
+    size_t remaining        = 2 + sizeof( protocol ) - 1 + 1 + 1 + 2
+                            + 2 + client_id_size
+                            + ( user_name ? 2 + user_name_size : 0 );
+
+    int s = mqtt_write_fixed_header( buffer, buffer_size, XI_MQTT_CONNECT << 4, remaining );
+
+    if( s == -1 ) { return -1; }
+
+    XI_CHECK_CND( s + remaining > buffer_size, XI_MQTT_PACKET_ERROR );
+
+    {
+        size_t offset = s;
+
+        offset += mqtt_write_string( buffer + offset, protocol, sizeof( protocol ) - 1 );
+        buffer[ offset++ ] = 3;                                 // protocol level
+        buffer[ offset++ ] = ( char ) ( user_name ? 0x82 : 0x02 ); // clean session
+        buffer[ offset++ ] = ( char ) ( keep_alive >> 8 );
+        buffer[ offset++ ] = ( char ) keep_alive;
+        offset += mqtt_write_string( buffer + offset, client_id, client_id_size );
+
+        if( user_name )
+        {
+            offset += mqtt_write_string( buffer + offset, user_name, user_name_size );
+        }
+
+        return ( int ) offset;
+    }
+
+err_handling:
+    return -1;
+}
+
+int mqtt_construct_publish(
+      char* buffer, size_t buffer_size
+    , const char* topic
+    , const char* payload, size_t payload_size
+    , uint8_t qos, uint16_t packet_id )
+{
+    // PRECONDITIONS
+    assert( buffer != 0 );
+    assert( topic != 0 );
+    assert( qos <= 1 );
+
+    size_t topic_size   = strlen( topic );
+    size_t remaining    = 2 + topic_size + ( qos ? 2 : 0 ) + payload_size;
+
+    int s = mqtt_write_fixed_header( buffer, buffer_size
+        , ( XI_MQTT_PUBLISH << 4 ) | ( qos << 1 ), remaining );
+
+    if( s == -1 ) { return -1; }
+
+    XI_CHECK_CND( s + remaining > buffer_size, XI_MQTT_PACKET_ERROR );
+
+    {
+        size_t offset = s;
+
+        offset += mqtt_write_string( buffer + offset, topic, topic_size );
+
+        if( qos )
+        {
+            buffer[ offset++ ] = ( char ) ( packet_id >> 8 );
+            buffer[ offset++ ] = ( char ) packet_id;
+        }
+
+        // the payload may already be in place, right behind the variable header
+        memmove( buffer + offset, payload, payload_size );
+
+        return ( int ) ( offset + payload_size );
+    }
+
+err_handling:
+    return -1;
+}
+
+int mqtt_parse_packet(
+      const char* data, size_t data_size
+    , mqtt_packet_type_t* type
+    , uint16_t* value )
+{
+    // PRECONDITIONS
+    assert( data != 0 );
+    assert( type != 0 );
+    assert( value != 0 );
+
+    const uint8_t* p    = ( const uint8_t* ) data;
+    size_t remaining    = 0;
+    size_t offset       = 1;
+    size_t multiplier   = 1;
+
+    for( ;; )
+    {
+        if( offset >= data_size ) { return 0; }
+
+        XI_CHECK_CND( offset > 4, XI_MQTT_PACKET_ERROR );
+
+        remaining += ( p[ offset ] & 0x7F ) * multiplier;
+        multiplier <<= 7;
+
+        if( ( p[ offset++ ] & 0x80 ) == 0 ) { break; }
+    }
+
+    if( data_size < offset + remaining ) { return 0; }
+
+    *type   = ( mqtt_packet_type_t ) ( p[ 0 ] >> 4 );
+    *value  = 0;
+
+    switch( *type )
+    {
+        case XI_MQTT_CONNACK:
+            XI_CHECK_CND( remaining != 2, XI_MQTT_PACKET_ERROR );
+            *value = p[ offset + 1 ];
+            break;
+        case XI_MQTT_PUBACK:
+            XI_CHECK_CND( remaining != 2, XI_MQTT_PACKET_ERROR );
+            *value = ( uint16_t ) ( ( p[ offset ] << 8 ) | p[ offset + 1 ] );
+            break;
+        default:
+            break;
+    }
+
+    return ( int ) ( offset + remaining );
+
+err_handling:
+    return -1;
+}
+
+#endif // XI_TRANSPORT_MQTT
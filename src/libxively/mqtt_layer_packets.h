@@ -0,0 +1,70 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    mqtt_layer_packets.h
+ * \brief   MQTT v3.1 packets needed by a publishing client
+ *
+ *    Only the client side of `CONNECT`, `PUBLISH` (QoS 0 and 1) and `DISCONNECT`
+ *    is implemented, along with parsing of what the broker sends back.
+ */
+
+#ifndef __MQTT_LAYER_PACKETS_H__
+#define __MQTT_LAYER_PACKETS_H__
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum
+{
+    XI_MQTT_CONNECT     = 1,
+    XI_MQTT_CONNACK     = 2,
+    XI_MQTT_PUBLISH     = 3,
+    XI_MQTT_PUBACK      = 4,
+    XI_MQTT_PINGRESP    = 13,
+    XI_MQTT_DISCONNECT  = 14
+} mqtt_packet_type_t;
+
+/**
+ * \brief   Writes `CONNECT` packet with clean session and the API key as the user name
+ *
+ * \return  Size of the packet or -1 if an error occurred.
+ */
+int mqtt_construct_connect(
+      char* buffer, size_t buffer_size
+    , const char* client_id
+    , const char* user_name
+    , uint16_t keep_alive );
+
+/**
+ * \brief   Writes `PUBLISH` packet, `packet_id` is only used for QoS 1
+ *
+ * \return  Size of the packet or -1 if an error occurred.
+ */
+int mqtt_construct_publish(
+      char* buffer, size_t buffer_size
+    , const char* topic
+    , const char* payload, size_t payload_size
+    , uint8_t qos, uint16_t packet_id );
+
+/**
+ * \brief   Parses fixed header of a packet from the beginning of the buffer
+ *
+ *    For `CONNACK` and `PUBACK` the return code or the packet id is given in `value`.
+ *
+ * \return  Size of the whole packet, 0 if more data is needed or -1 if an error occurred.
+ */
+int mqtt_parse_packet(
+      const char* data, size_t data_size
+    , mqtt_packet_type_t* type
+    , uint16_t* value );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __MQTT_LAYER_PACKETS_H__
@@ -0,0 +1,42 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    mqtt_transport.c
+ * \brief   Implements MQTT _transport layer_ abstraction interface [see mqtt_transport.h and transport_layer.h]
+ */
+
+#include "mqtt_transport_layer.h"
+#include "mqtt_transport.h"
+
+#ifdef XI_TRANSPORT_MQTT
+
+transport_layer_t* get_mqtt_transport_layer( void )
+{
+    static transport_layer_t __mqtt_transport_layer =
+    {
+          &mqtt_encode_update_feed
+        , &mqtt_encode_get_feed
+        , &mqtt_encode_create_datastream
+        , &mqtt_encode_update_datastream
+        , &mqtt_encode_get_datastream
+        , &mqtt_encode_delete_datastream
+        , &mqtt_encode_delete_datapoint
+        , &mqtt_encode_datapoint_delete_range
+        , &mqtt_encode_get_datastream_history
+        , &mqtt_decode_reply
+        , &mqtt_get_encoded_size
+        , &mqtt_get_request_id
+        , &mqtt_reply_size
+        , &mqtt_open_session
+        , &mqtt_close_session
+        , &mqtt_get_immediate_reply
+        , 0 // no conditional requests
+        , 0 // bodies are encoded with the request
+        , 0 // replies are read whole
+    };
+
+    return &__mqtt_transport_layer;
+}
+
+#endif // XI_TRANSPORT_MQTT
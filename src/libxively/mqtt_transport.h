@@ -0,0 +1,30 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    mqtt_transport.h
+ * \brief   Implements MQTT _transport layer_ abstraction interface
+ */
+
+#ifndef __MQTT_TRANSPORT_H__
+#define __MQTT_TRANSPORT_H__
+
+#include "transport_layer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+ /**
+ * \brief   Initialise MQTT implementation of the _transport layer_
+ *
+ * \return  Structure with function pointers for MQTT encoders and decoders
+ *          which had been implemented in `mqtt_transport_layer.c`.
+ */
+transport_layer_t* get_mqtt_transport_layer( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __MQTT_TRANSPORT_H__
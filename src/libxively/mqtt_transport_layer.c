@@ -0,0 +1,388 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    mqtt_transport_layer.c
+ * \brief   Implements MQTT _transport layer_ encoders for publishing feed and datastream updates [see mqtt_transport_layer.h]
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <assert.h>
+
+#include "mqtt_transport_layer.h"
+#include "mqtt_layer_packets.h"
+#include "transport_layer.h"
+#include "xi_macros.h"
+#include "xi_err.h"
+#include "xi_consts.h"
+#include "xi_globals.h"
+
+#ifdef XI_TRANSPORT_MQTT
+
+// fixed header, topic and packet id at their longest
+#define XI_MQTT_MAX_HEADER_SIZE ( 5 + 2 + XI_ID_BUFFER_SIZE + 2 )
+
+// the payload is rendered behind the room for the biggest header, which is then
+// put in front of it, so it's only moved by the few bytes the header is shorter
+static char XI_MQTT_PACKET_BUFFER[ XI_MQTT_MAX_HEADER_SIZE + XI_CONTENT_BUFFER_SIZE ];
+static char XI_MQTT_TOPIC[ XI_ID_BUFFER_SIZE ];
+static size_t XI_MQTT_PACKET_SIZE = 0;
+static uint16_t XI_MQTT_PACKET_ID = 0;
+
+#define XI_MQTT_PAYLOAD ( XI_MQTT_PACKET_BUFFER + XI_MQTT_MAX_HEADER_SIZE )
+
+// no keep alive, there is nothing that would ping the broker between the calls
+#define XI_MQTT_KEEP_ALIVE 0
+
+// the longest client id every broker has to accept
+#define XI_MQTT_CLIENT_ID_SIZE 24
+
+static const char* mqtt_publish( size_t payload_size )
+{
+    uint8_t qos = xi_globals.mqtt_qos;
+
+    if( qos )
+    {
+        // zero isn't a valid packet id
+        if( ++XI_MQTT_PACKET_ID == 0 ) { ++XI_MQTT_PACKET_ID; }
+    }
+
+    int s = mqtt_construct_publish( XI_MQTT_PACKET_BUFFER, sizeof( XI_MQTT_PACKET_BUFFER )
+        , XI_MQTT_TOPIC, XI_MQTT_PAYLOAD, payload_size, qos, XI_MQTT_PACKET_ID );
+
+    if( s == -1 ) { return 0; }
+
+    XI_MQTT_PACKET_SIZE = s;
+
+    return XI_MQTT_PACKET_BUFFER;
+}
+
+// the replies are nothing but a status, so clearing the whole response isn't worth it
+static const xi_response_t* mqtt_status_reply( int status, const char* status_string, uint32_t request_id )
+{
+    xi_response_t* __tmp = get_transport_response();
+
+    __tmp->http.http_status             = status;
+    __tmp->http.http_headers_size       = 0;
+    __tmp->http.http_headers_raw_size   = 0;
+    __tmp->http.http_content[ 0 ]       = '\0';
+    __tmp->request_id                   = request_id;
+
+    memset( __tmp->http.http_headers_checklist, 0, sizeof( __tmp->http.http_headers_checklist ) );
+    strcpy( __tmp->http.http_status_string, status_string );
+
+    return __tmp;
+}
+
+static const char* mqtt_unsupported_request( void )
+{
+    XI_CHECK_CND( 1, XI_MQTT_UNSUPPORTED_REQUEST );
+
+err_handling:
+    return 0;
+}
+
+const char* mqtt_encode_create_datastream(
+          const data_layer_t* data_layer
+        , const char* x_api_key
+        , int32_t feed_id
+        , const char *datastream_id
+        , const xi_datapoint_t* datapoint )
+{
+    XI_UNUSED( data_layer );
+    XI_UNUSED( x_api_key );
+    XI_UNUSED( feed_id );
+    XI_UNUSED( datastream_id );
+    XI_UNUSED( datapoint );
+
+    return mqtt_unsupported_request();
+}
+
+const char* mqtt_encode_update_datastream(
+          const data_layer_t* data_layer
+        , const char* x_api_key
+        , int32_t feed_id
+        , const char *datastream_id
+        , const xi_datapoint_t* datapoint )
+{
+    XI_UNUSED( x_api_key ); // the session is authenticated
+
+    // PRECONDITIONS
+    assert( data_layer != 0 );
+    assert( datastream_id != 0 );
+    assert( datapoint != 0 );
+
+    int s = snprintf( XI_MQTT_TOPIC, sizeof( XI_MQTT_TOPIC )
+        , "/v2/feeds/%ld/datastreams/%s.csv", ( long ) feed_id, datastream_id );
+    XI_CHECK_SIZE( s, ( int ) sizeof( XI_MQTT_TOPIC ), XI_MQTT_PACKET_ERROR );
+
+    s = data_layer->encode_datapoint_in_place(
+        XI_MQTT_PAYLOAD, XI_CONTENT_BUFFER_SIZE, datapoint );
+    XI_CHECK_SIZE( s, XI_CONTENT_BUFFER_SIZE, XI_MQTT_PACKET_ERROR );
+
+    return mqtt_publish( s );
+
+err_handling:
+    return 0;
+}
+
+const char* mqtt_encode_get_datastream(
+          const data_layer_t* data_layer
+        , const char* x_api_key
+        , int32_t feed_id
+        , const char *datastream_id )
+{
+    XI_UNUSED( data_layer );
+    XI_UNUSED( x_api_key );
+    XI_UNUSED( feed_id );
+    XI_UNUSED( datastream_id );
+
+    return mqtt_unsupported_request();
+}
+
+const char* mqtt_encode_delete_datastream(
+          const data_layer_t* data_layer
+        , const char* x_api_key
+        , int32_t feed_id
+        , const char *datastream_id )
+{
+    XI_UNUSED( data_layer );
+    XI_UNUSED( x_api_key );
+    XI_UNUSED( feed_id );
+    XI_UNUSED( datastream_id );
+
+    return mqtt_unsupported_request();
+}
+
+const char* mqtt_encode_delete_datapoint(
+          const data_layer_t* data_layer
+        , const char* x_api_key
+        , int32_t feed_id
+        , const char *datastream_id
+        , const xi_datapoint_t* o )
+{
+    XI_UNUSED( data_layer );
+    XI_UNUSED( x_api_key );
+    XI_UNUSED( feed_id );
+    XI_UNUSED( datastream_id );
+    XI_UNUSED( o );
+
+    return mqtt_unsupported_request();
+}
+
+const char* mqtt_encode_update_feed(
+          const data_layer_t* data_layer
+        , const char* x_api_key
+        , const xi_feed_t* feed )
+{
+    XI_UNUSED( x_api_key ); // the session is authenticated
+
+    // PRECONDITIONS
+    assert( data_layer != 0 );
+    assert( feed != 0 );
+
+    int offset  = 0;
+    int size    = XI_CONTENT_BUFFER_SIZE;
+    int s       = 0;
+
+    // same body as the one we send over HTTP
+    for( size_t i = 0; i < feed->datastream_count; ++i )
+    {
+        const xi_datastream_t* curr_datastream = &feed->datastreams[ i ];
+
+        for( size_t j = 0; j < curr_datastream->datapoint_count; ++j )
+        {
+            s = snprintf( XI_MQTT_PAYLOAD + offset, XI_MAX( size - offset, 0 ), "%s,"
+                , curr_datastream->datastream_id );
+            XI_CHECK_S( s, size, offset, XI_MQTT_PACKET_ERROR );
+
+            s = data_layer->encode_datapoint_in_place(
+                  XI_MQTT_PAYLOAD + offset, XI_MAX( size - offset, 0 )
+                , &curr_datastream->datapoints[ j ] );
+            XI_CHECK_S( s, size, offset, XI_MQTT_PACKET_ERROR );
+        }
+    }
+
+    s = snprintf( XI_MQTT_TOPIC, sizeof( XI_MQTT_TOPIC )
+        , "/v2/feeds/%ld.csv", ( long ) feed->feed_id );
+    XI_CHECK_SIZE( s, ( int ) sizeof( XI_MQTT_TOPIC ), XI_MQTT_PACKET_ERROR );
+
+    return mqtt_publish( offset );
+
+err_handling:
+    return 0;
+}
+
+const char* mqtt_encode_get_feed(
+        const data_layer_t* data_layer
+      , const char* x_api_key
+      , const xi_feed_t* feed )
+{
+    XI_UNUSED( data_layer );
+    XI_UNUSED( x_api_key );
+    XI_UNUSED( feed );
+
+    return mqtt_unsupported_request();
+}
+
+const char* mqtt_encode_datapoint_delete_range(
+        const data_layer_t* data_layer
+      , const char* x_api_key
+      , int feed_id
+      , const char* datastream_id
+      , const xi_timestamp_t* start
+      , const xi_timestamp_t* end )
+{
+    XI_UNUSED( data_layer );
+    XI_UNUSED( x_api_key );
+    XI_UNUSED( feed_id );
+    XI_UNUSED( datastream_id );
+    XI_UNUSED( start );
+    XI_UNUSED( end );
+
+    return mqtt_unsupported_request();
+}
+
+const char* mqtt_encode_get_datastream_history(
+        const data_layer_t* data_layer
+      , const char* x_api_key
+      , int32_t feed_id
+      , const char* datastream_id
+      , const xi_timestamp_t* start
+      , const xi_timestamp_t* end
+      , uint32_t interval
+      , uint32_t limit )
+{
+    XI_UNUSED( data_layer );
+    XI_UNUSED( x_api_key );
+    XI_UNUSED( feed_id );
+    XI_UNUSED( datastream_id );
+    XI_UNUSED( start );
+    XI_UNUSED( end );
+    XI_UNUSED( interval );
+    XI_UNUSED( limit );
+
+    return mqtt_unsupported_request();
+}
+
+const xi_response_t* mqtt_decode_reply(
+          const data_layer_t* data_layer
+        , const char* data
+        , size_t data_size )
+{
+    XI_UNUSED( data_layer );
+
+    mqtt_packet_type_t type = XI_MQTT_PUBACK;
+    uint16_t value          = 0;
+
+    int s = mqtt_parse_packet( data, data_size, &type, &value );
+
+    if( s == -1 ) { return 0; }
+
+    XI_CHECK_CND( s == 0, XI_MQTT_PACKET_ERROR );
+
+    // anything but an acknowledgement (e.g. a late ping response) is left unrelated
+    if( type == XI_MQTT_PUBACK )
+    {
+        return mqtt_status_reply( 200, "OK", value );
+    }
+
+    return mqtt_status_reply( 0, "", 0 );
+
+err_handling:
+    return 0;
+}
+
+size_t mqtt_get_encoded_size( void )
+{
+    return XI_MQTT_PACKET_SIZE;
+}
+
+uint32_t mqtt_get_request_id( void )
+{
+    return xi_globals.mqtt_qos ? XI_MQTT_PACKET_ID : 0;
+}
+
+int mqtt_reply_size( const char* data, size_t data_size )
+{
+    mqtt_packet_type_t type = XI_MQTT_PUBACK;
+    uint16_t value          = 0;
+
+    return mqtt_parse_packet( data, data_size, &type, &value );
+}
+
+int mqtt_open_session( const comm_layer_t* comm_layer, connection_t* conn, const char* api_key )
+{
+    // PRECONDITIONS
+    assert( comm_layer != 0 );
+    assert( conn != 0 );
+
+    static uint32_t counter = 0;
+
+    char client_id[ XI_MQTT_CLIENT_ID_SIZE ];
+    char buffer[ XI_QUERY_BUFFER_SIZE ];
+    size_t size = 0;
+
+    // the session is clean, the id only has to differ from the other clients' ones
+    snprintf( client_id, sizeof( client_id ), "xi%08lx%08lx"
+        , ( unsigned long ) time( 0 ), ( unsigned long ) ( ( uintptr_t ) conn ^ ++counter ) );
+
+    int s = mqtt_construct_connect( buffer, sizeof( buffer ), client_id, api_key, XI_MQTT_KEEP_ALIVE );
+
+    if( s == -1 ) { return -1; }
+
+    if( comm_layer->send_data( conn, buffer, s ) == -1 ) { return -1; }
+
+    for( ;; )
+    {
+        mqtt_packet_type_t type = XI_MQTT_CONNACK;
+        uint16_t value          = 0;
+
+        s = mqtt_parse_packet( buffer, size, &type, &value );
+
+        if( s == -1 ) { return -1; }
+
+        // the broker doesn't send anything else until it gets a publish
+        if( s > 0 )
+        {
+            XI_CHECK_CND( type != XI_MQTT_CONNACK || value != 0, XI_MQTT_CONNECT_ERROR );
+            return 0;
+        }
+
+        XI_CHECK_CND( size == sizeof( buffer ), XI_MQTT_CONNECT_ERROR );
+
+        int r = comm_layer->read_data( conn, buffer + size, sizeof( buffer ) - size );
+
+        if( r == -1 ) { return -1; }
+
+        XI_CHECK_CND( r == 0, XI_MQTT_CONNECT_ERROR );
+
+        size += r;
+    }
+
+err_handling:
+    return -1;
+}
+
+int mqtt_close_session( const comm_layer_t* comm_layer, connection_t* conn )
+{
+    // PRECONDITIONS
+    assert( comm_layer != 0 );
+    assert( conn != 0 );
+
+    static const char disconnect[] = { ( char ) ( XI_MQTT_DISCONNECT << 4 ), 0 };
+
+    return comm_layer->send_data( conn, disconnect, sizeof( disconnect ) ) == -1 ? -1 : 0;
+}
+
+const xi_response_t* mqtt_get_immediate_reply( void )
+{
+    if( xi_globals.mqtt_qos ) { return 0; }
+
+    // the publish is accepted as soon as it is sent, it won't be acknowledged
+    return mqtt_status_reply( 202, "Accepted", 0 );
+}
+
+#endif // XI_TRANSPORT_MQTT
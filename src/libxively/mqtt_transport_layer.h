@@ -0,0 +1,109 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    mqtt_transport_layer.h
+ * \brief   Implements MQTT _transport layer_ encoders for publishing feed and datastream updates
+ *
+ *    Updates are published to `/v2/feeds/<feed>.csv` and `/v2/feeds/<feed>/datastreams/<id>.csv`
+ *    topics, the payload is the same CSV body an HTTP `PUT` would carry. The session is opened
+ *    with `CONNECT`, authenticated by the API key given as the user name. With QoS 0 nothing
+ *    comes back, so the reply is made up right away, with QoS 1 it is the broker's `PUBACK`
+ *    matched by its packet id. Requests that need a reply with data (or a delete) have no
+ *    counterpart in a publish-only session and fail with `XI_MQTT_UNSUPPORTED_REQUEST`.
+ */
+
+#ifndef __MQTT_TRANSPORT_LAYER_H__
+#define __MQTT_TRANSPORT_LAYER_H__
+
+#include "xively.h"
+#include "data_layer.h"
+#include "comm_layer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+const char* mqtt_encode_create_datastream(
+          const data_layer_t*
+        , const char* x_api_key
+        , int32_t feed_id
+        , const char *datastream_id
+        , const xi_datapoint_t* value );
+
+const char* mqtt_encode_update_datastream(
+          const data_layer_t*
+        , const char* x_api_key
+        , int32_t feed_id
+        , const char *datastream_id
+        , const xi_datapoint_t* value );
+
+const char* mqtt_encode_get_datastream(
+          const data_layer_t*
+        , const char* x_api_key
+        , int32_t feed_id
+        , const char *datastream_id );
+
+const char* mqtt_encode_delete_datastream(
+          const data_layer_t*
+        , const char* x_api_key
+        , int32_t feed_id
+        , const char *datastream_id );
+
+const char* mqtt_encode_delete_datapoint(
+          const data_layer_t*
+        , const char* x_api_key
+        , int32_t feed_id
+        , const char *datastream_id
+        , const xi_datapoint_t* o );
+
+const char* mqtt_encode_update_feed(
+          const data_layer_t*
+        , const char* x_api_key
+        , const xi_feed_t* feed );
+
+const char* mqtt_encode_get_feed(
+        const data_layer_t*
+      , const char* x_api_key
+      , const xi_feed_t* feed );
+
+const char* mqtt_encode_datapoint_delete_range(
+        const data_layer_t*
+      , const char* x_api_key
+      , int feed_id
+      , const char* datastream_id
+      , const xi_timestamp_t* start
+      , const xi_timestamp_t* end );
+
+const char* mqtt_encode_get_datastream_history(
+        const data_layer_t*
+      , const char* x_api_key
+      , int32_t feed_id
+      , const char* datastream_id
+      , const xi_timestamp_t* start
+      , const xi_timestamp_t* end
+      , uint32_t interval
+      , uint32_t limit );
+
+const xi_response_t* mqtt_decode_reply(
+          const data_layer_t*
+        , const char* data
+        , size_t data_size );
+
+size_t mqtt_get_encoded_size( void );
+
+uint32_t mqtt_get_request_id( void );
+
+int mqtt_reply_size( const char* data, size_t data_size );
+
+int mqtt_open_session( const comm_layer_t* comm_layer, connection_t* conn, const char* api_key );
+
+int mqtt_close_session( const comm_layer_t* comm_layer, connection_t* conn );
+
+const xi_response_t* mqtt_get_immediate_reply( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __MQTT_TRANSPORT_LAYER_H__
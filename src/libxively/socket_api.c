@@ -0,0 +1,676 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    socket_api.c
+ * \brief   Xively socket API messages [see socket_api.h]
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include <assert.h>
+
+#include "socket_api.h"
+#include "xi_macros.h"
+#include "xi_helpers.h"
+#include "xi_err.h"
+#include "xi_consts.h"
+
+#if defined( XI_TRANSPORT_WS ) || defined( XI_TRANSPORT_TCP )
+
+static char XI_SOCKET_API_RESOURCE[ XI_ID_BUFFER_SIZE ];
+static char XI_SOCKET_API_PARAMS[ XI_ID_BUFFER_SIZE ];
+static char XI_SOCKET_API_BODY[ XI_CONTENT_BUFFER_SIZE ];
+static uint32_t XI_SOCKET_API_TOKEN = 0;
+
+uint32_t socket_api_next_token( void )
+{
+    // zero is reserved for replies that aren't related to any request
+    if( ++XI_SOCKET_API_TOKEN == 0 ) { ++XI_SOCKET_API_TOKEN; }
+
+    return XI_SOCKET_API_TOKEN;
+}
+
+uint32_t socket_api_last_token( void )
+{
+    return XI_SOCKET_API_TOKEN;
+}
+
+//-----------------------------------------------------------------------
+// ENCODING
+//-----------------------------------------------------------------------
+
+// writes `str` as a quoted JSON string, returns the size or -1 if it didn't fit
+static int socket_api_write_string( char* buffer, int size, const char* str )
+{
+    int offset = 0;
+
+    if( size < 2 ) { return -1; }
+
+    buffer[ offset++ ] = '"';
+
+    for( ; *str != '\0'; ++str )
+    {
+        char c      = *str;
+        char escape = 0;
+
+        switch( c )
+        {
+            case '"':   escape = '"';  break;
+            case '\\':  escape = '\\'; break;
+            case '\n':  escape = 'n';  break;
+            case '\r':  escape = 'r';  break;
+            case '\t':  escape = 't';  break;
+            default:    break;
+        }
+
+        if( escape )
+        {
+            if( offset + 2 >= size ) { return -1; }
+            buffer[ offset++ ] = '\\';
+            buffer[ offset++ ] = escape;
+        }
+        else if( ( unsigned char ) c < 0x20 )
+        {
+            if( offset + 6 >= size ) { return -1; }
+            offset += snprintf( buffer + offset, size - offset, "\\u%04x", ( unsigned char ) c );
+        }
+        else
+        {
+            if( offset + 1 >= size ) { return -1; }
+            buffer[ offset++ ] = c;
+        }
+    }
+
+    if( offset + 1 >= size ) { return -1; }
+
+    buffer[ offset++ ] = '"';
+    buffer[ offset ]   = '\0';
+
+    return offset;
+}
+
+static int socket_api_encode_request(
+      char* buffer, size_t buffer_size
+    , const char* method
+    , const char* resource
+    , const char* params
+    , const char* api_key
+    , const char* body
+    , uint32_t token )
+{
+    // PRECONDITIONS
+    assert( buffer != 0 );
+    assert( method != 0 );
+    assert( resource != 0 );
+    assert( api_key != 0 );
+
+    int offset  = 0;
+    int size    = ( int ) buffer_size;
+    int s       = 0;
+
+    s = snprintf( buffer, size, "{\"method\":\"%s\",\"resource\":", method );
+    XI_CHECK_S( s, size, offset, XI_SOCKET_API_ENCODE_ERROR );
+
+    // the datastream id in it is the user's, so it's escaped like the rest
+    s = socket_api_write_string( buffer + offset, size - offset, resource );
+    XI_CHECK_S( s, size, offset, XI_SOCKET_API_ENCODE_ERROR );
+
+    // the extension goes inside the quotes
+    offset -= 1;
+
+    s = snprintf( buffer + offset, XI_MAX( size - offset, 0 ), ".csv\"" );
+    XI_CHECK_S( s, size, offset, XI_SOCKET_API_ENCODE_ERROR );
+
+    if( params != 0 )
+    {
+        s = snprintf( buffer + offset, XI_MAX( size - offset, 0 ), ",\"params\":{%s}", params );
+        XI_CHECK_S( s, size, offset, XI_SOCKET_API_ENCODE_ERROR );
+    }
+
+    s = snprintf( buffer + offset, XI_MAX( size - offset, 0 ), ",\"headers\":{\"X-ApiKey\":" );
+    XI_CHECK_S( s, size, offset, XI_SOCKET_API_ENCODE_ERROR );
+
+    s = socket_api_write_string( buffer + offset, size - offset, api_key );
+    XI_CHECK_S( s, size, offset, XI_SOCKET_API_ENCODE_ERROR );
+
+    s = snprintf( buffer + offset, XI_MAX( size - offset, 0 ), "}" );
+    XI_CHECK_S( s, size, offset, XI_SOCKET_API_ENCODE_ERROR );
+
+    if( body != 0 )
+    {
+        s = snprintf( buffer + offset, XI_MAX( size - offset, 0 ), ",\"body\":" );
+        XI_CHECK_S( s, size, offset, XI_SOCKET_API_ENCODE_ERROR );
+
+        s = socket_api_write_string( buffer + offset, size - offset, body );
+        XI_CHECK_S( s, size, offset, XI_SOCKET_API_ENCODE_ERROR );
+    }
+
+    s = snprintf( buffer + offset, XI_MAX( size - offset, 0 ), ",\"token\":\"%lu\"}"
+        , ( unsigned long ) token );
+    XI_CHECK_S( s, size, offset, XI_SOCKET_API_ENCODE_ERROR );
+
+    return offset;
+
+err_handling:
+    return -1;
+}
+
+static const char* socket_api_datastream_resource( int32_t feed_id, const char* datastream_id )
+{
+    int s = 0;
+
+    if( datastream_id )
+    {
+        s = snprintf( XI_SOCKET_API_RESOURCE, sizeof( XI_SOCKET_API_RESOURCE )
+            , "/feeds/%ld/datastreams/%s", ( long ) feed_id, datastream_id );
+    }
+    else
+    {
+        s = snprintf( XI_SOCKET_API_RESOURCE, sizeof( XI_SOCKET_API_RESOURCE )
+            , "/feeds/%ld/datastreams", ( long ) feed_id );
+    }
+
+    XI_CHECK_SIZE( s, ( int ) sizeof( XI_SOCKET_API_RESOURCE ), XI_SOCKET_API_ENCODE_ERROR );
+
+    return XI_SOCKET_API_RESOURCE;
+
+err_handling:
+    return 0;
+}
+
+int socket_api_encode_update_feed(
+      char* buffer, size_t buffer_size, uint32_t token
+    , const data_layer_t* data_layer, const char* api_key
+    , const xi_feed_t* feed )
+{
+    // PRECONDITIONS
+    assert( data_layer != 0 );
+    assert( feed != 0 );
+
+    int offset  = 0;
+    int size    = sizeof( XI_SOCKET_API_BODY );
+    int s       = 0;
+
+    XI_SOCKET_API_BODY[ 0 ] = '\0';
+
+    // same body as the one we send over HTTP
+    for( size_t i = 0; i < feed->datastream_count; ++i )
+    {
+        const xi_datastream_t* curr_datastream = &feed->datastreams[ i ];
+
+        for( size_t j = 0; j < curr_datastream->datapoint_count; ++j )
+        {
+            s = snprintf( XI_SOCKET_API_BODY + offset, XI_MAX( size - offset, 0 ), "%s,"
+                , curr_datastream->datastream_id );
+            XI_CHECK_S( s, size, offset, XI_SOCKET_API_ENCODE_ERROR );
+
+            s = data_layer->encode_datapoint_in_place(
+                  XI_SOCKET_API_BODY + offset, XI_MAX( size - offset, 0 )
+                , &curr_datastream->datapoints[ j ] );
+            XI_CHECK_S( s, size, offset, XI_SOCKET_API_ENCODE_ERROR );
+        }
+    }
+
+    s = snprintf( XI_SOCKET_API_RESOURCE, sizeof( XI_SOCKET_API_RESOURCE )
+        , "/feeds/%ld", ( long ) feed->feed_id );
+    XI_CHECK_SIZE( s, ( int ) sizeof( XI_SOCKET_API_RESOURCE ), XI_SOCKET_API_ENCODE_ERROR );
+
+    return socket_api_encode_request( buffer, buffer_size
+        , "put", XI_SOCKET_API_RESOURCE, 0, api_key, XI_SOCKET_API_BODY, token );
+
+err_handling:
+    return -1;
+}
+
+int socket_api_encode_get_feed(
+      char* buffer, size_t buffer_size, uint32_t token
+    , const data_layer_t* data_layer, const char* api_key
+    , const xi_feed_t* feed )
+{
+    XI_UNUSED( data_layer );
+
+    // PRECONDITIONS
+    assert( feed != 0 );
+
+    const char* params = 0;
+
+    if( feed->datastream_count > 0 )
+    {
+        int offset  = 0;
+        int size    = sizeof( XI_SOCKET_API_PARAMS );
+        int s       = 0;
+
+        for( size_t i = 0; i < feed->datastream_count; ++i )
+        {
+            s = snprintf( XI_SOCKET_API_PARAMS + offset, XI_MAX( size - offset, 0 )
+                , i == 0 ? "\"datastreams\":\"%s" : ",%s"
+                , feed->datastreams[ i ].datastream_id );
+            XI_CHECK_S( s, size, offset, XI_SOCKET_API_ENCODE_ERROR );
+        }
+
+        s = snprintf( XI_SOCKET_API_PARAMS + offset, XI_MAX( size - offset, 0 ), "\"" );
+        XI_CHECK_S( s, size, offset, XI_SOCKET_API_ENCODE_ERROR );
+
+        params = XI_SOCKET_API_PARAMS;
+    }
+
+    {
+        int s = snprintf( XI_SOCKET_API_RESOURCE, sizeof( XI_SOCKET_API_RESOURCE )
+            , "/feeds/%ld", ( long ) feed->feed_id );
+        XI_CHECK_SIZE( s, ( int ) sizeof( XI_SOCKET_API_RESOURCE ), XI_SOCKET_API_ENCODE_ERROR );
+    }
+
+    return socket_api_encode_request( buffer, buffer_size
+        , "get", XI_SOCKET_API_RESOURCE, params, api_key, 0, token );
+
+err_handling:
+    return -1;
+}
+
+int socket_api_encode_create_datastream(
+      char* buffer, size_t buffer_size, uint32_t token
+    , const data_layer_t* data_layer, const char* api_key, int32_t feed_id
+    , const char* datastream_id
+    , const xi_datapoint_t* datapoint )
+{
+    const char* body = data_layer->encode_create_datastream( datastream_id, datapoint );
+
+    if( body == 0 ) { return -1; }
+
+    const char* resource = socket_api_datastream_resource( feed_id, 0 );
+
+    if( resource == 0 ) { return -1; }
+
+    return socket_api_encode_request( buffer, buffer_size
+        , "post", resource, 0, api_key, body, token );
+}
+
+int socket_api_encode_update_datastream(
+      char* buffer, size_t buffer_size, uint32_t token
+    , const data_layer_t* data_layer, const char* api_key, int32_t feed_id
+    , const char* datastream_id
+    , const xi_datapoint_t* datapoint )
+{
+    const char* body = data_layer->encode_datapoint( datapoint );
+
+    if( body == 0 ) { return -1; }
+
+    const char* resource = socket_api_datastream_resource( feed_id, datastream_id );
+
+    if( resource == 0 ) { return -1; }
+
+    return socket_api_encode_request( buffer, buffer_size
+        , "put", resource, 0, api_key, body, token );
+}
+
+int socket_api_encode_get_datastream(
+      char* buffer, size_t buffer_size, uint32_t token
+    , const data_layer_t* data_layer, const char* api_key, int32_t feed_id
+    , const char* datastream_id )
+{
+    XI_UNUSED( data_layer );
+
+    const char* resource = socket_api_datastream_resource( feed_id, datastream_id );
+
+    if( resource == 0 ) { return -1; }
+
+    return socket_api_encode_request( buffer, buffer_size
+        , "get", resource, 0, api_key, 0, token );
+}
+
+int socket_api_encode_delete_datastream(
+      char* buffer, size_t buffer_size, uint32_t token
+    , const data_layer_t* data_layer, const char* api_key, int32_t feed_id
+    , const char* datastream_id )
+{
+    XI_UNUSED( data_layer );
+
+    const char* resource = socket_api_datastream_resource( feed_id, datastream_id );
+
+    if( resource == 0 ) { return -1; }
+
+    return socket_api_encode_request( buffer, buffer_size
+        , "delete", resource, 0, api_key, 0, token );
+}
+
+int socket_api_encode_delete_datapoint(
+      char* buffer, size_t buffer_size, uint32_t token
+    , const data_layer_t* data_layer, const char* api_key, int32_t feed_id
+    , const char* datastream_id
+    , const xi_datapoint_t* datapoint )
+{
+    XI_UNUSED( data_layer );
+
+    // PRECONDITIONS
+    assert( datapoint != 0 );
+
+    int offset  = 0;
+    int size    = sizeof( XI_SOCKET_API_RESOURCE );
+    int s       = 0;
+
+    s = snprintf( XI_SOCKET_API_RESOURCE, size, "/feeds/%ld/datastreams/%s/datapoints/"
+        , ( long ) feed_id, datastream_id );
+    XI_CHECK_S( s, size, offset, XI_SOCKET_API_ENCODE_ERROR );
+
+    s = xi_timestamp_to_str( XI_SOCKET_API_RESOURCE + offset, size - offset
+        , datapoint->timestamp.timestamp, datapoint->timestamp.micro );
+    XI_CHECK_S( s, size, offset, XI_SOCKET_API_ENCODE_ERROR );
+
+    return socket_api_encode_request( buffer, buffer_size
+        , "delete", XI_SOCKET_API_RESOURCE, 0, api_key, 0, token );
+
+err_handling:
+    return -1;
+}
+
+// writes `start` and `end` timestamps (either may be null) into the params buffer
+static int socket_api_range_params( const xi_timestamp_t* start, const xi_timestamp_t* end )
+{
+    int offset  = 0;
+    int size    = sizeof( XI_SOCKET_API_PARAMS );
+    int s       = 0;
+
+    XI_SOCKET_API_PARAMS[ 0 ] = '\0';
+
+    if( start )
+    {
+        s = snprintf( XI_SOCKET_API_PARAMS, size, "\"start\":\"" );
+        XI_CHECK_S( s, size, offset, XI_SOCKET_API_ENCODE_ERROR );
+
+        s = xi_timestamp_to_str( XI_SOCKET_API_PARAMS + offset, size - offset
+            , start->timestamp, start->micro );
+        XI_CHECK_S( s, size, offset, XI_SOCKET_API_ENCODE_ERROR );
+
+        s = snprintf( XI_SOCKET_API_PARAMS + offset, size - offset, "\"" );
+        XI_CHECK_S( s, size, offset, XI_SOCKET_API_ENCODE_ERROR );
+    }
+
+    if( end )
+    {
+        s = snprintf( XI_SOCKET_API_PARAMS + offset, size - offset
+            , start ? ",\"end\":\"" : "\"end\":\"" );
+        XI_CHECK_S( s, size, offset, XI_SOCKET_API_ENCODE_ERROR );
+
+        s = xi_timestamp_to_str( XI_SOCKET_API_PARAMS + offset, size - offset
+            , end->timestamp, end->micro );
+        XI_CHECK_S( s, size, offset, XI_SOCKET_API_ENCODE_ERROR );
+
+        s = snprintf( XI_SOCKET_API_PARAMS + offset, size - offset, "\"" );
+        XI_CHECK_S( s, size, offset, XI_SOCKET_API_ENCODE_ERROR );
+    }
+
+    return offset;
+
+err_handling:
+    return -1;
+}
+
+int socket_api_encode_datapoint_delete_range(
+      char* buffer, size_t buffer_size, uint32_t token
+    , const data_layer_t* data_layer, const char* api_key, int32_t feed_id
+    , const char* datastream_id
+    , const xi_timestamp_t* start
+    , const xi_timestamp_t* end )
+{
+    XI_UNUSED( data_layer );
+
+    XI_CHECK_CND( start == 0 && end == 0, XI_SOCKET_API_ENCODE_ERROR );
+
+    if( socket_api_range_params( start, end ) == -1 ) { return -1; }
+
+    {
+        int s = snprintf( XI_SOCKET_API_RESOURCE, sizeof( XI_SOCKET_API_RESOURCE )
+            , "/feeds/%ld/datastreams/%s/datapoints", ( long ) feed_id, datastream_id );
+        XI_CHECK_SIZE( s, ( int ) sizeof( XI_SOCKET_API_RESOURCE ), XI_SOCKET_API_ENCODE_ERROR );
+    }
+
+    return socket_api_encode_request( buffer, buffer_size
+        , "delete", XI_SOCKET_API_RESOURCE, XI_SOCKET_API_PARAMS, api_key, 0, token );
+
+err_handling:
+    return -1;
+}
+
+int socket_api_encode_get_datastream_history(
+      char* buffer, size_t buffer_size, uint32_t token
+    , const data_layer_t* data_layer, const char* api_key, int32_t feed_id
+    , const char* datastream_id
+    , const xi_timestamp_t* start
+    , const xi_timestamp_t* end
+    , uint32_t interval
+    , uint32_t limit )
+{
+    XI_UNUSED( data_layer );
+
+    // PRECONDITIONS
+    assert( start != 0 );
+
+    int offset  = socket_api_range_params( start, end );
+    int size    = sizeof( XI_SOCKET_API_PARAMS );
+    int s       = 0;
+
+    if( offset == -1 ) { return -1; }
+
+    if( interval )
+    {
+        s = snprintf( XI_SOCKET_API_PARAMS + offset, size - offset
+            , ",\"interval\":%lu", ( unsigned long ) interval );
+        XI_CHECK_S( s, size, offset, XI_SOCKET_API_ENCODE_ERROR );
+    }
+
+    s = snprintf( XI_SOCKET_API_PARAMS + offset, size - offset
+        , ",\"limit\":%lu", ( unsigned long ) limit );
+    XI_CHECK_S( s, size, offset, XI_SOCKET_API_ENCODE_ERROR );
+
+    s = snprintf( XI_SOCKET_API_RESOURCE, sizeof( XI_SOCKET_API_RESOURCE )
+        , "/feeds/%ld/datastreams/%s/datapoints", ( long ) feed_id, datastream_id );
+    XI_CHECK_SIZE( s, ( int ) sizeof( XI_SOCKET_API_RESOURCE ), XI_SOCKET_API_ENCODE_ERROR );
+
+    return socket_api_encode_request( buffer, buffer_size
+        , "get", XI_SOCKET_API_RESOURCE, XI_SOCKET_API_PARAMS, api_key, 0, token );
+
+err_handling:
+    return -1;
+}
+
+//-----------------------------------------------------------------------
+// DECODING
+//-----------------------------------------------------------------------
+
+// returns the position right past the string starting at `p` (which points at the opening quote)
+static const char* socket_api_skip_string( const char* p, const char* end )
+{
+    for( ++p; p < end; ++p )
+    {
+        if( *p == '\\' ) { ++p; continue; }
+        if( *p == '"' ) { return p + 1; }
+    }
+
+    return 0;
+}
+
+// returns the position right past the value starting at `p` or null if it's incomplete
+static const char* socket_api_skip_value( const char* p, const char* end )
+{
+    int depth = 0;
+
+    while( p < end )
+    {
+        switch( *p )
+        {
+            case '"':
+                p = socket_api_skip_string( p, end );
+                if( p == 0 ) { return 0; }
+                if( depth == 0 ) { return p; }
+                continue;
+            case '{':
+            case '[':
+                ++depth;
+                break;
+            case '}':
+            case ']':
+                if( depth == 0 ) { return p; } // end of the enclosing object
+                if( --depth == 0 ) { return p + 1; }
+                break;
+            case ',':
+                if( depth == 0 ) { return p; }
+                break;
+            default:
+                break;
+        }
+
+        ++p;
+    }
+
+    return 0;
+}
+
+static const char* socket_api_skip_space( const char* p, const char* end )
+{
+    while( p < end && ( *p == ' ' || *p == '\t' || *p == '\r' || *p == '\n' ) ) { ++p; }
+    return p;
+}
+
+int socket_api_message_size( const char* data, size_t data_size )
+{
+    const char* end = data + data_size;
+    const char* p   = socket_api_skip_space( data, end );
+
+    if( p == end ) { return 0; }
+    if( *p != '{' ) { return -1; }
+
+    p = socket_api_skip_value( p, end );
+
+    if( p == 0 ) { return 0; }
+
+    // swallow the separator, so the next message starts at the beginning of the buffer
+    p = socket_api_skip_space( p, end );
+
+    return ( int ) ( p - data );
+}
+
+// unescapes JSON string starting at the quote into `dst`, returns the size or -1
+static int socket_api_read_string( const char* p, const char* end, char* dst, size_t dst_size )
+{
+    size_t offset = 0;
+
+    for( ++p; p < end && *p != '"'; ++p )
+    {
+        char c = *p;
+
+        if( c == '\\' )
+        {
+            if( ++p == end ) { return -1; }
+
+            switch( *p )
+            {
+                case 'n':   c = '\n'; break;
+                case 'r':   c = '\r'; break;
+                case 't':   c = '\t'; break;
+                case 'b':   c = '\b'; break;
+                case 'f':   c = '\f'; break;
+                case 'u':
+                    {
+                        // only the code points we ever escape ourselves
+                        unsigned int u = 0;
+                        if( end - p < 5 || sscanf( p + 1, "%4x", &u ) != 1 || u > 0x7f ) { return -1; }
+                        c = ( char ) u;
+                        p += 4;
+                    }
+                    break;
+                default:    c = *p; break;
+            }
+        }
+
+        if( offset + 1 >= dst_size ) { return -1; }
+
+        dst[ offset++ ] = c;
+    }
+
+    if( p == end ) { return -1; }
+
+    dst[ offset ] = '\0';
+
+    return ( int ) offset;
+}
+
+http_response_t* socket_api_decode_reply(
+      http_response_t* response
+    , uint32_t* token
+    , const char* data, size_t data_size )
+{
+    // PRECONDITIONS
+    assert( response != 0 );
+    assert( token != 0 );
+    assert( data != 0 );
+
+    const char* end = data + data_size;
+    const char* p   = socket_api_skip_space( data, end );
+
+    memset( response, 0, sizeof( http_response_t ) );
+    *token = 0;
+
+    XI_CHECK_CND( p == end || *p != '{', XI_SOCKET_API_DECODE_ERROR );
+
+    p = socket_api_skip_space( p + 1, end );
+
+    while( p < end && *p != '}' )
+    {
+        const char* key = p;
+        const char* value = 0;
+
+        XI_CHECK_CND( *p != '"', XI_SOCKET_API_DECODE_ERROR );
+
+        p = socket_api_skip_string( p, end );
+        XI_CHECK_CND( p == 0, XI_SOCKET_API_DECODE_ERROR );
+
+        p = socket_api_skip_space( p, end );
+        XI_CHECK_CND( p == end || *p != ':', XI_SOCKET_API_DECODE_ERROR );
+
+        value = socket_api_skip_space( p + 1, end );
+        p = socket_api_skip_value( value, end );
+        XI_CHECK_CND( p == 0 || p == value, XI_SOCKET_API_DECODE_ERROR );
+
+        if( strncmp( key, "\"status\"", 8 ) == 0 )
+        {
+            response->http_status = atoi( value );
+        }
+        else if( strncmp( key, "\"token\"", 7 ) == 0 )
+        {
+            // tokens are ours, so they're always numbers in a string
+            *token = ( uint32_t ) strtoul( *value == '"' ? value + 1 : value, 0, 10 );
+        }
+        else if( strncmp( key, "\"body\"", 6 ) == 0 )
+        {
+            if( *value == '"' )
+            {
+                XI_CHECK_CND( socket_api_read_string( value, p, response->http_content
+                    , sizeof( response->http_content ) ) == -1, XI_SOCKET_API_DECODE_ERROR );
+            }
+            else
+            {
+                // not what we've asked for, but pass it on as is
+                size_t s = XI_MIN( ( size_t ) ( p - value ), sizeof( response->http_content ) - 1 );
+                memcpy( response->http_content, value, s );
+                response->http_content[ s ] = '\0';
+            }
+        }
+
+        p = socket_api_skip_space( p, end );
+
+        if( p < end && *p == ',' )
+        {
+            p = socket_api_skip_space( p + 1, end );
+        }
+    }
+
+    XI_CHECK_CND( p == end, XI_SOCKET_API_DECODE_ERROR );
+
+    return response;
+
+err_handling:
+    return 0;
+}
+
+#endif // XI_TRANSPORT_WS || XI_TRANSPORT_TCP
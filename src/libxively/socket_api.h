@@ -0,0 +1,129 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    socket_api.h
+ * \brief   Xively socket API messages, which are shared by the TCP and WebSocket _transport layers_
+ *
+ *    Every request is a JSON object that describes an equivalent REST call:
+ *
+ *        {"method":"put","resource":"/feeds/128.csv","headers":{"X-ApiKey":"..."},"body":"...","token":"7"}
+ *
+ *    and the reply refers back to it by the token:
+ *
+ *        {"status":200,"body":"...","resource":"/feeds/128.csv","token":"7"}
+ *
+ *    The resources use `.csv` representation, so the body is carried as a JSON string
+ *    holding whatever the _data layer_ has encoded.
+ */
+
+#ifndef __SOCKET_API_H__
+#define __SOCKET_API_H__
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "xively.h"
+#include "data_layer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief   Gives a new token for the next request, tokens are never `0`
+ */
+uint32_t socket_api_next_token( void );
+
+/**
+ * \brief   Gives the token most recently returned by `socket_api_next_token()`
+ */
+uint32_t socket_api_last_token( void );
+
+/**
+ * \brief   Request encoders, one for each of the _transport layer_ operations
+ *
+ *    Each of them renders a complete message into the buffer and tags it with the
+ *    given token, the framing is left to the _transport layer_.
+ *
+ * \return  Size of the message or -1 if an error occurred.
+ */
+int socket_api_encode_update_feed(
+      char* buffer, size_t buffer_size, uint32_t token
+    , const data_layer_t* data_layer, const char* api_key
+    , const xi_feed_t* feed );
+
+int socket_api_encode_get_feed(
+      char* buffer, size_t buffer_size, uint32_t token
+    , const data_layer_t* data_layer, const char* api_key
+    , const xi_feed_t* feed );
+
+int socket_api_encode_create_datastream(
+      char* buffer, size_t buffer_size, uint32_t token
+    , const data_layer_t* data_layer, const char* api_key, int32_t feed_id
+    , const char* datastream_id
+    , const xi_datapoint_t* datapoint );
+
+int socket_api_encode_update_datastream(
+      char* buffer, size_t buffer_size, uint32_t token
+    , const data_layer_t* data_layer, const char* api_key, int32_t feed_id
+    , const char* datastream_id
+    , const xi_datapoint_t* datapoint );
+
+int socket_api_encode_get_datastream(
+      char* buffer, size_t buffer_size, uint32_t token
+    , const data_layer_t* data_layer, const char* api_key, int32_t feed_id
+    , const char* datastream_id );
+
+int socket_api_encode_delete_datastream(
+      char* buffer, size_t buffer_size, uint32_t token
+    , const data_layer_t* data_layer, const char* api_key, int32_t feed_id
+    , const char* datastream_id );
+
+int socket_api_encode_delete_datapoint(
+      char* buffer, size_t buffer_size, uint32_t token
+    , const data_layer_t* data_layer, const char* api_key, int32_t feed_id
+    , const char* datastream_id
+    , const xi_datapoint_t* datapoint );
+
+int socket_api_encode_datapoint_delete_range(
+      char* buffer, size_t buffer_size, uint32_t token
+    , const data_layer_t* data_layer, const char* api_key, int32_t feed_id
+    , const char* datastream_id
+    , const xi_timestamp_t* start
+    , const xi_timestamp_t* end );
+
+int socket_api_encode_get_datastream_history(
+      char* buffer, size_t buffer_size, uint32_t token
+    , const data_layer_t* data_layer, const char* api_key, int32_t feed_id
+    , const char* datastream_id
+    , const xi_timestamp_t* start
+    , const xi_timestamp_t* end
+    , uint32_t interval
+    , uint32_t limit );
+
+/**
+ * \brief   Finds the end of the first complete JSON object in the buffer
+ *
+ * \return  Size of the object, 0 if more data is needed or -1 if it's not an object.
+ */
+int socket_api_message_size( const char* data, size_t data_size );
+
+/**
+ * \brief   Extracts status, token and body from a reply message
+ *
+ *    The body is unescaped into `response->http_content`, so the _data layer_ can
+ *    decode it as if it came over HTTP.
+ *
+ * \return  Pointer or null if an error occurred.
+ */
+http_response_t* socket_api_decode_reply(
+      http_response_t* response
+    , uint32_t* token
+    , const char* data, size_t data_size );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __SOCKET_API_H__
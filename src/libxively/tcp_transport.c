@@ -0,0 +1,42 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    tcp_transport.c
+ * \brief   Implements TCP _transport layer_ abstraction interface [see tcp_transport.h and transport_layer.h]
+ */
+
+#include "tcp_transport_layer.h"
+#include "tcp_transport.h"
+
+#ifdef XI_TRANSPORT_TCP
+
+transport_layer_t* get_tcp_transport_layer( void )
+{
+    static transport_layer_t __tcp_transport_layer =
+    {
+          &tcp_encode_update_feed
+        , &tcp_encode_get_feed
+        , &tcp_encode_create_datastream
+        , &tcp_encode_update_datastream
+        , &tcp_encode_get_datastream
+        , &tcp_encode_delete_datastream
+        , &tcp_encode_delete_datapoint
+        , &tcp_encode_datapoint_delete_range
+        , &tcp_encode_get_datastream_history
+        , &tcp_decode_reply
+        , &tcp_get_encoded_size
+        , &tcp_get_request_id
+        , &tcp_reply_size
+        , &tcp_open_session
+        , &tcp_close_session
+        , 0 // every request gets a reply
+        , 0 // no conditional requests
+        , 0 // bodies are encoded with the request
+        , 0 // replies are read whole
+    };
+
+    return &__tcp_transport_layer;
+}
+
+#endif // XI_TRANSPORT_TCP
@@ -0,0 +1,30 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    tcp_transport.h
+ * \brief   Implements TCP _transport layer_ abstraction interface
+ */
+
+#ifndef __TCP_TRANSPORT_H__
+#define __TCP_TRANSPORT_H__
+
+#include "transport_layer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+ /**
+ * \brief   Initialise TCP implementation of the _transport layer_
+ *
+ * \return  Structure with function pointers for TCP encoders and decoders
+ *          which had been implemented in `tcp_transport_layer.c`.
+ */
+transport_layer_t* get_tcp_transport_layer( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __TCP_TRANSPORT_H__
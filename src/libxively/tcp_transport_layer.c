@@ -0,0 +1,200 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    tcp_transport_layer.c
+ * \brief   Implements raw TCP _transport layer_ encoders and decoders specific to Xively socket API [see tcp_transport_layer.h]
+ */
+
+#include <string.h>
+#include <assert.h>
+
+#include "tcp_transport_layer.h"
+#include "socket_api.h"
+#include "transport_layer.h"
+#include "xi_macros.h"
+#include "xi_err.h"
+#include "xi_consts.h"
+
+#ifdef XI_TRANSPORT_TCP
+
+static char XI_TCP_QUERY_BUFFER[ XI_QUERY_BUFFER_SIZE + XI_CONTENT_BUFFER_SIZE ];
+static size_t XI_TCP_QUERY_SIZE = 0;
+
+// room for the newline that ends every message
+#define XI_TCP_MESSAGE_SIZE ( sizeof( XI_TCP_QUERY_BUFFER ) - 1 )
+
+static const char* tcp_terminate_message( int message_size )
+{
+    if( message_size < 0 ) { return 0; }
+
+    XI_TCP_QUERY_BUFFER[ message_size ] = '\n';
+    XI_TCP_QUERY_SIZE = message_size + 1;
+
+    return XI_TCP_QUERY_BUFFER;
+}
+
+const char* tcp_encode_create_datastream(
+          const data_layer_t* data_layer
+        , const char* x_api_key
+        , int32_t feed_id
+        , const char *datastream_id
+        , const xi_datapoint_t* datapoint )
+{
+    return tcp_terminate_message( socket_api_encode_create_datastream(
+          XI_TCP_QUERY_BUFFER, XI_TCP_MESSAGE_SIZE, socket_api_next_token()
+        , data_layer, x_api_key, feed_id, datastream_id, datapoint ) );
+}
+
+const char* tcp_encode_update_datastream(
+          const data_layer_t* data_layer
+        , const char* x_api_key
+        , int32_t feed_id
+        , const char *datastream_id
+        , const xi_datapoint_t* datapoint )
+{
+    return tcp_terminate_message( socket_api_encode_update_datastream(
+          XI_TCP_QUERY_BUFFER, XI_TCP_MESSAGE_SIZE, socket_api_next_token()
+        , data_layer, x_api_key, feed_id, datastream_id, datapoint ) );
+}
+
+const char* tcp_encode_get_datastream(
+          const data_layer_t* data_layer
+        , const char* x_api_key
+        , int32_t feed_id
+        , const char *datastream_id )
+{
+    return tcp_terminate_message( socket_api_encode_get_datastream(
+          XI_TCP_QUERY_BUFFER, XI_TCP_MESSAGE_SIZE, socket_api_next_token()
+        , data_layer, x_api_key, feed_id, datastream_id ) );
+}
+
+const char* tcp_encode_delete_datastream(
+          const data_layer_t* data_layer
+        , const char* x_api_key
+        , int32_t feed_id
+        , const char *datastream_id )
+{
+    return tcp_terminate_message( socket_api_encode_delete_datastream(
+          XI_TCP_QUERY_BUFFER, XI_TCP_MESSAGE_SIZE, socket_api_next_token()
+        , data_layer, x_api_key, feed_id, datastream_id ) );
+}
+
+const char* tcp_encode_delete_datapoint(
+          const data_layer_t* data_layer
+        , const char* x_api_key
+        , int32_t feed_id
+        , const char *datastream_id
+        , const xi_datapoint_t* o )
+{
+    return tcp_terminate_message( socket_api_encode_delete_datapoint(
+          XI_TCP_QUERY_BUFFER, XI_TCP_MESSAGE_SIZE, socket_api_next_token()
+        , data_layer, x_api_key, feed_id, datastream_id, o ) );
+}
+
+const char* tcp_encode_update_feed(
+          const data_layer_t* data_layer
+        , const char* x_api_key
+        , const xi_feed_t* feed )
+{
+    return tcp_terminate_message( socket_api_encode_update_feed(
+          XI_TCP_QUERY_BUFFER, XI_TCP_MESSAGE_SIZE, socket_api_next_token()
+        , data_layer, x_api_key, feed ) );
+}
+
+const char* tcp_encode_get_feed(
+        const data_layer_t* data_layer
+      , const char* x_api_key
+      , const xi_feed_t* feed )
+{
+    return tcp_terminate_message( socket_api_encode_get_feed(
+          XI_TCP_QUERY_BUFFER, XI_TCP_MESSAGE_SIZE, socket_api_next_token()
+        , data_layer, x_api_key, feed ) );
+}
+
+const char* tcp_encode_datapoint_delete_range(
+        const data_layer_t* data_layer
+      , const char* x_api_key
+      , int feed_id
+      , const char* datastream_id
+      , const xi_timestamp_t* start
+      , const xi_timestamp_t* end )
+{
+    return tcp_terminate_message( socket_api_encode_datapoint_delete_range(
+          XI_TCP_QUERY_BUFFER, XI_TCP_MESSAGE_SIZE, socket_api_next_token()
+        , data_layer, x_api_key, feed_id, datastream_id, start, end ) );
+}
+
+const char* tcp_encode_get_datastream_history(
+        const data_layer_t* data_layer
+      , const char* x_api_key
+      , int32_t feed_id
+      , const char* datastream_id
+      , const xi_timestamp_t* start
+      , const xi_timestamp_t* end
+      , uint32_t interval
+      , uint32_t limit )
+{
+    return tcp_terminate_message( socket_api_encode_get_datastream_history(
+          XI_TCP_QUERY_BUFFER, XI_TCP_MESSAGE_SIZE, socket_api_next_token()
+        , data_layer, x_api_key, feed_id, datastream_id, start, end, interval, limit ) );
+}
+
+const xi_response_t* tcp_decode_reply(
+          const data_layer_t* data_layer
+        , const char* data
+        , size_t data_size )
+{
+    XI_UNUSED( data_layer );
+
+    xi_response_t* __tmp = get_transport_response();
+
+    if( socket_api_decode_reply( &__tmp->http, &__tmp->request_id, data, data_size ) == 0 )
+    {
+        return 0;
+    }
+
+    return __tmp;
+}
+
+size_t tcp_get_encoded_size( void )
+{
+    return XI_TCP_QUERY_SIZE;
+}
+
+uint32_t tcp_get_request_id( void )
+{
+    return socket_api_last_token();
+}
+
+int tcp_reply_size( const char* data, size_t data_size )
+{
+    int s = socket_api_message_size( data, data_size );
+
+    XI_CHECK_CND( s == -1, XI_SOCKET_API_DECODE_ERROR );
+
+    return s;
+
+err_handling:
+    return -1;
+}
+
+int tcp_open_session( const comm_layer_t* comm_layer, connection_t* conn, const char* api_key )
+{
+    XI_UNUSED( comm_layer );
+    XI_UNUSED( conn );
+    XI_UNUSED( api_key );
+
+    // there is no handshake, but having a session keeps the connection open between calls
+    return 0;
+}
+
+int tcp_close_session( const comm_layer_t* comm_layer, connection_t* conn )
+{
+    XI_UNUSED( comm_layer );
+    XI_UNUSED( conn );
+
+    return 0;
+}
+
+#endif // XI_TRANSPORT_TCP
@@ -0,0 +1,105 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    tcp_transport_layer.h
+ * \brief   Implements raw TCP _transport layer_ encoders and decoders specific to Xively socket API
+ *
+ *    Requests are socket API messages (see `socket_api.h`) written one after another
+ *    to a persistent connection, each followed by a newline. Replies are delimited by
+ *    the JSON objects themselves and matched to the requests by their tokens, so any
+ *    number of requests can be outstanding and answered out of order.
+ */
+
+#ifndef __TCP_TRANSPORT_LAYER_H__
+#define __TCP_TRANSPORT_LAYER_H__
+
+#include "xively.h"
+#include "data_layer.h"
+#include "comm_layer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+const char* tcp_encode_create_datastream(
+          const data_layer_t*
+        , const char* x_api_key
+        , int32_t feed_id
+        , const char *datastream_id
+        , const xi_datapoint_t* value );
+
+const char* tcp_encode_update_datastream(
+          const data_layer_t*
+        , const char* x_api_key
+        , int32_t feed_id
+        , const char *datastream_id
+        , const xi_datapoint_t* value );
+
+const char* tcp_encode_get_datastream(
+          const data_layer_t*
+        , const char* x_api_key
+        , int32_t feed_id
+        , const char *datastream_id );
+
+const char* tcp_encode_delete_datastream(
+          const data_layer_t*
+        , const char* x_api_key
+        , int32_t feed_id
+        , const char *datastream_id );
+
+const char* tcp_encode_delete_datapoint(
+          const data_layer_t*
+        , const char* x_api_key
+        , int32_t feed_id
+        , const char *datastream_id
+        , const xi_datapoint_t* o );
+
+const char* tcp_encode_update_feed(
+          const data_layer_t*
+        , const char* x_api_key
+        , const xi_feed_t* feed );
+
+const char* tcp_encode_get_feed(
+        const data_layer_t*
+      , const char* x_api_key
+      , const xi_feed_t* feed );
+
+const char* tcp_encode_datapoint_delete_range(
+        const data_layer_t*
+      , const char* x_api_key
+      , int feed_id
+      , const char* datastream_id
+      , const xi_timestamp_t* start
+      , const xi_timestamp_t* end );
+
+const char* tcp_encode_get_datastream_history(
+        const data_layer_t*
+      , const char* x_api_key
+      , int32_t feed_id
+      , const char* datastream_id
+      , const xi_timestamp_t* start
+      , const xi_timestamp_t* end
+      , uint32_t interval
+      , uint32_t limit );
+
+const xi_response_t* tcp_decode_reply(
+          const data_layer_t*
+        , const char* data
+        , size_t data_size );
+
+size_t tcp_get_encoded_size( void );
+
+uint32_t tcp_get_request_id( void );
+
+int tcp_reply_size( const char* data, size_t data_size );
+
+int tcp_open_session( const comm_layer_t* comm_layer, connection_t* conn, const char* api_key );
+
+int tcp_close_session( const comm_layer_t* comm_layer, connection_t* conn );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __TCP_TRANSPORT_LAYER_H__
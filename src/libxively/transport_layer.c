@@ -0,0 +1,18 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    transport_layer.c
+ * \brief   Implements what the _transport layers_ have in common [see transport_layer.h]
+ */
+
+#include "xively.h"
+#include "transport_layer.h"
+
+// only one reply is decoded at a time, whichever transport it came over
+static xi_response_t XI_TRANSPORT_RESPONSE;
+
+xi_response_t* get_transport_response( void )
+{
+    return &XI_TRANSPORT_RESPONSE;
+}
@@ -12,6 +12,7 @@
 
 #include "xively.h"
 #include "data_layer.h"
+#include "comm_layer.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -32,6 +33,9 @@ extern "C" {
  *          top of the function definition, that is a macro that casts the pointer to unused _data layer_ to void.
  * \note    Similarly to the _data layer_ (see notes in `data_layer.h`), there no symmetry needed and we only have
  *          one decoder.
+ * \note    The session hooks at the bottom are optional (null for HTTP). Transports that implement
+ *          `open_session` are session-based: their connection is kept in the context and reused
+ *          by subsequent calls, replies are framed by `reply_size` and matched by request ids.
  */
 typedef struct {
     const char* ( *encode_update_feed )(
@@ -71,10 +75,99 @@ typedef struct {
         , const xi_timestamp_t* start
         , const xi_timestamp_t* end );
 
+    /**
+     * \brief   Encodes a request for at most `limit` datapoints from `start` (inclusive)
+     *          to `end` (may be null), aggregated over `interval` seconds unless it's 0
+     */
+    const char* ( *encode_get_datastream_history )(
+          const data_layer_t*, const char* api_key, int32_t feed_id
+        , const char* datastream_id
+        , const xi_timestamp_t* start
+        , const xi_timestamp_t* end
+        , uint32_t interval
+        , uint32_t limit );
+
     const xi_response_t* ( *decode_reply )(
-        const data_layer_t*, const char* data );
+        const data_layer_t*, const char* data, size_t data_size );
+
+    /**
+     * \brief   Gives the size of the most recently encoded request
+     *
+     * \note    Requests may carry binary data (e.g. compressed body),
+     *          hence `strlen()` must not be used to measure them.
+     */
+    size_t ( *get_encoded_size )( void );
+
+    /**
+     * \brief   Gives the id of the most recently encoded request, which the reply will carry
+     *          in `xi_response_t::request_id`
+     *
+     * \return  Non-zero id or `0` if replies come in order and have no ids.
+     */
+    uint32_t ( *get_request_id )( void );
+
+    /**
+     * \brief   Measures the reply at the beginning of the buffer
+     *
+     * \return  Size of the complete reply, `0` if more data is needed or `-1` if an error occurred.
+     */
+    int ( *reply_size )( const char* data, size_t data_size );
+
+    /**
+     * \brief   Prepares a freshly opened connection for requests (e.g. performs a handshake)
+     *
+     * \return  `0` on success or `-1` if an error occurred.
+     */
+    int ( *open_session )( const comm_layer_t*, connection_t*, const char* api_key );
+
+    /**
+     * \brief   Tells the server that the session ends, before the connection gets closed
+     *
+     * \return  `0` on success or `-1` if an error occurred.
+     */
+    int ( *close_session )( const comm_layer_t*, connection_t* );
+
+    /**
+     * \brief   Gives the reply to the most recently encoded request if the server
+     *          is not going to send one (e.g. MQTT publish with QoS 0)
+     *
+     * \return  Pointer to the reply or null if it has to be read from the connection.
+     */
+    const xi_response_t* ( *get_immediate_reply )( void );
+
+    /**
+     * \brief   Makes the next `GET` encoded conditional on the validators of the previous
+     *          reply (either may be null), so that unchanged resources get `304 Not Modified`
+     *
+     * \return  `0` on success or `-1` if an error occurred.
+     */
+    int ( *set_request_validators )( const char* etag, const char* last_modified );
+
+    /**
+     * \brief   Sends the body of the most recently encoded request after the request itself
+     *          was sent, if the body was too big to be encoded with it (e.g. a large feed update)
+     *          or is compressed on its way out
+     *
+     * \return  `0` on success or if there is no such body, `-1` if an error occurred.
+     */
+    int ( *send_body )( const comm_layer_t*, connection_t* );
+
+    /**
+     * \brief   Reads the rest of the reply decoded last into the given buffer, a piece at
+     *          a time, if it didn't all come with the first read (e.g. a large compressed body)
+     *
+     * \return  `0` on success or if there is nothing more to read, `-1` if an error occurred.
+     */
+    int ( *read_body )( const comm_layer_t*, connection_t*, char* buffer, size_t buffer_size );
 } transport_layer_t;
 
+/**
+ * \brief   Gives the response that the transports decode replies into
+ *
+ *    There is one for all of them, so a reply is valid until the next one is decoded.
+ */
+xi_response_t* get_transport_response( void );
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,378 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    ws_layer_frames.c
+ * \brief   WebSocket framing and opening handshake [see ws_layer_frames.h]
+ */
+
+#include <string.h>
+#include <strings.h>
+#include <stdio.h>
+#include <assert.h>
+
+#include "xively.h"
+#include "ws_layer_frames.h"
+#include "http_consts.h"
+#include "xi_macros.h"
+#include "xi_err.h"
+#include "xi_consts.h"
+#include "xi_helpers.h"
+#include "comm_layer.h"
+
+#ifdef XI_TRANSPORT_WS
+
+static const char XI_WS_GUID[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+static char XI_WS_HANDSHAKE_BUFFER[ XI_QUERY_BUFFER_SIZE ];
+
+//-----------------------------------------------------------------------
+// FRAMES
+//-----------------------------------------------------------------------
+
+size_t ws_construct_frame_header(
+      char* header, ws_opcode_t opcode
+    , size_t payload_size, uint32_t mask )
+{
+    // PRECONDITIONS
+    assert( header != 0 );
+
+    size_t offset = 0;
+
+    header[ offset++ ] = ( char ) ( 0x80 | opcode );
+
+    if( payload_size < 126 )
+    {
+        header[ offset++ ] = ( char ) ( 0x80 | payload_size );
+    }
+    else if( payload_size <= 0xFFFF )
+    {
+        header[ offset++ ] = ( char ) ( 0x80 | 126 );
+        header[ offset++ ] = ( char ) ( payload_size >> 8 );
+        header[ offset++ ] = ( char ) ( payload_size );
+    }
+    else
+    {
+        header[ offset++ ] = ( char ) ( 0x80 | 127 );
+
+        for( int i = 7; i >= 0; --i )
+        {
+            header[ offset++ ] = ( char ) ( ( uint64_t ) payload_size >> ( i * 8 ) );
+        }
+    }
+
+    header[ offset++ ] = ( char ) ( mask >> 24 );
+    header[ offset++ ] = ( char ) ( mask >> 16 );
+    header[ offset++ ] = ( char ) ( mask >> 8 );
+    header[ offset++ ] = ( char ) ( mask );
+
+    return offset;
+}
+
+void ws_mask_payload( char* payload, size_t payload_size, uint32_t mask )
+{
+    const uint8_t key[ 4 ] = {
+          ( uint8_t ) ( mask >> 24 ), ( uint8_t ) ( mask >> 16 )
+        , ( uint8_t ) ( mask >> 8 ), ( uint8_t ) ( mask ) };
+
+    for( size_t i = 0; i < payload_size; ++i )
+    {
+        payload[ i ] ^= key[ i & 3 ];
+    }
+}
+
+int ws_parse_frame(
+      const char* data, size_t data_size
+    , ws_opcode_t* opcode
+    , size_t* payload_offset, size_t* payload_size )
+{
+    // PRECONDITIONS
+    assert( data != 0 );
+    assert( opcode != 0 );
+    assert( payload_offset != 0 );
+    assert( payload_size != 0 );
+
+    const uint8_t* p    = ( const uint8_t* ) data;
+    size_t offset       = 2;
+    uint64_t size       = 0;
+
+    if( data_size < 2 ) { return 0; }
+
+    // we never negotiate extensions, so reserved bits must be clear, nor we expect fragments
+    XI_CHECK_CND( ( p[ 0 ] & 0x70 ) != 0 || ( p[ 0 ] & 0x80 ) == 0, XI_WS_FRAME_ERROR );
+
+    size = p[ 1 ] & 0x7F;
+
+    if( size == 126 )
+    {
+        if( data_size < 4 ) { return 0; }
+        size    = ( ( uint64_t ) p[ 2 ] << 8 ) | p[ 3 ];
+        offset  = 4;
+    }
+    else if( size == 127 )
+    {
+        if( data_size < 10 ) { return 0; }
+        size = 0;
+        for( int i = 0; i < 8; ++i )
+        {
+            size = ( size << 8 ) | p[ 2 + i ];
+        }
+        offset = 10;
+    }
+
+    // servers must not mask their frames
+    XI_CHECK_CND( ( p[ 1 ] & 0x80 ) != 0, XI_WS_FRAME_ERROR );
+    XI_CHECK_CND( size > ( uint64_t ) XI_HTTP_MAX_CONTENT_SIZE * 4, XI_WS_FRAME_ERROR );
+
+    if( data_size < offset + size ) { return 0; }
+
+    *opcode         = ( ws_opcode_t ) ( p[ 0 ] & 0x0F );
+    *payload_offset = offset;
+    *payload_size   = ( size_t ) size;
+
+    return ( int ) ( offset + size );
+
+err_handling:
+    return -1;
+}
+
+//-----------------------------------------------------------------------
+// KEYS
+//-----------------------------------------------------------------------
+
+// RFC 6455 asks for the masking key and the handshake nonce to come from a strong
+// source of entropy, the software generator is only used where the platform has none
+static void ws_random_bytes( uint8_t* buffer, size_t size )
+{
+    const comm_layer_t* comm_layer = get_comm_layer();
+
+    if( comm_layer->get_random && comm_layer->get_random( buffer, size ) == 0 )
+    {
+        return;
+    }
+
+    for( size_t i = 0; i < size; ++i )
+    {
+        buffer[ i ] = ( uint8_t ) ( xi_random() >> 24 );
+    }
+}
+
+uint32_t ws_generate_mask( void )
+{
+    uint32_t mask = 0;
+
+    ws_random_bytes( ( uint8_t* ) &mask, sizeof( mask ) );
+
+    return mask;
+}
+
+static void ws_base64_encode( const uint8_t* src, size_t src_size, char* dst )
+{
+    static const char alphabet[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    size_t i = 0;
+
+    for( ; i + 2 < src_size; i += 3 )
+    {
+        uint32_t v = ( src[ i ] << 16 ) | ( src[ i + 1 ] << 8 ) | src[ i + 2 ];
+        *dst++ = alphabet[ ( v >> 18 ) & 0x3F ];
+        *dst++ = alphabet[ ( v >> 12 ) & 0x3F ];
+        *dst++ = alphabet[ ( v >> 6 ) & 0x3F ];
+        *dst++ = alphabet[ v & 0x3F ];
+    }
+
+    if( i < src_size )
+    {
+        uint32_t v = src[ i ] << 16;
+        if( i + 1 < src_size ) { v |= src[ i + 1 ] << 8; }
+
+        *dst++ = alphabet[ ( v >> 18 ) & 0x3F ];
+        *dst++ = alphabet[ ( v >> 12 ) & 0x3F ];
+        *dst++ = i + 1 < src_size ? alphabet[ ( v >> 6 ) & 0x3F ] : '=';
+        *dst++ = '=';
+    }
+
+    *dst = '\0';
+}
+
+#define XI_WS_SHA1_ROTL(x,n) ( ( (x) << (n) ) | ( (x) >> ( 32 - (n) ) ) )
+
+static void ws_sha1_block( uint32_t h[ 5 ], const uint8_t block[ 64 ] )
+{
+    uint32_t w[ 80 ];
+
+    for( int i = 0; i < 16; ++i )
+    {
+        w[ i ] = ( ( uint32_t ) block[ i * 4 ] << 24 ) | ( ( uint32_t ) block[ i * 4 + 1 ] << 16 )
+               | ( ( uint32_t ) block[ i * 4 + 2 ] << 8 ) | block[ i * 4 + 3 ];
+    }
+
+    for( int i = 16; i < 80; ++i )
+    {
+        w[ i ] = XI_WS_SHA1_ROTL( w[ i - 3 ] ^ w[ i - 8 ] ^ w[ i - 14 ] ^ w[ i - 16 ], 1 );
+    }
+
+    uint32_t a = h[ 0 ], b = h[ 1 ], c = h[ 2 ], d = h[ 3 ], e = h[ 4 ];
+
+    for( int i = 0; i < 80; ++i )
+    {
+        uint32_t f, k;
+
+        if( i < 20 )        { f = ( b & c ) | ( ~b & d );            k = 0x5A827999; }
+        else if( i < 40 )   { f = b ^ c ^ d;                         k = 0x6ED9EBA1; }
+        else if( i < 60 )   { f = ( b & c ) | ( b & d ) | ( c & d ); k = 0x8F1BBCDC; }
+        else                { f = b ^ c ^ d;                         k = 0xCA62C1D6; }
+
+        uint32_t t = XI_WS_SHA1_ROTL( a, 5 ) + f + e + k + w[ i ];
+        e = d;
+        d = c;
+        c = XI_WS_SHA1_ROTL( b, 30 );
+        b = a;
+        a = t;
+    }
+
+    h[ 0 ] += a; h[ 1 ] += b; h[ 2 ] += c; h[ 3 ] += d; h[ 4 ] += e;
+}
+
+// the input is tiny (key and GUID), so it's done in one go
+static void ws_sha1( const uint8_t* src, size_t src_size, uint8_t digest[ 20 ] )
+{
+    uint32_t h[ 5 ] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+    uint8_t block[ 64 ];
+    size_t i = 0;
+
+    for( ; i + 64 <= src_size; i += 64 )
+    {
+        ws_sha1_block( h, src + i );
+    }
+
+    size_t rest = src_size - i;
+    memset( block, 0, sizeof( block ) );
+    memcpy( block, src + i, rest );
+    block[ rest ] = 0x80;
+
+    if( rest >= 56 )
+    {
+        ws_sha1_block( h, block );
+        memset( block, 0, sizeof( block ) );
+    }
+
+    uint64_t bits = ( uint64_t ) src_size * 8;
+
+    for( int j = 0; j < 8; ++j )
+    {
+        block[ 63 - j ] = ( uint8_t ) ( bits >> ( j * 8 ) );
+    }
+
+    ws_sha1_block( h, block );
+
+    for( int j = 0; j < 20; ++j )
+    {
+        digest[ j ] = ( uint8_t ) ( h[ j / 4 ] >> ( 24 - ( j % 4 ) * 8 ) );
+    }
+}
+
+void ws_generate_key( char key[ XI_WS_KEY_SIZE ] )
+{
+    uint8_t nonce[ 16 ];
+
+    ws_random_bytes( nonce, sizeof( nonce ) );
+
+    ws_base64_encode( nonce, sizeof( nonce ), key );
+}
+
+void ws_compute_accept( const char* key, char accept[ XI_WS_ACCEPT_SIZE ] )
+{
+    char concat[ XI_WS_KEY_SIZE + sizeof( XI_WS_GUID ) ];
+    uint8_t digest[ 20 ];
+
+    int s = snprintf( concat, sizeof( concat ), "%s%s", key, XI_WS_GUID );
+
+    ws_sha1( ( const uint8_t* ) concat, XI_MIN( ( size_t ) s, sizeof( concat ) - 1 ), digest );
+    ws_base64_encode( digest, sizeof( digest ), accept );
+}
+
+//-----------------------------------------------------------------------
+// HANDSHAKE
+//-----------------------------------------------------------------------
+
+const char* ws_construct_handshake( const char* host, int32_t port, const char* key )
+{
+    int s = snprintf( XI_WS_HANDSHAKE_BUFFER, sizeof( XI_WS_HANDSHAKE_BUFFER )
+        , "GET / HTTP/1.1\r\n"
+          "Host: %s:%ld\r\n"
+          "User-Agent: %s\r\n"
+          "Upgrade: websocket\r\n"
+          "Connection: Upgrade\r\n"
+          "Sec-WebSocket-Key: %s\r\n"
+          "Sec-WebSocket-Version: 13\r\n"
+          "\r\n"
+        , host, ( long ) port, XI_USER_AGENT, key );
+
+    XI_CHECK_SIZE( s, ( int ) sizeof( XI_WS_HANDSHAKE_BUFFER ), XI_WS_HANDSHAKE_ERROR );
+
+    return XI_WS_HANDSHAKE_BUFFER;
+
+err_handling:
+    return 0;
+}
+
+int ws_check_handshake( const char* data, size_t data_size, const char* key )
+{
+    static const char status[]  = "HTTP/1.1 101 ";
+    static const char name[]    = "Sec-WebSocket-Accept:";
+
+    size_t header_size  = 0;
+    char accept[ XI_WS_ACCEPT_SIZE ];
+
+    // the server won't say anything else until it sees our frames, so the headers are all we wait for
+    for( size_t i = 0; i + 4 <= data_size; ++i )
+    {
+        if( memcmp( data + i, XI_HTTP_CRLFX2, 4 ) == 0 )
+        {
+            header_size = i + 4;
+            break;
+        }
+    }
+
+    if( header_size == 0 ) { return 0; }
+
+    XI_CHECK_CND( header_size < sizeof( status ) - 1
+        || memcmp( data, status, sizeof( status ) - 1 ) != 0, XI_WS_HANDSHAKE_ERROR );
+
+    ws_compute_accept( key, accept );
+
+    // only the one header matters, so the lines are looked through as they are
+    for( const char* line = data; line < data + header_size; )
+    {
+        const char* line_end = memchr( line, '\n', data + header_size - line );
+
+        if( line_end == 0 ) { break; }
+
+        if( ( size_t ) ( line_end - line ) > sizeof( name ) - 1
+         && strncasecmp( line, name, sizeof( name ) - 1 ) == 0 )
+        {
+            const char* value   = line + sizeof( name ) - 1;
+            const char* end     = line_end;
+
+            while( value < end && *value == ' ' ) { ++value; }
+            while( end > value && ( end[ -1 ] == '\r' || end[ -1 ] == ' ' ) ) { --end; }
+
+            if( ( size_t ) ( end - value ) == strlen( accept )
+             && memcmp( value, accept, end - value ) == 0 )
+            {
+                return ( int ) header_size;
+            }
+        }
+
+        line = line_end + 1;
+    }
+
+    xi_set_err( XI_WS_HANDSHAKE_ERROR );
+
+err_handling:
+    return -1;
+}
+
+#endif // XI_TRANSPORT_WS
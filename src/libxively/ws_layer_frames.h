@@ -0,0 +1,96 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    ws_layer_frames.h
+ * \brief   WebSocket framing and opening handshake (RFC 6455)
+ *
+ *    Only what the client side needs is implemented: it sends masked frames,
+ *    which always fit in one piece, and receives unmasked ones from the server.
+ */
+
+#ifndef __WS_LAYER_FRAMES_H__
+#define __WS_LAYER_FRAMES_H__
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Biggest header of a client frame: 2 bytes, 64-bit length and the masking key */
+#define XI_WS_MAX_HEADER_SIZE   14
+
+/** Size of the `Sec-WebSocket-Key` value including the terminator */
+#define XI_WS_KEY_SIZE          25
+
+/** Size of the `Sec-WebSocket-Accept` value including the terminator */
+#define XI_WS_ACCEPT_SIZE       29
+
+typedef enum
+{
+    XI_WS_OPCODE_CONTINUATION   = 0x0,
+    XI_WS_OPCODE_TEXT           = 0x1,
+    XI_WS_OPCODE_BINARY         = 0x2,
+    XI_WS_OPCODE_CLOSE          = 0x8,
+    XI_WS_OPCODE_PING           = 0x9,
+    XI_WS_OPCODE_PONG           = 0xA
+} ws_opcode_t;
+
+/**
+ * \brief   Writes header of a final client frame, the masking key included
+ *
+ *    The payload has to follow the header and be masked with `ws_mask_payload()`.
+ *
+ * \return  Size of the header.
+ */
+size_t ws_construct_frame_header(
+      char* header, ws_opcode_t opcode
+    , size_t payload_size, uint32_t mask );
+
+/**
+ * \brief   Applies (or removes) the masking key in place
+ */
+void ws_mask_payload( char* payload, size_t payload_size, uint32_t mask );
+
+/**
+ * \brief   Parses header of a frame from the beginning of the buffer
+ *
+ * \return  Size of the whole frame, 0 if more data is needed or -1 if an error occurred.
+ */
+int ws_parse_frame(
+      const char* data, size_t data_size
+    , ws_opcode_t* opcode
+    , size_t* payload_offset, size_t* payload_size );
+
+/**
+ * \brief   Generates random `Sec-WebSocket-Key` and masking keys
+ */
+void ws_generate_key( char key[ XI_WS_KEY_SIZE ] );
+uint32_t ws_generate_mask( void );
+
+/**
+ * \brief   Computes `Sec-WebSocket-Accept` value the server has to respond with
+ */
+void ws_compute_accept( const char* key, char accept[ XI_WS_ACCEPT_SIZE ] );
+
+/**
+ * \brief   Builds the upgrade request
+ *
+ * \return  Pointer to the static buffer or null if an error occurred.
+ */
+const char* ws_construct_handshake( const char* host, int32_t port, const char* key );
+
+/**
+ * \brief   Checks the server's response to the upgrade request
+ *
+ * \return  Size of the response, 0 if more data is needed or -1 if the upgrade has failed.
+ */
+int ws_check_handshake( const char* data, size_t data_size, const char* key );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __WS_LAYER_FRAMES_H__
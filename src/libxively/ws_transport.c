@@ -0,0 +1,42 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    ws_transport.c
+ * \brief   Implements WebSocket _transport layer_ abstraction interface [see ws_transport.h and transport_layer.h]
+ */
+
+#include "ws_transport_layer.h"
+#include "ws_transport.h"
+
+#ifdef XI_TRANSPORT_WS
+
+transport_layer_t* get_ws_transport_layer( void )
+{
+    static transport_layer_t __ws_transport_layer =
+    {
+          &ws_encode_update_feed
+        , &ws_encode_get_feed
+        , &ws_encode_create_datastream
+        , &ws_encode_update_datastream
+        , &ws_encode_get_datastream
+        , &ws_encode_delete_datastream
+        , &ws_encode_delete_datapoint
+        , &ws_encode_datapoint_delete_range
+        , &ws_encode_get_datastream_history
+        , &ws_decode_reply
+        , &ws_get_encoded_size
+        , &ws_get_request_id
+        , &ws_reply_size
+        , &ws_open_session
+        , &ws_close_session
+        , 0 // every request gets a reply
+        , 0 // no conditional requests
+        , 0 // bodies are encoded with the request
+        , 0 // replies are read whole
+    };
+
+    return &__ws_transport_layer;
+}
+
+#endif // XI_TRANSPORT_WS
@@ -0,0 +1,285 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    ws_transport_layer.c
+ * \brief   Implements WebSocket _transport layer_ encoders and decoders specific to Xively socket API [see ws_transport_layer.h]
+ */
+
+#include <string.h>
+#include <assert.h>
+
+#include "ws_transport_layer.h"
+#include "ws_layer_frames.h"
+#include "transport_layer.h"
+#include "socket_api.h"
+#include "xi_macros.h"
+#include "xi_err.h"
+#include "xi_consts.h"
+
+#ifdef XI_TRANSPORT_WS
+
+// the message is rendered behind the room for the biggest header, the actual header
+// is then put right in front of it, so the frame is contiguous without copying
+static char XI_WS_FRAME_BUFFER[ XI_WS_MAX_HEADER_SIZE + XI_QUERY_BUFFER_SIZE + XI_CONTENT_BUFFER_SIZE ];
+static size_t XI_WS_FRAME_SIZE = 0;
+
+#define XI_WS_PAYLOAD       ( XI_WS_FRAME_BUFFER + XI_WS_MAX_HEADER_SIZE )
+#define XI_WS_PAYLOAD_SIZE  ( sizeof( XI_WS_FRAME_BUFFER ) - XI_WS_MAX_HEADER_SIZE )
+
+static const char* ws_frame_payload( int payload_size )
+{
+    if( payload_size < 0 ) { return 0; }
+
+    char header[ XI_WS_MAX_HEADER_SIZE ];
+    uint32_t mask = ws_generate_mask();
+
+    size_t header_size = ws_construct_frame_header(
+        header, XI_WS_OPCODE_TEXT, payload_size, mask );
+
+    char* frame = XI_WS_PAYLOAD - header_size;
+
+    memcpy( frame, header, header_size );
+    ws_mask_payload( XI_WS_PAYLOAD, payload_size, mask );
+
+    XI_WS_FRAME_SIZE = header_size + payload_size;
+
+    return frame;
+}
+
+const char* ws_encode_create_datastream(
+          const data_layer_t* data_layer
+        , const char* x_api_key
+        , int32_t feed_id
+        , const char *datastream_id
+        , const xi_datapoint_t* datapoint )
+{
+    return ws_frame_payload( socket_api_encode_create_datastream(
+          XI_WS_PAYLOAD, XI_WS_PAYLOAD_SIZE, socket_api_next_token()
+        , data_layer, x_api_key, feed_id, datastream_id, datapoint ) );
+}
+
+const char* ws_encode_update_datastream(
+          const data_layer_t* data_layer
+        , const char* x_api_key
+        , int32_t feed_id
+        , const char *datastream_id
+        , const xi_datapoint_t* datapoint )
+{
+    return ws_frame_payload( socket_api_encode_update_datastream(
+          XI_WS_PAYLOAD, XI_WS_PAYLOAD_SIZE, socket_api_next_token()
+        , data_layer, x_api_key, feed_id, datastream_id, datapoint ) );
+}
+
+const char* ws_encode_get_datastream(
+          const data_layer_t* data_layer
+        , const char* x_api_key
+        , int32_t feed_id
+        , const char *datastream_id )
+{
+    return ws_frame_payload( socket_api_encode_get_datastream(
+          XI_WS_PAYLOAD, XI_WS_PAYLOAD_SIZE, socket_api_next_token()
+        , data_layer, x_api_key, feed_id, datastream_id ) );
+}
+
+const char* ws_encode_delete_datastream(
+          const data_layer_t* data_layer
+        , const char* x_api_key
+        , int32_t feed_id
+        , const char *datastream_id )
+{
+    return ws_frame_payload( socket_api_encode_delete_datastream(
+          XI_WS_PAYLOAD, XI_WS_PAYLOAD_SIZE, socket_api_next_token()
+        , data_layer, x_api_key, feed_id, datastream_id ) );
+}
+
+const char* ws_encode_delete_datapoint(
+          const data_layer_t* data_layer
+        , const char* x_api_key
+        , int32_t feed_id
+        , const char *datastream_id
+        , const xi_datapoint_t* o )
+{
+    return ws_frame_payload( socket_api_encode_delete_datapoint(
+          XI_WS_PAYLOAD, XI_WS_PAYLOAD_SIZE, socket_api_next_token()
+        , data_layer, x_api_key, feed_id, datastream_id, o ) );
+}
+
+const char* ws_encode_update_feed(
+          const data_layer_t* data_layer
+        , const char* x_api_key
+        , const xi_feed_t* feed )
+{
+    return ws_frame_payload( socket_api_encode_update_feed(
+          XI_WS_PAYLOAD, XI_WS_PAYLOAD_SIZE, socket_api_next_token()
+        , data_layer, x_api_key, feed ) );
+}
+
+const char* ws_encode_get_feed(
+        const data_layer_t* data_layer
+      , const char* x_api_key
+      , const xi_feed_t* feed )
+{
+    return ws_frame_payload( socket_api_encode_get_feed(
+          XI_WS_PAYLOAD, XI_WS_PAYLOAD_SIZE, socket_api_next_token()
+        , data_layer, x_api_key, feed ) );
+}
+
+const char* ws_encode_datapoint_delete_range(
+        const data_layer_t* data_layer
+      , const char* x_api_key
+      , int feed_id
+      , const char* datastream_id
+      , const xi_timestamp_t* start
+      , const xi_timestamp_t* end )
+{
+    return ws_frame_payload( socket_api_encode_datapoint_delete_range(
+          XI_WS_PAYLOAD, XI_WS_PAYLOAD_SIZE, socket_api_next_token()
+        , data_layer, x_api_key, feed_id, datastream_id, start, end ) );
+}
+
+const char* ws_encode_get_datastream_history(
+        const data_layer_t* data_layer
+      , const char* x_api_key
+      , int32_t feed_id
+      , const char* datastream_id
+      , const xi_timestamp_t* start
+      , const xi_timestamp_t* end
+      , uint32_t interval
+      , uint32_t limit )
+{
+    return ws_frame_payload( socket_api_encode_get_datastream_history(
+          XI_WS_PAYLOAD, XI_WS_PAYLOAD_SIZE, socket_api_next_token()
+        , data_layer, x_api_key, feed_id, datastream_id, start, end, interval, limit ) );
+}
+
+const xi_response_t* ws_decode_reply(
+          const data_layer_t* data_layer
+        , const char* data
+        , size_t data_size )
+{
+    XI_UNUSED( data_layer );
+
+    xi_response_t* __tmp = get_transport_response();
+
+    ws_opcode_t opcode      = XI_WS_OPCODE_CONTINUATION;
+    size_t payload_offset   = 0;
+    size_t payload_size     = 0;
+
+    int s = ws_parse_frame( data, data_size, &opcode, &payload_offset, &payload_size );
+
+    if( s == -1 ) { return 0; }
+
+    XI_CHECK_CND( s == 0, XI_WS_FRAME_ERROR );
+
+    switch( opcode )
+    {
+        case XI_WS_OPCODE_TEXT:
+        case XI_WS_OPCODE_BINARY:
+            if( socket_api_decode_reply( &__tmp->http, &__tmp->request_id
+                , data + payload_offset, payload_size ) == 0 )
+            {
+                return 0;
+            }
+            break;
+        case XI_WS_OPCODE_CLOSE:
+            XI_CHECK_CND( 1, XI_WS_CONNECTION_CLOSED );
+            break;
+        default:
+            // pings are not answered, the server gets our next request instead
+            memset( __tmp, 0, sizeof( *__tmp ) );
+            break;
+    }
+
+    return __tmp;
+
+err_handling:
+    return 0;
+}
+
+size_t ws_get_encoded_size( void )
+{
+    return XI_WS_FRAME_SIZE;
+}
+
+uint32_t ws_get_request_id( void )
+{
+    return socket_api_last_token();
+}
+
+int ws_reply_size( const char* data, size_t data_size )
+{
+    ws_opcode_t opcode      = XI_WS_OPCODE_CONTINUATION;
+    size_t payload_offset   = 0;
+    size_t payload_size     = 0;
+
+    return ws_parse_frame( data, data_size, &opcode, &payload_offset, &payload_size );
+}
+
+int ws_open_session( const comm_layer_t* comm_layer, connection_t* conn, const char* api_key )
+{
+    XI_UNUSED( api_key ); // it goes with every request
+
+    // PRECONDITIONS
+    assert( comm_layer != 0 );
+    assert( conn != 0 );
+
+    char key[ XI_WS_KEY_SIZE ];
+    char buffer[ XI_QUERY_BUFFER_SIZE ];
+    size_t size = 0;
+
+    ws_generate_key( key );
+
+    const char* request = ws_construct_handshake( conn->address, conn->port, key );
+
+    if( request == 0 ) { return -1; }
+
+    if( comm_layer->send_data( conn, request, strlen( request ) ) == -1 ) { return -1; }
+
+    buffer[ 0 ] = '\0';
+
+    for( ;; )
+    {
+        int s = ws_check_handshake( buffer, size, key );
+
+        // the server doesn't send frames until it gets a request, so nothing is left over
+        if( s > 0 ) { return 0; }
+        if( s == -1 ) { return -1; }
+
+        XI_CHECK_CND( size + 1 >= sizeof( buffer ), XI_WS_HANDSHAKE_ERROR );
+
+        int r = comm_layer->read_data( conn, buffer + size, sizeof( buffer ) - size - 1 );
+
+        if( r == -1 ) { return -1; }
+
+        XI_CHECK_CND( r == 0, XI_WS_HANDSHAKE_ERROR );
+
+        size += r;
+        buffer[ size ] = '\0';
+    }
+
+err_handling:
+    return -1;
+}
+
+int ws_close_session( const comm_layer_t* comm_layer, connection_t* conn )
+{
+    // PRECONDITIONS
+    assert( comm_layer != 0 );
+    assert( conn != 0 );
+
+    // status code 1000, normal closure
+    char frame[ XI_WS_MAX_HEADER_SIZE + 2 ];
+    uint32_t mask = ws_generate_mask();
+
+    size_t header_size = ws_construct_frame_header( frame, XI_WS_OPCODE_CLOSE, 2, mask );
+
+    frame[ header_size ]        = ( char ) 0x03;
+    frame[ header_size + 1 ]    = ( char ) 0xE8;
+
+    ws_mask_payload( frame + header_size, 2, mask );
+
+    return comm_layer->send_data( conn, frame, header_size + 2 ) == -1 ? -1 : 0;
+}
+
+#endif // XI_TRANSPORT_WS
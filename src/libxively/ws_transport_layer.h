@@ -0,0 +1,108 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    ws_transport_layer.h
+ * \brief   Implements WebSocket _transport layer_ encoders and decoders specific to Xively socket API
+ *
+ *    Requests are socket API messages (see `socket_api.h`) sent as masked text frames
+ *    over a connection that had been upgraded once in `ws_open_session()`. Every request
+ *    gets a new token, so the replies can be told apart when several are in flight.
+ */
+
+#ifndef __WS_TRANSPORT_LAYER_H__
+#define __WS_TRANSPORT_LAYER_H__
+
+#include "xively.h"
+#include "data_layer.h"
+#include "comm_layer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+const char* ws_encode_create_datastream(
+          const data_layer_t*
+        , const char* x_api_key
+        , int32_t feed_id
+        , const char *datastream_id
+        , const xi_datapoint_t* value );
+
+const char* ws_encode_update_datastream(
+          const data_layer_t*
+        , const char* x_api_key
+        , int32_t feed_id
+        , const char *datastream_id
+        , const xi_datapoint_t* value );
+
+const char* ws_encode_get_datastream(
+          const data_layer_t*
+        , const char* x_api_key
+        , int32_t feed_id
+        , const char *datastream_id );
+
+const char* ws_encode_delete_datastream(
+          const data_layer_t*
+        , const char* x_api_key
+        , int32_t feed_id
+        , const char *datastream_id );
+
+const char* ws_encode_delete_datapoint(
+          const data_layer_t*
+        , const char* x_api_key
+        , int32_t feed_id
+        , const char *datastream_id
+        , const xi_datapoint_t* o );
+
+const char* ws_encode_update_feed(
+          const data_layer_t*
+        , const char* x_api_key
+        , const xi_feed_t* feed );
+
+const char* ws_encode_get_feed(
+        const data_layer_t*
+      , const char* x_api_key
+      , const xi_feed_t* feed );
+
+const char* ws_encode_datapoint_delete_range(
+        const data_layer_t*
+      , const char* x_api_key
+      , int feed_id
+      , const char* datastream_id
+      , const xi_timestamp_t* start
+      , const xi_timestamp_t* end );
+
+/**
+ * \note    Control frames other than close are not replies to anything,
+ *          they are decoded into a response with `request_id` set to `0`.
+ */
+const char* ws_encode_get_datastream_history(
+        const data_layer_t*
+      , const char* x_api_key
+      , int32_t feed_id
+      , const char* datastream_id
+      , const xi_timestamp_t* start
+      , const xi_timestamp_t* end
+      , uint32_t interval
+      , uint32_t limit );
+
+const xi_response_t* ws_decode_reply(
+          const data_layer_t*
+        , const char* data
+        , size_t data_size );
+
+size_t ws_get_encoded_size( void );
+
+uint32_t ws_get_request_id( void );
+
+int ws_reply_size( const char* data, size_t data_size );
+
+int ws_open_session( const comm_layer_t* comm_layer, connection_t* conn, const char* api_key );
+
+int ws_close_session( const comm_layer_t* comm_layer, connection_t* conn );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __WS_TRANSPORT_LAYER_H__
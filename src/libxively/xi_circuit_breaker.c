@@ -0,0 +1,76 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    xi_circuit_breaker.c
+ * \brief   Stops sending requests to an endpoint that keeps failing [see xi_circuit_breaker.h]
+ */
+
+#include <string.h>
+#include <stddef.h>
+#include <assert.h>
+
+#include "xi_circuit_breaker.h"
+#include "xi_globals.h"
+#include "xi_consts.h"
+#include "xi_helpers.h"
+
+static xi_circuit_t XI_CIRCUITS[ XI_CIRCUIT_BREAKER_HOSTS ];
+
+xi_circuit_t* xi_circuit_breaker_get( const char* host, int32_t port, uint32_t now )
+{
+    const char* h   = host ? host : "";
+    uint32_t key    = xi_hash( XI_HASH_SEED, h, strlen( h ) );
+    int found       = 0;
+
+    key = xi_hash_key( xi_hash( key, &port, sizeof( port ) ) );
+
+    return ( xi_circuit_t* ) xi_lru_slot(
+          XI_CIRCUITS, XI_CIRCUIT_BREAKER_HOSTS, sizeof( xi_circuit_t )
+        , offsetof( xi_circuit_t, key ), offsetof( xi_circuit_t, used )
+        , key, now, &found );
+}
+
+int xi_circuit_breaker_allow( xi_circuit_t* circuit, uint32_t now )
+{
+    // PRECONDITIONS
+    assert( circuit != 0 );
+
+    if( circuit->state != XI_CIRCUIT_OPENED ) { return 1; }
+
+    if( xi_time_after( circuit->opened + xi_globals.circuit_breaker_cooldown, now ) ) { return 0; }
+
+    circuit->state = XI_CIRCUIT_HALF_OPEN;
+
+    return 1;
+}
+
+void xi_circuit_breaker_success( xi_circuit_t* circuit )
+{
+    // PRECONDITIONS
+    assert( circuit != 0 );
+
+    circuit->failures   = 0;
+    circuit->state      = XI_CIRCUIT_CLOSED;
+}
+
+void xi_circuit_breaker_failure( xi_circuit_t* circuit, uint32_t now )
+{
+    // PRECONDITIONS
+    assert( circuit != 0 );
+
+    ++circuit->failures;
+
+    if( circuit->state == XI_CIRCUIT_HALF_OPEN
+        || ( xi_globals.circuit_breaker_threshold
+            && circuit->failures >= xi_globals.circuit_breaker_threshold ) )
+    {
+        circuit->state  = XI_CIRCUIT_OPENED;
+        circuit->opened = now;
+    }
+}
+
+void xi_circuit_breaker_reset( void )
+{
+    memset( XI_CIRCUITS, 0, sizeof( XI_CIRCUITS ) );
+}
@@ -0,0 +1,70 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    xi_circuit_breaker.h
+ * \brief   Stops sending requests to an endpoint that keeps failing
+ *
+ *    After `xi_globals.circuit_breaker_threshold` failures in a row the circuit of the
+ *    endpoint opens and requests fail right away instead of waiting for the network.
+ *    Once `xi_globals.circuit_breaker_cooldown` has passed it's half-open: the next
+ *    request is let through as a probe, it closes the circuit if it gets an answer
+ *    and opens it again for another cooldown if it doesn't.
+ *
+ *    All times are in milliseconds of `comm_layer_t::get_time_ms()`.
+ */
+
+#ifndef __XI_CIRCUIT_BREAKER_H__
+#define __XI_CIRCUIT_BREAKER_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum
+{
+      XI_CIRCUIT_CLOSED = 0
+    , XI_CIRCUIT_OPENED
+    , XI_CIRCUIT_HALF_OPEN
+} xi_circuit_state_t;
+
+typedef struct {
+    uint32_t            key;        //!< hash of the host and port, 0 if the circuit is free
+    uint32_t            failures;   //!< in a row
+    uint32_t            opened;     //!< when the circuit was last opened
+    uint32_t            used;       //!< when the circuit was last looked up
+    xi_circuit_state_t  state;
+} xi_circuit_t;
+
+/**
+ * \brief   Finds the circuit of the endpoint, the least recently used one is taken over for a new endpoint
+ */
+xi_circuit_t* xi_circuit_breaker_get( const char* host, int32_t port, uint32_t now );
+
+/**
+ * \brief   Tells if a request may be sent, an opened circuit becomes half-open after the cooldown
+ */
+int xi_circuit_breaker_allow( xi_circuit_t* circuit, uint32_t now );
+
+/**
+ * \brief   Closes the circuit, the endpoint has answered
+ */
+void xi_circuit_breaker_success( xi_circuit_t* circuit );
+
+/**
+ * \brief   Counts the failure, opens the circuit once there are enough of them or the probe failed
+ */
+void xi_circuit_breaker_failure( xi_circuit_t* circuit, uint32_t now );
+
+/**
+ * \brief   Forgets all the endpoints
+ */
+void xi_circuit_breaker_reset( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __XI_CIRCUIT_BREAKER_H__
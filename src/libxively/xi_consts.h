@@ -66,10 +66,73 @@
 #define XI_CONTENT_BUFFER_SIZE             256
 #endif
 
+// feed update bodies that don't fit in XI_CONTENT_BUFFER_SIZE are sent in chunks of this size,
+// every line of the body has to fit in one; compressed bodies are sent in windows of this size
+#ifndef XI_HTTP_STREAM_CHUNK_SIZE
+#define XI_HTTP_STREAM_CHUNK_SIZE          128
+#endif
+
 #ifndef XI_CSV_BUFFER_SIZE
 #define XI_CSV_BUFFER_SIZE                 128
 #endif
 
+#ifndef XI_JSON_BUFFER_SIZE
+#define XI_JSON_BUFFER_SIZE                256
+#endif
+
+#ifndef XI_CBOR_BUFFER_SIZE
+#define XI_CBOR_BUFFER_SIZE                128
+#endif
+
+// CBOR decoders that aren't given the size of the data don't read past this many bytes,
+// the data layer is handed `http_content`, which is no bigger
+#ifndef XI_CBOR_DECODE_MAX_SIZE
+#define XI_CBOR_DECODE_MAX_SIZE            XI_HTTP_MAX_CONTENT_SIZE
+#endif
+
+#ifndef XI_ZLIB_DEFLATE_WINDOW_BITS
+#define XI_ZLIB_DEFLATE_WINDOW_BITS        10
+#endif
+
+#ifndef XI_ZLIB_DEFLATE_MEM_LEVEL
+#define XI_ZLIB_DEFLATE_MEM_LEVEL          4
+#endif
+
+// datastreams whose values are kept for conditional requests, per context
+#ifndef XI_CACHED_DATASTREAMS
+#define XI_CACHED_DATASTREAMS              4
+#endif
+
+// API keys whose rate limits are tracked at the same time
+#ifndef XI_RATE_LIMITED_KEYS
+#define XI_RATE_LIMITED_KEYS               4
+#endif
+
+// pause after 429 or 503 that didn't say for how long, in milliseconds
+#ifndef XI_RATE_LIMIT_BACKOFF
+#define XI_RATE_LIMIT_BACKOFF              1000
+#endif
+
+// delimiters found by a single pass of the CSV scanner
+#ifndef XI_CSV_SCAN_INDEX_SIZE
+#define XI_CSV_SCAN_INDEX_SIZE             64
+#endif
+
+// endpoints whose failures are counted at the same time
+#ifndef XI_CIRCUIT_BREAKER_HOSTS
+#define XI_CIRCUIT_BREAKER_HOSTS           4
+#endif
+
+// requests sent ahead of their replies by `xi_feeds_update()`
+#ifndef XI_PIPELINE_WINDOW
+#define XI_PIPELINE_WINDOW                 8
+#endif
+
+// datapoints per page of a history query, the page has to fit `XI_HTTP_MAX_CONTENT_SIZE`
+#ifndef XI_HISTORY_PAGE_SIZE
+#define XI_HISTORY_PAGE_SIZE               8
+#endif
+
 #ifndef XI_HOST
 #define XI_HOST                            "api.xively.com"
 #endif
@@ -78,4 +141,16 @@
 #define XI_PORT                            80
 #endif
 
+#ifndef XI_TCP_PORT
+#define XI_TCP_PORT                        8081
+#endif
+
+#ifndef XI_WS_PORT
+#define XI_WS_PORT                         8080
+#endif
+
+#ifndef XI_MQTT_PORT
+#define XI_MQTT_PORT                       1883
+#endif
+
 #endif // __XI_CONSTST_H__
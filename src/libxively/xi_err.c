@@ -41,6 +41,28 @@ const char* xi_err_string[ XI_ERR_COUNT ] =
         , "XI_SOCKET_READ_ERROR"                       // XI_SOCKET_READ_ERROR
         , "XI_SOCKET_CLOSE_ERROR"                      // XI_SOCKET_CLOSE_ERROR
         , "XI_DATAPOINT_VALUE_BUFFER_OVERFLOW"         // XI_DATAPOINT_VALUE_BUFFER_OVERFLOW
+        , "XI_HTTP_CONTENT_ENCODING_ERROR"             // XI_HTTP_CONTENT_ENCODING_ERROR
+        , "XI_SOCKET_API_ENCODE_ERROR"                 // XI_SOCKET_API_ENCODE_ERROR
+        , "XI_SOCKET_API_DECODE_ERROR"                 // XI_SOCKET_API_DECODE_ERROR
+        , "XI_WS_HANDSHAKE_ERROR"                      // XI_WS_HANDSHAKE_ERROR
+        , "XI_WS_FRAME_ERROR"                          // XI_WS_FRAME_ERROR
+        , "XI_WS_CONNECTION_CLOSED"                    // XI_WS_CONNECTION_CLOSED
+        , "XI_REPLY_BUFFER_OVERFLOW"                   // XI_REPLY_BUFFER_OVERFLOW
+        , "XI_MQTT_CONNECT_ERROR"                      // XI_MQTT_CONNECT_ERROR
+        , "XI_MQTT_PACKET_ERROR"                       // XI_MQTT_PACKET_ERROR
+        , "XI_MQTT_UNSUPPORTED_REQUEST"                // XI_MQTT_UNSUPPORTED_REQUEST
+        , "XI_RATE_LIMITED"                            // XI_RATE_LIMITED
+        , "XI_CIRCUIT_OPEN"                            // XI_CIRCUIT_OPEN
+        , "XI_JSON_ENCODE_DATAPOINT_BUFFER_OVERRUN"    // XI_JSON_ENCODE_DATAPOINT_BUFFER_OVERRUN
+        , "XI_JSON_ENCODE_DATASTREAM_BUFFER_OVERRUN"   // XI_JSON_ENCODE_DATASTREAM_BUFFER_OVERRUN
+        , "XI_JSON_DECODE_FEED_PARSER_ERROR"           // XI_JSON_DECODE_FEED_PARSER_ERROR
+        , "XI_JSON_DECODE_DATAPOINT_PARSER_ERROR"      // XI_JSON_DECODE_DATAPOINT_PARSER_ERROR
+        , "XI_CBOR_ENCODE_DATAPOINT_BUFFER_OVERRUN"    // XI_CBOR_ENCODE_DATAPOINT_BUFFER_OVERRUN
+        , "XI_CBOR_ENCODE_DATASTREAM_BUFFER_OVERRUN"   // XI_CBOR_ENCODE_DATASTREAM_BUFFER_OVERRUN
+        , "XI_CBOR_ENCODE_FEED_BUFFER_OVERRUN"         // XI_CBOR_ENCODE_FEED_BUFFER_OVERRUN
+        , "XI_CBOR_DECODE_FEED_PARSER_ERROR"           // XI_CBOR_DECODE_FEED_PARSER_ERROR
+        , "XI_CBOR_DECODE_DATAPOINT_PARSER_ERROR"      // XI_CBOR_DECODE_DATAPOINT_PARSER_ERROR
+        , "XI_HTTP_CONTENT_TOO_LARGE"                  // XI_HTTP_CONTENT_TOO_LARGE
 };
 
 xi_err_t xi_get_last_error()
@@ -9,4 +9,4 @@
 
 #include "xi_globals.h"
 
-xi_globals_t xi_globals = { 1500 };
+xi_globals_t xi_globals = { 1500, 0, 0, 0, 0, 0, 10000, 0, 30000 };
@@ -22,7 +22,15 @@ extern "C" {
  */
 typedef struct
 {
-    uint32_t network_timeout; //!< the network timeout (default: 1500 milliseconds)
+    uint32_t network_timeout;       //!< the network timeout (default: 1500 milliseconds)
+    uint8_t  response_compression;  //!< ask for compressed responses (default: 0)
+    uint32_t request_compression;   //!< compress request bodies of at least that many bytes (default: 0 - never)
+    uint8_t  mqtt_qos;              //!< quality of service of MQTT publishes (default: 0)
+    uint32_t rate_limit;            //!< requests per minute allowed per API key (default: 0 - unlimited)
+    uint32_t rate_limit_burst;      //!< requests that may be sent at once (default: 0 - one)
+    uint32_t rate_limit_max_wait;   //!< the longest a request is held back before giving up (default: 10000 milliseconds)
+    uint32_t circuit_breaker_threshold; //!< consecutive failures that cut an endpoint off (default: 0 - never)
+    uint32_t circuit_breaker_cooldown;  //!< how long an endpoint stays cut off before it's tried again (default: 30000 milliseconds)
 } xi_globals_t;
 
 extern xi_globals_t xi_globals; //!< global instance of `xi_globals_t`
@@ -1,8 +1,8 @@
 // Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
 // This is part of Xively C library, it is under the BSD 3-Clause license.
 
-// This file also containes code from MINIX C library, which is under MINIX license
-// Copyright (c) 1987, 1997, 2006, Vrije Universiteit, Amsterdam, The Netherlands
+// The shortest float formatting follows Ryu, which is under the Boost Software License
+// Copyright (c) 2018 Ulf Adams
 
 /**
  * \file    xi_helpers.c
@@ -10,7 +10,9 @@
  * \brief   General helpers used by the library [see xi_helpers.h]
  */
 
+#include <stdio.h>
 #include <string.h>
+#include <time.h>
 #include <assert.h>
 
 #include "xi_helpers.h"
@@ -53,149 +55,130 @@ int xi_str_copy_untiln( char* dst, size_t dst_size, const char* src, char delim
 #define EPOCH_YR            1970  /* EPOCH = Jan 1 1970 00:00:00 */
 #define SECS_DAY            (24L * 60L * 60L)
 #define LEAPYEAR(year)      (!((year) % 4) && (((year) % 100) || !((year) % 400)))
-#define YEARSIZE(year)      (LEAPYEAR(year) ? 366 : 365)
-#define FIRSTSUNDAY(timp)    (((timp)->tm_yday - (timp)->tm_wday + 420) % 7)
-#define FIRSTDAYOF(timp)    (((timp)->tm_wday - (timp)->tm_yday + 420) % 7)
-#define TIME_MAX            ULONG_MAX
-#define ABB_LEN             3
 
-// used by the xi_mktime and xi_gmtime
+// used by the xi_str_to_timestamp
 static const int _ytab[2][12] = {
     { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 },
       { 31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 } };
 
-time_t xi_mktime(register struct tm *timep)
-{
-    register long day, year;
-    register int tm_year;
-    int yday, month;
-    register signed long seconds;
-    int overflow;
-
-    timep->tm_min += timep->tm_sec / 60;
-    timep->tm_sec %= 60;
-    if (timep->tm_sec < 0) {
-         timep->tm_sec += 60;
-         timep->tm_min--;
-    }
-    timep->tm_hour += timep->tm_min / 60;
-    timep->tm_min = timep->tm_min % 60;
-    if (timep->tm_min < 0) {
-         timep->tm_min += 60;
-         timep->tm_hour--;
-    }
-    day = timep->tm_hour / 24;
-    timep->tm_hour= timep->tm_hour % 24;
-    if (timep->tm_hour < 0) {
-         timep->tm_hour += 24;
-         day--;
-    }
-    timep->tm_year += timep->tm_mon / 12;
-    timep->tm_mon %= 12;
-    if (timep->tm_mon < 0) {
-         timep->tm_mon += 12;
-         timep->tm_year--;
-    }
-    day += (timep->tm_mday - 1);
-    while (day < 0) {
-         if(--timep->tm_mon < 0) {
-                 timep->tm_year--;
-                 timep->tm_mon = 11;
-         }
-         day += _ytab[LEAPYEAR(YEAR0 + timep->tm_year)][timep->tm_mon];
-    }
-    while (day >= _ytab[LEAPYEAR(YEAR0 + timep->tm_year)][timep->tm_mon]) {
-         day -= _ytab[LEAPYEAR(YEAR0 + timep->tm_year)][timep->tm_mon];
-         if (++(timep->tm_mon) == 12) {
-                 timep->tm_mon = 0;
-                 timep->tm_year++;
-         }
-    }
-    timep->tm_mday = day + 1;
-    year = EPOCH_YR;
-    if (timep->tm_year < year - YEAR0) return (time_t)-1;
-    seconds = 0;
-    day = 0;
-    overflow = 0;
-
-    /*
-     * Assume that when day becomes negative, there will certainly be overflow on seconds.
-     * The check for overflow needs not to be done for leapyears divisible by 400.
-     * The code only works when year (1970) is not a leapyear.
-     */
-    #if EPOCH_YR != 1970
-    #error EPOCH_YR != 1970
-    #endif
-
-    tm_year = timep->tm_year + YEAR0;
-
-    if (LONG_MAX / 365 < tm_year - year) overflow++;
-    day = (tm_year - year) * 365;
-    if (LONG_MAX - day < (tm_year - year) / 4 + 1) overflow++;
-    day += (tm_year - year) / 4
-         + ((tm_year % 4) && tm_year % 4 < year % 4);
-    day -= (tm_year - year) / 100
-         + ((tm_year % 100) && tm_year % 100 < year % 100);
-    day += (tm_year - year) / 400
-         + ((tm_year % 400) && tm_year % 400 < year % 400);
-
-    yday = month = 0;
-    while (month < timep->tm_mon) {
-         yday += _ytab[LEAPYEAR(tm_year)][month];
-         month++;
-    }
-    yday += (timep->tm_mday - 1);
-    if (day + yday < 0) overflow++;
-    day += yday;
-
-    timep->tm_yday = yday;
-    timep->tm_wday = (day + 4) % 7;
-
-    seconds = ( ( timep->tm_hour * 60L ) + timep->tm_min ) * 60L + timep->tm_sec;
-
-    if ( ( TIME_MAX - seconds ) / SECS_DAY < ( unsigned long ) day ) overflow++;
-    seconds += day * SECS_DAY;
-
-    if ( overflow ) return ( time_t ) - 1;
-
-    if ( ( time_t ) seconds != seconds) return ( time_t ) - 1;
-    return ( time_t ) seconds;
-}
-
-struct tm* xi_gmtime( register const time_t *timer )
+// days since the epoch of a date in the proleptic Gregorian calendar, months start at 1
+static int64_t xi_days_from_civil( int64_t year, uint32_t month, uint32_t day )
 {
-    static struct tm br_time;
-    register struct tm *timep = &br_time;
-    time_t time = *timer;
-    register unsigned long dayclock, dayno;
-    int year = EPOCH_YR;
+    // years start in March, so the leap day is the last one
+    year -= month <= 2;
+
+    int64_t era     = ( year >= 0 ? year : year - 399 ) / 400;
+    uint32_t yoe    = ( uint32_t ) ( year - era * 400 );
+    uint32_t doy    = ( 153 * ( month > 2 ? month - 3 : month + 9 ) + 2 ) / 5 + day - 1;
+    uint32_t doe    = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+
+    return era * 146097 + ( int64_t ) doe - 719468;
+}
+
+// the date of a day since the epoch, the inverse of xi_days_from_civil
+static void xi_civil_from_days( int64_t days, int64_t* year, uint32_t* month, uint32_t* day )
+{
+    days += 719468;
 
-    dayclock = (unsigned long)time % SECS_DAY;
-    dayno = (unsigned long)time / SECS_DAY;
+    int64_t era     = ( days >= 0 ? days : days - 146096 ) / 146097;
+    uint32_t doe    = ( uint32_t ) ( days - era * 146097 );
+    uint32_t yoe    = ( doe - doe / 1460 + doe / 36524 - doe / 146096 ) / 365;
+    uint32_t doy    = doe - ( 365 * yoe + yoe / 4 - yoe / 100 );
+    uint32_t mp     = ( 5 * doy + 2 ) / 153;
 
-    timep->tm_sec = dayclock % 60;
-    timep->tm_min = (dayclock % 3600) / 60;
-    timep->tm_hour = dayclock / 3600;
-    timep->tm_wday = (dayno + 4) % 7;       /* day 0 was a thursday */
+    *day    = doy - ( 153 * mp + 2 ) / 5 + 1;
+    *month  = mp < 10 ? mp + 3 : mp - 9;
+    *year   = yoe + era * 400 + ( *month <= 2 );
+}
+
+// takes whole units out of `value` and leaves the remainder, which is never negative
+inline static int64_t xi_carry( int64_t* value, int64_t unit )
+{
+    int64_t carry = *value / unit;
+
+    *value %= unit;
 
-    while (dayno >= YEARSIZE(year)) {
-            dayno -= YEARSIZE(year);
-            year++;
+    if( *value < 0 )
+    {
+        *value += unit;
+        --carry;
     }
 
-    timep->tm_year = year - YEAR0;
-    timep->tm_yday = dayno;
-    timep->tm_mon = 0;
+    return carry;
+}
 
-    while (dayno >= _ytab[LEAPYEAR(year)][timep->tm_mon]) {
-            dayno -= _ytab[LEAPYEAR(year)][timep->tm_mon];
-            timep->tm_mon++;
+// fills in the date fields of `timep` from a day since the epoch
+static void xi_set_date( struct tm* timep, int64_t days )
+{
+    int64_t year    = 0;
+    uint32_t month  = 0;
+    uint32_t day    = 0;
+    int64_t wday    = days + 4; // day 0 was a thursday
+
+    xi_civil_from_days( days, &year, &month, &day );
+    xi_carry( &wday, 7 );
+
+    timep->tm_year  = ( int ) ( year - YEAR0 );
+    timep->tm_mon   = month - 1;
+    timep->tm_mday  = day;
+    timep->tm_yday  = ( int ) ( days - xi_days_from_civil( year, 1, 1 ) );
+    timep->tm_wday  = ( int ) wday;
+}
+
+time_t xi_mktime( struct tm* timep )
+{
+    // PRECONDITIONS
+    assert( timep != 0 );
+
+    int64_t sec     = timep->tm_sec;
+    int64_t min     = timep->tm_min + xi_carry( &sec, 60 );
+    int64_t hour    = timep->tm_hour + xi_carry( &min, 60 );
+    int64_t days    = xi_carry( &hour, 24 );
+    int64_t mon     = timep->tm_mon;
+    int64_t year    = timep->tm_year + YEAR0 + xi_carry( &mon, 12 );
+
+    // the day of the month may be out of range as well, it's just added to the first one
+    days += xi_days_from_civil( year, ( uint32_t ) mon + 1, 1 ) + timep->tm_mday - 1;
+
+    timep->tm_sec   = ( int ) sec;
+    timep->tm_min   = ( int ) min;
+    timep->tm_hour  = ( int ) hour;
+    xi_set_date( timep, days );
+
+    if( days < 0 ) { return ( time_t ) -1; }
+
+    {
+        int64_t seconds = days * SECS_DAY + ( hour * 60 + min ) * 60 + sec;
+
+        if( ( time_t ) seconds != seconds ) { return ( time_t ) -1; }
+
+        return ( time_t ) seconds;
     }
+}
 
-    timep->tm_mday = dayno + 1;
-    timep->tm_isdst = 0;
+struct tm* xi_gmtime_r( const time_t* timer, struct tm* result )
+{
+    // PRECONDITIONS
+    assert( timer != 0 );
+    assert( result != 0 );
+
+    int64_t clock   = *timer;
+    int64_t days    = xi_carry( &clock, SECS_DAY );
+
+    result->tm_sec      = ( int ) ( clock % 60 );
+    result->tm_min      = ( int ) ( clock % 3600 / 60 );
+    result->tm_hour     = ( int ) ( clock / 3600 );
+    result->tm_isdst    = 0;
+    xi_set_date( result, days );
+
+    return result;
+}
+
+struct tm* xi_gmtime( const time_t* timer )
+{
+    static struct tm br_time;
 
-    return timep;
+    return xi_gmtime_r( timer, &br_time );
 }
 
 char* xi_replace_with(
@@ -213,3 +196,644 @@ char* xi_replace_with(
 
     return c;
 }
+
+//-----------------------------------------------------------------------
+// SHORTEST FLOAT FORMATTING
+//-----------------------------------------------------------------------
+
+// Ryu for single precision: the shortest decimal that reads back as the same
+// float is found with integer arithmetic only, see Ulf Adams, "Ryū: fast
+// float-to-string conversion", PLDI 2018
+
+#define XI_FLOAT_MANTISSA_BITS      23
+#define XI_FLOAT_EXPONENT_BITS      8
+#define XI_FLOAT_BIAS               127
+#define XI_FLOAT_POW5_INV_BITCOUNT  59
+#define XI_FLOAT_POW5_BITCOUNT      61
+
+// ceil( 2^( bitlength( 5^i ) - 1 + 59 ) / 5^i )
+static const uint64_t XI_FLOAT_POW5_INV_SPLIT[ 31 ] =
+{
+    0x0800000000000001u, 0x0666666666666667u, 0x051EB851EB851EB9u,
+    0x04189374BC6A7EFAu, 0x068DB8BAC710CB2Au, 0x053E2D6238DA3C22u,
+    0x0431BDE82D7B634Eu, 0x06B5FCA6AF2BD216u, 0x055E63B88C230E78u,
+    0x044B82FA09B5A52Du, 0x06DF37F675EF6EAEu, 0x057F5FF85E592558u,
+    0x0465E6604B7A8447u, 0x0709709A125DA071u, 0x05A126E1A84AE6C1u,
+    0x0480EBE7B9D58567u, 0x0734ACA5F6226F0Bu, 0x05C3BD5191B525A3u,
+    0x049C97747490EAE9u, 0x0760F253EDB4AB0Eu, 0x05E72843249088D8u,
+    0x04B8ED0283A6D3E0u, 0x078E480405D7B966u, 0x060B6CD004AC9452u,
+    0x04D5F0A66A23A9DBu, 0x07BCB43D769F762Bu, 0x063090312BB2C4EFu,
+    0x04F3A68DBC8F03F3u, 0x07EC3DAF94180651u, 0x065697BFA9ACD1DAu,
+    0x051212FFBAF0A7E2u
+};
+
+// 5^i scaled to 61 significant bits
+static const uint64_t XI_FLOAT_POW5_SPLIT[ 47 ] =
+{
+    0x1000000000000000u, 0x1400000000000000u, 0x1900000000000000u,
+    0x1F40000000000000u, 0x1388000000000000u, 0x186A000000000000u,
+    0x1E84800000000000u, 0x1312D00000000000u, 0x17D7840000000000u,
+    0x1DCD650000000000u, 0x12A05F2000000000u, 0x174876E800000000u,
+    0x1D1A94A200000000u, 0x12309CE540000000u, 0x16BCC41E90000000u,
+    0x1C6BF52634000000u, 0x11C37937E0800000u, 0x16345785D8A00000u,
+    0x1BC16D674EC80000u, 0x1158E460913D0000u, 0x15AF1D78B58C4000u,
+    0x1B1AE4D6E2EF5000u, 0x10F0CF064DD59200u, 0x152D02C7E14AF680u,
+    0x1A784379D99DB420u, 0x108B2A2C28029094u, 0x14ADF4B7320334B9u,
+    0x19D971E4FE8401E7u, 0x1027E72F1F128130u, 0x1431E0FAE6D7217Cu,
+    0x193E5939A08CE9DBu, 0x1F8DEF8808B02452u, 0x13B8B5B5056E16B3u,
+    0x18A6E32246C99C60u, 0x1ED09BEAD87C0378u, 0x13426172C74D822Bu,
+    0x1812F9CF7920E2B6u, 0x1E17B84357691B64u, 0x12CED32A16A1B11Eu,
+    0x178287F49C4A1D66u, 0x1D6329F1C35CA4BFu, 0x125DFA371A19E6F7u,
+    0x16F578C4E0A060B5u, 0x1CB2D6F618C878E3u, 0x11EFC659CF7D4B8Du,
+    0x166BB7F0435C9E71u, 0x1C06A5EC5433C60Du
+};
+
+static uint32_t xi_pow5_bits( int32_t e )
+{
+    return ( uint32_t ) ( ( ( uint32_t ) e * 1217359 ) >> 19 ) + 1;
+}
+
+static uint32_t xi_log10_pow2( int32_t e )
+{
+    return ( uint32_t ) ( ( ( uint32_t ) e * 78913 ) >> 18 );
+}
+
+static uint32_t xi_log10_pow5( int32_t e )
+{
+    return ( uint32_t ) ( ( ( uint32_t ) e * 732923 ) >> 20 );
+}
+
+static int xi_multiple_of_pow5( uint32_t value, uint32_t p )
+{
+    uint32_t count = 0;
+
+    for( ; value % 5 == 0; value /= 5 ) { ++count; }
+
+    return count >= p;
+}
+
+static int xi_multiple_of_pow2( uint32_t value, uint32_t p )
+{
+    return ( value & ( ( 1u << p ) - 1 ) ) == 0;
+}
+
+static uint32_t xi_mul_shift( uint32_t m, uint64_t factor, int32_t shift )
+{
+    uint64_t low    = ( uint64_t ) m * ( uint32_t ) factor;
+    uint64_t high   = ( uint64_t ) m * ( uint32_t ) ( factor >> 32 );
+
+    return ( uint32_t ) ( ( ( low >> 32 ) + high ) >> ( shift - 32 ) );
+}
+
+// `digits * 10^exponent` is the shortest decimal of a finite, non-zero float
+static void xi_float_to_decimal( uint32_t ieee_mantissa, uint32_t ieee_exponent
+    , uint32_t* digits, int32_t* exponent )
+{
+    int32_t e2      = 0;
+    uint32_t m2     = 0;
+
+    if( ieee_exponent == 0 )
+    {
+        e2 = 1 - XI_FLOAT_BIAS - XI_FLOAT_MANTISSA_BITS - 2;
+        m2 = ieee_mantissa;
+    }
+    else
+    {
+        e2 = ( int32_t ) ieee_exponent - XI_FLOAT_BIAS - XI_FLOAT_MANTISSA_BITS - 2;
+        m2 = ( 1u << XI_FLOAT_MANTISSA_BITS ) | ieee_mantissa;
+    }
+
+    // the halfway points to the neighbours are included for even mantissas
+    int accept_bounds   = ( m2 & 1 ) == 0;
+    uint32_t mv         = 4 * m2;
+    uint32_t mp         = 4 * m2 + 2;
+    uint32_t mm_shift   = ieee_mantissa != 0 || ieee_exponent <= 1;
+    uint32_t mm         = 4 * m2 - 1 - mm_shift;
+
+    uint32_t vr, vp, vm;
+    int32_t e10                 = 0;
+    int vm_is_trailing_zeros    = 0;
+    int vr_is_trailing_zeros    = 0;
+    uint8_t last_removed_digit  = 0;
+
+    if( e2 >= 0 )
+    {
+        uint32_t q  = xi_log10_pow2( e2 );
+        int32_t k   = XI_FLOAT_POW5_INV_BITCOUNT + xi_pow5_bits( q ) - 1;
+        int32_t i   = -e2 + ( int32_t ) q + k;
+
+        e10 = ( int32_t ) q;
+        vr  = xi_mul_shift( mv, XI_FLOAT_POW5_INV_SPLIT[ q ], i );
+        vp  = xi_mul_shift( mp, XI_FLOAT_POW5_INV_SPLIT[ q ], i );
+        vm  = xi_mul_shift( mm, XI_FLOAT_POW5_INV_SPLIT[ q ], i );
+
+        if( q != 0 && ( vp - 1 ) / 10 <= vm / 10 )
+        {
+            // one removed digit is needed for rounding even if the loop below doesn't run
+            int32_t l = XI_FLOAT_POW5_INV_BITCOUNT + xi_pow5_bits( q - 1 ) - 1;
+            last_removed_digit = ( uint8_t ) ( xi_mul_shift( mv
+                , XI_FLOAT_POW5_INV_SPLIT[ q - 1 ], -e2 + ( int32_t ) q - 1 + l ) % 10 );
+        }
+
+        if( q <= 9 )
+        {
+            // only one of mp, mv and mm can be a multiple of 5, if any
+            if( mv % 5 == 0 )       { vr_is_trailing_zeros = xi_multiple_of_pow5( mv, q ); }
+            else if( accept_bounds ){ vm_is_trailing_zeros = xi_multiple_of_pow5( mm, q ); }
+            else                    { vp -= xi_multiple_of_pow5( mp, q ); }
+        }
+    }
+    else
+    {
+        uint32_t q  = xi_log10_pow5( -e2 );
+        int32_t i   = -e2 - ( int32_t ) q;
+        int32_t k   = ( int32_t ) xi_pow5_bits( i ) - XI_FLOAT_POW5_BITCOUNT;
+        int32_t j   = ( int32_t ) q - k;
+
+        e10 = ( int32_t ) q + e2;
+        vr  = xi_mul_shift( mv, XI_FLOAT_POW5_SPLIT[ i ], j );
+        vp  = xi_mul_shift( mp, XI_FLOAT_POW5_SPLIT[ i ], j );
+        vm  = xi_mul_shift( mm, XI_FLOAT_POW5_SPLIT[ i ], j );
+
+        if( q != 0 && ( vp - 1 ) / 10 <= vm / 10 )
+        {
+            j = ( int32_t ) q - 1 - ( ( int32_t ) xi_pow5_bits( i + 1 ) - XI_FLOAT_POW5_BITCOUNT );
+            last_removed_digit = ( uint8_t ) ( xi_mul_shift( mv, XI_FLOAT_POW5_SPLIT[ i + 1 ], j ) % 10 );
+        }
+
+        if( q <= 1 )
+        {
+            // mv has at least two trailing zero bits, so it's a multiple of 10^q
+            vr_is_trailing_zeros = 1;
+
+            if( accept_bounds ) { vm_is_trailing_zeros = mm_shift == 1; }
+            else                { --vp; }
+        }
+        else if( q < 31 )
+        {
+            vr_is_trailing_zeros = xi_multiple_of_pow2( mv, q - 1 );
+        }
+    }
+
+    // digits are dropped for as long as the result stays between the neighbours
+    int32_t removed = 0;
+    uint32_t output = 0;
+
+    if( vm_is_trailing_zeros || vr_is_trailing_zeros )
+    {
+        while( vp / 10 > vm / 10 )
+        {
+            vm_is_trailing_zeros &= vm % 10 == 0;
+            vr_is_trailing_zeros &= last_removed_digit == 0;
+            last_removed_digit = ( uint8_t ) ( vr % 10 );
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            ++removed;
+        }
+
+        if( vm_is_trailing_zeros )
+        {
+            while( vm % 10 == 0 )
+            {
+                vr_is_trailing_zeros &= last_removed_digit == 0;
+                last_removed_digit = ( uint8_t ) ( vr % 10 );
+                vr /= 10;
+                vp /= 10;
+                vm /= 10;
+                ++removed;
+            }
+        }
+
+        // exactly halfway rounds to even
+        if( vr_is_trailing_zeros && last_removed_digit == 5 && vr % 2 == 0 )
+        {
+            last_removed_digit = 4;
+        }
+
+        output = vr + ( ( vr == vm && ( !accept_bounds || !vm_is_trailing_zeros ) )
+            || last_removed_digit >= 5 );
+    }
+    else
+    {
+        while( vp / 10 > vm / 10 )
+        {
+            last_removed_digit = ( uint8_t ) ( vr % 10 );
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            ++removed;
+        }
+
+        output = vr + ( vr == vm || last_removed_digit >= 5 );
+    }
+
+    *digits     = output;
+    *exponent   = e10 + removed;
+}
+
+int xi_float_to_str( char* buffer, size_t buffer_size, float value )
+{
+    // PRECONDITIONS
+    assert( buffer != 0 || buffer_size == 0 );
+
+    // the longest is the smallest subnormal, 45 digits after the point
+    char tmp[ 64 ];
+    size_t size = 0;
+
+    uint32_t bits = 0;
+    memcpy( &bits, &value, sizeof( bits ) );
+
+    uint32_t ieee_mantissa  = bits & ( ( 1u << XI_FLOAT_MANTISSA_BITS ) - 1 );
+    uint32_t ieee_exponent  = ( bits >> XI_FLOAT_MANTISSA_BITS ) & ( ( 1u << XI_FLOAT_EXPONENT_BITS ) - 1 );
+
+    if( ieee_exponent == ( ( 1u << XI_FLOAT_EXPONENT_BITS ) - 1 ) && ieee_mantissa != 0 )
+    {
+        memcpy( tmp, "nan", 3 );
+        size = 3;
+    }
+    else
+    {
+        if( bits >> 31 ) { tmp[ size++ ] = '-'; }
+
+        if( ieee_exponent == ( ( 1u << XI_FLOAT_EXPONENT_BITS ) - 1 ) )
+        {
+            memcpy( tmp + size, "inf", 3 );
+            size += 3;
+        }
+        else if( ieee_exponent == 0 && ieee_mantissa == 0 )
+        {
+            memcpy( tmp + size, "0.0", 3 );
+            size += 3;
+        }
+        else
+        {
+            uint32_t digits     = 0;
+            int32_t exponent    = 0;
+            char rendered[ 10 ];
+            int32_t length      = 0;
+
+            xi_float_to_decimal( ieee_mantissa, ieee_exponent, &digits, &exponent );
+
+            for( uint32_t d = digits; d; d /= 10 ) { ++length; }
+
+            for( int32_t i = length - 1; i >= 0; --i, digits /= 10 )
+            {
+                rendered[ i ] = ( char ) ( '0' + digits % 10 );
+            }
+
+            // plain notation, the decoder reads it as a float and there's a digit on both sides of the point
+            int32_t point = length + exponent;
+
+            if( point <= 0 )
+            {
+                tmp[ size++ ] = '0';
+                tmp[ size++ ] = '.';
+                memset( tmp + size, '0', -point );
+                size += -point;
+                memcpy( tmp + size, rendered, length );
+                size += length;
+            }
+            else if( point >= length )
+            {
+                memcpy( tmp + size, rendered, length );
+                size += length;
+                memset( tmp + size, '0', point - length );
+                size += point - length;
+                tmp[ size++ ] = '.';
+                tmp[ size++ ] = '0';
+            }
+            else
+            {
+                memcpy( tmp + size, rendered, point );
+                size += point;
+                tmp[ size++ ] = '.';
+                memcpy( tmp + size, rendered + point, length - point );
+                size += length - point;
+            }
+        }
+    }
+
+    if( buffer_size )
+    {
+        size_t n = size < buffer_size ? size : buffer_size - 1;
+        memcpy( buffer, tmp, n );
+        buffer[ n ] = '\0';
+    }
+
+    return ( int ) size;
+}
+
+// two digits at a time, so there's half as many divisions
+static const char XI_DIGIT_PAIRS[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+int xi_int_to_str( char* buffer, size_t buffer_size, int32_t value )
+{
+    // PRECONDITIONS
+    assert( buffer != 0 || buffer_size == 0 );
+
+    // sign and ten digits, written from the end
+    char tmp[ 11 ];
+    char* p     = tmp + sizeof( tmp );
+    uint32_t n  = value < 0 ? 0u - ( uint32_t ) value : ( uint32_t ) value;
+
+    while( n >= 100 )
+    {
+        const char* pair = XI_DIGIT_PAIRS + ( n % 100 ) * 2;
+        n /= 100;
+        *--p = pair[ 1 ];
+        *--p = pair[ 0 ];
+    }
+
+    if( n >= 10 )
+    {
+        const char* pair = XI_DIGIT_PAIRS + n * 2;
+        *--p = pair[ 1 ];
+        *--p = pair[ 0 ];
+    }
+    else
+    {
+        *--p = ( char ) ( '0' + n );
+    }
+
+    if( value < 0 ) { *--p = '-'; }
+
+    size_t size = tmp + sizeof( tmp ) - p;
+
+    if( buffer_size )
+    {
+        size_t c = size < buffer_size ? size : buffer_size - 1;
+        memcpy( buffer, p, c );
+        buffer[ c ] = '\0';
+    }
+
+    return ( int ) size;
+}
+
+// the prefix shared by every timestamp within the minute that starts at `minute`
+typedef struct
+{
+    time_t  minute;
+    char    prefix[ 17 ]; // YYYY-MM-DDTHH:MM:
+} xi_timestamp_cache_t;
+
+static xi_timestamp_cache_t XI_TIMESTAMP_CACHE = { 1, { 0 } };
+
+inline static char* xi_put_pair( char* p, int value )
+{
+    memcpy( p, XI_DIGIT_PAIRS + value * 2, 2 );
+    return p + 2;
+}
+
+// whatever doesn't fit the layout is written the way it used to be
+static int xi_timestamp_to_str_slow( char* buffer, size_t buffer_size
+    , const struct tm* ptm, time_t micro )
+{
+    return snprintf( buffer, buffer_size, "%04d-%02d-%02dT%02d:%02d:%02d.%06ldZ"
+        , ptm->tm_year + 1900, ptm->tm_mon + 1, ptm->tm_mday
+        , ptm->tm_hour, ptm->tm_min, ptm->tm_sec, ( long ) micro );
+}
+
+int xi_timestamp_to_str( char* buffer, size_t buffer_size, time_t timestamp, time_t micro )
+{
+    // PRECONDITIONS
+    assert( buffer != 0 || buffer_size == 0 );
+
+    char tmp[ 27 ];
+
+    if( micro < 0 || micro > 999999 )
+    {
+        struct tm tm;
+
+        return xi_timestamp_to_str_slow( buffer, buffer_size, xi_gmtime_r( &timestamp, &tm ), micro );
+    }
+
+    // another thread may be storing the cache meanwhile, so only the copy is
+    // used and its range is checked on the copy; a minute never starts 1s past
+    // the epoch, so the cache starts out empty
+    xi_timestamp_cache_t cache = XI_TIMESTAMP_CACHE;
+
+    if( timestamp < cache.minute || timestamp - cache.minute >= 60 )
+    {
+        struct tm tm;
+        struct tm* ptm  = xi_gmtime_r( &timestamp, &tm );
+        int year        = ptm->tm_year + 1900;
+
+        if( year < 0 || year > 9999 || ptm->tm_sec < 0 || ptm->tm_sec > 59 )
+        {
+            return xi_timestamp_to_str_slow( buffer, buffer_size, ptm, micro );
+        }
+
+        char* p = cache.prefix;
+
+        p = xi_put_pair( p, year / 100 );
+        p = xi_put_pair( p, year % 100 );
+        *p++ = '-';
+        p = xi_put_pair( p, ptm->tm_mon + 1 );
+        *p++ = '-';
+        p = xi_put_pair( p, ptm->tm_mday );
+        *p++ = 'T';
+        p = xi_put_pair( p, ptm->tm_hour );
+        *p++ = ':';
+        p = xi_put_pair( p, ptm->tm_min );
+        *p++ = ':';
+
+        cache.minute        = timestamp - ptm->tm_sec;
+        XI_TIMESTAMP_CACHE  = cache;
+    }
+
+    {
+        char* p         = tmp + sizeof( cache.prefix );
+        uint32_t m      = ( uint32_t ) micro;
+
+        memcpy( tmp, cache.prefix, sizeof( cache.prefix ) );
+
+        p = xi_put_pair( p, ( int ) ( timestamp - cache.minute ) );
+        *p++ = '.';
+        p = xi_put_pair( p, m / 10000 );
+        p = xi_put_pair( p, m / 100 % 100 );
+        p = xi_put_pair( p, m % 100 );
+        *p = 'Z';
+    }
+
+    if( buffer_size )
+    {
+        size_t c = sizeof( tmp ) < buffer_size ? sizeof( tmp ) : buffer_size - 1;
+        memcpy( buffer, tmp, c );
+        buffer[ c ] = '\0';
+    }
+
+    return ( int ) sizeof( tmp );
+}
+
+inline static int xi_is_digit( char c )
+{
+    return ( unsigned char ) ( c - '0' ) < 10;
+}
+
+inline static int32_t xi_get_pair( const char* str )
+{
+    return ( str[ 0 ] - '0' ) * 10 + ( str[ 1 ] - '0' );
+}
+
+int xi_str_to_timestamp( const char* str, time_t* timestamp, time_t* micro )
+{
+    // PRECONDITIONS
+    assert( str != 0 );
+    assert( timestamp != 0 );
+    assert( micro != 0 );
+
+    static const char layout[] = "dddd-dd-ddTdd:dd:dd";
+
+    // checked in order, so nothing is read past the end of a shorter string
+    for( int i = 0; i < ( int ) sizeof( layout ) - 1; ++i )
+    {
+        if( layout[ i ] == 'd' ? !xi_is_digit( str[ i ] ) : str[ i ] != layout[ i ] ) { return -1; }
+    }
+
+    int32_t year    = xi_get_pair( str ) * 100 + xi_get_pair( str + 2 );
+    int32_t month   = xi_get_pair( str + 5 );
+    int32_t day     = xi_get_pair( str + 8 );
+    int32_t hour    = xi_get_pair( str + 11 );
+    int32_t minute  = xi_get_pair( str + 14 );
+    int32_t second  = xi_get_pair( str + 17 );
+
+    if( year < EPOCH_YR || month < 1 || month > 12 || day < 1
+        || day > _ytab[ LEAPYEAR( year ) ][ month - 1 ]
+        || hour > 23 || minute > 59 || second > 60 )
+    {
+        return -1;
+    }
+
+    int offset          = 19;
+    int32_t fraction    = 0;
+
+    // what Xively sends
+    if( str[ 19 ] == '.' && xi_is_digit( str[ 20 ] ) && xi_is_digit( str[ 21 ] )
+        && xi_is_digit( str[ 22 ] ) && xi_is_digit( str[ 23 ] ) && xi_is_digit( str[ 24 ] )
+        && xi_is_digit( str[ 25 ] ) && str[ 26 ] == 'Z' )
+    {
+        fraction    = ( xi_get_pair( str + 20 ) * 100 + xi_get_pair( str + 22 ) ) * 100
+                    + xi_get_pair( str + 24 );
+        offset      = 27;
+    }
+    else
+    {
+        if( str[ offset ] == '.' )
+        {
+            int digits = 0;
+
+            for( ++offset; xi_is_digit( str[ offset ] ); ++offset, ++digits )
+            {
+                if( digits < 6 ) { fraction = fraction * 10 + ( str[ offset ] - '0' ); }
+            }
+
+            if( digits == 0 ) { return -2; }
+
+            for( ; digits < 6; ++digits ) { fraction *= 10; }
+        }
+
+        if( str[ offset++ ] != 'Z' ) { return -2; }
+    }
+
+    {
+        int64_t seconds = xi_days_from_civil( year, month, day ) * SECS_DAY
+            + ( hour * 60L + minute ) * 60L + second;
+
+        if( ( time_t ) seconds != seconds ) { return -1; }
+
+        *timestamp  = ( time_t ) seconds;
+        *micro      = fraction;
+    }
+
+    return offset;
+}
+
+uint32_t xi_hash( uint32_t h, const void* data, size_t size )
+{
+    const uint8_t* p = ( const uint8_t* ) data;
+
+    for( size_t i = 0; i < size; ++i )
+    {
+        h = ( h ^ p[ i ] ) * 16777619u;
+    }
+
+    return h;
+}
+
+uint32_t xi_hash_key( uint32_t h )
+{
+    return h == 0 ? 1 : h;
+}
+
+int xi_time_after( uint32_t a, uint32_t b )
+{
+    return ( int32_t ) ( a - b ) > 0;
+}
+
+uint32_t xi_random( void )
+{
+    static uint32_t state = 0;
+
+    if( state == 0 )
+    {
+        state = ( uint32_t ) time( 0 ) ^ ( uint32_t ) ( size_t ) &state;
+        state = state ? state : 0x9E3779B9;
+    }
+
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+
+    return state;
+}
+
+void* xi_lru_slot( void* slots, size_t count, size_t slot_size
+    , size_t key_offset, size_t used_offset
+    , uint32_t key, uint32_t now, int* found )
+{
+    // PRECONDITIONS
+    assert( slots != 0 );
+    assert( count > 0 );
+    assert( found != 0 );
+
+    uint8_t* lru = ( uint8_t* ) slots;
+
+    for( size_t i = 0; i < count; ++i )
+    {
+        uint8_t* slot       = ( uint8_t* ) slots + i * slot_size;
+        uint32_t* slot_key  = ( uint32_t* ) ( slot + key_offset );
+        uint32_t* slot_used = ( uint32_t* ) ( slot + used_offset );
+
+        if( *slot_key == key )
+        {
+            *slot_used  = now;
+            *found      = 1;
+            return slot;
+        }
+
+        if( *( uint32_t* ) ( lru + key_offset ) != 0
+            && ( *slot_key == 0 || xi_time_after( *( uint32_t* ) ( lru + used_offset ), *slot_used ) ) )
+        {
+            lru = slot;
+        }
+    }
+
+    memset( lru, 0, slot_size );
+
+    *( uint32_t* ) ( lru + key_offset )     = key;
+    *( uint32_t* ) ( lru + used_offset )    = now;
+    *found                                  = 0;
+
+    return lru;
+}
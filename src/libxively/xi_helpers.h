@@ -11,6 +11,7 @@
 #define __XI_HELPERS_H__
 
 #include <stdlib.h>
+#include <stdint.h>
 #include <time.h>
 #include <limits.h>
 
@@ -36,29 +37,30 @@ int xi_str_copy_untiln( char* dst, size_t dst_size, const char* src, char delim
 /**
  * \brief   Converts from `tm` to `time_t`
  *
- * \note    This code assumes that unsigned long can be converted to `time_t`.
- *          A `time_t` should not be wider than `unsigned long`, since this
- *          would mean that the check for overflow at the end could fail.
- *
- * \note    This implementation had been copied from MINIX C library.
- *          Which is 100% compatible with our license.
+ *   Fields out of their range are carried over, e.g. 60 seconds make a minute,
+ *   and `t` is updated with the normalised date and time, along with `tm_yday`
+ *   and `tm_wday`. Nothing is kept between calls, so it is reentrant.
  *
  * \note    This function does not take into account the timezone or the `dst`,
  *          it just converts `tm` structure using date and time fields (i.e. UTC).
+ *
+ * \return  Seconds since the epoch or -1 if the time is before it or doesn't fit `time_t`.
  */
 time_t xi_mktime( struct tm* t );
 
 /**
- * \brief   Converts from `time_t` to `tm`
+ * \brief   Converts from `time_t` to `tm` (UTC)
  *
- * \note    This code assumes that unsigned long can be converted to `time_t`.
- *          A `time_t` should not be wider than `unsigned long`, since this
- *          would mean that the check for overflow at the end could fail.
+ * \note    The result is in a static buffer, overwritten by every call.
+ */
+struct tm* xi_gmtime( const time_t* t );
+
+/**
+ * \brief   Converts from `time_t` to `tm` (UTC), writing into `result`
  *
- * \note    This implementation had been copied from MINIX C library.
- *          Which is 100% compatible with our license.
+ * \return  `result`
  */
-struct tm* xi_gmtime( register const time_t* t );
+struct tm* xi_gmtime_r( const time_t* t, struct tm* result );
 
 /**
  * \brief   Replaces `p` with `r` for every `p` in `buffer`
@@ -71,6 +73,89 @@ char* xi_replace_with(
     , char* buffer
     , size_t max_chars );
 
+/**
+ * \brief   Writes the shortest decimal that reads back as the same float
+ *
+ *   The notation is always plain, with at least one digit after the point,
+ *   e.g. `21.5`, `0.1` or `30000.0`, regardless of the locale. Infinities
+ *   and NaN are written as `inf`, `-inf` and `nan`.
+ *
+ * \return  Like `snprintf()`, the size of the whole string, which was cut short if it's not below `buffer_size`.
+ */
+int xi_float_to_str( char* buffer, size_t buffer_size, float value );
+
+/**
+ * \brief   Writes the decimal digits of `value`, same as `%d` would
+ *
+ * \return  Like `snprintf()`, the size of the whole string, which was cut short if it's not below `buffer_size`.
+ */
+int xi_int_to_str( char* buffer, size_t buffer_size, int32_t value );
+
+/**
+ * \brief   Writes the timestamp as `YYYY-MM-DDTHH:MM:SS.ffffffZ`, as Xively takes it
+ *
+ *   The date and time up to the minute are kept from the previous call, so
+ *   timestamps of a batch taken within the same minute are formatted without
+ *   converting them with `xi_gmtime()` again. Each call works on its own copy
+ *   of what is kept, so calls from several threads at once stay within bounds.
+ *
+ * \return  Like `snprintf()`, the size of the whole string, which was cut short if it's not below `buffer_size`.
+ */
+int xi_timestamp_to_str( char* buffer, size_t buffer_size, time_t timestamp, time_t micro );
+
+/**
+ * \brief   Reads a timestamp written as `YYYY-MM-DDTHH:MM:SS.ffffffZ`
+ *
+ *   The layout is fixed and each field is checked against the calendar, the
+ *   fraction may have any number of digits or be left out along with the point.
+ *   Nothing past the `Z` is read.
+ *
+ * \return  Number of characters read, -1 if the date and time aren't valid
+ *          or -2 if they aren't followed by the fraction and `Z`.
+ */
+int xi_str_to_timestamp( const char* str, time_t* timestamp, time_t* micro );
+
+/**
+ * \brief   Seed of the hash computed by `xi_hash()`
+ */
+#define XI_HASH_SEED 2166136261u
+
+/**
+ * \brief   Adds `size` bytes to the FNV-1a hash `h`, which starts as `XI_HASH_SEED`
+ */
+uint32_t xi_hash( uint32_t h, const void* data, size_t size );
+
+/**
+ * \brief   Turns the hash into a key of the tables below, where zero is left for free slots
+ */
+uint32_t xi_hash_key( uint32_t h );
+
+/**
+ * \brief   Tells whether millisecond time `a` comes after `b`, the difference is taken
+ *          as signed, so the clock may wrap around
+ */
+int xi_time_after( uint32_t a, uint32_t b );
+
+/**
+ * \brief   Time-seeded xorshift, cheap pseudo random numbers e.g. for retry jitter
+ * \warning It's predictable, don't use it where a secret or a nonce is needed.
+ */
+uint32_t xi_random( void );
+
+/**
+ * \brief   Looks `key` up in a table of `count` slots of `slot_size` bytes, each with
+ *          a `uint32_t` key and time of last use at the given offsets
+ *
+ *    Slots with zero key are free. If the key isn't found, the first free slot, or
+ *    the one left unused for longest, is cleared and given the key, and `*found`
+ *    is set to 0, so the caller can set up the rest of it.
+ *
+ * \return  The slot, marked as used at `now`.
+ */
+void* xi_lru_slot( void* slots, size_t count, size_t slot_size
+    , size_t key_offset, size_t used_offset
+    , uint32_t key, uint32_t now, int* found );
+
 #ifdef __cplusplus
 }
 #endif
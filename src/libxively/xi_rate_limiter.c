@@ -0,0 +1,146 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    xi_rate_limiter.c
+ * \brief   Paces requests per API key so they aren't sent just to be rejected [see xi_rate_limiter.h]
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <assert.h>
+
+#include "xi_rate_limiter.h"
+#include "xi_globals.h"
+#include "xi_consts.h"
+#include "xi_helpers.h"
+
+static xi_rate_bucket_t XI_RATE_BUCKETS[ XI_RATE_LIMITED_KEYS ];
+
+static uint32_t xi_rate_limiter_capacity( void )
+{
+    return ( xi_globals.rate_limit_burst ? xi_globals.rate_limit_burst : 1 ) * 1000;
+}
+
+// the bucket fills up at `rate_limit` thousandths of a request per 60 milliseconds
+static void xi_rate_limiter_refill( xi_rate_bucket_t* bucket, uint32_t now )
+{
+    if( !xi_time_after( now, bucket->updated ) ) { return; }
+
+    uint64_t tokens = bucket->tokens
+        + ( uint64_t ) ( now - bucket->updated ) * xi_globals.rate_limit / 60;
+
+    bucket->tokens  = ( uint32_t ) ( tokens < xi_rate_limiter_capacity() ? tokens : xi_rate_limiter_capacity() );
+    bucket->updated = now;
+}
+
+xi_rate_bucket_t* xi_rate_limiter_get( const char* api_key, uint32_t now )
+{
+    const char* k   = api_key ? api_key : "";
+    uint32_t key    = xi_hash_key( xi_hash( XI_HASH_SEED, k, strlen( k ) ) );
+    int found       = 0;
+
+    xi_rate_bucket_t* bucket = ( xi_rate_bucket_t* ) xi_lru_slot(
+          XI_RATE_BUCKETS, XI_RATE_LIMITED_KEYS, sizeof( xi_rate_bucket_t )
+        , offsetof( xi_rate_bucket_t, key ), offsetof( xi_rate_bucket_t, used )
+        , key, now, &found );
+
+    if( !found )
+    {
+        bucket->tokens  = xi_rate_limiter_capacity();
+        bucket->updated = now;
+    }
+
+    return bucket;
+}
+
+uint32_t xi_rate_limiter_delay( xi_rate_bucket_t* bucket, uint32_t now )
+{
+    // PRECONDITIONS
+    assert( bucket != 0 );
+
+    uint32_t delay = 0;
+
+    if( bucket->blocked )
+    {
+        if( xi_time_after( bucket->blocked_until, now ) )
+        {
+            delay = bucket->blocked_until - now;
+        }
+        else
+        {
+            bucket->blocked = 0;
+        }
+    }
+
+    if( xi_globals.rate_limit == 0 ) { return delay; }
+
+    xi_rate_limiter_refill( bucket, now );
+
+    // a blocked bucket is refilled from the end of the block on
+    uint32_t from = now + delay;
+    uint32_t tokens = bucket->tokens;
+
+    if( xi_time_after( from, bucket->updated ) )
+    {
+        uint64_t t = tokens + ( uint64_t ) ( from - bucket->updated ) * xi_globals.rate_limit / 60;
+        tokens = ( uint32_t ) ( t < 1000 ? t : 1000 );
+    }
+
+    if( tokens < 1000 )
+    {
+        delay += ( uint32_t ) ( ( ( uint64_t ) ( 1000 - tokens ) * 60 + xi_globals.rate_limit - 1 )
+            / xi_globals.rate_limit );
+    }
+
+    return delay;
+}
+
+void xi_rate_limiter_take( xi_rate_bucket_t* bucket, uint32_t now )
+{
+    // PRECONDITIONS
+    assert( bucket != 0 );
+
+    if( xi_globals.rate_limit == 0 ) { return; }
+
+    xi_rate_limiter_refill( bucket, now );
+
+    bucket->tokens = bucket->tokens > 1000 ? bucket->tokens - 1000 : 0;
+}
+
+void xi_rate_limiter_update( xi_rate_bucket_t* bucket, uint32_t now
+    , int http_status, const char* retry_after )
+{
+    // PRECONDITIONS
+    assert( bucket != 0 );
+
+    if( http_status != 429 && http_status != 503 ) { return; }
+
+    uint32_t backoff = XI_RATE_LIMIT_BACKOFF;
+
+    // a date is as good as nothing, the clocks can't be compared anyway
+    if( retry_after && *retry_after >= '0' && *retry_after <= '9' )
+    {
+        unsigned long seconds = strtoul( retry_after, 0, 10 );
+
+        // a day is long enough to tell the API has given up on us
+        backoff = ( uint32_t ) ( seconds < 86400 ? seconds : 86400 ) * 1000;
+    }
+
+    uint32_t until = now + backoff;
+
+    if( !bucket->blocked || xi_time_after( until, bucket->blocked_until ) )
+    {
+        bucket->blocked_until = until;
+    }
+
+    bucket->blocked = 1;
+    bucket->tokens  = 0;
+    bucket->updated = bucket->blocked_until;
+}
+
+void xi_rate_limiter_reset( void )
+{
+    memset( XI_RATE_BUCKETS, 0, sizeof( XI_RATE_BUCKETS ) );
+}
@@ -0,0 +1,66 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    xi_rate_limiter.h
+ * \brief   Paces requests per API key so they aren't sent just to be rejected
+ *
+ *    Each key gets a token bucket refilled at `xi_globals.rate_limit` requests per
+ *    minute, which is what the API allows, and a request takes one token. When
+ *    the server answers `429 Too Many Requests` or `503 Service Unavailable` the
+ *    bucket is emptied and nothing is sent until `Retry-After` has passed.
+ *
+ *    All times are in milliseconds of `comm_layer_t::get_time_ms()`.
+ */
+
+#ifndef __XI_RATE_LIMITER_H__
+#define __XI_RATE_LIMITER_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint32_t    key;            //!< hash of the API key, 0 if the bucket is free
+    uint32_t    tokens;         //!< in thousandths of a request
+    uint32_t    updated;        //!< when the tokens were last added
+    uint32_t    used;           //!< when the bucket was last looked up
+    uint32_t    blocked_until;  //!< nothing may be sent before that
+    uint8_t     blocked;        //!< whether `blocked_until` applies
+} xi_rate_bucket_t;
+
+/**
+ * \brief   Finds the bucket of the key, the least recently used one is taken over for a new key
+ */
+xi_rate_bucket_t* xi_rate_limiter_get( const char* api_key, uint32_t now );
+
+/**
+ * \brief   Tells how long the next request has to wait
+ */
+uint32_t xi_rate_limiter_delay( xi_rate_bucket_t* bucket, uint32_t now );
+
+/**
+ * \brief   Takes a token for the request being sent at `now`
+ */
+void xi_rate_limiter_take( xi_rate_bucket_t* bucket, uint32_t now );
+
+/**
+ * \brief   Blocks the bucket if the server has been asked too much
+ *
+ * \param   retry_after value of `Retry-After` header or null
+ */
+void xi_rate_limiter_update( xi_rate_bucket_t* bucket, uint32_t now
+    , int http_status, const char* retry_after );
+
+/**
+ * \brief   Forgets all the keys
+ */
+void xi_rate_limiter_reset( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __XI_RATE_LIMITER_H__
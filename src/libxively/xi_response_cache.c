@@ -0,0 +1,105 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    xi_response_cache.c
+ * \brief   Validators and decoded values of the resources fetched by a context [see xi_response_cache.h]
+ */
+
+#include <string.h>
+#include <assert.h>
+
+#include "xi_response_cache.h"
+#include "xi_helpers.h"
+#include "http_layer_parser.h"
+#include "xi_allocator.h"
+#include "xi_macros.h"
+
+uint32_t xi_response_cache_feed_key( const xi_feed_t* feed )
+{
+    // PRECONDITIONS
+    assert( feed != 0 );
+
+    uint32_t h = xi_hash( XI_HASH_SEED
+        , &feed->feed_id, sizeof( feed->feed_id ) );
+
+    for( size_t i = 0; i < feed->datastream_count; ++i )
+    {
+        const char* id = feed->datastreams[ i ].datastream_id;
+
+        // the terminator keeps "ab","c" apart from "a","bc"
+        h = xi_hash( h, id, strlen( id ) + 1 );
+    }
+
+    return xi_hash_key( h );
+}
+
+uint32_t xi_response_cache_datastream_key( int32_t feed_id, const char* datastream_id )
+{
+    // PRECONDITIONS
+    assert( datastream_id != 0 );
+
+    uint32_t h = xi_hash( XI_HASH_SEED
+        , &feed_id, sizeof( feed_id ) );
+
+    return xi_hash_key(
+        xi_hash( h, datastream_id, strlen( datastream_id ) ) );
+}
+
+int xi_response_cache_find_datastream( const xi_response_cache_t* cache, uint32_t key )
+{
+    // PRECONDITIONS
+    assert( cache != 0 );
+
+    for( size_t i = 0; i < XI_CACHED_DATASTREAMS; ++i )
+    {
+        if( cache->datastream_validators[ i ].key == key ) { return ( int ) i; }
+    }
+
+    return -1;
+}
+
+int xi_response_cache_store_validators(
+      xi_validators_t* validators, uint32_t key
+    , const http_response_t* response )
+{
+    // PRECONDITIONS
+    assert( validators != 0 );
+    assert( response != 0 );
+
+    http_response_header( response, XI_HTTP_HEADER_ETAG
+        , validators->etag, sizeof( validators->etag ) );
+    http_response_header( response, XI_HTTP_HEADER_LAST_MODIFIED
+        , validators->last_modified, sizeof( validators->last_modified ) );
+
+    int found = validators->etag[ 0 ] != '\0' || validators->last_modified[ 0 ] != '\0';
+
+    validators->key = found ? key : 0;
+
+    return found;
+}
+
+int xi_response_cache_store_feed( xi_response_cache_t* cache, const xi_feed_t* feed )
+{
+    // PRECONDITIONS
+    assert( cache != 0 );
+    assert( feed != 0 );
+
+    if( cache->feed == 0 )
+    {
+        cache->feed = ( xi_feed_t* ) xi_alloc( sizeof( xi_feed_t ) );
+
+        if( cache->feed == 0 ) { return -1; }
+    }
+
+    memcpy( cache->feed, feed, sizeof( xi_feed_t ) );
+
+    return 0;
+}
+
+void xi_response_cache_release( xi_response_cache_t* cache )
+{
+    if( cache == 0 ) { return; }
+
+    XI_SAFE_FREE( cache->feed );
+}
@@ -0,0 +1,86 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    xi_response_cache.h
+ * \brief   Validators and decoded values of the resources fetched by a context
+ *
+ *    The feed and the most recently fetched datastreams are remembered along with
+ *    `ETag` and `Last-Modified` of their replies, so the next `GET` can be made
+ *    conditional and a `304 Not Modified` can be answered from the cache without
+ *    running the data layer again.
+ */
+
+#ifndef __XI_RESPONSE_CACHE_H__
+#define __XI_RESPONSE_CACHE_H__
+
+#include "xively.h"
+#include "xi_consts.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint32_t    key;                                            //!< identifies the request, 0 if the slot is empty
+    char        etag[ XI_HTTP_HEADER_VALUE_MAX_SIZE ];
+    char        last_modified[ XI_HTTP_HEADER_VALUE_MAX_SIZE ];
+} xi_validators_t;
+
+typedef struct {
+    xi_cache_stats_t    stats;
+    xi_validators_t     feed_validators;
+    xi_feed_t*          feed;                                   //!< allocated once a feed is cached
+    uint32_t            feed_reply_key;                         //!< key of the feed as it was handed back
+    size_t              feed_filter_count;                      //!< datastreams the cached request asked for
+    xi_validators_t     datastream_validators[ XI_CACHED_DATASTREAMS ];
+    xi_datapoint_t      datapoints[ XI_CACHED_DATASTREAMS ];
+    size_t              next_datastream;                        //!< slot to be replaced next
+} xi_response_cache_t;
+
+/**
+ * \brief   Key of a feed request, which depends on the datastreams asked for
+ *
+ *    `xi_feed_get()` fills the datastreams in from the reply, so the same feed
+ *    passed again keys differently, `feed_reply_key` of the cache tells it apart.
+ */
+uint32_t xi_response_cache_feed_key( const xi_feed_t* feed );
+
+/**
+ * \brief   Key of a datastream request
+ */
+uint32_t xi_response_cache_datastream_key( int32_t feed_id, const char* datastream_id );
+
+/**
+ * \brief   Finds the cached datastream
+ *
+ * \return  Index of the slot or -1 if it's not there.
+ */
+int xi_response_cache_find_datastream( const xi_response_cache_t* cache, uint32_t key );
+
+/**
+ * \brief   Remembers validators of the reply under the given key
+ *
+ * \return  1 if there were any validators to remember, 0 otherwise.
+ */
+int xi_response_cache_store_validators(
+      xi_validators_t* validators, uint32_t key
+    , const http_response_t* response );
+
+/**
+ * \brief   Keeps a copy of the feed, the room for it is allocated on first use
+ *
+ * \return  0 on success or -1 if there is no memory for it.
+ */
+int xi_response_cache_store_feed( xi_response_cache_t* cache, const xi_feed_t* feed );
+
+/**
+ * \brief   Frees what the cache has allocated, but not the cache itself
+ */
+void xi_response_cache_release( xi_response_cache_t* cache );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __XI_RESPONSE_CACHE_H__
@@ -0,0 +1,57 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    xi_retry.c
+ * \brief   Decides whether a failed request is worth sending again and when [see xi_retry.h]
+ */
+
+#include <assert.h>
+
+#include "xi_retry.h"
+
+uint32_t xi_retry_delay( const xi_retry_policy_t* policy, uint32_t previous, uint32_t random )
+{
+    // PRECONDITIONS
+    assert( policy != 0 );
+
+    uint32_t base   = policy->base_delay;
+    uint32_t cap    = policy->max_delay > base ? policy->max_delay : base;
+    uint64_t upper  = ( uint64_t ) ( previous > base ? previous : base ) * 3;
+
+    if( upper > cap ) { upper = cap; }
+
+    if( upper <= base ) { return base; }
+
+    return base + ( uint32_t ) ( random % ( upper - base + 1 ) );
+}
+
+int xi_retry_is_transient_status( int http_status )
+{
+    switch( http_status )
+    {
+        case 408: // Request Timeout
+        case 429: // Too Many Requests
+        case 502: // Bad Gateway
+        case 503: // Service Unavailable
+        case 504: // Gateway Timeout
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+int xi_retry_is_transient_error( xi_err_t err )
+{
+    switch( err )
+    {
+        case XI_SOCKET_GETHOSTBYNAME_ERROR:
+        case XI_SOCKET_CONNECTION_ERROR:
+        case XI_SOCKET_WRITE_ERROR:
+        case XI_SOCKET_READ_ERROR:
+        case XI_WS_CONNECTION_CLOSED:
+            return 1;
+        default:
+            return 0;
+    }
+}
@@ -0,0 +1,47 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    xi_retry.h
+ * \brief   Decides whether a failed request is worth sending again and when
+ *
+ *    Waits between attempts follow the "decorrelated jitter" scheme: each one is
+ *    picked at random between the base delay and three times the previous wait,
+ *    capped at the maximum, so clients that failed together don't come back together.
+ */
+
+#ifndef __XI_RETRY_H__
+#define __XI_RETRY_H__
+
+#include <stdint.h>
+
+#include "xively.h"
+#include "xi_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief   Picks the wait before the next attempt
+ *
+ * \param   previous the wait before this attempt, 0 for the first one
+ * \param   random   any value, e.g. of `xi_random()`
+ */
+uint32_t xi_retry_delay( const xi_retry_policy_t* policy, uint32_t previous, uint32_t random );
+
+/**
+ * \brief   Tells if the server may answer differently next time
+ */
+int xi_retry_is_transient_status( int http_status );
+
+/**
+ * \brief   Tells if the error came from the network rather than the request itself
+ */
+int xi_retry_is_transient_error( xi_err_t err );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __XI_RETRY_H__
@@ -14,12 +14,21 @@
 #include "xi_allocator.h"
 #include "xively.h"
 #include "http_transport.h"
+#include "http_transport_layer.h"
+#include "ws_transport.h"
+#include "tcp_transport.h"
+#include "mqtt_transport.h"
 #include "csv_data_layer.h"
 #include "xi_macros.h"
 #include "xi_debug.h"
 #include "xi_helpers.h"
 #include "xi_err.h"
 #include "xi_globals.h"
+#include "xi_response_cache.h"
+#include "http_layer_parser.h"
+#include "xi_rate_limiter.h"
+#include "xi_retry.h"
+#include "xi_circuit_breaker.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -46,50 +55,595 @@ const comm_layer_t* get_comm_layer( void );
     const transport_layer_t* transport_layer = 0;\
     const data_layer_t* data_layer = 0;\
     char  buffer[ XI_HTTP_MAX_CONTENT_SIZE ];\
-    const xi_response_t* response = 0;\
-    int sent = 0;\
-    int recv = 0;
+    const xi_response_t* response = 0;
 
 #define XI_FUNCTION_PROLOGUE  XI_FUNCTION_VARIABLES\
     xi_debug_log_str( "Getting the comm layer...\n" );\
     comm_layer = get_comm_layer();\
     xi_debug_log_str( "Getting the transport layer...\n" );\
-    transport_layer = get_http_transport_layer();\
+    transport_layer = get_transport_layer( xi->protocol );\
     xi_debug_log_str( "Getting the data layer...\n");\
     data_layer = get_csv_data_layer();\
 
-#define XI_FUNCTION_GET_RESPONSE if( data == 0 ) { goto err_handling; }\
-    xi_debug_log_str( "Connecting to the endpoint...\n" );\
-    conn = comm_layer->open_connection( XI_HOST, XI_PORT );\
-    if( conn == 0 ) { goto err_handling; }\
-    xi_debug_log_str( "Sending data:\n" );\
-    xi_debug_log_data( data );\
-    sent = comm_layer->send_data( conn, data, strlen( data ) );\
-    if( sent == -1 ) { goto err_handling; }\
-    xi_debug_log_str( "Sent: " );\
-    xi_debug_log_int( ( int ) sent );\
-    xi_debug_log_endl();\
-    xi_debug_log_str( "Reading data...\n" );\
-    recv = comm_layer->read_data( conn, buffer, XI_HTTP_MAX_CONTENT_SIZE );\
-    if( recv == -1 ) { goto err_handling; }\
-    xi_debug_log_str( "Received: " );\
-    xi_debug_log_int( ( int ) recv );\
-    xi_debug_log_endl();\
-    xi_debug_log_str( "Response:\n" );\
-    xi_debug_log_data( buffer );\
-    xi_debug_log_endl();\
-    response = transport_layer->decode_reply(\
-        data_layer, buffer );\
+#define XI_FUNCTION_GET_RESPONSE_IF( idempotent ) if( data == 0 ) { goto err_handling; }\
+    response = xi_get_response( xi, &conn, comm_layer, transport_layer\
+        , data_layer, data, buffer, sizeof( buffer ), idempotent );\
     if( response == 0 ) { goto err_handling; }\
 
-#define XI_FUNCTION_EPILOGUE xi_debug_log_str( "Closing connection...\n" );\
+// gets, updates and deletes may be retried
+#define XI_FUNCTION_GET_RESPONSE XI_FUNCTION_GET_RESPONSE_IF( 1 )
+
+// creates are sent once, the server may have done it before the connection broke
+#define XI_FUNCTION_GET_RESPONSE_ONCE XI_FUNCTION_GET_RESPONSE_IF( 0 )
+
+#define XI_FUNCTION_EPILOGUE \
 err_handling:\
-    if( conn )\
-    {\
-        comm_layer->close_connection( conn );\
-    }\
+    xi_release_connection( xi, comm_layer, conn, response == 0 );\
     return response;\
 
+//-----------------------------------------------------------------------
+// TRANSPORT HELPERS
+//-----------------------------------------------------------------------
+
+static const transport_layer_t* get_transport_layer( xi_protocol_t protocol )
+{
+    switch( protocol )
+    {
+#ifdef XI_TRANSPORT_TCP
+        case XI_TCP:
+            return get_tcp_transport_layer();
+#endif
+#ifdef XI_TRANSPORT_WS
+        case XI_WS:
+            return get_ws_transport_layer();
+#endif
+#ifdef XI_TRANSPORT_MQTT
+        case XI_MQTT:
+            return get_mqtt_transport_layer();
+#endif
+        default:
+            // the rest has no implementation of its own or it wasn't built in,
+            // so it goes over plain HTTP as it always did
+            return get_http_transport_layer();
+    }
+}
+
+static int32_t get_transport_port( xi_protocol_t protocol )
+{
+    switch( protocol )
+    {
+#ifdef XI_TRANSPORT_TCP
+        case XI_TCP:
+            return XI_TCP_PORT;
+#endif
+#ifdef XI_TRANSPORT_WS
+        case XI_WS:
+            return XI_WS_PORT;
+#endif
+#ifdef XI_TRANSPORT_MQTT
+        case XI_MQTT:
+            return XI_MQTT_PORT;
+#endif
+        default:
+            return XI_PORT;
+    }
+}
+
+// the circuit of the endpoint of the context, if the breaker is on and there's a clock to time it
+static xi_circuit_t* xi_get_circuit(
+      xi_context_t* xi
+    , const comm_layer_t* comm_layer )
+{
+    if( xi_globals.circuit_breaker_threshold == 0 || comm_layer->get_time_ms == 0 ) { return 0; }
+
+    return xi_circuit_breaker_get( XI_HOST, get_transport_port( xi->protocol )
+        , comm_layer->get_time_ms() );
+}
+
+// the endpoint couldn't be reached or didn't answer
+static void xi_note_failure(
+      xi_context_t* xi
+    , const comm_layer_t* comm_layer )
+{
+    xi_circuit_t* circuit = xi_get_circuit( xi, comm_layer );
+
+    if( circuit ) { xi_circuit_breaker_failure( circuit, comm_layer->get_time_ms() ); }
+}
+
+// the endpoint answered
+static void xi_note_success(
+      xi_context_t* xi
+    , const comm_layer_t* comm_layer )
+{
+    xi_circuit_t* circuit = xi_get_circuit( xi, comm_layer );
+
+    if( circuit ) { xi_circuit_breaker_success( circuit ); }
+}
+
+// session-based transports keep their connection in the context, so the handshake is done once
+static connection_t* xi_acquire_connection(
+      xi_context_t* xi
+    , const comm_layer_t* comm_layer
+    , const transport_layer_t* transport_layer )
+{
+    connection_t* conn = ( connection_t* ) xi->connection;
+
+    if( conn ) { return conn; }
+
+    // an endpoint that keeps failing isn't waited for
+    xi_circuit_t* circuit = xi_get_circuit( xi, comm_layer );
+
+    XI_CHECK_CND( circuit && !xi_circuit_breaker_allow( circuit, comm_layer->get_time_ms() )
+        , XI_CIRCUIT_OPEN );
+
+    xi_debug_log_str( "Connecting to the endpoint...\n" );
+    conn = comm_layer->open_connection( XI_HOST, get_transport_port( xi->protocol ) );
+
+    if( conn == 0 )
+    {
+        xi_note_failure( xi, comm_layer );
+        return 0;
+    }
+
+    if( transport_layer->open_session )
+    {
+        xi_debug_log_str( "Opening the session...\n" );
+
+        if( transport_layer->open_session( comm_layer, conn, xi->api_key ) == -1 )
+        {
+            xi_note_failure( xi, comm_layer );
+            comm_layer->close_connection( conn );
+            return 0;
+        }
+
+        // the handshake is an answer too, there may be no other one (e.g. MQTT with QoS 0)
+        xi_note_success( xi, comm_layer );
+
+        xi->connection = conn;
+    }
+
+    return conn;
+
+err_handling:
+    return 0;
+}
+
+static void xi_release_connection(
+      xi_context_t* xi
+    , const comm_layer_t* comm_layer
+    , connection_t* conn
+    , int failed )
+{
+    if( conn == 0 ) { return; }
+
+    // the session stays open for the next call, unless it's broken
+    if( conn == xi->connection && !failed ) { return; }
+
+    xi_debug_log_str( "Closing connection...\n" );
+    comm_layer->close_connection( conn );
+
+    if( conn == xi->connection ) { xi->connection = 0; }
+}
+
+// what was read past the last reply would be gone with the buffer and the next reply read
+// from the session would start in the middle of something, so the session is left instead,
+// a connection of the call is closed when it's released
+static void xi_leave_session_if_unread(
+      xi_context_t* xi
+    , const comm_layer_t* comm_layer
+    , connection_t* conn
+    , size_t size )
+{
+    if( size == 0 || xi->connection == 0 ) { return; }
+
+    xi_debug_log_str( "Leaving the session, there is more to read...\n" );
+
+    if( conn != xi->connection ) { comm_layer->close_connection( ( connection_t* ) xi->connection ); }
+
+    xi->connection = 0;
+}
+
+// holds the request back for as long as the rate limit of the key says
+static int xi_pace_request(
+      xi_context_t* xi
+    , const comm_layer_t* comm_layer )
+{
+    // there is no way to tell the time
+    if( comm_layer->get_time_ms == 0 || comm_layer->sleep_ms == 0 ) { return 0; }
+
+    uint32_t now                = comm_layer->get_time_ms();
+    xi_rate_bucket_t* bucket    = xi_rate_limiter_get( xi->api_key, now );
+    uint32_t delay              = xi_rate_limiter_delay( bucket, now );
+
+    XI_CHECK_CND( delay > xi_globals.rate_limit_max_wait, XI_RATE_LIMITED );
+
+    if( delay )
+    {
+        xi_debug_log_str( "Waiting for the rate limit: " );
+        xi_debug_log_int( ( int ) delay );
+        xi_debug_log_endl();
+
+        comm_layer->sleep_ms( delay );
+        now += delay;
+    }
+
+    xi_rate_limiter_take( bucket, now );
+
+    return 0;
+
+err_handling:
+    return -1;
+}
+
+// lets the circuit breaker know the endpoint is up and the rate limiter
+// if the server has been asked too much
+static void xi_note_reply(
+      xi_context_t* xi
+    , const comm_layer_t* comm_layer
+    , const xi_response_t* response )
+{
+    int status              = response->http.http_status;
+    xi_circuit_t* circuit   = xi_get_circuit( xi, comm_layer );
+
+    // a gateway answering for the service that's down doesn't count
+    if( circuit )
+    {
+        if( status == 502 || status == 503 || status == 504 )
+        {
+            xi_circuit_breaker_failure( circuit, comm_layer->get_time_ms() );
+        }
+        else
+        {
+            xi_circuit_breaker_success( circuit );
+        }
+    }
+
+    if( ( status != 429 && status != 503 ) || comm_layer->get_time_ms == 0 ) { return; }
+
+    uint32_t now = comm_layer->get_time_ms();
+    char retry_after[ XI_HTTP_HEADER_VALUE_MAX_SIZE ];
+
+    xi_rate_limiter_update( xi_rate_limiter_get( xi->api_key, now ), now
+        , status, http_response_header( &response->http, XI_HTTP_HEADER_RETRY_AFTER
+            , retry_after, sizeof( retry_after ) ) );
+}
+
+// sends the most recently encoded request
+static int xi_send_data(
+      xi_context_t* xi
+    , connection_t* conn
+    , const comm_layer_t* comm_layer
+    , const transport_layer_t* transport_layer
+    , const char* data )
+{
+    if( xi_pace_request( xi, comm_layer ) == -1 ) { return -1; }
+
+    xi_debug_log_str( "Sending data:\n" );
+    xi_debug_log_data( data );
+    int sent = comm_layer->send_data( conn, data, transport_layer->get_encoded_size() );
+    if( sent == -1 ) { xi_note_failure( xi, comm_layer ); return -1; }
+    xi_debug_log_str( "Sent: " );
+    xi_debug_log_int( ( int ) sent );
+    xi_debug_log_endl();
+
+    if( transport_layer->send_body && transport_layer->send_body( comm_layer, conn ) == -1 )
+    {
+        xi_note_failure( xi, comm_layer );
+        return -1;
+    }
+
+    return 0;
+}
+
+// waits for the reply with the given id, replies to anything else are skipped, the first `*size`
+// bytes of the buffer are what's been read before and whatever follows the reply is left there
+static const xi_response_t* xi_read_reply(
+      xi_context_t* xi
+    , connection_t* conn
+    , const comm_layer_t* comm_layer
+    , const transport_layer_t* transport_layer
+    , const data_layer_t* data_layer
+    , uint32_t request_id
+    , char* buffer, size_t buffer_size, size_t* size )
+{
+    int recv = 0;
+
+    if( transport_layer->reply_size == 0 )
+    {
+        // the whole reply is expected in a single read
+        xi_debug_log_str( "Reading data...\n" );
+        recv = comm_layer->read_data( conn, buffer, buffer_size );
+        if( recv <= 0 ) { xi_note_failure( xi, comm_layer ); }
+        if( recv == -1 ) { return 0; }
+        XI_CHECK_CND( recv == 0, XI_SOCKET_READ_ERROR );
+        xi_debug_log_str( "Received: " );
+        xi_debug_log_int( ( int ) recv );
+        xi_debug_log_endl();
+        xi_debug_log_str( "Response:\n" );
+        xi_debug_log_data( buffer );
+        xi_debug_log_endl();
+
+        const xi_response_t* response = transport_layer->decode_reply( data_layer, buffer, recv );
+
+        // the content that didn't come with the first read
+        if( response && transport_layer->read_body
+         && transport_layer->read_body( comm_layer, conn, buffer, buffer_size ) == -1 )
+        {
+            if( xi_get_last_error() == XI_SOCKET_READ_ERROR ) { xi_note_failure( xi, comm_layer ); }
+            return 0;
+        }
+
+        if( response ) { xi_note_reply( xi, comm_layer, response ); }
+
+        return response;
+    }
+
+    for( ;; )
+    {
+        int reply_size = transport_layer->reply_size( buffer, *size );
+
+        if( reply_size == -1 ) { return 0; }
+
+        if( reply_size == 0 )
+        {
+            XI_CHECK_CND( *size == buffer_size, XI_REPLY_BUFFER_OVERFLOW );
+
+            xi_debug_log_str( "Reading data...\n" );
+            recv = comm_layer->read_data( conn, buffer + *size, buffer_size - *size );
+            if( recv <= 0 ) { xi_note_failure( xi, comm_layer ); }
+            if( recv == -1 ) { return 0; }
+            XI_CHECK_CND( recv == 0, XI_SOCKET_READ_ERROR );
+            xi_debug_log_str( "Received: " );
+            xi_debug_log_int( ( int ) recv );
+            xi_debug_log_endl();
+
+            *size += recv;
+            continue;
+        }
+
+        const xi_response_t* response = transport_layer->decode_reply(
+            data_layer, buffer, reply_size );
+
+        *size -= reply_size;
+        memmove( buffer, buffer + reply_size, *size );
+
+        if( response == 0 ) { return 0; }
+
+        xi_note_reply( xi, comm_layer, response );
+
+        if( request_id == 0 || response->request_id == request_id )
+        {
+            return response;
+        }
+
+        xi_debug_log_str( "Skipping unrelated reply...\n" );
+    }
+
+err_handling:
+    return 0;
+}
+
+// reads the reply to a request whose answer isn't wanted anymore, the transport decodes every reply
+// into the same place, so `response` is put back the way it was
+static int xi_drain_reply(
+      xi_context_t* xi
+    , connection_t* conn
+    , const comm_layer_t* comm_layer
+    , const transport_layer_t* transport_layer
+    , const data_layer_t* data_layer
+    , uint32_t request_id
+    , char* buffer, size_t buffer_size, size_t* size
+    , const xi_response_t* response )
+{
+    xi_response_t kept;
+    memcpy( &kept, response, sizeof( xi_response_t ) );
+
+    const xi_response_t* drained = xi_read_reply( xi, conn, comm_layer, transport_layer, data_layer
+        , request_id, buffer, buffer_size, size );
+
+    memcpy( ( xi_response_t* ) response, &kept, sizeof( xi_response_t ) );
+
+    return drained == 0 ? -1 : 0;
+}
+
+// sends the request and waits for its reply
+static const xi_response_t* xi_send_request(
+      xi_context_t* xi
+    , connection_t* conn
+    , const comm_layer_t* comm_layer
+    , const transport_layer_t* transport_layer
+    , const data_layer_t* data_layer
+    , const char* data
+    , char* buffer, size_t buffer_size )
+{
+    uint32_t request_id = transport_layer->get_request_id
+        ? transport_layer->get_request_id() : 0;
+    size_t size         = 0;
+
+    if( xi_send_data( xi, conn, comm_layer, transport_layer, data ) == -1 ) { return 0; }
+
+    if( transport_layer->get_immediate_reply )
+    {
+        const xi_response_t* response = transport_layer->get_immediate_reply();
+
+        if( response )
+        {
+            xi_note_reply( xi, comm_layer, response );
+            return response;
+        }
+    }
+
+    const xi_response_t* response = xi_read_reply( xi, conn, comm_layer, transport_layer, data_layer
+        , request_id, buffer, buffer_size, &size );
+
+    xi_leave_session_if_unread( xi, comm_layer, conn, size );
+
+    return response;
+}
+
+// sends the request again for as long as the retry policy of the context allows,
+// if it's safe to repeat and whatever went wrong may not happen next time
+static const xi_response_t* xi_get_response(
+      xi_context_t* xi
+    , connection_t** conn
+    , const comm_layer_t* comm_layer
+    , const transport_layer_t* transport_layer
+    , const data_layer_t* data_layer
+    , const char* data
+    , char* buffer, size_t buffer_size
+    , int idempotent )
+{
+    const xi_retry_policy_t* policy = &xi->retry_policy;
+    xi_retry_stats_t* stats         = &xi->retry_stats;
+
+    // without a clock the attempts go one after another
+    int timed           = comm_layer->get_time_ms != 0 && comm_layer->sleep_ms != 0;
+    uint32_t attempts   = idempotent && policy->max_attempts > 1 ? policy->max_attempts : 1;
+    uint32_t start      = timed ? comm_layer->get_time_ms() : 0;
+    uint32_t delay      = 0;
+    uint32_t attempt    = 1;
+
+    for( ;; ++attempt )
+    {
+        ++stats->attempts;
+
+        *conn = xi_acquire_connection( xi, comm_layer, transport_layer );
+
+        const xi_response_t* response = *conn == 0 ? 0 : xi_send_request(
+            xi, *conn, comm_layer, transport_layer, data_layer, data, buffer, buffer_size );
+
+        xi_err_t err    = response ? XI_NO_ERR : xi_get_last_error();
+        int transient   = response
+            ? xi_retry_is_transient_status( response->http.http_status )
+            : xi_retry_is_transient_error( err );
+        int retry       = transient && attempt < attempts;
+
+        if( retry )
+        {
+            delay = xi_retry_delay( policy, delay, xi_random() );
+
+            retry = !timed || policy->deadline == 0
+                || comm_layer->get_time_ms() - start + delay <= policy->deadline;
+        }
+
+        if( !retry )
+        {
+            if( attempt > 1 )
+            {
+                if( response && !transient )    { ++stats->recovered; }
+                else                            { ++stats->gave_up; }
+            }
+
+            xi_set_err( err );
+
+            return response;
+        }
+
+        // a broken session is done with, the request goes on a fresh connection
+        xi_release_connection( xi, comm_layer, *conn, 1 );
+        *conn = 0;
+
+        xi_debug_log_str( "Retrying in: " );
+        xi_debug_log_int( ( int ) delay );
+        xi_debug_log_endl();
+
+        if( timed && delay ) { comm_layer->sleep_ms( delay ); }
+
+        ++stats->retries;
+    }
+}
+
+//-----------------------------------------------------------------------
+// CACHE HELPERS
+//-----------------------------------------------------------------------
+
+// the cache is only allocated once something is fetched, if there is no memory
+// for it the requests are made unconditional
+static xi_response_cache_t* xi_get_response_cache( xi_context_t* xi )
+{
+    if( xi->cache == 0 )
+    {
+        xi->cache = xi_alloc( sizeof( xi_response_cache_t ) );
+
+        if( xi->cache == 0 ) { return 0; }
+
+        memset( xi->cache, 0, sizeof( xi_response_cache_t ) );
+    }
+
+    return ( xi_response_cache_t* ) xi->cache;
+}
+
+// makes the next request conditional, there is nothing to send without an entry
+static void xi_set_request_validators(
+      const transport_layer_t* transport_layer
+    , const xi_validators_t* validators )
+{
+    if( transport_layer->set_request_validators == 0 ) { return; }
+
+    if( validators )
+    {
+        transport_layer->set_request_validators(
+              validators->etag[ 0 ] ? validators->etag : 0
+            , validators->last_modified[ 0 ] ? validators->last_modified : 0 );
+    }
+    else
+    {
+        transport_layer->set_request_validators( 0, 0 );
+    }
+}
+
+static int xi_is_success( const xi_response_t* response )
+{
+    return response->http.http_status >= 200 && response->http.http_status < 300;
+}
+
+//-----------------------------------------------------------------------
+// HISTORY HELPERS
+//-----------------------------------------------------------------------
+
+// counts the datapoints on a page of history and decodes the last one
+static int xi_history_page_last(
+      const data_layer_t* data_layer
+    , const char* content
+    , xi_datapoint_t* last )
+{
+    const char* last_line   = 0;
+    int count               = 0;
+
+    for( const char* line = content; line && *line != '\0'; )
+    {
+        const char* end_of_line = strchr( line, '\n' );
+
+        if( *line != '\n' && *line != '\r' )
+        {
+            last_line = line;
+            ++count;
+        }
+
+        line = end_of_line ? end_of_line + 1 : 0;
+    }
+
+    if( last_line && data_layer->decode_datapoint( last_line, last ) == 0 ) { return -1; }
+
+    return count;
+}
+
+static int xi_timestamp_before( const xi_timestamp_t* a, const xi_timestamp_t* b )
+{
+    return a->timestamp < b->timestamp
+        || ( a->timestamp == b->timestamp && a->micro < b->micro );
+}
+
+// the smallest step the API can tell apart
+static void xi_timestamp_next( xi_timestamp_t* t )
+{
+    if( ++t->micro == 1000000 )
+    {
+        t->micro = 0;
+        ++t->timestamp;
+    }
+}
+
 //-----------------------------------------------------------------------
 // HELPER FUNCTIONS
 //-----------------------------------------------------------------------
@@ -144,6 +698,76 @@ uint32_t xi_get_network_timeout( void )
     return xi_globals.network_timeout;
 }
 
+void xi_set_response_compression( uint8_t enabled )
+{
+    xi_globals.response_compression = enabled;
+}
+
+uint8_t xi_get_response_compression( void )
+{
+    return xi_globals.response_compression;
+}
+
+void xi_set_request_compression( uint32_t threshold )
+{
+    xi_globals.request_compression = threshold;
+}
+
+uint32_t xi_get_request_compression( void )
+{
+    return xi_globals.request_compression;
+}
+
+void xi_set_mqtt_qos( uint8_t qos )
+{
+    xi_globals.mqtt_qos = qos > 1 ? 1 : qos;
+}
+
+uint8_t xi_get_mqtt_qos( void )
+{
+    return xi_globals.mqtt_qos;
+}
+
+void xi_set_rate_limit( uint32_t requests_per_minute, uint32_t burst )
+{
+    xi_globals.rate_limit       = requests_per_minute;
+    xi_globals.rate_limit_burst = burst;
+}
+
+uint32_t xi_get_rate_limit( void )
+{
+    return xi_globals.rate_limit;
+}
+
+void xi_set_rate_limit_max_wait( uint32_t max_wait )
+{
+    xi_globals.rate_limit_max_wait = max_wait;
+}
+
+uint32_t xi_get_rate_limit_max_wait( void )
+{
+    return xi_globals.rate_limit_max_wait;
+}
+
+void xi_set_circuit_breaker( uint32_t threshold, uint32_t cooldown )
+{
+    xi_globals.circuit_breaker_threshold    = threshold;
+    xi_globals.circuit_breaker_cooldown     = cooldown;
+
+    // circuits opened with the old settings don't apply
+    xi_circuit_breaker_reset();
+}
+
+uint32_t xi_get_circuit_breaker_threshold( void )
+{
+    return xi_globals.circuit_breaker_threshold;
+}
+
+uint32_t xi_get_circuit_breaker_cooldown( void )
+{
+    return xi_globals.circuit_breaker_cooldown;
+}
+
 //-----------------------------------------------------------------------
 // MAIN LIBRARY FUNCTIONS
 //-----------------------------------------------------------------------
@@ -160,6 +784,12 @@ xi_context_t* xi_create_context(
     // copy given numeric parameters as is
     ret->protocol       = protocol;
     ret->feed_id        = feed_id;
+    ret->connection     = 0;
+    ret->cache          = 0;
+
+    // nothing is retried until asked for
+    memset( &ret->retry_policy, 0, sizeof( ret->retry_policy ) );
+    memset( &ret->retry_stats, 0, sizeof( ret->retry_stats ) );
 
     // copy string parameters carefully
     if( api_key )
@@ -189,29 +819,160 @@ void xi_delete_context( xi_context_t* context )
 {
     if( context )
     {
+        if( context->connection )
+        {
+            const comm_layer_t* comm_layer              = get_comm_layer();
+            const transport_layer_t* transport_layer    = get_transport_layer( context->protocol );
+
+            if( transport_layer->close_session )
+            {
+                transport_layer->close_session( comm_layer, context->connection );
+            }
+
+            comm_layer->close_connection( context->connection );
+        }
+
+        xi_response_cache_release( ( xi_response_cache_t* ) context->cache );
+        XI_SAFE_FREE( context->cache );
         XI_SAFE_FREE( context->api_key );
     }
     XI_SAFE_FREE( context );
 }
 
+const char* xi_response_header(
+          const xi_response_t* response
+        , http_header_type_t type
+        , char* buffer
+        , size_t buffer_size )
+{
+    if( buffer == 0 || buffer_size == 0 ) { return 0; }
+
+    buffer[ 0 ] = '\0';
+
+    if( response == 0 ) { return 0; }
+
+    return http_response_header( &response->http, type, buffer, buffer_size );
+}
+
+xi_cache_stats_t xi_get_cache_stats( const xi_context_t* context )
+{
+    static const xi_cache_stats_t empty = { 0, 0 };
+
+    if( context == 0 || context->cache == 0 ) { return empty; }
+
+    return ( ( const xi_response_cache_t* ) context->cache )->stats;
+}
+
+void xi_set_retry_policy( xi_context_t* context, const xi_retry_policy_t* policy )
+{
+    // PRECONDITIONS
+    assert( context != 0 );
+    assert( policy != 0 );
+
+    context->retry_policy = *policy;
+}
+
+xi_retry_stats_t xi_get_retry_stats( const xi_context_t* context )
+{
+    static const xi_retry_stats_t empty = { 0, 0, 0, 0 };
+
+    if( context == 0 ) { return empty; }
+
+    return context->retry_stats;
+}
+
 const xi_response_t* xi_feed_get(
           xi_context_t* xi
         , xi_feed_t* feed )
 {
     XI_FUNCTION_PROLOGUE
 
+    // without memory for the cache the request just isn't conditional
+    xi_response_cache_t* cache = xi_get_response_cache( xi );
+
+    uint32_t key = xi_response_cache_feed_key( feed );
+    size_t datastream_count = feed->datastream_count;
+
+    // when polling, the feed filled in by the last reply comes back, it stands for
+    // the datastreams the caller asked for then, not for the ones the reply listed
+    if( cache && cache->feed_validators.key != 0 && key == cache->feed_reply_key )
+    {
+        key                     = cache->feed_validators.key;
+        feed->datastream_count  = cache->feed_filter_count;
+    }
+
+    int cached = cache && cache->feed_validators.key == key;
+    size_t filter_count = feed->datastream_count;
+
+    xi_set_request_validators( transport_layer, cached ? &cache->feed_validators : 0 );
+
     const char* data = transport_layer->encode_get_feed(
               data_layer
             , xi->api_key
             , feed );
 
+    feed->datastream_count = datastream_count;
+
     if( data == 0 ) { goto err_handling; }
 
     XI_FUNCTION_GET_RESPONSE
 
+    if( cached && response->http.http_status == 304 )
+    {
+        memcpy( feed, cache->feed, sizeof( xi_feed_t ) );
+        cache->stats.hits += 1;
+        goto err_handling;
+    }
+
     feed = data_layer->decode_feed( response->http.http_content, feed );
     if( feed == 0 ) { goto err_handling; }
 
+    if( cache && xi_is_success( response ) )
+    {
+        cache->stats.misses += 1;
+
+        // without room for the copy the validators are of no use
+        if( xi_response_cache_store_validators( &cache->feed_validators, key, &response->http )
+         && xi_response_cache_store_feed( cache, feed ) == -1 )
+        {
+            cache->feed_validators.key = 0;
+        }
+
+        cache->feed_reply_key       = xi_response_cache_feed_key( feed );
+        cache->feed_filter_count    = filter_count;
+    }
+
+    XI_FUNCTION_EPILOGUE
+}
+
+const xi_response_t* xi_feed_get_each(
+          xi_context_t* xi
+        , const xi_feed_t* feed
+        , const xi_feed_visitor_t* visitor, void* user_data )
+{
+    // PRECONDITIONS
+    assert( feed != 0 );
+    assert( visitor != 0 );
+
+    XI_FUNCTION_PROLOGUE
+
+    // the feed isn't kept, so a 304 would leave nothing to visit
+    xi_set_request_validators( transport_layer, 0 );
+
+    const char* data = transport_layer->encode_get_feed(
+              data_layer
+            , xi->api_key
+            , feed );
+
+    if( data == 0 ) { goto err_handling; }
+
+    XI_FUNCTION_GET_RESPONSE
+
+    // error replies have no feed in them
+    if( !xi_is_success( response ) ) { goto err_handling; }
+
+    if( data_layer->visit_feed( response->http.http_content, visitor, user_data ) == -1 ) { goto err_handling; }
+
     XI_FUNCTION_EPILOGUE
 }
 
@@ -233,12 +994,123 @@ const xi_response_t* xi_feed_update(
     XI_FUNCTION_EPILOGUE
 }
 
+const xi_response_t* xi_feeds_update(
+          xi_context_t* xi
+        , const xi_feed_t* feeds, size_t feeds_count
+        , xi_response_callback_t callback, void* user_data )
+{
+    // PRECONDITIONS
+    assert( feeds != 0 || feeds_count == 0 );
+
+    XI_FUNCTION_PROLOGUE
+
+    // requests waiting for their replies, the oldest first
+    uint32_t pending_ids[ XI_PIPELINE_WINDOW ];
+    size_t pending_indexes[ XI_PIPELINE_WINDOW ];
+    size_t pending  = 0;
+    size_t sent     = 0;
+    size_t size     = 0;
+
+    // plain HTTP reads one reply per connection otherwise
+    if( transport_layer == get_http_transport_layer() )
+    {
+        transport_layer = get_http_pipelined_transport_layer();
+    }
+
+    if( feeds_count == 0 ) { goto err_handling; }
+
+    conn = xi_acquire_connection( xi, comm_layer, transport_layer );
+    if( conn == 0 ) { goto err_handling; }
+
+    while( sent < feeds_count || pending > 0 )
+    {
+        const xi_response_t* reply = 0;
+
+        while( sent < feeds_count && pending < XI_PIPELINE_WINDOW )
+        {
+            const char* data = transport_layer->encode_update_feed(
+                      data_layer
+                    , xi->api_key
+                    , &feeds[ sent ] );
+
+            if( data == 0 ) { response = 0; goto err_handling; }
+
+            uint32_t request_id = transport_layer->get_request_id
+                ? transport_layer->get_request_id() : 0;
+
+            if( xi_send_data( xi, conn, comm_layer, transport_layer, data ) == -1 ) { response = 0; goto err_handling; }
+
+            reply = transport_layer->get_immediate_reply
+                ? transport_layer->get_immediate_reply() : 0;
+
+            if( reply )
+            {
+                xi_note_reply( xi, comm_layer, reply );
+                response = reply;
+                if( callback ) { callback( sent, response, user_data ); }
+            }
+            else
+            {
+                pending_ids[ pending ]      = request_id;
+                pending_indexes[ pending ]  = sent;
+                ++pending;
+            }
+
+            ++sent;
+        }
+
+        if( pending == 0 ) { continue; }
+
+        reply = xi_read_reply( xi, conn, comm_layer, transport_layer, data_layer
+            , 0, buffer, sizeof( buffer ), &size );
+
+        if( reply == 0 ) { response = 0; goto err_handling; }
+
+        // replies of transports without ids come in order, the others are matched to their requests,
+        // anything without an id there (e.g. a ping) isn't a reply to an update
+        size_t i = 0;
+
+        if( transport_layer->get_request_id )
+        {
+            if( reply->request_id == 0 ) { i = pending; }
+
+            while( i < pending && pending_ids[ i ] != reply->request_id ) { ++i; }
+        }
+
+        if( i == pending )
+        {
+            xi_debug_log_str( "Skipping unrelated reply...\n" );
+            continue;
+        }
+
+        response = reply;
+        if( callback ) { callback( pending_indexes[ i ], response, user_data ); }
+
+        --pending;
+        memmove( pending_ids + i, pending_ids + i + 1, ( pending - i ) * sizeof( pending_ids[ 0 ] ) );
+        memmove( pending_indexes + i, pending_indexes + i + 1, ( pending - i ) * sizeof( pending_indexes[ 0 ] ) );
+    }
+
+    xi_leave_session_if_unread( xi, comm_layer, conn, size );
+
+    XI_FUNCTION_EPILOGUE
+}
+
 const xi_response_t* xi_datastream_get(
             xi_context_t* xi, int32_t feed_id
           , const char * datastream_id, xi_datapoint_t* o )
 {
     XI_FUNCTION_PROLOGUE
 
+    // without memory for the cache the request just isn't conditional
+    xi_response_cache_t* cache = xi_get_response_cache( xi );
+
+    uint32_t key = xi_response_cache_datastream_key( feed_id, datastream_id );
+    int slot = cache ? xi_response_cache_find_datastream( cache, key ) : -1;
+
+    xi_set_request_validators( transport_layer
+        , slot == -1 ? 0 : &cache->datastream_validators[ slot ] );
+
     const char* data = transport_layer->encode_get_datastream(
               data_layer
             , xi->api_key
@@ -249,11 +1121,34 @@ const xi_response_t* xi_datastream_get(
 
     XI_FUNCTION_GET_RESPONSE
 
+    if( slot != -1 && response->http.http_status == 304 )
+    {
+        memcpy( o, &cache->datapoints[ slot ], sizeof( xi_datapoint_t ) );
+        cache->stats.hits += 1;
+        goto err_handling;
+    }
+
     o = data_layer->decode_datapoint(
         response->http.http_content, o );
 
     if( o == 0 ) { goto err_handling; }
 
+    if( cache && xi_is_success( response ) )
+    {
+        cache->stats.misses += 1;
+
+        if( slot == -1 )
+        {
+            slot = ( int ) cache->next_datastream;
+            cache->next_datastream = ( cache->next_datastream + 1 ) % XI_CACHED_DATASTREAMS;
+        }
+
+        if( xi_response_cache_store_validators( &cache->datastream_validators[ slot ], key, &response->http ) )
+        {
+            memcpy( &cache->datapoints[ slot ], o, sizeof( xi_datapoint_t ) );
+        }
+    }
+
     XI_FUNCTION_EPILOGUE
 }
 
@@ -274,7 +1169,7 @@ const xi_response_t* xi_datastream_create(
 
     if( data == 0 ) { goto err_handling; }
 
-    XI_FUNCTION_GET_RESPONSE
+    XI_FUNCTION_GET_RESPONSE_ONCE
     XI_FUNCTION_EPILOGUE
 }
 
@@ -300,6 +1195,40 @@ const xi_response_t* xi_datastream_update(
 
     XI_FUNCTION_EPILOGUE
 }
+
+const xi_response_t* xi_datastream_update_static(
+          xi_context_t* xi
+        , const xi_static_request_t* request
+        , const xi_datapoint_t* datapoint )
+{
+    XI_FUNCTION_PROLOGUE
+
+    const char* data = 0;
+
+    if( transport_layer == get_http_transport_layer() )
+    {
+        data = http_encode_update_datastream_static(
+                  data_layer
+                , xi->api_key
+                , request
+                , datapoint );
+    }
+    else
+    {
+        data = transport_layer->encode_update_datastream(
+                  data_layer
+                , xi->api_key
+                , request->feed_id
+                , request->datastream_id
+                , datapoint );
+    }
+
+    if( data == 0 ) { goto err_handling; }
+
+    XI_FUNCTION_GET_RESPONSE
+    XI_FUNCTION_EPILOGUE
+}
+
 const xi_response_t* xi_datastream_delete(
             xi_context_t* xi, int32_t feed_id
           , const char * datastream_id )
@@ -320,7 +1249,7 @@ const xi_response_t* xi_datastream_delete(
 }
 
 const xi_response_t* xi_datapoint_delete(
-          const xi_context_t* xi, int feed_id
+          xi_context_t* xi, int feed_id
         , const char * datastream_id
         , const xi_datapoint_t* o )
 {
@@ -340,7 +1269,7 @@ const xi_response_t* xi_datapoint_delete(
 }
 
 extern const xi_response_t* xi_datapoint_delete_range(
-            const xi_context_t* xi, int feed_id
+            xi_context_t* xi, int feed_id
           , const char * datastream_id
           , const xi_timestamp_t* start
           , const xi_timestamp_t* end )
@@ -362,6 +1291,126 @@ extern const xi_response_t* xi_datapoint_delete_range(
 }
 
 
+const xi_response_t* xi_datastream_get_history(
+            xi_context_t* xi, int32_t feed_id
+          , const char * datastream_id
+          , const xi_timestamp_t* start
+          , const xi_timestamp_t* end
+          , uint32_t interval
+          , xi_datapoint_callback_t callback
+          , void* user_data )
+{
+    // PRECONDITIONS
+    assert( start != 0 );
+    assert( callback != 0 );
+
+    XI_FUNCTION_PROLOGUE
+
+    xi_timestamp_t cursor   = *start;
+    uint32_t request_id     = 0;
+    size_t size             = 0;
+    int prefetched          = 0;
+    int stopped             = 0;
+    xi_datapoint_t datapoint;
+
+    const char* data = transport_layer->encode_get_datastream_history(
+              data_layer
+            , xi->api_key
+            , feed_id
+            , datastream_id
+            , &cursor
+            , end
+            , interval
+            , XI_HISTORY_PAGE_SIZE );
+
+    if( data == 0 ) { goto err_handling; }
+
+    conn = xi_acquire_connection( xi, comm_layer, transport_layer );
+    if( conn == 0 ) { goto err_handling; }
+
+    request_id = transport_layer->get_request_id ? transport_layer->get_request_id() : 0;
+    if( xi_send_data( xi, conn, comm_layer, transport_layer, data ) == -1 ) { goto err_handling; }
+
+    do
+    {
+        response = xi_read_reply( xi, conn, comm_layer, transport_layer, data_layer
+            , request_id, buffer, sizeof( buffer ), &size );
+
+        if( response == 0 ) { goto err_handling; }
+
+        // the session stays open, a plain HTTP connection is done with
+        xi_release_connection( xi, comm_layer, conn, 0 );
+        conn = 0;
+
+        if( response->http.http_status != 200 ) { break; }
+
+        // a full page means there may be more, which start right after its last datapoint
+        int count = xi_history_page_last( data_layer, response->http.http_content, &datapoint );
+        if( count == -1 ) { response = 0; goto err_handling; }
+
+        prefetched = count >= XI_HISTORY_PAGE_SIZE
+            && ( end == 0 || xi_timestamp_before( &datapoint.timestamp, end ) );
+
+        if( prefetched )
+        {
+            // the next page is on its way while this one is being consumed
+            cursor = datapoint.timestamp;
+            xi_timestamp_next( &cursor );
+
+            data = transport_layer->encode_get_datastream_history(
+                      data_layer
+                    , xi->api_key
+                    , feed_id
+                    , datastream_id
+                    , &cursor
+                    , end
+                    , interval
+                    , XI_HISTORY_PAGE_SIZE );
+
+            if( data == 0 ) { response = 0; goto err_handling; }
+
+            conn = xi_acquire_connection( xi, comm_layer, transport_layer );
+            if( conn == 0 ) { response = 0; goto err_handling; }
+
+            request_id = transport_layer->get_request_id ? transport_layer->get_request_id() : 0;
+            if( xi_send_data( xi, conn, comm_layer, transport_layer, data ) == -1 ) { response = 0; goto err_handling; }
+        }
+
+        for( const char* line = response->http.http_content; line && *line != '\0' && !stopped; )
+        {
+            const char* end_of_line = strchr( line, '\n' );
+
+            if( *line != '\n' && *line != '\r' )
+            {
+                if( data_layer->decode_datapoint( line, &datapoint ) == 0 ) { response = 0; goto err_handling; }
+
+                stopped = callback( &datapoint, user_data ) != 0;
+            }
+
+            line = end_of_line ? end_of_line + 1 : 0;
+        }
+
+        if( stopped && prefetched )
+        {
+            prefetched = 0;
+
+            // the reply has to be taken off the session, the connection would be out of sync otherwise,
+            // if it can't be the session is closed, the callback has had what it asked for either way
+            if( conn == xi->connection && xi_drain_reply( xi, conn, comm_layer, transport_layer
+                , data_layer, request_id, buffer, sizeof( buffer ), &size, response ) == -1 )
+            {
+                xi_release_connection( xi, comm_layer, conn, 1 );
+                conn = 0;
+                xi_set_err( XI_NO_ERR );
+            }
+        }
+    } while( prefetched );
+
+    xi_leave_session_if_unread( xi, comm_layer, conn, size );
+
+    XI_FUNCTION_EPILOGUE
+}
+
 #ifdef __cplusplus
 }
 #endif
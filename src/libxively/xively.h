@@ -42,8 +42,30 @@ typedef enum {
     XI_WS,
     /** `wss://api.xively.com:8090` */
     XI_WSS,
+    /** `mqtt://api.xively.com:1883` (publish only) */
+    XI_MQTT,
 } xi_protocol_t;
 
+/**
+ * \brief   How requests that failed on the way are sent again - see `xi_set_retry_policy()`
+ */
+typedef struct {
+    uint32_t          max_attempts; //!< attempts in total, 0 or 1 means a request is never sent again
+    uint32_t          base_delay;   //!< the shortest wait between attempts in milliseconds
+    uint32_t          max_delay;    //!< the longest wait between attempts in milliseconds
+    uint32_t          deadline;     //!< milliseconds all the attempts of a call have to fit in, 0 for no limit
+} xi_retry_policy_t;
+
+/**
+ * \brief   Counters of the retries made with a context - see `xi_get_retry_stats()`
+ */
+typedef struct {
+    uint32_t          attempts;     //!< requests sent, the first attempts included
+    uint32_t          retries;      //!< requests sent again after a failure
+    uint32_t          recovered;    //!< calls that got an answer after being retried
+    uint32_t          gave_up;      //!< calls that ran out of attempts or time
+} xi_retry_stats_t;
+
 /**
  * \brief   _The context structure_ - it's the first agument for all functions
  *          that communicate with Xively API (_i.e. not helpers or utilities_)
@@ -52,6 +74,10 @@ typedef struct {
     char *api_key; /** Xively API key */
     xi_protocol_t protocol; /** Xively protocol */
     int32_t feed_id; /** Xively feed ID */
+    void* connection; /** connection kept open by session-based transports (e.g. `XI_WS`) */
+    void* cache; /** validators and values of fetched resources, used for conditional requests */
+    xi_retry_policy_t retry_policy; /** how failed requests are sent again */
+    xi_retry_stats_t retry_stats; /** what the retry policy has done */
 } xi_context_t;
 
 /**
@@ -77,6 +103,14 @@ typedef enum
     XI_HTTP_HEADER_COUNT,
     /** `Age` */
     XI_HTTP_HEADER_AGE,
+    /** `Content-Encoding` */
+    XI_HTTP_HEADER_CONTENT_ENCODING,
+    /** `ETag` */
+    XI_HTTP_HEADER_ETAG,
+    /** `Last-Modified` */
+    XI_HTTP_HEADER_LAST_MODIFIED,
+    /** `Retry-After` */
+    XI_HTTP_HEADER_RETRY_AFTER,
     // must go before the last here
     XI_HTTP_HEADER_UNKNOWN,
     // must be the last here
@@ -105,9 +139,10 @@ typedef struct {
     int             http_version2;
     int             http_status;
     char            http_status_string[ XI_HTTP_STATUS_STRING_SIZE ];
-    http_header_t*  http_headers_checklist[ XI_HTTP_HEADERS_COUNT ];
-    http_header_t   http_headers[ XI_HTTP_MAX_HEADERS ];
-    size_t          http_headers_size;
+    http_header_t*  http_headers_checklist[ XI_HTTP_HEADERS_COUNT ]; //!< not filled in replies to `xi_*` calls, see `xi_response_header()`
+    http_header_t   http_headers[ XI_HTTP_MAX_HEADERS ]; //!< in replies to `xi_*` calls it holds the header lines as received, see `xi_response_header()`
+    size_t          http_headers_size; //!< 0 in replies to `xi_*` calls
+    size_t          http_headers_raw_size; //!< size of the header lines kept in `http_headers`, 0 once they are parsed
     char            http_content[ XI_HTTP_MAX_CONTENT_SIZE ];
 } http_response_t;
 
@@ -117,6 +152,7 @@ typedef struct {
  */
 typedef struct {
     http_response_t http;
+    uint32_t        request_id; //!< id of the request this is a reply to, `0` over HTTP
 } xi_response_t;
 
 /**
@@ -166,6 +202,69 @@ typedef struct {
     xi_datastream_t   datastreams[ XI_MAX_DATASTREAMS ];
 } xi_feed_t;
 
+/**
+ * \brief   Counters of conditional requests made by `xi_feed_get()` and `xi_datastream_get()`
+ */
+typedef struct {
+    uint32_t          hits;   //!< replies that were `304 Not Modified` and were served from the cache
+    uint32_t          misses; //!< successful replies that had to be decoded
+} xi_cache_stats_t;
+
+#define XI_STATIC_STR_EXPAND(tok) #tok
+#define XI_STATIC_STR(tok) XI_STATIC_STR_EXPAND(tok)
+
+/**
+ * \brief   Request line of a datastream update, put together by the preprocessor
+ *
+ * \note    `feed_id` has to be an integer literal and `datastream_id` a string literal.
+ */
+#define XI_STATIC_DATASTREAM_UPDATE_LINE( feed_id, datastream_id ) \
+    "PUT /v2/feeds/" XI_STATIC_STR( feed_id ) "/datastreams/" datastream_id ".csv HTTP/1.1\r\n"
+
+/**
+ * \brief   Initialiser of `xi_static_request_t` for a datastream known at compile time, e.g.
+ *
+ *     static const xi_static_request_t temp = XI_STATIC_DATASTREAM_UPDATE( 504, "temp" );
+ */
+#define XI_STATIC_DATASTREAM_UPDATE( feed_id, datastream_id ) \
+    { XI_STATIC_DATASTREAM_UPDATE_LINE( feed_id, datastream_id ) \
+    , sizeof( XI_STATIC_DATASTREAM_UPDATE_LINE( feed_id, datastream_id ) ) - 1 \
+    , feed_id, datastream_id }
+
+/**
+ * \brief   _Datastream update with fixed feed and datastream_ - see `xi_datastream_update_static()`
+ */
+typedef struct {
+    const char*       request_line;
+    size_t            request_line_size;
+    int32_t           feed_id;
+    const char*       datastream_id;
+} xi_static_request_t;
+
+/**
+ * \brief   Receives datapoints one by one from `xi_datastream_get_history()`
+ *
+ * \return  0 to carry on or any other value to stop the query.
+ */
+typedef int ( *xi_datapoint_callback_t )( const xi_datapoint_t* dp, void* user_data );
+
+/**
+ * \brief   Receives a feed from `xi_feed_get_each()` as it is being decoded
+ *
+ *    `on_datastream` is called when the next datastream begins and `on_datapoint`
+ *    for each of its datapoints, either may be null. What they are given is only
+ *    valid during the call. Both return 0 to carry on or any other value to stop.
+ */
+typedef struct {
+    int ( *on_datastream )( const char* datastream_id, void* user_data );
+    int ( *on_datapoint )( const char* datastream_id, const xi_datapoint_t* dp, void* user_data );
+} xi_feed_visitor_t;
+
+/**
+ * \brief   Receives the reply to `index`-th request of `xi_feeds_update()`
+ */
+typedef void ( *xi_response_callback_t )( size_t index, const xi_response_t* response, void* user_data );
+
 //-----------------------------------------------------------------------
 // HELPER FUNCTIONS
 //-----------------------------------------------------------------------
@@ -209,6 +308,115 @@ extern void xi_set_network_timeout( uint32_t milliseconds );
  */
 extern uint32_t xi_get_network_timeout( void );
 
+/**
+ * \brief   Enables or disables compressed responses
+ *
+ * \note    When enabled, requests carry `Accept-Encoding: gzip, deflate`
+ *          header and compressed bodies are inflated by the _transport layer_
+ *          before they reach the _data layer_. It has no effect unless the
+ *          library had been built with `XI_ZLIB=1`.
+ *
+ * \note    The compressed body is read and inflated a buffer at a time straight
+ *          into `http_content`, the content the _data layer_ decodes. Content that
+ *          doesn't fit in `XI_HTTP_MAX_CONTENT_SIZE` once inflated is an error
+ *          (`XI_HTTP_CONTENT_TOO_LARGE`), while uncompressed content is cut off.
+ */
+extern void xi_set_response_compression( uint8_t enabled );
+
+/**
+ * \brief   Gets the current response compression setting
+ */
+extern uint8_t xi_get_response_compression( void );
+
+/**
+ * \brief   Sets the size threshold for compressed request bodies
+ *
+ * \note    Request bodies of at least `threshold` bytes are sent with
+ *          `Content-Encoding: gzip`, smaller ones stay uncompressed as
+ *          the gzip framing would outweigh the savings. Zero (the default)
+ *          disables compression. It has no effect unless the library had
+ *          been built with `XI_ZLIB=1`.
+ * \note    `Content-Length` has to be known before the body is sent, so a
+ *          compressed body is deflated twice, once to measure it and once more
+ *          on its way out, and is never held whole in memory. That goes for
+ *          feed updates too big for `XI_CONTENT_BUFFER_SIZE` as well.
+ */
+extern void xi_set_request_compression( uint32_t threshold );
+
+/**
+ * \brief   Gets the current size threshold for compressed request bodies
+ */
+extern uint32_t xi_get_request_compression( void );
+
+/**
+ * \brief   Sets the quality of service for `XI_MQTT` publishes
+ *
+ * \note    With QoS 0 (the default) updates return as soon as they are
+ *          sent, with a response carrying status 202 as nothing comes back.
+ *          With QoS 1 updates wait for the broker's `PUBACK` and return
+ *          status 200. Higher levels are treated as 1.
+ */
+extern void xi_set_mqtt_qos( uint8_t qos );
+
+/**
+ * \brief   Gets the current quality of service for `XI_MQTT` publishes
+ */
+extern uint8_t xi_get_mqtt_qos( void );
+
+/**
+ * \brief   Sets how many requests per minute may be sent with one API key
+ *
+ *   Requests over the limit are held back until the key is allowed to send
+ *   again, `burst` of them may go at once after a quiet period. With 0 (the
+ *   default) requests aren't paced.
+ *
+ * \note    Regardless of the limit, once the server answers 429 or 503 the
+ *          key sends nothing until `Retry-After` has passed (or a second if
+ *          it didn't say). Requests that would have to wait longer than
+ *          `xi_set_rate_limit_max_wait()` fail with `XI_RATE_LIMITED`
+ *          without being sent.
+ */
+extern void xi_set_rate_limit( uint32_t requests_per_minute, uint32_t burst );
+
+/**
+ * \brief   Gets the current number of requests per minute allowed per API key
+ */
+extern uint32_t xi_get_rate_limit( void );
+
+/**
+ * \brief   Sets the longest a request may be held back by the rate limit in milliseconds
+ */
+extern void xi_set_rate_limit_max_wait( uint32_t max_wait );
+
+/**
+ * \brief   Gets the longest a request may be held back by the rate limit
+ */
+extern uint32_t xi_get_rate_limit_max_wait( void );
+
+/**
+ * \brief   Sets when requests stop being sent to an endpoint that is down
+ *
+ *   After `threshold` failures in a row (no connection, no reply or 502, 503
+ *   or 504 from a gateway) requests to the same host and port fail right away
+ *   with `XI_CIRCUIT_OPEN` instead of waiting for the network timeout. Once
+ *   `cooldown` milliseconds have passed the next request is let through as a
+ *   probe, if it gets an answer requests flow again, if it doesn't the endpoint
+ *   is cut off for another `cooldown`. With 0 (the default) it is never cut off.
+ *
+ * \note    The breaker needs `get_time_ms()` of the _communication layer_.
+ */
+extern void xi_set_circuit_breaker( uint32_t threshold, uint32_t cooldown );
+
+/**
+ * \brief   Gets the number of failures in a row that cut an endpoint off
+ */
+extern uint32_t xi_get_circuit_breaker_threshold( void );
+
+/**
+ * \brief   Gets how long an endpoint stays cut off in milliseconds
+ */
+extern uint32_t xi_get_circuit_breaker_cooldown( void );
+
 //-----------------------------------------------------------------------
 // MAIN LIBRARY FUNCTIONS
 //-----------------------------------------------------------------------
@@ -233,6 +441,58 @@ extern xi_context_t* xi_create_context(
  */
 extern void xi_delete_context( xi_context_t* context );
 
+/**
+ * \brief   Gets the counters of conditional requests made with the context
+ *
+ *   Validators (`ETag` and `Last-Modified`) of the feed and of the last
+ *   `XI_CACHED_DATASTREAMS` datastreams fetched are remembered and sent back
+ *   with the next request for the same resource. When the server answers
+ *   `304 Not Modified` the value decoded last time is returned instead.
+ *
+ * \note    Only `XI_HTTP` sends validators, with the other protocols every
+ *          successful fetch is a miss.
+ */
+extern xi_cache_stats_t xi_get_cache_stats( const xi_context_t* context );
+
+/**
+ * \brief   Sets how requests made with the context are retried
+ *
+ *   When a request fails on the way (the connection can't be made, breaks or
+ *   times out) or the server answers 408, 429, 502, 503 or 504 the request is
+ *   sent again, up to `max_attempts` times in total. Waits between attempts are
+ *   random, between `base_delay` and three times the previous wait but no more
+ *   than `max_delay`, so clients that failed together don't all come back at
+ *   once. No attempt is made that would end the wait after `deadline`.
+ *
+ * \note    Only the requests that can safely be repeated are retried: gets,
+ *          updates and deletes. `xi_datastream_create()` is sent once, as are
+ *          `xi_feeds_update()` and `xi_datastream_get_history()`, which may have
+ *          delivered part of their work when something fails. The default
+ *          policy doesn't retry anything.
+ */
+extern void xi_set_retry_policy( xi_context_t* context, const xi_retry_policy_t* policy );
+
+/**
+ * \brief   Gets the counters of retries made with the context
+ */
+extern xi_retry_stats_t xi_get_retry_stats( const xi_context_t* context );
+
+/**
+ * \brief   Gets the value of a header of the reply
+ *
+ *   Headers of HTTP replies are not parsed up front, they are looked up
+ *   when asked for, so `http_headers` and `http_headers_checklist` of the
+ *   response are left empty. The value is copied to the given buffer and
+ *   truncated to `buffer_size - 1` characters.
+ *
+ * \return  The buffer, or `0` if there is no such header.
+ */
+extern const char* xi_response_header(
+          const xi_response_t* response
+        , http_header_type_t type
+        , char* buffer
+        , size_t buffer_size );
+
 
 /**
  * \brief   Update Xively feed
@@ -241,13 +501,46 @@ extern const xi_response_t* xi_feed_update(
           xi_context_t* xi
         , const xi_feed_t* value );
 
+/**
+ * \brief   Update many feeds over one connection
+ *
+ *   Up to `XI_PIPELINE_WINDOW` updates are sent ahead of their replies, each reply
+ *   is passed to the callback (if there is one) along with the index of its feed,
+ *   over the socket API they may come in any order.
+ *
+ * \return  Response to the last reply received or null if an error occurred,
+ *          the feeds that haven't been replied to by then should be updated again.
+ */
+extern const xi_response_t* xi_feeds_update(
+          xi_context_t* xi
+        , const xi_feed_t* feeds, size_t feeds_count
+        , xi_response_callback_t callback, void* user_data );
+
 /**
  * \brief   Retrieve Xively feed
+ *
+ *    A datastream that comes with several datapoints, e.g. when the feed is
+ *    requested with a time range, gets them all, up to `XI_MAX_DATAPOINTS`.
  */
 extern const xi_response_t* xi_feed_get(
           xi_context_t* xi
         , xi_feed_t* value );
 
+/**
+ * \brief   Retrieve Xively feed and hand it to `visitor` while it is being decoded
+ *
+ *    The `feed` tells which feed and datastreams to get, as it does for `xi_feed_get()`,
+ *    but nothing is written to it, so a single value can be read without the room
+ *    for a whole feed. The request isn't conditional, there's nothing kept to reuse.
+ *
+ * \return  Response or null if an error occurred, as for `xi_feed_get()` the error
+ *          is set if the feed couldn't be decoded. Stopping the visitor isn't an error.
+ */
+extern const xi_response_t* xi_feed_get_each(
+          xi_context_t* xi
+        , const xi_feed_t* feed
+        , const xi_feed_visitor_t* visitor, void* user_data );
+
 /**
  * \brief   Create a datastream with given value using server timestamp
  */
@@ -264,6 +557,22 @@ extern const xi_response_t* xi_datastream_update(
         , const char * datastream_id
         , const xi_datapoint_t* value );
 
+/**
+ * \brief   Same as `xi_datastream_update()` for a datastream fixed at compile time
+ *
+ *   Over HTTP the request line comes ready made from `XI_STATIC_DATASTREAM_UPDATE()`
+ *   and the headers are constant, so encoding costs about as much as formatting
+ *   the value. Other protocols encode it the usual way.
+ *
+ * \note    The request is the same as the one of `xi_datastream_update()`, if
+ *          the body is to be compressed (see `xi_set_request_compression()`)
+ *          it's put together the usual way.
+ */
+extern const xi_response_t* xi_datastream_update_static(
+          xi_context_t* xi
+        , const xi_static_request_t* request
+        , const xi_datapoint_t* value );
+
 /**
  * \brief   Retrieve latest datapoint from a given datastream
  */
@@ -288,7 +597,7 @@ extern const xi_response_t* xi_datastream_delete(
  *          `xi_datapoint_delete_range()` with short range instead.
  */
 extern const xi_response_t* xi_datapoint_delete(
-          const xi_context_t* xi, int feed_id
+          xi_context_t* xi, int feed_id
         , const char * datastream_id
         , const xi_datapoint_t* dp );
 
@@ -297,9 +606,27 @@ extern const xi_response_t* xi_datapoint_delete(
  * \warning This function destroys the data in Xively and there is no way to restore it!
  */
 extern const xi_response_t* xi_datapoint_delete_range(
-          const xi_context_t* xi, int feed_id, const char * datastream_id
+          xi_context_t* xi, int feed_id, const char * datastream_id
         , const xi_timestamp_t* start, const xi_timestamp_t* end );
 
+/**
+ * \brief   Retrieve datapoints from `start` till `end` (or till the latest one if `end`
+ *          is null), aggregated over `interval` seconds unless it's 0
+ *
+ *    The range is fetched in pages of `XI_HISTORY_PAGE_SIZE` datapoints, each page is
+ *    decoded line by line and given to `callback` while the next one is already being
+ *    requested, so the memory used doesn't depend on the size of the range.
+ *
+ * \return  Response to the last page requested, or to the last one given to `callback`
+ *          if it stopped while the next was on its way, null if an error occurred.
+ */
+extern const xi_response_t* xi_datastream_get_history(
+          xi_context_t* xi, int32_t feed_id
+        , const char * datastream_id
+        , const xi_timestamp_t* start, const xi_timestamp_t* end
+        , uint32_t interval
+        , xi_datapoint_callback_t callback, void* user_data );
+
 #ifdef __cplusplus
 }
 #endif
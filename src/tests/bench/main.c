@@ -0,0 +1,1191 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    main.c
+ * \brief   Benchmarks of the library hot paths
+ *
+ *    Each benchmark prints one line per variant with time per operation,
+ *    throughput and, where it matters, the number of bytes on the wire.
+ *    Run without arguments to execute all benchmarks or give name prefixes
+ *    to select some of them, e.g. `libxively_benchmark_suite response/`.
+ */
+
+#include "xively.h"
+#include "xi_err.h"
+#include "xi_helpers.h"
+#include "xi_macros.h"
+#include "socket_api.h"
+#include "xi_globals.h"
+#include "csv_data.h"
+#include "http_transport_layer.h"
+#include "http_layer_parser.h"
+#include "csv_data_layer.h"
+#include "json_data_layer.h"
+#include "cbor_data_layer.h"
+#include "http_transport.h"
+#include "tcp_transport.h"
+#include "mqtt_transport.h"
+#include "mqtt_layer_packets.h"
+#include "comm_layer.h"
+#include "mock_server.h"
+
+#ifdef XI_ZLIB
+#include <zlib.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// HARNESS
+///////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+    const char* name;
+    void ( *fn )( const char* name );
+} benchmark_t;
+
+static double bench_now( void )
+{
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// keeps the optimiser from throwing away the results
+static volatile size_t bench_sink;
+
+static void bench_report(
+      const char* name, const char* variant
+    , size_t ops, double seconds
+    , size_t bytes_per_op, size_t wire_bytes_per_op )
+{
+    printf( "%-28s %-16s %10.1f ns/op %10.0f op/s %9.1f MB/s"
+        , name, variant
+        , seconds * 1e9 / ops
+        , ops / seconds
+        , bytes_per_op * ( double ) ops / seconds / 1e6 );
+
+    if( wire_bytes_per_op )
+    {
+        printf( " %7lu B on wire", ( unsigned long ) wire_bytes_per_op );
+    }
+
+    printf( "\n" );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// RESPONSE DECODING
+///////////////////////////////////////////////////////////////////////////////
+
+#define RESPONSE_ITERATIONS 200000
+
+static const char RESPONSE_HEADERS[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Date: Sun, 14 Apr 2013 20:20:01 GMT\r\n"
+    "Content-Type: text/plain; charset=utf-8\r\n"
+    "Connection: keep-alive\r\n"
+    "X-Request-Id: 9de9ac7071bdbf105804ce0eaf7979adc77f6e25\r\n"
+    "Cache-Control: max-age=0\r\n"
+    "Vary: Accept-Encoding\r\n";
+
+// renders a typical feed body, the last line has no terminating newline
+static size_t bench_feed_body( char* buffer, size_t buffer_size, size_t lines )
+{
+    size_t offset = 0;
+
+    for( size_t i = 0; i < lines; ++i )
+    {
+        offset += snprintf( buffer + offset, buffer_size - offset
+            , "%ssensor%02lu,2013-04-14T20:%02lu:01.%06luZ,%d.%d"
+            , i == 0 ? "" : "\n"
+            , ( unsigned long ) i, ( unsigned long ) i
+            , ( unsigned long ) i * 1013, ( int ) ( 20 + i ), ( int ) i );
+    }
+
+    return offset;
+}
+
+static void bench_response_decode_one(
+      const char* name, const char* variant
+    , const char* response, size_t response_size, size_t content_size )
+{
+    const data_layer_t* data_layer = get_csv_data_layer();
+    xi_feed_t feed;
+
+    double start = bench_now();
+
+    for( size_t i = 0; i < RESPONSE_ITERATIONS; ++i )
+    {
+        const xi_response_t* r = http_decode_reply( data_layer, response, response_size );
+
+        if( r == 0 || data_layer->decode_feed( r->http.http_content, &feed ) == 0 )
+        {
+            printf( "%s: decoding failed (%s)\n", name
+                , xi_get_error_string( xi_get_last_error() ) );
+            return;
+        }
+
+        bench_sink += feed.datastream_count;
+    }
+
+    bench_report( name, variant, RESPONSE_ITERATIONS, bench_now() - start
+        , content_size, response_size );
+}
+
+static void bench_response_decode( const char* name )
+{
+    char body[ 1024 ];
+    char response[ 2048 ];
+
+    size_t body_size = bench_feed_body( body, sizeof( body ), XI_MAX_DATASTREAMS - 1 );
+
+    // identity
+    {
+        size_t s = snprintf( response, sizeof( response ), "%sContent-Length: %lu\r\n\r\n%s"
+            , RESPONSE_HEADERS, ( unsigned long ) body_size, body );
+
+        bench_response_decode_one( name, "identity", response, s, body_size );
+    }
+
+#ifdef XI_ZLIB
+    // gzip, compressed the way a server would do it
+    {
+        unsigned char compressed[ 1024 ];
+
+        z_stream strm;
+        memset( &strm, 0, sizeof( z_stream ) );
+        deflateInit2( &strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY );
+        strm.next_in    = ( Bytef* ) body;
+        strm.avail_in   = body_size;
+        strm.next_out   = compressed;
+        strm.avail_out  = sizeof( compressed );
+        deflate( &strm, Z_FINISH );
+        deflateEnd( &strm );
+
+        size_t s = snprintf( response, sizeof( response )
+            , "%sContent-Encoding: gzip\r\nContent-Length: %lu\r\n\r\n"
+            , RESPONSE_HEADERS, ( unsigned long ) strm.total_out );
+
+        memcpy( response + s, compressed, strm.total_out );
+
+        bench_response_decode_one( name, "gzip", response, s + strm.total_out, body_size );
+    }
+#else
+    printf( "%-28s %-16s skipped, build with XI_ZLIB=1\n", name, "gzip" );
+#endif
+}
+
+static void bench_response_parse_one(
+      const char* name, const char* variant
+    , http_response_t* ( *parse )( http_response_t*, const char*, size_t )
+    , int lookup
+    , const char* response, size_t response_size )
+{
+    static http_response_t parsed;
+
+    double start = bench_now();
+
+    for( size_t i = 0; i < RESPONSE_ITERATIONS; ++i )
+    {
+        if( parse( &parsed, response, response_size ) == 0 )
+        {
+            printf( "%s: parsing failed (%s)\n", name
+                , xi_get_error_string( xi_get_last_error() ) );
+            return;
+        }
+
+        bench_sink += parsed.http_status;
+
+        if( lookup )
+        {
+            char value[ XI_HTTP_HEADER_VALUE_MAX_SIZE ];
+
+            bench_sink += http_response_header( &parsed, XI_HTTP_HEADER_X_REQUEST_ID
+                , value, sizeof( value ) ) != 0;
+        }
+    }
+
+    bench_report( name, variant, RESPONSE_ITERATIONS, bench_now() - start
+        , response_size, response_size );
+}
+
+// headers only, the content is the same for both parsers
+static void bench_response_parse( const char* name )
+{
+    char response[ 1024 ];
+
+    size_t s = snprintf( response, sizeof( response ), "%sContent-Length: 2\r\n\r\n42"
+        , RESPONSE_HEADERS );
+
+    bench_response_parse_one( name, "eager", &parse_http_sized, 0, response, s );
+    bench_response_parse_one( name, "lazy", &parse_http_lazy, 0, response, s );
+    bench_response_parse_one( name, "lazy/lookup=1", &parse_http_lazy, 1, response, s );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// VALUE DECODING
+///////////////////////////////////////////////////////////////////////////////
+
+extern xi_datapoint_t* csv_decode_value(
+    const char* buffer, xi_datapoint_t* p );
+
+#define VALUE_COUNT         4096
+#define VALUE_ITERATIONS    2000000
+
+// values as they come in feeds, `kind` picks ints (0), floats (1), strings (2) or a mix of them (3)
+static size_t bench_values( char values[][ 16 ], size_t count, int kind )
+{
+    size_t bytes = 0;
+
+    for( size_t i = 0; i < count; ++i )
+    {
+        switch( kind == 3 ? i % 3 : ( size_t ) kind )
+        {
+            case 0:
+                snprintf( values[ i ], 16, "%ld", ( long ) ( i * 7919 ) - 16000000 );
+                break;
+            case 1:
+                snprintf( values[ i ], 16, "%ld.%03lu", ( long ) ( i % 200 ) - 100, ( unsigned long ) i % 1000 );
+                break;
+            default:
+                snprintf( values[ i ], 16, "%s%lu", i & 1 ? "on-" : "off ", ( unsigned long ) i );
+                break;
+        }
+
+        bytes += strlen( values[ i ] );
+    }
+
+    return bytes;
+}
+
+static void bench_value_decode_one( const char* name, const char* variant, int kind )
+{
+    static char values[ VALUE_COUNT ][ 16 ];
+    xi_datapoint_t dp;
+
+    size_t bytes = bench_values( values, VALUE_COUNT, kind );
+
+    double start = bench_now();
+
+    for( size_t i = 0; i < VALUE_ITERATIONS; ++i )
+    {
+        if( csv_decode_value( values[ i % VALUE_COUNT ], &dp ) == 0 )
+        {
+            printf( "%s: decoding failed (%s)\n", name
+                , xi_get_error_string( xi_get_last_error() ) );
+            return;
+        }
+
+        bench_sink += dp.value_type + ( size_t ) dp.value.i32_value;
+    }
+
+    bench_report( name, variant, VALUE_ITERATIONS, bench_now() - start
+        , bytes / VALUE_COUNT, 0 );
+}
+
+static void bench_value_decode( const char* name )
+{
+    bench_value_decode_one( name, "int", 0 );
+    bench_value_decode_one( name, "float", 1 );
+    bench_value_decode_one( name, "string", 2 );
+    bench_value_decode_one( name, "mixed", 3 );
+}
+
+// the biggest feed there's room for, without the HTTP around it
+static int bench_visit_datapoint( const char* datastream_id, const xi_datapoint_t* dp, void* user_data )
+{
+    XI_UNUSED( datastream_id );
+    XI_UNUSED( user_data );
+
+    bench_sink += dp->value.i32_value;
+
+    return 0;
+}
+
+static void bench_feed_decode( const char* name )
+{
+    char body[ XI_HTTP_MAX_CONTENT_SIZE * 2 ];
+    char variant[ 16 ];
+    xi_feed_t feed;
+
+    size_t body_size = bench_feed_body( body, sizeof( body ), XI_MAX_DATASTREAMS - 1 );
+
+    double start = bench_now();
+
+    for( size_t i = 0; i < RESPONSE_ITERATIONS; ++i )
+    {
+        if( csv_decode_feed( body, &feed ) == 0 )
+        {
+            printf( "%s: decoding failed (%s)\n", name
+                , xi_get_error_string( xi_get_last_error() ) );
+            return;
+        }
+
+        bench_sink += feed.datastream_count;
+    }
+
+    snprintf( variant, sizeof( variant ), "lines=%d", XI_MAX_DATASTREAMS - 1 );
+
+    bench_report( name, variant, RESPONSE_ITERATIONS, bench_now() - start, body_size, 0 );
+
+    // handing the datapoints over instead of filling the feed
+    {
+        const xi_feed_visitor_t visitor = { 0, bench_visit_datapoint };
+
+        start = bench_now();
+
+        for( size_t i = 0; i < RESPONSE_ITERATIONS; ++i )
+        {
+            if( csv_visit_feed( body, &visitor, 0 ) != 0 )
+            {
+                printf( "%s: visiting failed\n", name );
+                return;
+            }
+        }
+
+        bench_report( name, "visit", RESPONSE_ITERATIONS, bench_now() - start, body_size, 0 );
+    }
+
+    // finding the delimiters alone
+    {
+        uint32_t index[ XI_CSV_SCAN_INDEX_SIZE ];
+        size_t scanned = 0;
+
+        start = bench_now();
+
+        for( size_t i = 0; i < RESPONSE_ITERATIONS; ++i )
+        {
+            for( size_t offset = 0; offset < body_size; offset += scanned )
+            {
+                bench_sink += csv_scan_delimiters( body + offset, body_size - offset
+                    , index, XI_CSV_SCAN_INDEX_SIZE, &scanned );
+            }
+        }
+
+        bench_report( name, "scan", RESPONSE_ITERATIONS, bench_now() - start, body_size, 0 );
+    }
+}
+
+#define HISTORY_DATAPOINTS 10000
+#define HISTORY_ITERATIONS 20
+
+// datapoints of a history download, one operation is one datapoint
+static void bench_timestamp_decode( const char* name )
+{
+    static char lines[ HISTORY_DATAPOINTS ][ 40 ];
+    xi_datapoint_t datapoint;
+
+    for( size_t i = 0; i < HISTORY_DATAPOINTS; ++i )
+    {
+        time_t stamp = 1365970801 + ( time_t ) i * 37;
+
+        int s = xi_timestamp_to_str( lines[ i ], sizeof( lines[ i ] ), stamp
+            , ( time_t ) ( i * 7919 % 1000000 ) );
+        snprintf( lines[ i ] + s, sizeof( lines[ i ] ) - s, ",%d", ( int ) ( i & 1023 ) );
+    }
+
+    for( int variant = 0; variant < 3; ++variant )
+    {
+        static const char* const variants[] = { "sscanf+mktime", "parser", "datapoint" };
+
+        double start = bench_now();
+
+        for( size_t n = 0; n < HISTORY_ITERATIONS; ++n )
+        {
+            for( size_t i = 0; i < HISTORY_DATAPOINTS; ++i )
+            {
+                time_t stamp = 0;
+                time_t micro = 0;
+
+                switch( variant )
+                {
+                    case 0:
+                    {
+                        struct tm t;
+                        int ms = 0;
+
+                        memset( &t, 0, sizeof( t ) );
+                        sscanf( lines[ i ], "%04d-%02d-%02dT%02d:%02d:%02d.%06dZ"
+                            , &t.tm_year, &t.tm_mon, &t.tm_mday, &t.tm_hour, &t.tm_min, &t.tm_sec, &ms );
+                        t.tm_year -= 1900;
+                        t.tm_mon  -= 1;
+
+                        stamp = xi_mktime( &t );
+                        micro = ms;
+                        break;
+                    }
+                    case 1:
+                        xi_str_to_timestamp( lines[ i ], &stamp, &micro );
+                        break;
+                    default:
+                        if( csv_decode_datapoint( lines[ i ], &datapoint ) == 0 )
+                        {
+                            printf( "%s: decoding failed (%s)\n", name
+                                , xi_get_error_string( xi_get_last_error() ) );
+                            return;
+                        }
+
+                        stamp = datapoint.timestamp.timestamp;
+                        micro = datapoint.timestamp.micro;
+                        break;
+                }
+
+                bench_sink += stamp + micro;
+            }
+        }
+
+        bench_report( name, variants[ variant ], HISTORY_DATAPOINTS * HISTORY_ITERATIONS
+            , bench_now() - start, strlen( lines[ 0 ] ), 0 );
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// REQUEST ENCODING
+///////////////////////////////////////////////////////////////////////////////
+
+#define ENCODE_ITERATIONS 500000
+
+static const xi_static_request_t bench_static_request = XI_STATIC_DATASTREAM_UPDATE( 504, "temperature" );
+
+// the value alone is the lower bound of what the encoders can do
+static void bench_encode_update_values( const char* name, int integers )
+{
+    const data_layer_t* data_layer = get_csv_data_layer();
+    xi_datapoint_t datapoint;
+
+    memset( &datapoint, 0, sizeof( datapoint ) );
+    datapoint.timestamp.timestamp = 1365970801;
+
+    for( int variant = 0; variant < 3; ++variant )
+    {
+        static const char* const variants[] = { "value", "dynamic", "static" };
+        size_t size = 0;
+
+        double start = bench_now();
+
+        for( size_t i = 0; i < ENCODE_ITERATIONS; ++i )
+        {
+            const char* data = 0;
+
+            if( integers )
+            {
+                xi_set_value_i32( &datapoint, ( int32_t ) ( ( uint32_t ) ( i * 2654435761u ) >> ( i & 31 ) ) );
+            }
+            else
+            {
+                xi_set_value_f32( &datapoint, 20.0f + ( float ) ( i & 63 ) / 8 );
+            }
+
+            switch( variant )
+            {
+                case 0:
+                    data = data_layer->encode_datapoint( &datapoint );
+                    break;
+                case 1:
+                    data = http_encode_update_datastream( data_layer, "apikey"
+                        , bench_static_request.feed_id, bench_static_request.datastream_id, &datapoint );
+                    break;
+                default:
+                    data = http_encode_update_datastream_static( data_layer, "apikey"
+                        , &bench_static_request, &datapoint );
+                    break;
+            }
+
+            if( data == 0 )
+            {
+                printf( "%s: encoding failed (%s)\n", name
+                    , xi_get_error_string( xi_get_last_error() ) );
+                return;
+            }
+
+            bench_sink += data[ 0 ];
+        }
+
+        size = variant == 0 ? 0 : http_get_encoded_size();
+
+        bench_report( name, variants[ variant ], ENCODE_ITERATIONS, bench_now() - start, size, size );
+    }
+}
+
+static void bench_encode_update( const char* name )
+{
+    bench_encode_update_values( name, 0 );
+}
+
+// counters and readings of every magnitude, so each digit count is taken
+static void bench_encode_update_int( const char* name )
+{
+    bench_encode_update_values( name, 1 );
+}
+
+#define FLOAT_COUNT 4096
+
+// what sensors send: temperatures to a tenth, humidity, pressure, battery voltage and small currents
+static void bench_sensor_values( float* values, size_t count )
+{
+    uint32_t state = 2463534242u;
+
+    for( size_t i = 0; i < count; ++i )
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+
+        uint32_t r = state % 1000;
+
+        switch( i % 5 )
+        {
+            case 0: values[ i ] = -10.0f + ( float ) r / 10;        break;
+            case 1: values[ i ] = ( float ) ( r % 100 ) + 0.5f;     break;
+            case 2: values[ i ] = 980.0f + ( float ) r / 20;        break;
+            case 3: values[ i ] = 3.0f + ( float ) r / 1000;        break;
+            default: values[ i ] = ( float ) r / 100000;            break;
+        }
+    }
+}
+
+// the value alone, with what it was formatted with before and now
+static void bench_encode_float( const char* name )
+{
+    static float values[ FLOAT_COUNT ];
+    char buffer[ 64 ];
+
+    bench_sensor_values( values, FLOAT_COUNT );
+
+    for( int variant = 0; variant < 2; ++variant )
+    {
+        static const char* const variants[] = { "snprintf(%f)", "shortest" };
+        size_t bytes = 0;
+
+        double start = bench_now();
+
+        for( size_t i = 0; i < ENCODE_ITERATIONS; ++i )
+        {
+            float value = values[ i % FLOAT_COUNT ];
+
+            int s = variant == 0
+                ? snprintf( buffer, sizeof( buffer ), "%f", value )
+                : xi_float_to_str( buffer, sizeof( buffer ), value );
+
+            bytes += s;
+            bench_sink += buffer[ 0 ];
+        }
+
+        bench_report( name, variants[ variant ], ENCODE_ITERATIONS, bench_now() - start
+            , bytes / ENCODE_ITERATIONS, bytes / ENCODE_ITERATIONS );
+    }
+}
+
+#define FEED_DATAPOINTS 10000
+#define FEED_ITERATIONS 50
+
+// a batch of readings taken every second, one operation is one datapoint
+static void bench_encode_feed_timestamps( const char* name )
+{
+    static char body[ FEED_DATAPOINTS * 48 ];
+    const data_layer_t* data_layer = get_csv_data_layer();
+    xi_datapoint_t datapoint;
+
+    memset( &datapoint, 0, sizeof( datapoint ) );
+
+    for( int variant = 0; variant < 3; ++variant )
+    {
+        static const char* const variants[] = { "gmtime+snprintf", "cached", "csv body" };
+        size_t offset = 0;
+
+        double start = bench_now();
+
+        for( size_t n = 0; n < FEED_ITERATIONS; ++n )
+        {
+            offset = 0;
+
+            for( size_t i = 0; i < FEED_DATAPOINTS; ++i )
+            {
+                time_t stamp    = 1365970801 + ( time_t ) i;
+                time_t micro    = ( time_t ) ( i * 7919 % 1000000 );
+                int s           = 0;
+
+                switch( variant )
+                {
+                    case 0:
+                    {
+                        struct tm* ptm = xi_gmtime( &stamp );
+
+                        s = snprintf( body + offset, sizeof( body ) - offset
+                            , "%04d-%02d-%02dT%02d:%02d:%02d.%06ldZ\n"
+                            , ptm->tm_year + 1900, ptm->tm_mon + 1, ptm->tm_mday
+                            , ptm->tm_hour, ptm->tm_min, ptm->tm_sec, ( long ) micro );
+                        break;
+                    }
+                    case 1:
+                        s = xi_timestamp_to_str( body + offset, sizeof( body ) - offset, stamp, micro );
+                        body[ offset + s++ ] = '\n';
+                        break;
+                    default:
+                        datapoint.timestamp.timestamp   = stamp;
+                        datapoint.timestamp.micro       = micro;
+                        xi_set_value_i32( &datapoint, ( int32_t ) ( i & 1023 ) );
+
+                        s = data_layer->encode_datapoint_in_place(
+                            body + offset, sizeof( body ) - offset, &datapoint );
+                        break;
+                }
+
+                if( s < 0 )
+                {
+                    printf( "%s: encoding failed\n", name );
+                    return;
+                }
+
+                offset += s;
+            }
+
+            bench_sink += body[ offset - 2 ];
+        }
+
+        bench_report( name, variants[ variant ], FEED_DATAPOINTS * FEED_ITERATIONS
+            , bench_now() - start, offset / FEED_DATAPOINTS, 0 );
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// DATA FORMATS
+///////////////////////////////////////////////////////////////////////////////
+
+#define FORMAT_ITERATIONS 100000
+
+// the same feed as `bench_feed_body` gives, in the JSON the API sends back
+static size_t bench_json_feed_body( char* buffer, size_t buffer_size, size_t lines )
+{
+    size_t offset = snprintf( buffer, buffer_size, "{\"id\":504,\"version\":\"1.0.0\",\"datastreams\":[" );
+
+    for( size_t i = 0; i < lines; ++i )
+    {
+        offset += snprintf( buffer + offset, buffer_size - offset
+            , "%s{\"id\":\"sensor%02lu\",\"current_value\":\"%d.%d\",\"at\":\"2013-04-14T20:%02lu:01.%06luZ\"}"
+            , i == 0 ? "" : ","
+            , ( unsigned long ) i, ( int ) ( 20 + i ), ( int ) i
+            , ( unsigned long ) i, ( unsigned long ) i * 1013 );
+    }
+
+    offset += snprintf( buffer + offset, buffer_size - offset, "]}" );
+
+    return offset;
+}
+
+// the same feed again, as the gateway would send it to the relay
+static size_t bench_cbor_feed_body( char* buffer, size_t buffer_size, size_t lines )
+{
+    static xi_feed_t feed;
+    char csv[ 4096 ];
+
+    bench_feed_body( csv, sizeof( csv ), lines );
+
+    if( csv_decode_feed( csv, &feed ) == 0 ) { return 0; }
+
+    int s = cbor_encode_feed( buffer, buffer_size, &feed );
+
+    return s < 0 ? 0 : s;
+}
+
+typedef struct
+{
+    const char*             name;
+    const data_layer_t*     ( *get_data_layer )( void );
+    size_t                  ( *feed_body )( char* buffer, size_t buffer_size, size_t lines );
+} bench_format_t;
+
+static const bench_format_t bench_formats[] = {
+    { "csv", get_csv_data_layer, bench_feed_body },
+    { "json", get_json_data_layer, bench_json_feed_body },
+    { "cbor", get_cbor_data_layer, bench_cbor_feed_body },
+};
+
+// one datapoint encoded the way it's sent and a whole feed decoded the way it's received
+static void bench_data_formats( const char* name )
+{
+    char body[ 4096 ];
+    char variant[ 24 ];
+    xi_datapoint_t datapoint;
+    xi_feed_t feed;
+
+    memset( &datapoint, 0, sizeof( datapoint ) );
+
+    for( size_t f = 0; f < sizeof( bench_formats ) / sizeof( bench_formats[ 0 ] ); ++f )
+    {
+        const data_layer_t* data_layer = bench_formats[ f ].get_data_layer();
+        int s = 0;
+
+        double start = bench_now();
+
+        for( size_t i = 0; i < FORMAT_ITERATIONS; ++i )
+        {
+            datapoint.timestamp.timestamp   = 1365970801 + ( time_t ) i;
+            datapoint.timestamp.micro       = ( time_t ) ( i * 7919 % 1000000 );
+            xi_set_value_f32( &datapoint, 20.0f + ( float ) ( i & 255 ) * 0.25f );
+
+            s = data_layer->encode_datapoint_in_place( body, sizeof( body ), &datapoint );
+
+            if( s < 0 )
+            {
+                printf( "%s: encoding failed\n", name );
+                return;
+            }
+
+            bench_sink += body[ s - 1 ];
+        }
+
+        snprintf( variant, sizeof( variant ), "%s encode", bench_formats[ f ].name );
+
+        bench_report( name, variant, FORMAT_ITERATIONS, bench_now() - start, s, s );
+
+        size_t body_size = bench_formats[ f ].feed_body( body, sizeof( body ), XI_MAX_DATASTREAMS - 1 );
+
+        start = bench_now();
+
+        for( size_t i = 0; i < FORMAT_ITERATIONS; ++i )
+        {
+            if( data_layer->decode_feed( body, &feed ) == 0 )
+            {
+                printf( "%s: decoding failed (%s)\n", name
+                    , xi_get_error_string( xi_get_last_error() ) );
+                return;
+            }
+
+            bench_sink += feed.datastream_count;
+        }
+
+        snprintf( variant, sizeof( variant ), "%s decode", bench_formats[ f ].name );
+
+        bench_report( name, variant, FORMAT_ITERATIONS, bench_now() - start, body_size, body_size );
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// TRANSPORT THROUGHPUT
+///////////////////////////////////////////////////////////////////////////////
+
+#define TRANSPORT_REQUESTS  2000
+#define TRANSPORT_WINDOW    8
+
+// replies to each HTTP request and lets the client close the connection
+static int bench_http_stub( int fd, void* arg )
+{
+    ( void ) arg;
+
+    char request[ 2048 ];
+    const char* body = 0;
+    const char reply[] = "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n";
+
+    if( mock_server_read_http( fd, request, sizeof( request ), &body ) == -1 ) { return 1; }
+    if( write( fd, reply, sizeof( reply ) - 1 ) != sizeof( reply ) - 1 ) { return 2; }
+
+    // wait for the client to hang up
+    return read( fd, request, sizeof( request ) ) < 0;
+}
+
+#ifdef XI_TRANSPORT_TCP
+// replies to every socket API message as soon as it's complete
+static int bench_socket_api_stub( int fd, void* arg )
+{
+    ( void ) arg;
+
+    char buffer[ 4096 ];
+    size_t size = 0;
+    int flag = 1;
+
+    setsockopt( fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof( flag ) );
+
+    for( ;; )
+    {
+        int s = socket_api_message_size( buffer, size );
+
+        if( s == -1 ) { return 1; }
+
+        if( s == 0 )
+        {
+            int r = read( fd, buffer + size, sizeof( buffer ) - size );
+            if( r <= 0 ) { return r < 0; }
+            size += r;
+            continue;
+        }
+
+        const char* t = strstr( buffer, "\"token\":\"" );
+        char reply[ 64 ];
+        int n = snprintf( reply, sizeof( reply ), "{\"status\":200,\"token\":\"%lu\"}\n"
+            , t ? strtoul( t + 9, 0, 10 ) : 0 );
+
+        if( write( fd, reply, n ) != n ) { return 2; }
+
+        size -= s;
+        memmove( buffer, buffer + s, size );
+    }
+}
+#endif
+
+// replies to every HTTP request on the connection as soon as it's complete
+static int bench_http_pipelined_stub( int fd, void* arg )
+{
+    ( void ) arg;
+
+    char buffer[ 4096 ];
+    size_t size = 0;
+    int flag = 1;
+    const char reply[] = "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n";
+
+    setsockopt( fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof( flag ) );
+
+    for( ;; )
+    {
+        // the empty line behind each body is skipped
+        size_t skip = 0;
+        while( skip + 1 < size && buffer[ skip ] == '\r' && buffer[ skip + 1 ] == '\n' ) { skip += 2; }
+        size -= skip;
+        memmove( buffer, buffer + skip, size );
+        buffer[ size ] = '\0';
+
+        const char* headers_end = strstr( buffer, "\r\n\r\n" );
+
+        if( headers_end )
+        {
+            const char* length = strstr( buffer, "Content-Length:" );
+            size_t s = headers_end + 4 - buffer
+                + ( length && length < headers_end ? atoi( length + 15 ) : 0 );
+
+            if( s <= size )
+            {
+                if( write( fd, reply, sizeof( reply ) - 1 ) != sizeof( reply ) - 1 ) { return 2; }
+
+                size -= s;
+                memmove( buffer, buffer + s, size );
+                continue;
+            }
+        }
+
+        int r = read( fd, buffer + size, sizeof( buffer ) - size - 1 );
+        if( r <= 0 ) { return r < 0; }
+        size += r;
+    }
+}
+
+static void bench_transport_http( const char* name )
+{
+    const transport_layer_t* transport_layer    = get_http_transport_layer();
+    const data_layer_t* data_layer              = get_csv_data_layer();
+    const comm_layer_t* comm_layer              = get_comm_layer();
+
+    char buffer[ XI_HTTP_MAX_CONTENT_SIZE ];
+    size_t wire = 0;
+    pid_t pid = 0;
+
+    xi_datapoint_t datapoint;
+    memset( &datapoint, 0, sizeof( xi_datapoint_t ) );
+    xi_set_value_f32( &datapoint, 21.5f );
+
+    int port = mock_server_start_many( &bench_http_stub, 0, TRANSPORT_REQUESTS, &pid );
+    if( port == -1 ) { printf( "%s: can't start the stub\n", name ); return; }
+
+    double start = bench_now();
+
+    // what xively.c does for every call: connect, send, read, close
+    for( size_t i = 0; i < TRANSPORT_REQUESTS; ++i )
+    {
+        connection_t* conn = comm_layer->open_connection( MOCK_SERVER_ADDRESS, port );
+        const char* data = transport_layer->encode_update_datastream(
+            data_layer, "apikey", 128, "temperature", &datapoint );
+
+        if( conn == 0 || data == 0 ) { printf( "%s: request failed\n", name ); break; }
+
+        wire = transport_layer->get_encoded_size();
+        comm_layer->send_data( conn, data, wire );
+
+        int recv = comm_layer->read_data( conn, buffer, sizeof( buffer ) );
+        bench_sink += recv > 0 ? transport_layer->decode_reply( data_layer, buffer, recv ) != 0 : 0;
+
+        comm_layer->close_connection( conn );
+    }
+
+    bench_report( name, "http", TRANSPORT_REQUESTS, bench_now() - start, wire, wire );
+
+    mock_server_wait( pid );
+}
+
+static void bench_transport_pipelined( const char* name
+    , const char* variant, const transport_layer_t* transport_layer
+    , mock_server_handler_t stub, size_t window )
+{
+    const data_layer_t* data_layer  = get_csv_data_layer();
+    const comm_layer_t* comm_layer  = get_comm_layer();
+
+    char buffer[ XI_HTTP_MAX_CONTENT_SIZE ];
+    size_t size = 0;
+    size_t wire = 0;
+    size_t sent = 0;
+    size_t received = 0;
+    pid_t pid = 0;
+
+    xi_datapoint_t datapoint;
+    memset( &datapoint, 0, sizeof( xi_datapoint_t ) );
+    xi_set_value_f32( &datapoint, 21.5f );
+
+    int port = mock_server_start( stub, 0, &pid );
+    if( port == -1 ) { printf( "%s: can't start the stub\n", name ); return; }
+
+    double start = bench_now();
+
+    connection_t* conn = comm_layer->open_connection( MOCK_SERVER_ADDRESS, port );
+
+    if( conn == 0 || ( transport_layer->open_session
+        && transport_layer->open_session( comm_layer, conn, "apikey" ) == -1 ) )
+    {
+        printf( "%s: can't connect\n", name );
+        return;
+    }
+
+    // keeps up to `window` requests outstanding
+    while( received < TRANSPORT_REQUESTS )
+    {
+        while( sent < TRANSPORT_REQUESTS && sent - received < window )
+        {
+            const char* data = transport_layer->encode_update_datastream(
+                data_layer, "apikey", 128, "temperature", &datapoint );
+
+            wire = transport_layer->get_encoded_size();
+            comm_layer->send_data( conn, data, wire );
+            ++sent;
+        }
+
+        int reply_size = transport_layer->reply_size( buffer, size );
+
+        if( reply_size == -1 ) { printf( "%s: bad reply\n", name ); break; }
+
+        if( reply_size == 0 )
+        {
+            int recv = comm_layer->read_data( conn, buffer + size, sizeof( buffer ) - size );
+            if( recv <= 0 ) { printf( "%s: read failed\n", name ); break; }
+            size += recv;
+            continue;
+        }
+
+        bench_sink += transport_layer->decode_reply( data_layer, buffer, reply_size ) != 0;
+        ++received;
+
+        size -= reply_size;
+        memmove( buffer, buffer + reply_size, size );
+    }
+
+    if( transport_layer->close_session ) { transport_layer->close_session( comm_layer, conn ); }
+    comm_layer->close_connection( conn );
+
+    bench_report( name, variant, TRANSPORT_REQUESTS, bench_now() - start, wire, wire );
+
+    mock_server_wait( pid );
+}
+
+static void bench_transport( const char* name )
+{
+    bench_transport_http( name );
+    bench_transport_pipelined( name, "http/window=" XI_STR( TRANSPORT_WINDOW )
+        , get_http_pipelined_transport_layer(), &bench_http_pipelined_stub, TRANSPORT_WINDOW );
+#ifdef XI_TRANSPORT_TCP
+    bench_transport_pipelined( name, "tcp", get_tcp_transport_layer(), &bench_socket_api_stub, 1 );
+    bench_transport_pipelined( name, "tcp/window=" XI_STR( TRANSPORT_WINDOW )
+        , get_tcp_transport_layer(), &bench_socket_api_stub, TRANSPORT_WINDOW );
+#else
+    printf( "%-28s %-16s skipped, build with XI_TRANSPORT_TCP=1\n", name, "tcp" );
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// MQTT PUBLISHING
+///////////////////////////////////////////////////////////////////////////////
+
+#define MQTT_MESSAGES   100000
+#define MQTT_WINDOW     8
+
+#ifdef XI_TRANSPORT_MQTT
+// acknowledges the connection and QoS 1 publishes until the client disconnects
+static int bench_mqtt_stub( int fd, void* arg )
+{
+    ( void ) arg;
+
+    char buffer[ 4096 ];
+    size_t size = 0;
+    int flag = 1;
+
+    setsockopt( fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof( flag ) );
+
+    for( ;; )
+    {
+        mqtt_packet_type_t type = XI_MQTT_CONNECT;
+        uint16_t value = 0;
+
+        int s = mqtt_parse_packet( buffer, size, &type, &value );
+
+        if( s == -1 ) { return 1; }
+
+        if( s == 0 )
+        {
+            int r = read( fd, buffer + size, sizeof( buffer ) - size );
+            if( r <= 0 ) { return 2; }
+            size += r;
+            continue;
+        }
+
+        if( type == XI_MQTT_DISCONNECT ) { return 0; }
+
+        if( type == XI_MQTT_CONNECT && write( fd, "\x20\x02\x00\x00", 4 ) != 4 ) { return 3; }
+
+        if( type == XI_MQTT_PUBLISH && ( buffer[ 0 ] & 0x06 ) )
+        {
+            // the packet id follows the topic
+            size_t topic = ( ( uint8_t ) buffer[ 2 ] << 8 ) | ( uint8_t ) buffer[ 3 ];
+            char puback[] = { 0x40, 0x02, buffer[ 4 + topic ], buffer[ 5 + topic ] };
+
+            if( write( fd, puback, sizeof( puback ) ) != sizeof( puback ) ) { return 4; }
+        }
+
+        size -= s;
+        memmove( buffer, buffer + s, size );
+    }
+}
+
+static void bench_mqtt_publish_one( const char* name
+    , const char* variant, uint8_t qos, size_t window )
+{
+    const transport_layer_t* transport_layer    = get_mqtt_transport_layer();
+    const data_layer_t* data_layer              = get_csv_data_layer();
+    const comm_layer_t* comm_layer              = get_comm_layer();
+
+    char buffer[ 256 ];
+    size_t size = 0;
+    size_t wire = 0;
+    size_t sent = 0;
+    size_t acknowledged = 0;
+    pid_t pid = 0;
+
+    xi_datapoint_t datapoint;
+    memset( &datapoint, 0, sizeof( xi_datapoint_t ) );
+    xi_set_value_f32( &datapoint, 21.5f );
+
+    xi_set_mqtt_qos( qos );
+
+    int port = mock_server_start( &bench_mqtt_stub, 0, &pid );
+    if( port == -1 ) { printf( "%s: can't start the stub\n", name ); return; }
+
+    double start = bench_now();
+
+    connection_t* conn = comm_layer->open_connection( MOCK_SERVER_ADDRESS, port );
+
+    if( conn == 0 || transport_layer->open_session( comm_layer, conn, "apikey" ) == -1 )
+    {
+        printf( "%s: can't connect\n", name );
+        return;
+    }
+
+    // with QoS 0 the window doesn't matter, nothing is waited for
+    while( acknowledged < MQTT_MESSAGES )
+    {
+        while( sent < MQTT_MESSAGES && sent - acknowledged < window )
+        {
+            const char* data = transport_layer->encode_update_datastream(
+                data_layer, "apikey", 128, "temperature", &datapoint );
+
+            wire = transport_layer->get_encoded_size();
+            comm_layer->send_data( conn, data, wire );
+            ++sent;
+
+            acknowledged += transport_layer->get_immediate_reply() != 0;
+        }
+
+        if( acknowledged == MQTT_MESSAGES ) { break; }
+
+        int reply_size = transport_layer->reply_size( buffer, size );
+
+        if( reply_size == -1 ) { printf( "%s: bad reply\n", name ); break; }
+
+        if( reply_size == 0 )
+        {
+            int recv = comm_layer->read_data( conn, buffer + size, sizeof( buffer ) - size );
+            if( recv <= 0 ) { printf( "%s: read failed\n", name ); break; }
+            size += recv;
+            continue;
+        }
+
+        bench_sink += transport_layer->decode_reply( data_layer, buffer, reply_size ) != 0;
+        ++acknowledged;
+
+        size -= reply_size;
+        memmove( buffer, buffer + reply_size, size );
+    }
+
+    transport_layer->close_session( comm_layer, conn );
+    comm_layer->close_connection( conn );
+
+    // the broker has seen every message once it gets to the disconnect
+    mock_server_wait( pid );
+
+    bench_report( name, variant, MQTT_MESSAGES, bench_now() - start, wire, wire );
+
+    xi_set_mqtt_qos( 0 );
+}
+
+#endif
+
+static void bench_mqtt_publish( const char* name )
+{
+#ifdef XI_TRANSPORT_MQTT
+    bench_mqtt_publish_one( name, "qos=0", 0, MQTT_WINDOW );
+    bench_mqtt_publish_one( name, "qos=1", 1, 1 );
+    bench_mqtt_publish_one( name, "qos=1/window=" XI_STR( MQTT_WINDOW ), 1, MQTT_WINDOW );
+#else
+    printf( "%-28s %-16s skipped, build with XI_TRANSPORT_MQTT=1\n", name, "mqtt" );
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// MAIN
+///////////////////////////////////////////////////////////////////////////////
+
+static const benchmark_t benchmarks[] = {
+    { "response/decode_feed", bench_response_decode },
+    { "response/parse_headers", bench_response_parse },
+    { "decode/value", bench_value_decode },
+    { "decode/feed", bench_feed_decode },
+    { "decode/timestamp", bench_timestamp_decode },
+    { "encode/update_datastream", bench_encode_update },
+    { "encode/update_datastream_int", bench_encode_update_int },
+    { "encode/float", bench_encode_float },
+    { "encode/feed_timestamps", bench_encode_feed_timestamps },
+    { "data/formats", bench_data_formats },
+    { "transport/update_datastream", bench_transport },
+    { "mqtt/publish", bench_mqtt_publish },
+    { 0, 0 }
+};
+
+int main( int argc, char const *argv[] )
+{
+    for( const benchmark_t* b = benchmarks; b->name; ++b )
+    {
+        int selected = argc < 2;
+
+        for( int i = 1; i < argc; ++i )
+        {
+            selected |= strncmp( b->name, argv[ i ], strlen( argv[ i ] ) ) == 0;
+        }
+
+        if( selected )
+        {
+            b->fn( b->name );
+        }
+    }
+
+    return 0;
+}
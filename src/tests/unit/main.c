@@ -9,12 +9,36 @@
 #include "http_layer_parser.h"
 #include "http_layer_queries.h"
 #include "xi_helpers.h"
+#include "xi_globals.h"
+#include "http_transport.h"
+#include "http_transport_layer.h"
+#include "csv_data_layer.h"
+#include "json_data_layer.h"
+#include "cbor_data_layer.h"
+#include "comm_layer.h"
+#include "ws_transport.h"
+#include "tcp_transport.h"
+#include "mqtt_transport.h"
+#include "ws_layer_frames.h"
+#include "socket_api.h"
+#include "mock_server.h"
+#include "xi_response_cache.h"
+#include "xi_rate_limiter.h"
+#include "xi_retry.h"
+#include "xi_circuit_breaker.h"
+
+#ifdef XI_ZLIB
+#include <zlib.h>
+#endif
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <string.h>
 #include <errno.h>
 #include <time.h>
+#include <unistd.h>
+#include <float.h>
 
 ///////////////////////////////////////////////////////////////////////////////
 // HTTP PARSER TESTS
@@ -256,69 +280,2326 @@ void test_parse_http(void* data)
     ;
 }
 
+void test_parse_http_header_types(void* data)
+{
+    (void)(data);
+
+    // prepare structure
+    http_response_t response;
+    memset( &response, 0, sizeof( http_response_t ) );
+
+    {
+        const char test_response[] =
+            "HTTP/1.1 200 OK\r\n"
+            "Vary: Accept-Encoding\r\n"
+            "Age: 0\r\n"
+            "Content-Encoding: gzip\r\n\r\n";
+
+        // gzip with no content is an error, but the headers are parsed before that
+        parse_http( &response, test_response );
+
+        tt_assert( response.http_headers_size == 3 );
+        tt_assert( response.http_headers[ 0 ].header_type == XI_HTTP_HEADER_VARY );
+        tt_assert( response.http_headers[ 1 ].header_type == XI_HTTP_HEADER_AGE );
+        tt_assert( response.http_headers[ 2 ].header_type == XI_HTTP_HEADER_CONTENT_ENCODING );
+        tt_assert( strcmp( response.http_headers_checklist[ XI_HTTP_HEADER_CONTENT_ENCODING ]->value, "gzip" ) == 0 );
+    }
+
+    // the error left by the gzip above would be taken for a header parsing error
+    xi_set_err( XI_NO_ERR );
+    memset( &response, 0, sizeof( http_response_t ) );
+
+    {
+        const char test_response[] =
+            "HTTP/1.1 304 Not Modified\r\n"
+            "ETag: \"4f3bd0c1\"\r\n"
+            "Last-Modified: Sun, 14 Apr 2013 20:20:01 GMT\r\n\r\n";
+
+        tt_assert( parse_http( &response, test_response ) != 0 );
+
+        tt_assert( response.http_status == 304 );
+        tt_assert( strcmp( response.http_headers_checklist[ XI_HTTP_HEADER_ETAG ]->value, "\"4f3bd0c1\"" ) == 0 );
+        tt_assert( strcmp( response.http_headers_checklist[ XI_HTTP_HEADER_LAST_MODIFIED ]->value
+            , "Sun, 14 Apr 2013 20:20:01 GMT" ) == 0 );
+
+        xi_validators_t validators;
+        tt_assert( xi_response_cache_store_validators( &validators, 7, &response ) == 1 );
+        tt_assert( validators.key == 7 );
+        tt_assert( strcmp( validators.etag, "\"4f3bd0c1\"" ) == 0 );
+    }
+
+ end:
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+
+void test_parse_http_lazy(void* data)
+{
+    (void)(data);
+
+    http_response_t response;
+    memset( &response, 0, sizeof( http_response_t ) );
+
+    {
+        const char test_response[] =
+            "HTTP/1.1 200 OK\r\n"
+            "Date: Sun, 14 Apr 2013 20:20:01 GMT\r\n"
+            "content-length: 10\r\n"
+            "ETag:   \"4f3bd0c1\"\r\n\r\n"
+            "test,12345 trailing garbage";
+
+        tt_assert( parse_http_lazy( &response, test_response, sizeof( test_response ) - 1 ) != 0 );
+
+        tt_assert( response.http_version1 == 1 );
+        tt_assert( response.http_version2 == 1 );
+        tt_assert( response.http_status == 200 );
+        tt_assert( strcmp( response.http_status_string, "OK" ) == 0 );
+        tt_assert( strcmp( response.http_content, "test,12345" ) == 0 );
+
+        // nothing is parsed until asked for
+        tt_assert( response.http_headers_size == 0 );
+        tt_assert( response.http_headers_checklist[ XI_HTTP_HEADER_DATE ] == 0 );
+
+        char value[ XI_HTTP_HEADER_VALUE_MAX_SIZE ];
+        char other[ 8 ];
+
+        tt_assert( http_response_header( &response, XI_HTTP_HEADER_CONTENT_LENGTH, value, sizeof( value ) ) == value );
+        tt_assert( strcmp( value, "10" ) == 0 );
+        tt_assert( strcmp( http_response_header( &response, XI_HTTP_HEADER_ETAG, value, sizeof( value ) )
+            , "\"4f3bd0c1\"" ) == 0 );
+
+        // each caller has its own copy, which is truncated to fit
+        tt_assert( http_response_header( &response, XI_HTTP_HEADER_DATE, other, sizeof( other ) ) == other );
+        tt_assert( strcmp( other, "Sun, 14" ) == 0 );
+        tt_assert( strcmp( value, "\"4f3bd0c1\"" ) == 0 );
+
+        tt_assert( http_response_header( &response, XI_HTTP_HEADER_VARY, value, sizeof( value ) ) == 0 );
+        tt_assert( value[ 0 ] == '\0' );
+        tt_assert( http_response_header( &response, XI_HTTP_HEADER_UNKNOWN, value, sizeof( value ) ) == 0 );
+    }
+
+    // no headers at all
+    {
+        const char test_response[] = "HTTP/1.0 404 Not Found\r\n\r\n";
+
+        tt_assert( parse_http_lazy( &response, test_response, sizeof( test_response ) - 1 ) != 0 );
+        tt_assert( response.http_status == 404 );
+        tt_assert( strcmp( response.http_status_string, "Not Found" ) == 0 );
+        tt_assert( response.http_headers_raw_size == 0 );
+        char value[ XI_HTTP_HEADER_VALUE_MAX_SIZE ];
+
+        tt_assert( http_response_header( &response, XI_HTTP_HEADER_CONTENT_LENGTH, value, sizeof( value ) ) == 0 );
+    }
+
+    // the same errors as the eager parser
+    {
+        const char test_response[] = "HTTP/1.1 2x0 OK\r\n\r\n";
+
+        tt_assert( parse_http_lazy( &response, test_response, sizeof( test_response ) - 1 ) == 0 );
+        tt_assert( xi_get_last_error() == XI_HTTP_PARSE_ERROR );
+        xi_set_err( XI_NO_ERR );
+    }
+
+    {
+        const char test_response[] = "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n";
+
+        tt_assert( parse_http_lazy( &response, test_response, sizeof( test_response ) - 1 ) == 0 );
+        tt_assert( xi_get_last_error() == XI_HTTP_PARSE_ERROR );
+    }
+
+ end:
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+
+void test_parse_http_reply_size(void* data)
+{
+    (void)(data);
+
+    // two pipelined replies, read a piece at a time
+    {
+        const char replies[] =
+            "HTTP/1.1 200 OK\r\n"
+            "Content-Length: 4\r\n\r\n"
+            "1234"
+            "HTTP/1.1 304 Not Modified\r\n"
+            "ETag: \"4f3bd0c1\"\r\n\r\n";
+
+        const int first = sizeof( "HTTP/1.1 200 OK\r\nContent-Length: 4\r\n\r\n1234" ) - 1;
+
+        tt_assert( parse_http_reply_size( replies, 10 ) == 0 );
+        tt_assert( parse_http_reply_size( replies, first - 1 ) == 0 );
+        tt_assert( parse_http_reply_size( replies, first ) == first );
+        tt_assert( parse_http_reply_size( replies, sizeof( replies ) - 1 ) == first );
+
+        // no content without Content-Length for 304
+        tt_assert( parse_http_reply_size( replies + first, sizeof( replies ) - 1 - first )
+            == ( int ) sizeof( replies ) - 1 - first );
+    }
+
+    // content that can't be framed
+    {
+        const char reply[] = "HTTP/1.1 200 OK\r\nConnection: close\r\n\r\n1234";
+
+        tt_assert( parse_http_reply_size( reply, sizeof( reply ) - 1 ) == -1 );
+        tt_assert( xi_get_last_error() == XI_HTTP_PARSE_ERROR );
+    }
+
+ end:
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+
+#ifdef XI_ZLIB
+void test_parse_http_gzip(void* data)
+{
+    (void)(data);
+
+    // prepare structure
+    http_response_t response;
+    memset( &response, 0, sizeof( http_response_t ) );
+
+    const char body[] =
+        "temperature,2013-01-01T18:44:21.423452Z,21.5\n"
+        "humidity,2013-01-01T18:44:21.423452Z,45\n"
+        "temperature,2013-01-01T18:44:22.423452Z,21.6\n";
+
+    char message[ 512 ];
+    memset( message, 0, sizeof( message ) );
+
+    // compress the body the same way a server would do it
+    unsigned char compressed[ 256 ];
+    z_stream strm;
+    memset( &strm, 0, sizeof( z_stream ) );
+    tt_assert( deflateInit2( &strm, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY ) == Z_OK );
+    strm.next_in    = ( Bytef* ) body;
+    strm.avail_in   = sizeof( body ) - 1;
+    strm.next_out   = compressed;
+    strm.avail_out  = sizeof( compressed );
+    tt_assert( deflate( &strm, Z_FINISH ) == Z_STREAM_END );
+    deflateEnd( &strm );
+
+    int header_size = snprintf( message, sizeof( message )
+        , "HTTP/1.1 200 OK\r\n"
+          "Content-Type: text/plain; charset=utf-8\r\n"
+          "Content-Encoding: gzip\r\n"
+          "Content-Length: %d\r\n\r\n", ( int ) strm.total_out );
+
+    memcpy( message + header_size, compressed, strm.total_out );
+
+    // sized variant needs to be used as gzip stream contains zeros
+    {
+        http_response_t* ret = parse_http_sized( &response, message, header_size + strm.total_out );
+
+        tt_assert( ret != 0 );
+        tt_assert( strcmp( ret->http_content, body ) == 0 );
+    }
+
+    // the rest of the stream follows a piece at a time
+    {
+        size_t first = strm.total_out / 2;
+
+        http_response_t* ret = parse_http_sized( &response, message, header_size + first );
+
+        tt_assert( ret != 0 );
+        tt_assert( http_content_left() == strm.total_out - first );
+
+        for( size_t i = header_size + first; i < header_size + strm.total_out; i += 3 )
+        {
+            tt_assert( parse_http_content( message + i, XI_MIN( 3, header_size + strm.total_out - i ) ) == 0 );
+        }
+
+        tt_assert( http_content_left() == 0 );
+        tt_assert( strcmp( ret->http_content, body ) == 0 );
+    }
+
+    // a stream that ends early
+    {
+        char truncated[ 512 ];
+        int size = snprintf( truncated, sizeof( truncated )
+            , "HTTP/1.1 200 OK\r\nContent-Encoding: gzip\r\n\r\n" );
+
+        memcpy( truncated + size, compressed, strm.total_out / 2 );
+
+        http_response_t* ret = parse_http_sized( &response, truncated, size + strm.total_out / 2 );
+
+        tt_assert( ret == 0 );
+        tt_assert( xi_get_last_error() == XI_HTTP_CONTENT_ENCODING_ERROR );
+    }
+
+    xi_set_err( XI_NO_ERR );
+
+    // a corrupt stream
+    {
+        message[ header_size + strm.total_out - 6 ] ^= 0xFF;
+
+        http_response_t* ret = parse_http_sized( &response, message, header_size + strm.total_out );
+
+        tt_assert( ret == 0 );
+        tt_assert( xi_get_last_error() == XI_HTTP_CONTENT_ENCODING_ERROR );
+    }
+
+    xi_set_err( XI_NO_ERR );
+
+    // content that inflates past the buffer is an error rather than cut off
+    {
+        char large_body[ 4 * XI_HTTP_MAX_CONTENT_SIZE ];
+        size_t large_body_size = 0;
+
+        while( large_body_size + sizeof( body ) < sizeof( large_body ) )
+        {
+            memcpy( large_body + large_body_size, body, sizeof( body ) - 1 );
+            large_body_size += sizeof( body ) - 1;
+        }
+
+        memset( &strm, 0, sizeof( z_stream ) );
+        tt_assert( deflateInit2( &strm, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY ) == Z_OK );
+        strm.next_in    = ( Bytef* ) large_body;
+        strm.avail_in   = large_body_size;
+        strm.next_out   = compressed;
+        strm.avail_out  = sizeof( compressed );
+        tt_assert( deflate( &strm, Z_FINISH ) == Z_STREAM_END );
+        deflateEnd( &strm );
+
+        header_size = snprintf( message, sizeof( message )
+            , "HTTP/1.1 200 OK\r\n"
+              "Content-Encoding: gzip\r\n"
+              "Content-Length: %d\r\n\r\n", ( int ) strm.total_out );
+
+        tt_assert( header_size + strm.total_out < sizeof( message ) );
+        memcpy( message + header_size, compressed, strm.total_out );
+
+        http_response_t* ret = parse_http_sized( &response, message, header_size + strm.total_out );
+
+        tt_assert( ret == 0 );
+        tt_assert( xi_get_last_error() == XI_HTTP_CONTENT_TOO_LARGE );
+
+        xi_set_err( XI_NO_ERR );
+
+        ret = parse_http_lazy( &response, message, header_size + strm.total_out );
+
+        tt_assert( ret == 0 );
+        tt_assert( xi_get_last_error() == XI_HTTP_CONTENT_TOO_LARGE );
+    }
+
+    xi_set_err( XI_NO_ERR );
+
+    // content that just fits
+    {
+        char exact_body[ XI_HTTP_MAX_CONTENT_SIZE ];
+
+        memset( exact_body, 'a', sizeof( exact_body ) - 1 );
+        exact_body[ sizeof( exact_body ) - 1 ] = '\0';
+
+        memset( &strm, 0, sizeof( z_stream ) );
+        tt_assert( deflateInit2( &strm, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY ) == Z_OK );
+        strm.next_in    = ( Bytef* ) exact_body;
+        strm.avail_in   = sizeof( exact_body ) - 1;
+        strm.next_out   = compressed;
+        strm.avail_out  = sizeof( compressed );
+        tt_assert( deflate( &strm, Z_FINISH ) == Z_STREAM_END );
+        deflateEnd( &strm );
+
+        header_size = snprintf( message, sizeof( message )
+            , "HTTP/1.1 200 OK\r\n"
+              "Content-Encoding: gzip\r\n"
+              "Content-Length: %d\r\n\r\n", ( int ) strm.total_out );
+
+        memcpy( message + header_size, compressed, strm.total_out );
+
+        http_response_t* ret = parse_http_sized( &response, message, header_size + strm.total_out );
+
+        tt_assert( ret != 0 );
+        tt_assert( strcmp( ret->http_content, exact_body ) == 0 );
+    }
+
+ end:
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+#endif
+
 ///////////////////////////////////////////////////////////////////////////////
 // HTTP CONSTRUCT TEST
 ///////////////////////////////////////////////////////////////////////////////
 
-void test_http_construct_request(void *data)
+void test_http_construct_request(void *data)
+{
+    (void)(data);
+
+    // simple test
+    {
+        const char expected[] =
+            "GET /v2/feeds/128/datastreams/test.csv HTTP/1.1\r\n"
+            "Host: " XI_HOST "\r\n"
+            "User-Agent: " XI_USER_AGENT "\r\n"
+            "Accept: */*\r\n"
+            "X-ApiKey: apikey\r\n";
+
+        int feed_id = 128;
+        const char* ret = http_construct_request_datastream( "GET", &feed_id, "test", "apikey" );
+        tt_assert( strcmp( expected, ret ) == 0 );
+    }
+
+    // simple test2
+    {
+        const char expected[] =
+            "GET /v2/feeds/128/datastreams.csv HTTP/1.1\r\n"
+            "Host: " XI_HOST "\r\n"
+            "User-Agent: " XI_USER_AGENT "\r\n"
+            "Accept: */*\r\n"
+            "X-ApiKey: apikey\r\n";
+
+        int feed_id = 128;
+        const char* ret = http_construct_request_datastream( "GET", &feed_id, 0, "apikey" );
+        tt_assert( strcmp( expected, ret ) == 0 );
+    }
+
+ end:
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+
+void test_http_construct_request_conditional(void *data)
+{
+    (void)(data);
+
+    const char expected_prefix[] =
+        "GET /v2/feeds/128/datastreams/test.csv HTTP/1.1\r\n"
+        "Host: " XI_HOST "\r\n"
+        "User-Agent: " XI_USER_AGENT "\r\n"
+        "Accept: */*\r\n"
+        "X-ApiKey: apikey\r\n";
+
+    int feed_id = 128;
+
+    // both validators go with the GET
+    {
+        const char expected[] =
+            "If-None-Match: \"4f3bd0c1\"\r\n"
+            "If-Modified-Since: Sun, 14 Apr 2013 20:20:01 GMT\r\n";
+
+        tt_assert( http_set_conditional_headers( "\"4f3bd0c1\"", "Sun, 14 Apr 2013 20:20:01 GMT" ) == 0 );
+
+        const char* ret = http_construct_request_datastream( "GET", &feed_id, "test", "apikey" );
+        tt_assert( ret != 0 );
+        tt_assert( strncmp( expected_prefix, ret, sizeof( expected_prefix ) - 1 ) == 0 );
+        tt_assert( strcmp( expected, ret + sizeof( expected_prefix ) - 1 ) == 0 );
+    }
+
+    // and they are used up by it
+    {
+        const char* ret = http_construct_request_datastream( "GET", &feed_id, "test", "apikey" );
+        tt_assert( ret != 0 );
+        tt_assert( strcmp( expected_prefix, ret ) == 0 );
+    }
+
+    // but an update never carries them
+    {
+        tt_assert( http_set_conditional_headers( "\"4f3bd0c1\"", 0 ) == 0 );
+
+        const char* ret = http_construct_request_datastream( "PUT", &feed_id, "test", "apikey" );
+        tt_assert( ret != 0 );
+        tt_assert( strstr( ret, "If-None-Match" ) == 0 );
+
+        http_set_conditional_headers( 0, 0 );
+    }
+
+    // different requests have different keys
+    {
+        xi_feed_t feed;
+        memset( &feed, 0, sizeof( feed ) );
+        feed.feed_id = 128;
+
+        uint32_t all = xi_response_cache_feed_key( &feed );
+
+        feed.datastream_count = 1;
+        strcpy( feed.datastreams[ 0 ].datastream_id, "test" );
+
+        tt_assert( all != 0 );
+        tt_assert( all != xi_response_cache_feed_key( &feed ) );
+        tt_assert( xi_response_cache_datastream_key( 128, "test" )
+            != xi_response_cache_datastream_key( 129, "test" ) );
+    }
+
+    // the copy of the feed is only allocated once a feed is cached
+    {
+        xi_feed_t feed;
+        xi_response_cache_t cache;
+
+        memset( &feed, 0, sizeof( feed ) );
+        memset( &cache, 0, sizeof( cache ) );
+        feed.feed_id = 128;
+
+        tt_assert( sizeof( cache ) < sizeof( feed ) );
+        tt_assert( cache.feed == 0 );
+
+        tt_assert( xi_response_cache_store_feed( &cache, &feed ) == 0 );
+        tt_assert( cache.feed != 0 );
+        tt_assert( cache.feed->feed_id == 128 );
+
+        xi_response_cache_release( &cache );
+        tt_assert( cache.feed == 0 );
+    }
+
+ end:
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+
+void test_encode_get_datastream_history(void *data)
+{
+    (void)(data);
+
+    const data_layer_t* data_layer = get_csv_data_layer();
+
+    xi_timestamp_t start = { 1365970801, 1 };
+    xi_timestamp_t end   = { 1365974401, 0 };
+
+    {
+        const char expected[] =
+            "GET /v2/feeds/128/datastreams/temp/datapoints.csv"
+            "?start=2013-04-14T20:20:01.000001Z&end=2013-04-14T21:20:01.000000Z&interval=60&limit=8 HTTP/1.1\r\n"
+            "Host: " XI_HOST "\r\n";
+
+        const char* ret = get_http_transport_layer()->encode_get_datastream_history(
+            data_layer, "apikey", 128, "temp", &start, &end, 60, 8 );
+        tt_assert( ret != 0 );
+        tt_assert( strncmp( expected, ret, sizeof( expected ) - 1 ) == 0 );
+    }
+
+#ifdef XI_TRANSPORT_TCP
+    // no end and no interval
+    {
+        const char expected[] =
+            "{\"method\":\"get\",\"resource\":\"/feeds/128/datastreams/temp/datapoints.csv\""
+            ",\"params\":{\"start\":\"2013-04-14T20:20:01.000001Z\",\"limit\":8}"
+            ",\"headers\":{\"X-ApiKey\":\"apikey\"}";
+
+        const char* ret = get_tcp_transport_layer()->encode_get_datastream_history(
+            data_layer, "apikey", 128, "temp", &start, 0, 0, 8 );
+        tt_assert( ret != 0 );
+        tt_assert( strncmp( expected, ret, sizeof( expected ) - 1 ) == 0 );
+    }
+#endif
+
+ end:
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+
+#ifdef XI_ZLIB
+void test_http_construct_request_accept_encoding(void *data)
+{
+    (void)(data);
+
+    {
+        const char expected[] =
+            "GET /v2/feeds/128.csv HTTP/1.1\r\n"
+            "Host: " XI_HOST "\r\n"
+            "User-Agent: " XI_USER_AGENT "\r\n"
+            "Accept: */*\r\n"
+            "X-ApiKey: apikey\r\n"
+            "Accept-Encoding: gzip, deflate\r\n";
+
+        int feed_id = 128;
+
+        xi_set_response_compression( 1 );
+        const char* ret = http_construct_request_feed( "GET", &feed_id, "apikey", 0 );
+        xi_set_response_compression( 0 );
+
+        tt_assert( strcmp( expected, ret ) == 0 );
+    }
+
+ end:
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+#endif
+
+void test_http_construct_content(void *data)
+{
+    (void)(data);
+
+    // simple test
+    {
+        const char expected[] =
+            "Content-Type: text/plain\r\n"
+            "Content-Length: 128\r\n";
+
+        const char* ret = http_construct_content( 128 );
+        tt_assert( strcmp( expected, ret ) == 0 );
+    }
+
+ end:
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+
+void test_http_encode_update_datastream_static(void *data)
+{
+    (void)(data);
+
+    const data_layer_t* data_layer = get_csv_data_layer();
+
+    static const xi_static_request_t request = XI_STATIC_DATASTREAM_UPDATE( 128, "temp" );
+
+    tt_assert( request.feed_id == 128 );
+    tt_assert( strcmp( request.datastream_id, "temp" ) == 0 );
+    tt_assert( strcmp( request.request_line, "PUT /v2/feeds/128/datastreams/temp.csv HTTP/1.1\r\n" ) == 0 );
+    tt_assert( request.request_line_size == strlen( request.request_line ) );
+
+    // byte for byte the same as the one put together at run time
+    {
+        char expected[ 1024 ];
+        xi_datapoint_t datapoint;
+
+        memset( &datapoint, 0, sizeof( datapoint ) );
+        xi_set_value_f32( &datapoint, 21.5f );
+        datapoint.timestamp.timestamp = 1365970801;
+
+        const char* ret = http_encode_update_datastream(
+            data_layer, "apikey", 128, "temp", &datapoint );
+        tt_assert( ret != 0 );
+        strcpy( expected, ret );
+
+        ret = http_encode_update_datastream_static(
+            data_layer, "apikey", &request, &datapoint );
+        tt_assert( ret != 0 );
+        tt_assert( strcmp( expected, ret ) == 0 );
+        tt_assert( get_http_transport_layer()->get_encoded_size() == strlen( expected ) );
+    }
+
+#ifdef XI_ZLIB
+    // the same with compression, both of the response and of a body that shrinks
+    {
+        char expected[ 1024 ];
+        size_t expected_size = 0;
+        xi_datapoint_t datapoint;
+
+        memset( &datapoint, 0, sizeof( datapoint ) );
+        xi_set_value_str( &datapoint, "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa" );
+        datapoint.timestamp.timestamp = 1365970801;
+
+        xi_set_response_compression( 1 );
+
+        const char* ret = http_encode_update_datastream(
+            data_layer, "apikey", 128, "temp", &datapoint );
+        tt_assert( ret != 0 );
+        tt_assert( strstr( ret, "Accept-Encoding: gzip, deflate\r\n" ) != 0 );
+        strcpy( expected, ret );
+
+        ret = http_encode_update_datastream_static(
+            data_layer, "apikey", &request, &datapoint );
+        tt_assert( ret != 0 );
+        tt_assert( strcmp( expected, ret ) == 0 );
+
+        xi_set_request_compression( 16 );
+
+        ret = http_encode_update_datastream(
+            data_layer, "apikey", 128, "temp", &datapoint );
+        tt_assert( ret != 0 );
+        tt_assert( strstr( ret, "Content-Encoding: gzip\r\n" ) != 0 );
+        expected_size = get_http_transport_layer()->get_encoded_size();
+        memcpy( expected, ret, expected_size );
+
+        ret = http_encode_update_datastream_static(
+            data_layer, "apikey", &request, &datapoint );
+        tt_assert( ret != 0 );
+        tt_assert( get_http_transport_layer()->get_encoded_size() == expected_size );
+        tt_assert( memcmp( expected, ret, expected_size ) == 0 );
+    }
+#endif
+
+ end:
+#ifdef XI_ZLIB
+    xi_set_response_compression( 0 );
+    xi_set_request_compression( 0 );
+#endif
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+
+#ifdef XI_ZLIB
+// the server inflates the body and compares it with the expected one
+static int mock_inflating_server( int fd, void* arg )
+{
+    const char* expected = ( const char* ) arg;
+    const char* body = 0;
+    char request[ 1024 ];
+
+    int size = mock_server_read_http( fd, request, sizeof( request ), &body );
+    if( size == -1 ) { return 1; }
+    if( strstr( request, "Content-Encoding: gzip\r\n" ) == 0 ) { return 2; }
+
+    char inflated[ 8 * XI_CONTENT_BUFFER_SIZE ];
+    memset( inflated, 0, sizeof( inflated ) );
+
+    z_stream strm;
+    memset( &strm, 0, sizeof( z_stream ) );
+    if( inflateInit2( &strm, 15 + 16 ) != Z_OK ) { return 3; }
+    strm.next_in    = ( Bytef* ) body;
+    strm.avail_in   = size - ( body - request );
+    strm.next_out   = ( Bytef* ) inflated;
+    strm.avail_out  = sizeof( inflated ) - 1;
+    int ret = inflate( &strm, Z_FINISH );
+    inflateEnd( &strm );
+
+    if( ret != Z_STREAM_END ) { return 4; }
+    if( strcmp( inflated, expected ) != 0 ) { return 5; }
+
+    const char reply[] = "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n";
+    return write( fd, reply, sizeof( reply ) - 1 ) == sizeof( reply ) - 1 ? 0 : 6;
+}
+
+void test_http_encode_update_feed_gzip(void *data)
+{
+    (void)(data);
+
+    const transport_layer_t* transport_layer    = get_http_transport_layer();
+    const data_layer_t* data_layer              = get_csv_data_layer();
+    const comm_layer_t* comm_layer              = get_comm_layer();
+
+    char expected_body[ XI_CONTENT_BUFFER_SIZE ];
+    char reply[ 256 ];
+    pid_t pid = 0;
+    int port = 0;
+
+    // the datastream id is repeated on every line
+    xi_feed_t feed;
+    memset( &feed, 0, sizeof( xi_feed_t ) );
+    feed.feed_id            = 128;
+    feed.datastream_count   = 2;
+
+    for( size_t i = 0; i < feed.datastream_count; ++i )
+    {
+        xi_datastream_t* d = &feed.datastreams[ i ];
+        strcpy( d->datastream_id, i == 0 ? "temperature" : "humidity" );
+        d->datapoint_count = 3;
+
+        for( size_t j = 0; j < d->datapoint_count; ++j )
+        {
+            xi_set_value_i32( &d->datapoints[ j ], 20 + j );
+        }
+    }
+
+    // below the threshold the body goes as it is
+    {
+        xi_set_request_compression( 1024 );
+
+        const char* ret = http_encode_update_feed( data_layer, "apikey", &feed );
+
+        tt_assert( ret != 0 );
+        tt_assert( strstr( ret, "Content-Encoding" ) == 0 );
+        tt_assert( transport_layer->get_encoded_size() == strlen( ret ) );
+
+        // remember the body without the trailing CRLF
+        const char* body = strstr( ret, "\r\n\r\n" ) + 4;
+        size_t body_size = strlen( body ) - 2;
+        memcpy( expected_body, body, body_size );
+        expected_body[ body_size ] = '\0';
+    }
+
+    // above the threshold it gets compressed on its way out, after the headers
+    {
+        xi_set_request_compression( 16 );
+
+        const char* ret = http_encode_update_feed( data_layer, "apikey", &feed );
+        size_t ret_size = transport_layer->get_encoded_size();
+
+        tt_assert( ret != 0 );
+        tt_assert( xi_get_last_error() == XI_NO_ERR );
+        tt_assert( ret_size == strlen( ret ) );
+        tt_assert( strcmp( ret + ret_size - 4, "\r\n\r\n" ) == 0 );
+
+        port = mock_server_start( &mock_inflating_server, expected_body, &pid );
+        tt_assert( port != -1 );
+
+        connection_t* conn = comm_layer->open_connection( MOCK_SERVER_ADDRESS, port );
+        tt_assert( conn != 0 );
+        tt_assert( comm_layer->send_data( conn, ret, ret_size ) == ( int ) ret_size );
+        tt_assert( transport_layer->send_body( comm_layer, conn ) == 0 );
+
+        int recv = comm_layer->read_data( conn, reply, sizeof( reply ) );
+        comm_layer->close_connection( conn );
+
+        tt_assert( mock_server_wait( pid ) == 0 );
+        pid = 0;
+
+        tt_assert( recv > 0 );
+
+        const xi_response_t* response = transport_layer->decode_reply( data_layer, reply, recv );
+        tt_assert( response != 0 );
+        tt_assert( response->http.http_status == 200 );
+    }
+
+ end:
+    if( pid ) { mock_server_wait( pid ); }
+    xi_set_request_compression( 0 );
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+#endif
+
+// the server compares the body with the expected one, which may be longer than its buffer
+static int mock_streamed_body_server( int fd, void* arg )
+{
+    const char* expected = ( const char* ) arg;
+    const char* body = 0;
+    char request[ 4096 ];
+    const char request_line[] = "PUT /v2/feeds/128.csv HTTP/1.1\r\n";
+
+    int size = mock_server_read_http( fd, request, sizeof( request ), &body );
+    if( size == -1 ) { return 1; }
+    if( strncmp( request, request_line, sizeof( request_line ) - 1 ) != 0 ) { return 2; }
+    if( strncmp( body, expected, strlen( expected ) ) != 0 ) { return 3; }
+
+    const char reply[] = "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n";
+    return write( fd, reply, sizeof( reply ) - 1 ) == sizeof( reply ) - 1 ? 0 : 4;
+}
+
+void test_http_encode_update_feed_streamed(void *data)
+{
+    (void)(data);
+
+    const transport_layer_t* transport_layer    = get_http_transport_layer();
+    const data_layer_t* data_layer              = get_csv_data_layer();
+    const comm_layer_t* comm_layer              = get_comm_layer();
+
+    char expected_body[ 8 * XI_CONTENT_BUFFER_SIZE ];
+    char expected_content[ 32 ];
+    char reply[ 256 ];
+    size_t expected_size = 0;
+    pid_t pid = 0;
+    int port = 0;
+
+    // far more than fits in XI_CONTENT_BUFFER_SIZE
+    xi_feed_t feed;
+    memset( &feed, 0, sizeof( xi_feed_t ) );
+    feed.feed_id            = 128;
+    feed.datastream_count   = XI_MAX_DATASTREAMS;
+
+    for( size_t i = 0; i < feed.datastream_count; ++i )
+    {
+        xi_datastream_t* d = &feed.datastreams[ i ];
+        snprintf( d->datastream_id, sizeof( d->datastream_id ), "datastream_%d", ( int ) i );
+        d->datapoint_count = 4;
+
+        for( size_t j = 0; j < d->datapoint_count; ++j )
+        {
+            xi_set_value_i32( &d->datapoints[ j ], ( int32_t ) ( i * 100 + j ) );
+            expected_size += snprintf( expected_body + expected_size, sizeof( expected_body ) - expected_size
+                , "%s,%d\n", d->datastream_id, ( int ) ( i * 100 + j ) );
+        }
+    }
+
+    tt_assert( expected_size > XI_CONTENT_BUFFER_SIZE );
+    tt_assert( expected_size < sizeof( expected_body ) );
+
+    // only the headers are encoded, with the length of the whole body
+    const char* ret = http_encode_update_feed( data_layer, "apikey", &feed );
+    size_t ret_size = transport_layer->get_encoded_size();
+
+    tt_assert( ret != 0 );
+    tt_assert( xi_get_last_error() == XI_NO_ERR );
+    tt_assert( ret_size == strlen( ret ) );
+    tt_assert( strcmp( ret + ret_size - 4, "\r\n\r\n" ) == 0 );
+
+    snprintf( expected_content, sizeof( expected_content ), "Content-Length: %d\r\n", ( int ) expected_size );
+    tt_assert( strstr( ret, expected_content ) != 0 );
+
+    // the body follows in chunks
+    port = mock_server_start( &mock_streamed_body_server, expected_body, &pid );
+    tt_assert( port != -1 );
+
+    connection_t* conn = comm_layer->open_connection( MOCK_SERVER_ADDRESS, port );
+    tt_assert( conn != 0 );
+    tt_assert( comm_layer->send_data( conn, ret, ret_size ) == ( int ) ret_size );
+    tt_assert( transport_layer->send_body( comm_layer, conn ) == 0 );
+
+    int recv = comm_layer->read_data( conn, reply, sizeof( reply ) );
+    comm_layer->close_connection( conn );
+
+    tt_assert( mock_server_wait( pid ) == 0 );
+    pid = 0;
+
+    tt_assert( recv > 0 );
+
+    const xi_response_t* response = transport_layer->decode_reply( data_layer, reply, recv );
+    tt_assert( response != 0 );
+    tt_assert( response->http.http_status == 200 );
+
+    // once the feed fits again the body goes with the headers
+    feed.datastream_count = 1;
+
+    ret = http_encode_update_feed( data_layer, "apikey", &feed );
+    tt_assert( ret != 0 );
+    tt_assert( strstr( ret, "Content-Length: 60\r\n" ) != 0 );
+    tt_assert( strcmp( ret + strlen( ret ) - 17, "datastream_0,3\n\r\n" ) == 0 );
+
+#ifdef XI_ZLIB
+    // compressed, it's deflated in chunks on its way out as well
+    {
+        xi_set_request_compression( 16 );
+        feed.datastream_count = XI_MAX_DATASTREAMS;
+
+        ret = http_encode_update_feed( data_layer, "apikey", &feed );
+        ret_size = transport_layer->get_encoded_size();
+
+        tt_assert( ret != 0 );
+        tt_assert( xi_get_last_error() == XI_NO_ERR );
+        tt_assert( ret_size == strlen( ret ) );
+        tt_assert( strstr( ret, "Content-Encoding: gzip\r\n" ) != 0 );
+        tt_assert( strstr( ret, expected_content ) == 0 );
+
+        port = mock_server_start( &mock_inflating_server, expected_body, &pid );
+        tt_assert( port != -1 );
+
+        conn = comm_layer->open_connection( MOCK_SERVER_ADDRESS, port );
+        tt_assert( conn != 0 );
+        tt_assert( comm_layer->send_data( conn, ret, ret_size ) == ( int ) ret_size );
+        tt_assert( transport_layer->send_body( comm_layer, conn ) == 0 );
+
+        recv = comm_layer->read_data( conn, reply, sizeof( reply ) );
+        comm_layer->close_connection( conn );
+
+        tt_assert( mock_server_wait( pid ) == 0 );
+        pid = 0;
+
+        tt_assert( recv > 0 );
+
+        response = transport_layer->decode_reply( data_layer, reply, recv );
+        tt_assert( response != 0 );
+        tt_assert( response->http.http_status == 200 );
+    }
+#endif
+
+ end:
+    if( pid ) { mock_server_wait( pid ); }
+#ifdef XI_ZLIB
+    xi_set_request_compression( 0 );
+#endif
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+
+// answers the first poll of the whole feed and expects the second to be conditional
+static int mock_feed_poll_server( int fd, void* arg )
+{
+    (void)(arg);
+
+    char request[ 2048 ];
+    const char* body = 0;
+    const char request_line[] = "GET /v2/feeds/128.csv HTTP/1.1\r\n";
+
+    if( mock_server_read_http( fd, request, sizeof( request ), &body ) == -1 ) { return 1; }
+    if( strncmp( request, request_line, sizeof( request_line ) - 1 ) != 0 ) { return 2; }
+    if( strstr( request, "If-None-Match" ) != 0 ) { return 3; }
+
+    const char reply[] =
+        "HTTP/1.1 200 OK\r\n"
+        "ETag: \"4f3bd0c1\"\r\n"
+        "Content-Length: 72\r\n"
+        "\r\n"
+        "temp,2013-04-14T20:20:01.000000Z,21.5\n"
+        "hum,2013-04-14T20:20:01.000000Z,40";
+
+    if( write( fd, reply, sizeof( reply ) - 1 ) != sizeof( reply ) - 1 ) { return 4; }
+
+    // the same resource, not the datastreams the reply has listed
+    if( mock_server_read_http( fd, request, sizeof( request ), &body ) == -1 ) { return 5; }
+    if( strncmp( request, request_line, sizeof( request_line ) - 1 ) != 0 ) { return 6; }
+    if( strstr( request, "If-None-Match: \"4f3bd0c1\"\r\n" ) == 0 ) { return 7; }
+
+    const char not_modified[] = "HTTP/1.1 304 Not Modified\r\nContent-Length: 0\r\n\r\n";
+
+    if( write( fd, not_modified, sizeof( not_modified ) - 1 ) != sizeof( not_modified ) - 1 ) { return 8; }
+
+    // wait for the client to hang up
+    return read( fd, request, sizeof( request ) ) == 0 ? 0 : 9;
+}
+
+void test_http_feed_get_poll_cached(void *data)
+{
+    (void)(data);
+
+    const comm_layer_t* comm_layer = get_comm_layer();
+
+    xi_context_t* xi    = 0;
+    connection_t* conn  = 0;
+    pid_t pid           = 0;
+
+    xi_feed_t feed;
+    memset( &feed, 0, sizeof( xi_feed_t ) );
+    feed.feed_id = 128;
+
+    int port = mock_server_start( &mock_feed_poll_server, 0, &pid );
+    tt_assert( port != -1 );
+
+    xi = xi_create_context( XI_HTTP, "apikey", 128 );
+    tt_assert( xi != 0 );
+
+    conn = comm_layer->open_connection( MOCK_SERVER_ADDRESS, port );
+    tt_assert( conn != 0 );
+    xi->connection = conn;
+    conn = 0;
+
+    // the whole feed is asked for and the reply fills the datastreams in
+    const xi_response_t* response = xi_feed_get( xi, &feed );
+    tt_assert( response != 0 );
+    tt_assert( response->http.http_status == 200 );
+    tt_assert( xi_get_last_error() == XI_NO_ERR );
+    tt_assert( feed.datastream_count == 2 );
+
+    // polling with the same feed is the same request
+    response = xi_feed_get( xi, &feed );
+    tt_assert( response != 0 );
+    tt_assert( response->http.http_status == 304 );
+    tt_assert( feed.datastream_count == 2 );
+    tt_assert( strcmp( feed.datastreams[ 1 ].datastream_id, "hum" ) == 0 );
+
+    tt_assert( xi_get_cache_stats( xi ).hits == 1 );
+    tt_assert( xi_get_cache_stats( xi ).misses == 1 );
+
+    xi_delete_context( xi );
+    xi = 0;
+
+    tt_assert( mock_server_wait( pid ) == 0 );
+    pid = 0;
+
+ end:
+    if( xi ) { xi_delete_context( xi ); }
+    if( conn ) { comm_layer->close_connection( conn ); }
+    if( pid ) { mock_server_wait( pid ); }
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+
+#ifdef XI_ZLIB
+// replies with a compressed feed that doesn't fit in the reply buffer along with the headers
+static int mock_gzip_feed_server( int fd, void* arg )
+{
+    const char* feed_body = ( const char* ) arg;
+    const char* body = 0;
+    char request[ 2048 ];
+
+    if( mock_server_read_http( fd, request, sizeof( request ), &body ) == -1 ) { return 1; }
+    if( strstr( request, "Accept-Encoding: gzip, deflate\r\n" ) == 0 ) { return 2; }
+
+    unsigned char compressed[ XI_HTTP_MAX_CONTENT_SIZE ];
+    z_stream strm;
+    memset( &strm, 0, sizeof( z_stream ) );
+    if( deflateInit2( &strm, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY ) != Z_OK ) { return 3; }
+    strm.next_in    = ( Bytef* ) feed_body;
+    strm.avail_in   = strlen( feed_body );
+    strm.next_out   = compressed;
+    strm.avail_out  = sizeof( compressed );
+    int ret = deflate( &strm, Z_FINISH );
+    deflateEnd( &strm );
+    if( ret != Z_STREAM_END ) { return 4; }
+
+    // the headers end close to the end of the buffer, most of the body comes with the next reads
+    char padding[ XI_HTTP_MAX_CONTENT_SIZE ];
+    memset( padding, 'x', sizeof( padding ) );
+    padding[ XI_HTTP_MAX_CONTENT_SIZE - 128 ] = '\0';
+
+    char reply[ 2 * XI_HTTP_MAX_CONTENT_SIZE ];
+    int header_size = snprintf( reply, sizeof( reply )
+        , "HTTP/1.1 200 OK\r\n"
+          "X-Padding: %s\r\n"
+          "Content-Encoding: gzip\r\n"
+          "Content-Length: %d\r\n\r\n", padding, ( int ) strm.total_out );
+
+    if( header_size >= XI_HTTP_MAX_CONTENT_SIZE - 16 ) { return 5; }
+    if( header_size + strm.total_out < XI_HTTP_MAX_CONTENT_SIZE + 16 ) { return 6; }
+
+    memcpy( reply + header_size, compressed, strm.total_out );
+
+    int size = header_size + ( int ) strm.total_out;
+    if( write( fd, reply, size ) != size ) { return 7; }
+
+    // wait for the client to hang up
+    return read( fd, request, sizeof( request ) ) == 0 ? 0 : 8;
+}
+
+void test_http_feed_get_gzip(void *data)
+{
+    (void)(data);
+
+    const comm_layer_t* comm_layer = get_comm_layer();
+
+    xi_context_t* xi    = 0;
+    connection_t* conn  = 0;
+    pid_t pid           = 0;
+
+    char feed_body[ XI_HTTP_MAX_CONTENT_SIZE ];
+    size_t feed_body_size = 0;
+
+    for( int i = 0; i < XI_MAX_DATASTREAMS / 2; ++i )
+    {
+        feed_body_size += snprintf( feed_body + feed_body_size, sizeof( feed_body ) - feed_body_size
+            , "datastream_%d,2013-04-14T20:20:01.000000Z,%d\n", i, 20 + i );
+    }
+
+    tt_assert( feed_body_size < sizeof( feed_body ) - 1 );
+
+    // the way the server sends it, without a newline at the end
+    feed_body[ --feed_body_size ] = '\0';
+
+    xi_feed_t feed;
+    memset( &feed, 0, sizeof( xi_feed_t ) );
+    feed.feed_id = 128;
+
+    int port = mock_server_start( &mock_gzip_feed_server, feed_body, &pid );
+    tt_assert( port != -1 );
+
+    xi_set_response_compression( 1 );
+
+    xi = xi_create_context( XI_HTTP, "apikey", 128 );
+    tt_assert( xi != 0 );
+
+    conn = comm_layer->open_connection( MOCK_SERVER_ADDRESS, port );
+    tt_assert( conn != 0 );
+    xi->connection = conn;
+    conn = 0;
+
+    // the body is read and inflated a piece at a time
+    const xi_response_t* response = xi_feed_get( xi, &feed );
+    tt_assert( response != 0 );
+    tt_assert( response->http.http_status == 200 );
+    tt_assert( xi_get_last_error() == XI_NO_ERR );
+    tt_assert( strcmp( response->http.http_content, feed_body ) == 0 );
+    tt_assert( feed.datastream_count == XI_MAX_DATASTREAMS / 2 );
+    tt_assert( strcmp( feed.datastreams[ 1 ].datastream_id, "datastream_1" ) == 0 );
+
+    xi_delete_context( xi );
+    xi = 0;
+
+    tt_assert( mock_server_wait( pid ) == 0 );
+    pid = 0;
+
+ end:
+    if( xi ) { xi_delete_context( xi ); }
+    if( conn ) { comm_layer->close_connection( conn ); }
+    if( pid ) { mock_server_wait( pid ); }
+    xi_set_response_compression( 0 );
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// WEBSOCKET TESTS
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef XI_TRANSPORT_WS
+void test_ws_compute_accept(void *data)
+{
+    (void)(data);
+
+    char accept[ XI_WS_ACCEPT_SIZE ];
+    char key[ XI_WS_KEY_SIZE ];
+
+    // the example from RFC 6455
+    ws_compute_accept( "dGhlIHNhbXBsZSBub25jZQ==", accept );
+    tt_assert( strcmp( accept, "s3pPLMBiTxaQ9kYGzzhZRbK+xOo=" ) == 0 );
+
+    ws_generate_key( key );
+    tt_assert( strlen( key ) == XI_WS_KEY_SIZE - 1 );
+    tt_assert( key[ XI_WS_KEY_SIZE - 3 ] == '=' );
+
+    // the nonce comes from the platform's entropy source
+    {
+        char other[ XI_WS_KEY_SIZE ];
+        uint8_t random[ 16 ];
+
+        tt_assert( get_comm_layer()->get_random != 0 );
+        tt_assert( get_comm_layer()->get_random( random, sizeof( random ) ) == 0 );
+
+        ws_generate_key( other );
+        tt_assert( strcmp( key, other ) != 0 );
+    }
+
+ end:
+    ;
+}
+
+void test_ws_check_handshake(void *data)
+{
+    (void)(data);
+
+    static const char key[] = "dGhlIHNhbXBsZSBub25jZQ==";
+
+    // the headers are all that's waited for, whatever follows them is left alone
+    {
+        const char reply[] = "HTTP/1.1 101 Switching Protocols\r\n"
+                             "Upgrade: websocket\r\n"
+                             "Connection: Upgrade\r\n"
+                             "sec-websocket-accept:  s3pPLMBiTxaQ9kYGzzhZRbK+xOo=\r\n"
+                             "\r\n"
+                             "\x81";
+
+        tt_assert( ws_check_handshake( reply, sizeof( reply ) - 1, key ) == ( int ) sizeof( reply ) - 2 );
+        tt_assert( ws_check_handshake( reply, 40, key ) == 0 );
+    }
+
+    // a different accept or status
+    {
+        const char reply[] = "HTTP/1.1 101 Switching Protocols\r\n"
+                             "Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo\r\n"
+                             "\r\n";
+
+        tt_assert( ws_check_handshake( reply, sizeof( reply ) - 1, key ) == -1 );
+        tt_assert( xi_get_last_error() == XI_WS_HANDSHAKE_ERROR );
+        xi_set_err( XI_NO_ERR );
+    }
+
+    {
+        const char reply[] = "HTTP/1.1 200 OK\r\n"
+                             "Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=\r\n"
+                             "\r\n";
+
+        tt_assert( ws_check_handshake( reply, sizeof( reply ) - 1, key ) == -1 );
+        tt_assert( xi_get_last_error() == XI_WS_HANDSHAKE_ERROR );
+    }
+
+ end:
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+
+// reads one client frame and unmasks its payload, returns the opcode or -1
+static int mock_ws_read_frame( int fd, char* payload, size_t payload_size )
+{
+    unsigned char header[ 14 ];
+    size_t size = 0;
+    size_t offset = 2;
+
+    if( read( fd, header, 2 ) != 2 ) { return -1; }
+    if( ( header[ 1 ] & 0x80 ) == 0 ) { return -1; } // clients must mask
+
+    size = header[ 1 ] & 0x7F;
+
+    if( size == 126 )
+    {
+        if( read( fd, header + 2, 2 ) != 2 ) { return -1; }
+        size = ( header[ 2 ] << 8 ) | header[ 3 ];
+        offset = 4;
+    }
+
+    if( read( fd, header + offset, 4 ) != 4 ) { return -1; }
+    if( size + 1 > payload_size ) { return -1; }
+
+    for( size_t got = 0; got < size; )
+    {
+        int r = read( fd, payload + got, size - got );
+        if( r <= 0 ) { return -1; }
+        got += r;
+    }
+
+    for( size_t i = 0; i < size; ++i )
+    {
+        payload[ i ] ^= header[ offset + ( i & 3 ) ];
+    }
+
+    payload[ size ] = '\0';
+
+    return header[ 0 ] & 0x0F;
+}
+
+static int mock_ws_write_frame( int fd, int opcode, const char* payload )
+{
+    char frame[ 512 ];
+    size_t size = strlen( payload );
+
+    frame[ 0 ] = ( char ) ( 0x80 | opcode );
+    frame[ 1 ] = ( char ) size;
+    memcpy( frame + 2, payload, size );
+
+    return write( fd, frame, size + 2 ) == ( int ) size + 2 ? 0 : -1;
+}
+
+// accepts the upgrade, takes two requests and replies to them in reverse order
+static int mock_ws_server( int fd, void* arg )
+{
+    (void)(arg);
+
+    char request[ 1024 ];
+    char accept[ XI_WS_ACCEPT_SIZE ];
+    char key[ XI_WS_KEY_SIZE ];
+    char tokens[ 2 ][ 16 ];
+    const char* body = 0;
+
+    if( mock_server_read_http( fd, request, sizeof( request ), &body ) == -1 ) { return 1; }
+    if( strstr( request, "Upgrade: websocket\r\n" ) == 0 ) { return 2; }
+
+    const char* k = strstr( request, "Sec-WebSocket-Key: " );
+    if( k == 0 ) { return 3; }
+    memcpy( key, k + 19, XI_WS_KEY_SIZE - 1 );
+    key[ XI_WS_KEY_SIZE - 1 ] = '\0';
+    ws_compute_accept( key, accept );
+
+    char response[ 256 ];
+    int s = snprintf( response, sizeof( response )
+        , "HTTP/1.1 101 Switching Protocols\r\n"
+          "Upgrade: websocket\r\n"
+          "Connection: Upgrade\r\n"
+          "Sec-WebSocket-Accept: %s\r\n\r\n", accept );
+    if( write( fd, response, s ) != s ) { return 4; }
+
+    for( int i = 0; i < 2; ++i )
+    {
+        if( mock_ws_read_frame( fd, request, sizeof( request ) ) != XI_WS_OPCODE_TEXT ) { return 5; }
+
+        const char* t = strstr( request, "\"token\":\"" );
+        if( t == 0 || sscanf( t + 9, "%15[0-9]", tokens[ i ] ) != 1 ) { return 6; }
+
+        if( i == 0 && strstr( request
+            , "{\"method\":\"put\",\"resource\":\"/feeds/128/datastreams/temperature.csv\","
+              "\"headers\":{\"X-ApiKey\":\"apikey\"},\"body\":\"21\\n\"" ) != request ) { return 7; }
+
+        if( i == 1 && strstr( request
+            , "{\"method\":\"get\",\"resource\":\"/feeds/128/datastreams/humidity.csv\"" ) != request ) { return 8; }
+    }
+
+    // something unrelated goes first
+    if( mock_ws_write_frame( fd, XI_WS_OPCODE_PING, "" ) == -1 ) { return 9; }
+
+    snprintf( response, sizeof( response )
+        , "{\"status\":200,\"resource\":\"/feeds/128/datastreams/humidity.csv\","
+          "\"body\":\"2013-04-14T20:20:01.000000Z,55\",\"token\":\"%s\"}", tokens[ 1 ] );
+    if( mock_ws_write_frame( fd, XI_WS_OPCODE_TEXT, response ) == -1 ) { return 10; }
+
+    snprintf( response, sizeof( response ), "{\"status\":404,\"token\":\"%s\"}", tokens[ 0 ] );
+    if( mock_ws_write_frame( fd, XI_WS_OPCODE_TEXT, response ) == -1 ) { return 11; }
+
+    return mock_ws_read_frame( fd, request, sizeof( request ) ) == XI_WS_OPCODE_CLOSE ? 0 : 12;
+}
+
+void test_ws_transport_session(void *data)
+{
+    (void)(data);
+
+    const transport_layer_t* transport_layer    = get_ws_transport_layer();
+    const data_layer_t* data_layer              = get_csv_data_layer();
+    const comm_layer_t* comm_layer              = get_comm_layer();
+
+    connection_t* conn  = 0;
+    pid_t pid           = 0;
+    uint32_t ids[ 2 ];
+    int statuses[ 2 ]   = { 0, 0 };
+    int replies         = 0;
+    int skipped         = 0;
+    char buffer[ XI_HTTP_MAX_CONTENT_SIZE ];
+    size_t size         = 0;
+
+    xi_datapoint_t datapoint;
+    memset( &datapoint, 0, sizeof( xi_datapoint_t ) );
+    xi_set_value_i32( &datapoint, 21 );
+
+    int port = mock_server_start( &mock_ws_server, 0, &pid );
+    tt_assert( port != -1 );
+
+    conn = comm_layer->open_connection( MOCK_SERVER_ADDRESS, port );
+    tt_assert( conn != 0 );
+    tt_assert( transport_layer->open_session( comm_layer, conn, "apikey" ) == 0 );
+
+    // two requests in flight
+    {
+        const char* ret = transport_layer->encode_update_datastream(
+            data_layer, "apikey", 128, "temperature", &datapoint );
+        tt_assert( ret != 0 );
+        ids[ 0 ] = transport_layer->get_request_id();
+        tt_assert( comm_layer->send_data( conn, ret, transport_layer->get_encoded_size() ) > 0 );
+
+        ret = transport_layer->encode_get_datastream( data_layer, "apikey", 128, "humidity" );
+        tt_assert( ret != 0 );
+        ids[ 1 ] = transport_layer->get_request_id();
+        tt_assert( comm_layer->send_data( conn, ret, transport_layer->get_encoded_size() ) > 0 );
+
+        tt_assert( ids[ 0 ] != 0 && ids[ 1 ] != 0 && ids[ 0 ] != ids[ 1 ] );
+    }
+
+    while( replies < 2 )
+    {
+        int reply_size = transport_layer->reply_size( buffer, size );
+        tt_assert( reply_size != -1 );
+
+        if( reply_size == 0 )
+        {
+            int recv = comm_layer->read_data( conn, buffer + size, sizeof( buffer ) - size );
+            tt_assert( recv > 0 );
+            size += recv;
+            continue;
+        }
+
+        const xi_response_t* response = transport_layer->decode_reply( data_layer, buffer, reply_size );
+        tt_assert( response != 0 );
+
+        if( response->request_id == ids[ 1 ] )
+        {
+            xi_datapoint_t dp;
+            tt_assert( data_layer->decode_datapoint( response->http.http_content, &dp ) != 0 );
+            tt_assert( dp.value.i32_value == 55 );
+            statuses[ 1 ] = response->http.http_status;
+            ++replies;
+        }
+        else if( response->request_id == ids[ 0 ] )
+        {
+            statuses[ 0 ] = response->http.http_status;
+            ++replies;
+        }
+        else
+        {
+            ++skipped;
+        }
+
+        size -= reply_size;
+        memmove( buffer, buffer + reply_size, size );
+    }
+
+    tt_assert( statuses[ 0 ] == 404 );
+    tt_assert( statuses[ 1 ] == 200 );
+    tt_assert( skipped == 1 );
+
+    tt_assert( transport_layer->close_session( comm_layer, conn ) == 0 );
+    comm_layer->close_connection( conn );
+    conn = 0;
+
+    tt_assert( mock_server_wait( pid ) == 0 );
+    pid = 0;
+
+ end:
+    if( conn ) { comm_layer->close_connection( conn ); }
+    if( pid ) { mock_server_wait( pid ); }
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// TCP TESTS
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef XI_TRANSPORT_TCP
+void test_socket_api_encode_escaped(void *data)
+{
+    (void)(data);
+
+    char buffer[ 256 ];
+
+    // the datastream id is quoted like the API key
+    tt_assert( socket_api_encode_get_datastream( buffer, sizeof( buffer ), 7
+        , get_csv_data_layer(), "a\"key", 128, "te\"mp\\" ) > 0 );
+    tt_assert( strcmp( buffer
+        , "{\"method\":\"get\",\"resource\":\"/feeds/128/datastreams/te\\\"mp\\\\.csv\","
+          "\"headers\":{\"X-ApiKey\":\"a\\\"key\"},\"token\":\"7\"}" ) == 0 );
+
+    // and its escapes count against the buffer
+    tt_assert( socket_api_encode_get_datastream( buffer, 50, 7
+        , get_csv_data_layer(), "apikey", 128, "\"\"\"\"\"\"" ) == -1 );
+    tt_assert( xi_get_last_error() == XI_SOCKET_API_ENCODE_ERROR );
+
+ end:
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+
+#define TEST_TCP_REQUESTS 3
+
+// takes all the requests first and then replies to them in reverse order
+static int mock_tcp_server( int fd, void* arg )
+{
+    (void)(arg);
+
+    char request[ 2048 ];
+    char tokens[ TEST_TCP_REQUESTS ][ 16 ];
+    size_t size = 0;
+    int lines = 0;
+
+    memset( request, 0, sizeof( request ) );
+
+    while( lines < TEST_TCP_REQUESTS )
+    {
+        int r = read( fd, request + size, sizeof( request ) - size - 1 );
+        if( r <= 0 ) { return 1; }
+
+        for( int i = 0; i < r; ++i )
+        {
+            lines += request[ size + i ] == '\n';
+        }
+
+        size += r;
+    }
+
+    const char* p = request;
+
+    for( int i = 0; i < TEST_TCP_REQUESTS; ++i )
+    {
+        if( strncmp( p, "{\"method\":\"put\",\"resource\":\"/feeds/128/datastreams/temperature.csv\"", 66 ) != 0 ) { return 2; }
+
+        const char* t = strstr( p, "\"token\":\"" );
+        if( t == 0 || sscanf( t + 9, "%15[0-9]", tokens[ i ] ) != 1 ) { return 3; }
+
+        p = strchr( p, '\n' ) + 1;
+    }
+
+    for( int i = TEST_TCP_REQUESTS - 1; i >= 0; --i )
+    {
+        char reply[ 128 ];
+
+        // braces and quotes in strings must not confuse the framing
+        int s = snprintf( reply, sizeof( reply )
+            , "{\"status\":%d,\"body\":\"}{\\\"\",\"token\":\"%s\"}\r\n", 200 + i, tokens[ i ] );
+
+        if( write( fd, reply, s ) != s ) { return 4; }
+    }
+
+    // wait for the client to hang up
+    return read( fd, request, sizeof( request ) ) == 0 ? 0 : 5;
+}
+
+void test_tcp_transport_out_of_order(void *data)
+{
+    (void)(data);
+
+    const transport_layer_t* transport_layer    = get_tcp_transport_layer();
+    const data_layer_t* data_layer              = get_csv_data_layer();
+    const comm_layer_t* comm_layer              = get_comm_layer();
+
+    connection_t* conn  = 0;
+    pid_t pid           = 0;
+    uint32_t ids[ TEST_TCP_REQUESTS ];
+    int replies         = 0;
+    char buffer[ XI_HTTP_MAX_CONTENT_SIZE ];
+    size_t size         = 0;
+
+    // partial messages need more data
+    tt_assert( transport_layer->reply_size( "{\"status\":20", 12 ) == 0 );
+    tt_assert( transport_layer->reply_size( "{\"body\":\"}\"", 11 ) == 0 );
+    tt_assert( transport_layer->reply_size( "HTTP/1.1", 8 ) == -1 );
+
+    int port = mock_server_start( &mock_tcp_server, 0, &pid );
+    tt_assert( port != -1 );
+
+    conn = comm_layer->open_connection( MOCK_SERVER_ADDRESS, port );
+    tt_assert( conn != 0 );
+    tt_assert( transport_layer->open_session( comm_layer, conn, "apikey" ) == 0 );
+
+    for( int i = 0; i < TEST_TCP_REQUESTS; ++i )
+    {
+        xi_datapoint_t datapoint;
+        memset( &datapoint, 0, sizeof( xi_datapoint_t ) );
+        xi_set_value_i32( &datapoint, i );
+
+        const char* ret = transport_layer->encode_update_datastream(
+            data_layer, "apikey", 128, "temperature", &datapoint );
+        tt_assert( ret != 0 );
+        tt_assert( ret[ transport_layer->get_encoded_size() - 1 ] == '\n' );
+
+        ids[ i ] = transport_layer->get_request_id();
+        tt_assert( comm_layer->send_data( conn, ret, transport_layer->get_encoded_size() ) > 0 );
+    }
+
+    while( replies < TEST_TCP_REQUESTS )
+    {
+        int reply_size = transport_layer->reply_size( buffer, size );
+        tt_assert( reply_size != -1 );
+
+        if( reply_size == 0 )
+        {
+            int recv = comm_layer->read_data( conn, buffer + size, sizeof( buffer ) - size );
+            tt_assert( recv > 0 );
+            size += recv;
+            continue;
+        }
+
+        const xi_response_t* response = transport_layer->decode_reply( data_layer, buffer, reply_size );
+        tt_assert( response != 0 );
+        tt_assert( strcmp( response->http.http_content, "}{\"" ) == 0 );
+
+        // replies come last to first
+        tt_assert( response->request_id == ids[ TEST_TCP_REQUESTS - 1 - replies ] );
+        tt_assert( response->http.http_status == 200 + TEST_TCP_REQUESTS - 1 - replies );
+        ++replies;
+
+        size -= reply_size;
+        memmove( buffer, buffer + reply_size, size );
+    }
+
+    tt_assert( size == 0 );
+
+    tt_assert( transport_layer->close_session( comm_layer, conn ) == 0 );
+    comm_layer->close_connection( conn );
+    conn = 0;
+
+    tt_assert( mock_server_wait( pid ) == 0 );
+    pid = 0;
+
+ end:
+    if( conn ) { comm_layer->close_connection( conn ); }
+    if( pid ) { mock_server_wait( pid ); }
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+
+// takes two feed updates, sends a message without a token and then replies in reverse order
+static int mock_tcp_feeds_server( int fd, void* arg )
+{
+    (void)(arg);
+
+    char request[ 2048 ];
+    char tokens[ 2 ][ 16 ];
+    size_t size = 0;
+    int lines = 0;
+
+    memset( request, 0, sizeof( request ) );
+
+    while( lines < 2 )
+    {
+        int r = read( fd, request + size, sizeof( request ) - size - 1 );
+        if( r <= 0 ) { return 1; }
+
+        for( int i = 0; i < r; ++i )
+        {
+            lines += request[ size + i ] == '\n';
+        }
+
+        size += r;
+    }
+
+    const char* p = request;
+
+    for( int i = 0; i < 2; ++i )
+    {
+        char resource[ 64 ];
+        int s = snprintf( resource, sizeof( resource )
+            , "{\"method\":\"put\",\"resource\":\"/feeds/%d.csv\"", 128 + i );
+
+        if( strncmp( p, resource, s ) != 0 ) { return 2; }
+
+        const char* t = strstr( p, "\"token\":\"" );
+        if( t == 0 || sscanf( t + 9, "%15[0-9]", tokens[ i ] ) != 1 ) { return 3; }
+
+        p = strchr( p, '\n' ) + 1;
+    }
+
+    const char unrelated[] = "{\"status\":500}\r\n";
+    if( write( fd, unrelated, sizeof( unrelated ) - 1 ) != sizeof( unrelated ) - 1 ) { return 4; }
+
+    for( int i = 1; i >= 0; --i )
+    {
+        char reply[ 64 ];
+        int s = snprintf( reply, sizeof( reply ), "{\"status\":%d,\"token\":\"%s\"}\r\n", 200 + i, tokens[ i ] );
+
+        if( write( fd, reply, s ) != s ) { return 5; }
+    }
+
+    // wait for the client to hang up
+    return read( fd, request, sizeof( request ) ) == 0 ? 0 : 6;
+}
+
+// answers the update along with the beginning of a message that never ends
+static int mock_tcp_unread_server( int fd, void* arg )
+{
+    (void)(arg);
+
+    char request[ 1024 ];
+    char token[ 16 ];
+    size_t size = 0;
+
+    memset( request, 0, sizeof( request ) );
+
+    while( strchr( request, '\n' ) == 0 )
+    {
+        int r = read( fd, request + size, sizeof( request ) - size - 1 );
+        if( r <= 0 ) { return 1; }
+        size += r;
+    }
+
+    const char* t = strstr( request, "\"token\":\"" );
+    if( t == 0 || sscanf( t + 9, "%15[0-9]", token ) != 1 ) { return 2; }
+
+    char reply[ 128 ];
+    int s = snprintf( reply, sizeof( reply ), "{\"status\":200,\"token\":\"%s\"}\r\n{\"status\":", token );
+
+    if( write( fd, reply, s ) != s ) { return 3; }
+
+    // the client hangs up without a word
+    return read( fd, request, sizeof( request ) ) == 0 ? 0 : 4;
+}
+
+// answers the first history page and, if told to, the second one, which is asked for in advance
+static int mock_tcp_history_server( int fd, void* arg )
+{
+    int answer_second = *( const int* ) arg;
+
+    char request[ 1024 ];
+    char token[ 16 ];
+
+    for( int page = 0; page < 2; ++page )
+    {
+        size_t size = 0;
+
+        memset( request, 0, sizeof( request ) );
+
+        while( strchr( request, '\n' ) == 0 )
+        {
+            int r = read( fd, request + size, sizeof( request ) - size - 1 );
+            if( r <= 0 ) { return 1; }
+            size += r;
+        }
+
+        if( strstr( request, "\"resource\":\"/feeds/128/datastreams/temp/datapoints.csv\"" ) == 0 ) { return 2; }
+
+        const char* t = strstr( request, "\"token\":\"" );
+        if( t == 0 || sscanf( t + 9, "%15[0-9]", token ) != 1 ) { return 3; }
+
+        // the client hangs up on the second page
+        if( page == 1 && !answer_second ) { return 0; }
+
+        char reply[ 512 ];
+        int s = snprintf( reply, sizeof( reply ), "{\"status\":%d,\"body\":\"", 200 + page );
+
+        for( int i = 0; i < XI_HISTORY_PAGE_SIZE; ++i )
+        {
+            s += snprintf( reply + s, sizeof( reply ) - s
+                , "2013-04-14T20:%02d:%02d.000000Z,%d\\n", page, i, page * 100 + i );
+        }
+
+        s += snprintf( reply + s, sizeof( reply ) - s, "\",\"token\":\"%s\"}\r\n", token );
+
+        if( s >= ( int ) sizeof( reply ) || write( fd, reply, s ) != s ) { return 4; }
+    }
+
+    // wait for the client to hang up
+    return read( fd, request, sizeof( request ) ) == 0 ? 0 : 5;
+}
+
+static int stop_at_third_datapoint( const xi_datapoint_t* dp, void* user_data )
+{
+    int* count = ( int* ) user_data;
+
+    // datapoints of the first page only
+    if( dp->value.i32_value != *count ) { *count = -1; return 1; }
+
+    return ++*count == 3;
+}
+
+void test_tcp_history_stop_prefetched(void *data)
+{
+    (void)(data);
+
+    const transport_layer_t* transport_layer    = get_tcp_transport_layer();
+    const comm_layer_t* comm_layer              = get_comm_layer();
+
+    xi_context_t* xi    = 0;
+    connection_t* conn  = 0;
+    pid_t pid           = 0;
+
+    xi_timestamp_t start = { 0, 0 };
+
+    // with the second page drained and with the session broken before it came
+    for( int answer_second = 1; answer_second >= 0; --answer_second )
+    {
+        int count = 0;
+
+        int port = mock_server_start( &mock_tcp_history_server, &answer_second, &pid );
+        tt_assert( port != -1 );
+
+        xi = xi_create_context( XI_TCP, "apikey", 128 );
+        tt_assert( xi != 0 );
+
+        conn = comm_layer->open_connection( MOCK_SERVER_ADDRESS, port );
+        tt_assert( conn != 0 );
+        tt_assert( transport_layer->open_session( comm_layer, conn, "apikey" ) == 0 );
+        xi->connection = conn;
+        conn = 0;
+
+        // the reply is the one to the page the callback stopped in
+        const xi_response_t* response = xi_datastream_get_history(
+            xi, 128, "temp", &start, 0, 0, &stop_at_third_datapoint, &count );
+
+        tt_assert( response != 0 );
+        tt_assert( xi_get_last_error() == XI_NO_ERR );
+        tt_assert( count == 3 );
+        tt_assert( response->http.http_status == 200 );
+        tt_assert( strncmp( response->http.http_content, "2013-04-14T20:00:00.000000Z,0\n", 30 ) == 0 );
+
+        // the session is kept only if it's in sync
+        tt_assert( ( xi->connection != 0 ) == answer_second );
+
+        xi_delete_context( xi );
+        xi = 0;
+
+        tt_assert( mock_server_wait( pid ) == 0 );
+        pid = 0;
+    }
+
+ end:
+    if( xi ) { xi_delete_context( xi ); }
+    if( conn ) { comm_layer->close_connection( conn ); }
+    if( pid ) { mock_server_wait( pid ); }
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+
+static void record_feeds_update_status( size_t index, const xi_response_t* response, void* user_data )
+{
+    int* statuses = ( int* ) user_data;
+
+    if( index < 2 ) { statuses[ index ] = response->http.http_status; }
+}
+
+void test_tcp_feeds_update_unrelated_reply(void *data)
 {
     (void)(data);
 
-    // simple test
+    const transport_layer_t* transport_layer    = get_tcp_transport_layer();
+    const comm_layer_t* comm_layer              = get_comm_layer();
+
+    xi_context_t* xi    = 0;
+    connection_t* conn  = 0;
+    pid_t pid           = 0;
+    int statuses[ 2 ]   = { 0, 0 };
+
+    xi_feed_t feeds[ 2 ];
+    memset( feeds, 0, sizeof( feeds ) );
+
+    for( int i = 0; i < 2; ++i )
     {
-        const char expected[] =
-            "GET /v2/feeds/128/datastreams/test.csv HTTP/1.1\r\n"
-            "Host: " XI_HOST "\r\n"
-            "User-Agent: " XI_USER_AGENT "\r\n"
-            "Accept: */*\r\n"
-            "X-ApiKey: apikey\r\n";
+        feeds[ i ].feed_id                          = 128 + i;
+        feeds[ i ].datastream_count                 = 1;
+        feeds[ i ].datastreams[ 0 ].datapoint_count = 1;
+        strcpy( feeds[ i ].datastreams[ 0 ].datastream_id, "temperature" );
+        xi_set_value_i32( &feeds[ i ].datastreams[ 0 ].datapoints[ 0 ], 20 + i );
+    }
 
-        int feed_id = 128;
-        const char* ret = http_construct_request_datastream( "GET", &feed_id, "test", "apikey" );
-        tt_assert( strcmp( expected, ret ) == 0 );
+    int port = mock_server_start( &mock_tcp_feeds_server, 0, &pid );
+    tt_assert( port != -1 );
+
+    xi = xi_create_context( XI_TCP, "apikey", 128 );
+    tt_assert( xi != 0 );
+
+    // the session is already open, so the context doesn't connect on its own
+    conn = comm_layer->open_connection( MOCK_SERVER_ADDRESS, port );
+    tt_assert( conn != 0 );
+    tt_assert( transport_layer->open_session( comm_layer, conn, "apikey" ) == 0 );
+    xi->connection = conn;
+    conn = 0;
+
+    // the message without a token is no reply to either update
+    tt_assert( xi_feeds_update( xi, feeds, 2, &record_feeds_update_status, statuses ) != 0 );
+    tt_assert( statuses[ 0 ] == 200 );
+    tt_assert( statuses[ 1 ] == 201 );
+
+    xi_delete_context( xi );
+    xi = 0;
+
+    tt_assert( mock_server_wait( pid ) == 0 );
+    pid = 0;
+
+ end:
+    if( xi ) { xi_delete_context( xi ); }
+    if( conn ) { comm_layer->close_connection( conn ); }
+    if( pid ) { mock_server_wait( pid ); }
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+
+void test_tcp_session_left_with_unread_data(void *data)
+{
+    (void)(data);
+
+    const transport_layer_t* transport_layer    = get_tcp_transport_layer();
+    const comm_layer_t* comm_layer              = get_comm_layer();
+
+    xi_context_t* xi    = 0;
+    connection_t* conn  = 0;
+    pid_t pid           = 0;
+
+    xi_datapoint_t datapoint;
+    memset( &datapoint, 0, sizeof( datapoint ) );
+    xi_set_value_i32( &datapoint, 21 );
+
+    int port = mock_server_start( &mock_tcp_unread_server, 0, &pid );
+    tt_assert( port != -1 );
+
+    xi = xi_create_context( XI_TCP, "apikey", 128 );
+    tt_assert( xi != 0 );
+
+    conn = comm_layer->open_connection( MOCK_SERVER_ADDRESS, port );
+    tt_assert( conn != 0 );
+    tt_assert( transport_layer->open_session( comm_layer, conn, "apikey" ) == 0 );
+    xi->connection = conn;
+    conn = 0;
+
+    // the reply is there, but the session can't go on from the middle of the next message
+    const xi_response_t* response = xi_datastream_update( xi, 128, "temperature", &datapoint );
+    tt_assert( response != 0 );
+    tt_assert( response->http.http_status == 200 );
+    tt_assert( xi->connection == 0 );
+
+    tt_assert( mock_server_wait( pid ) == 0 );
+    pid = 0;
+
+ end:
+    if( xi ) { xi_delete_context( xi ); }
+    if( conn ) { comm_layer->close_connection( conn ); }
+    if( pid ) { mock_server_wait( pid ); }
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+#endif
+
+#ifdef XI_TRANSPORT_MQTT
+// reads a whole MQTT packet, returns its size and the offset of the variable header in `*header`
+static int mock_mqtt_read_packet( int fd, unsigned char* buffer, size_t buffer_size, size_t* header )
+{
+    size_t size         = 0;
+    size_t remaining    = 0;
+    size_t multiplier   = 1;
+
+    if( read( fd, buffer, 1 ) != 1 ) { return -1; }
+
+    for( size = 1; ; ++size )
+    {
+        if( size > 4 || read( fd, buffer + size, 1 ) != 1 ) { return -1; }
+
+        remaining += ( buffer[ size ] & 0x7F ) * multiplier;
+        multiplier <<= 7;
+
+        if( ( buffer[ size ] & 0x80 ) == 0 ) { break; }
     }
 
-    // simple test2
+    *header = ++size;
+
+    if( size + remaining > buffer_size ) { return -1; }
+
+    while( remaining )
     {
-        const char expected[] =
-            "GET /v2/feeds/128/datastreams.csv HTTP/1.1\r\n"
-            "Host: " XI_HOST "\r\n"
-            "User-Agent: " XI_USER_AGENT "\r\n"
-            "Accept: */*\r\n"
-            "X-ApiKey: apikey\r\n";
+        int r = read( fd, buffer + size, remaining );
+        if( r <= 0 ) { return -1; }
+        size += r;
+        remaining -= r;
+    }
 
-        int feed_id = 128;
-        const char* ret = http_construct_request_datastream( "GET", &feed_id, 0, "apikey" );
-        tt_assert( strcmp( expected, ret ) == 0 );
+    return ( int ) size;
+}
+
+static int mock_mqtt_broker( int fd, void* arg )
+{
+    (void)(arg);
+
+    unsigned char packet[ 512 ];
+    size_t h = 0;
+    int s = 0;
+
+    // CONNECT with clean session and the API key as the user name
+    s = mock_mqtt_read_packet( fd, packet, sizeof( packet ), &h );
+    if( s == -1 || packet[ 0 ] != 0x10 ) { return 1; }
+    if( memcmp( packet + h, "\0\6MQIsdp\3\x82\0\0", 12 ) != 0 ) { return 2; }
+
+    size_t id_size = ( packet[ h + 12 ] << 8 ) | packet[ h + 13 ];
+    if( id_size == 0 || id_size > 23 ) { return 3; }
+    if( memcmp( packet + h + 14 + id_size, "\0\6apikey", 8 ) != 0 ) { return 4; }
+
+    if( write( fd, "\x20\x02\x00\x00", 4 ) != 4 ) { return 5; }
+
+    // QoS 1 datastream update
+    s = mock_mqtt_read_packet( fd, packet, sizeof( packet ), &h );
+    if( s == -1 || packet[ 0 ] != 0x32 ) { return 6; }
+
+    static const char topic[] = "\0\x22/v2/feeds/128/datastreams/temp.csv";
+    if( memcmp( packet + h, topic, sizeof( topic ) - 1 ) != 0 ) { return 7; }
+
+    const unsigned char* id = packet + h + sizeof( topic ) - 1;
+    if( s - ( id + 2 - packet ) != 3 || memcmp( id + 2, "42\n", 3 ) != 0 ) { return 8; }
+
+    // unrelated packet first, the client has to skip it
+    unsigned char puback[] = { 0xD0, 0x00, 0x40, 0x02, id[ 0 ], id[ 1 ] };
+    if( write( fd, puback, sizeof( puback ) ) != sizeof( puback ) ) { return 9; }
+
+    // QoS 0 feed update
+    s = mock_mqtt_read_packet( fd, packet, sizeof( packet ), &h );
+    if( s == -1 || packet[ 0 ] != 0x30 ) { return 10; }
+
+    static const char feed[] = "\0\x11/v2/feeds/128.csvtemp,1\nhum,2\n";
+    if( ( size_t ) s - h != sizeof( feed ) - 1 || memcmp( packet + h, feed, s - h ) != 0 ) { return 11; }
+
+    // DISCONNECT
+    s = mock_mqtt_read_packet( fd, packet, sizeof( packet ), &h );
+    if( s != 2 || packet[ 0 ] != 0xE0 ) { return 12; }
+
+    return read( fd, packet, sizeof( packet ) ) == 0 ? 0 : 13;
+}
+
+void test_mqtt_transport_publish(void *data)
+{
+    (void)(data);
+
+    const transport_layer_t* transport_layer    = get_mqtt_transport_layer();
+    const data_layer_t* data_layer              = get_csv_data_layer();
+    const comm_layer_t* comm_layer              = get_comm_layer();
+
+    connection_t* conn  = 0;
+    pid_t pid           = 0;
+    char buffer[ 64 ];
+    size_t size         = 0;
+
+    xi_datapoint_t datapoint;
+    memset( &datapoint, 0, sizeof( datapoint ) );
+
+    // only updates can be published
+    tt_assert( transport_layer->encode_get_datastream( data_layer, "apikey", 128, "temp" ) == 0 );
+    tt_assert( xi_get_last_error() == XI_MQTT_UNSUPPORTED_REQUEST );
+
+    int port = mock_server_start( &mock_mqtt_broker, 0, &pid );
+    tt_assert( port != -1 );
+
+    conn = comm_layer->open_connection( MOCK_SERVER_ADDRESS, port );
+    tt_assert( conn != 0 );
+    tt_assert( transport_layer->open_session( comm_layer, conn, "apikey" ) == 0 );
+
+    // QoS 1, the reply is the acknowledgement
+    xi_set_mqtt_qos( 1 );
+    xi_set_value_i32( &datapoint, 42 );
+
+    const char* ret = transport_layer->encode_update_datastream(
+        data_layer, "apikey", 128, "temp", &datapoint );
+    tt_assert( ret != 0 );
+    tt_assert( transport_layer->get_immediate_reply() == 0 );
+
+    uint32_t id = transport_layer->get_request_id();
+    tt_assert( id != 0 );
+    tt_assert( comm_layer->send_data( conn, ret, transport_layer->get_encoded_size() ) > 0 );
+
+    for( ;; )
+    {
+        int reply_size = transport_layer->reply_size( buffer, size );
+        tt_assert( reply_size != -1 );
+
+        if( reply_size == 0 )
+        {
+            int recv = comm_layer->read_data( conn, buffer + size, sizeof( buffer ) - size );
+            tt_assert( recv > 0 );
+            size += recv;
+            continue;
+        }
+
+        const xi_response_t* response = transport_layer->decode_reply( data_layer, buffer, reply_size );
+        tt_assert( response != 0 );
+
+        size -= reply_size;
+        memmove( buffer, buffer + reply_size, size );
+
+        if( response->request_id == 0 ) { continue; }
+
+        tt_assert( response->request_id == id );
+        tt_assert( response->http.http_status == 200 );
+        break;
     }
 
+    // QoS 0, nothing comes back
+    xi_set_mqtt_qos( 0 );
+
+    xi_feed_t feed;
+    memset( &feed, 0, sizeof( feed ) );
+    feed.feed_id            = 128;
+    feed.datastream_count   = 2;
+
+    strcpy( feed.datastreams[ 0 ].datastream_id, "temp" );
+    strcpy( feed.datastreams[ 1 ].datastream_id, "hum" );
+    xi_set_value_i32( &feed.datastreams[ 0 ].datapoints[ 0 ], 1 );
+    xi_set_value_i32( &feed.datastreams[ 1 ].datapoints[ 0 ], 2 );
+    feed.datastreams[ 0 ].datapoint_count = 1;
+    feed.datastreams[ 1 ].datapoint_count = 1;
+
+    ret = transport_layer->encode_update_feed( data_layer, "apikey", &feed );
+    tt_assert( ret != 0 );
+    tt_assert( comm_layer->send_data( conn, ret, transport_layer->get_encoded_size() ) > 0 );
+
+    // it's only a status, put in the response the replies are decoded into
+    const xi_response_t* response = transport_layer->get_immediate_reply();
+    tt_assert( response == get_transport_response() );
+    tt_assert( response->http.http_status == 202 );
+    tt_assert( strcmp( response->http.http_status_string, "Accepted" ) == 0 );
+    tt_assert( response->request_id == 0 );
+
+    tt_assert( transport_layer->close_session( comm_layer, conn ) == 0 );
+    comm_layer->close_connection( conn );
+    conn = 0;
+
+    tt_assert( mock_server_wait( pid ) == 0 );
+    pid = 0;
+
  end:
+    if( conn ) { comm_layer->close_connection( conn ); }
+    if( pid ) { mock_server_wait( pid ); }
+    xi_set_mqtt_qos( 0 );
     xi_set_err( XI_NO_ERR );
     ;
 }
 
-void test_http_construct_content(void *data)
+// takes a QoS 0 publish, which has no reply
+static int mock_mqtt_qos0_broker( int fd, void* arg )
+{
+    (void)(arg);
+
+    unsigned char packet[ 512 ];
+    size_t h = 0;
+    int s = 0;
+
+    s = mock_mqtt_read_packet( fd, packet, sizeof( packet ), &h );
+    if( s == -1 || packet[ 0 ] != 0x10 ) { return 1; }
+    if( write( fd, "\x20\x02\x00\x00", 4 ) != 4 ) { return 2; }
+
+    s = mock_mqtt_read_packet( fd, packet, sizeof( packet ), &h );
+    if( s == -1 || packet[ 0 ] != 0x30 ) { return 3; }
+
+    s = mock_mqtt_read_packet( fd, packet, sizeof( packet ), &h );
+    if( s != 2 || packet[ 0 ] != 0xE0 ) { return 4; }
+
+    return read( fd, packet, sizeof( packet ) ) == 0 ? 0 : 5;
+}
+
+void test_mqtt_immediate_reply_closes_circuit(void *data)
 {
     (void)(data);
 
-    // simple test
+    const transport_layer_t* transport_layer    = get_mqtt_transport_layer();
+    const comm_layer_t* comm_layer              = get_comm_layer();
+
+    xi_context_t* xi    = 0;
+    connection_t* conn  = 0;
+    pid_t pid           = 0;
+
+    xi_feed_t feed;
+    memset( &feed, 0, sizeof( feed ) );
+    feed.feed_id                            = 128;
+    feed.datastream_count                   = 1;
+    feed.datastreams[ 0 ].datapoint_count   = 1;
+    strcpy( feed.datastreams[ 0 ].datastream_id, "temp" );
+    xi_set_value_i32( &feed.datastreams[ 0 ].datapoints[ 0 ], 1 );
+
+    xi_set_circuit_breaker( 3, 1000 );
+    xi_set_mqtt_qos( 0 );
+
+    // failures that aren't in a row
+    xi_circuit_t* circuit = xi_circuit_breaker_get( XI_HOST, XI_MQTT_PORT, comm_layer->get_time_ms() );
+    xi_circuit_breaker_failure( circuit, comm_layer->get_time_ms() );
+    xi_circuit_breaker_failure( circuit, comm_layer->get_time_ms() );
+
+    int port = mock_server_start( &mock_mqtt_qos0_broker, 0, &pid );
+    tt_assert( port != -1 );
+
+    xi = xi_create_context( XI_MQTT, "apikey", 128 );
+    tt_assert( xi != 0 );
+
+    conn = comm_layer->open_connection( MOCK_SERVER_ADDRESS, port );
+    tt_assert( conn != 0 );
+    tt_assert( transport_layer->open_session( comm_layer, conn, "apikey" ) == 0 );
+    xi->connection = conn;
+    conn = 0;
+
+    // the publish that went out counts as an answer
+    const xi_response_t* response = xi_feed_update( xi, &feed );
+    tt_assert( response != 0 );
+    tt_assert( response->http.http_status == 202 );
+    tt_assert( circuit->failures == 0 );
+
+    xi_circuit_breaker_failure( circuit, comm_layer->get_time_ms() );
+    tt_assert( xi_circuit_breaker_allow( circuit, comm_layer->get_time_ms() ) );
+
+    xi_delete_context( xi );
+    xi = 0;
+
+    tt_assert( mock_server_wait( pid ) == 0 );
+    pid = 0;
+
+ end:
+    if( xi ) { xi_delete_context( xi ); }
+    if( conn ) { comm_layer->close_connection( conn ); }
+    if( pid ) { mock_server_wait( pid ); }
+    xi_set_circuit_breaker( 0, 30000 );
+    xi_circuit_breaker_reset();
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// CSV TESTS
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+// RATE LIMITER TESTS
+///////////////////////////////////////////////////////////////////////////////
+
+void test_rate_limiter(void *data)
+{
+    (void)(data);
+
+    xi_rate_limiter_reset();
+
+    // a request a second, two at once
+    xi_set_rate_limit( 60, 2 );
+
     {
-        const char expected[] =
-            "Content-Type: text/plain\r\n"
-            "Content-Length: 128\r\n";
+        xi_rate_bucket_t* bucket = xi_rate_limiter_get( "apikey", 0 );
+
+        tt_assert( xi_rate_limiter_get( "apikey", 0 ) == bucket );
+        tt_assert( xi_rate_limiter_get( "other", 0 ) != bucket );
+
+        tt_assert( xi_rate_limiter_delay( bucket, 0 ) == 0 );
+        xi_rate_limiter_take( bucket, 0 );
+        tt_assert( xi_rate_limiter_delay( bucket, 0 ) == 0 );
+        xi_rate_limiter_take( bucket, 0 );
+
+        // the burst is used up
+        tt_assert( xi_rate_limiter_delay( bucket, 0 ) == 1000 );
+        tt_assert( xi_rate_limiter_delay( bucket, 400 ) == 600 );
+        tt_assert( xi_rate_limiter_delay( bucket, 1000 ) == 0 );
+        xi_rate_limiter_take( bucket, 1000 );
+
+        // 429 blocks it for as long as it says and the bucket fills up from then on
+        xi_rate_limiter_update( bucket, 1500, 429, "5" );
+        tt_assert( xi_rate_limiter_delay( bucket, 1500 ) == 5000 + 1000 );
+        tt_assert( xi_rate_limiter_delay( bucket, 7500 ) == 0 );
+
+        // other statuses don't matter
+        xi_rate_limiter_take( bucket, 7500 );
+        xi_rate_limiter_update( bucket, 7500, 500, "60" );
+        tt_assert( xi_rate_limiter_delay( bucket, 8000 ) == 500 );
+    }
 
-        const char* ret = http_construct_content( 128 );
-        tt_assert( strcmp( expected, ret ) == 0 );
+    // without a limit only the server is listened to, 503 with a date waits the default
+    xi_set_rate_limit( 0, 0 );
+
+    {
+        xi_rate_bucket_t* bucket = xi_rate_limiter_get( "other", 0 );
+
+        tt_assert( xi_rate_limiter_delay( bucket, 0 ) == 0 );
+
+        xi_rate_limiter_update( bucket, 0xFFFFFF00, 503, "Wed, 21 Oct 2015 07:28:00 GMT" );
+        tt_assert( xi_rate_limiter_delay( bucket, 0xFFFFFF00 ) == XI_RATE_LIMIT_BACKOFF );
+
+        // past the wrap around of the clock
+        tt_assert( xi_rate_limiter_delay( bucket, 0xFFFFFF00 + XI_RATE_LIMIT_BACKOFF ) == 0 );
     }
 
  end:
+    xi_set_rate_limit( 0, 0 );
+    xi_rate_limiter_reset();
     xi_set_err( XI_NO_ERR );
     ;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-// CSV TESTS
+// CIRCUIT BREAKER TESTS
+///////////////////////////////////////////////////////////////////////////////
+
+void test_circuit_breaker(void *data)
+{
+    (void)(data);
+
+    xi_set_circuit_breaker( 3, 1000 );
+
+    {
+        xi_circuit_t* circuit = xi_circuit_breaker_get( "api.xively.com", 80, 0 );
+
+        tt_assert( xi_circuit_breaker_get( "api.xively.com", 80, 0 ) == circuit );
+        tt_assert( xi_circuit_breaker_get( "api.xively.com", 8081, 0 ) != circuit );
+
+        // an answer in between starts the count again
+        xi_circuit_breaker_failure( circuit, 0 );
+        xi_circuit_breaker_failure( circuit, 0 );
+        xi_circuit_breaker_success( circuit );
+        xi_circuit_breaker_failure( circuit, 0 );
+        xi_circuit_breaker_failure( circuit, 0 );
+        tt_assert( xi_circuit_breaker_allow( circuit, 0 ) );
+
+        // the third one in a row cuts it off for the cooldown
+        xi_circuit_breaker_failure( circuit, 100 );
+        tt_assert( !xi_circuit_breaker_allow( circuit, 100 ) );
+        tt_assert( !xi_circuit_breaker_allow( circuit, 1099 ) );
+
+        // then a probe goes through, a failed one cuts it off straight away
+        tt_assert( xi_circuit_breaker_allow( circuit, 1100 ) );
+        tt_assert( circuit->state == XI_CIRCUIT_HALF_OPEN );
+        xi_circuit_breaker_failure( circuit, 1200 );
+        tt_assert( !xi_circuit_breaker_allow( circuit, 1200 ) );
+
+        // and an answered one lets everything through
+        tt_assert( xi_circuit_breaker_allow( circuit, 2200 ) );
+        xi_circuit_breaker_success( circuit );
+        tt_assert( circuit->state == XI_CIRCUIT_CLOSED );
+        tt_assert( xi_circuit_breaker_allow( circuit, 2200 ) );
+    }
+
+ end:
+    xi_set_circuit_breaker( 0, 30000 );
+    ;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
+// RETRY TESTS
+///////////////////////////////////////////////////////////////////////////////
+
+void test_retry_policy(void *data)
+{
+    (void)(data);
+
+    xi_retry_policy_t policy = { 5, 100, 1000, 0 };
+
+    // the first wait is the base, then up to three times the previous one
+    tt_assert( xi_retry_delay( &policy, 0, 0 ) == 100 );
+    tt_assert( xi_retry_delay( &policy, 0, 12345 ) <= 300 );
+    tt_assert( xi_retry_delay( &policy, 200, 0 ) == 100 );
+    tt_assert( xi_retry_delay( &policy, 200, 500 ) == 100 + 500 % 501 );
+
+    // but never more than the cap
+    for( uint32_t r = 0, previous = 0; r < 1000; ++r )
+    {
+        previous = xi_retry_delay( &policy, previous, xi_random() );
+
+        tt_assert( previous >= 100 );
+        tt_assert( previous <= 1000 );
+    }
+
+    // a cap below the base is the base
+    policy.max_delay = 10;
+    tt_assert( xi_retry_delay( &policy, 500, 777 ) == 100 );
+
+    tt_assert( xi_retry_is_transient_status( 503 ) );
+    tt_assert( xi_retry_is_transient_status( 429 ) );
+    tt_assert( !xi_retry_is_transient_status( 200 ) );
+    tt_assert( !xi_retry_is_transient_status( 404 ) );
+    tt_assert( !xi_retry_is_transient_status( 500 ) );
+
+    tt_assert( xi_retry_is_transient_error( XI_SOCKET_CONNECTION_ERROR ) );
+    tt_assert( xi_retry_is_transient_error( XI_SOCKET_READ_ERROR ) );
+    tt_assert( !xi_retry_is_transient_error( XI_HTTP_CONSTRUCT_REQUEST_BUFFER_OVERRUN ) );
+    tt_assert( !xi_retry_is_transient_error( XI_RATE_LIMITED ) );
+
+    // the context doesn't retry until asked to
+    {
+        xi_context_t* xi = xi_create_context( XI_HTTP, "apikey", 1 );
+        tt_assert( xi != 0 );
+
+        tt_assert( xi->retry_policy.max_attempts == 0 );
+        tt_assert( xi_get_retry_stats( xi ).retries == 0 );
+
+        policy.max_attempts = 3;
+        xi_set_retry_policy( xi, &policy );
+        tt_assert( xi->retry_policy.max_attempts == 3 );
+
+        xi_delete_context( xi );
+    }
+
+ end:
+    ;
+}
 
 void test_csv_decode_datapoint(void *data)
 {
@@ -374,13 +2655,138 @@ void test_csv_decode_datapoint_error( void * data )
         // call function
         const xi_datapoint_t* o = csv_decode_datapoint( test_data, &data_point );
 
-        // test values
-        tt_assert( o == 0 );
-        tt_assert( XI_CSV_DECODE_DATAPOINT_PARSER_ERROR == xi_get_last_error() );
+        // test values
+        tt_assert( o == 0 );
+        tt_assert( XI_CSV_DECODE_DATAPOINT_PARSER_ERROR == xi_get_last_error() );
+    }
+
+    /* Every test-case function needs to finish with an "end:"
+       label and (optionally) code to clean up local variables. */
+ end:
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+
+void test_csv_decode_feed( void * data )
+{
+    (void)(data);
+
+    xi_feed_t feed;
+    memset( &feed, 0, sizeof( xi_feed_t ) );
+
+    { // the scanner finds every delimiter, a chunk at a time when the index is small
+        const char test_data[] = "a,b\n,,c,,,,,,,,,,,,,,,,,,,,\nd";
+        uint32_t index[ 4 ];
+        size_t scanned  = 0;
+        size_t offset   = 0;
+        size_t found    = 0;
+
+        while( offset < sizeof( test_data ) - 1 )
+        {
+            size_t n = csv_scan_delimiters( test_data + offset, sizeof( test_data ) - 1 - offset
+                , index, 4, &scanned );
+
+            for( size_t i = 0; i < n; ++i )
+            {
+                char c = test_data[ offset + index[ i ] ];
+                tt_assert( c == ',' || c == '\n' );
+            }
+
+            found  += n;
+            offset += scanned;
+        }
+
+        tt_assert( found == 25 );
+    }
+
+    { // the value may have commas of its own
+        const char test_data[] =
+            "temp,2013-01-01T18:44:21.423452Z,21.5\n"
+            "note,2013-01-01T18:44:22.000001Z,a, b\n"
+            "count,2013-01-01T18:44:23.000000Z,-7";
+
+        tt_assert( csv_decode_feed( test_data, &feed ) == &feed );
+        tt_assert( feed.datastream_count == 3 );
+
+        tt_assert( strcmp( feed.datastreams[ 0 ].datastream_id, "temp" ) == 0 );
+        tt_assert( feed.datastreams[ 0 ].datapoints[ 0 ].value_type == XI_VALUE_TYPE_F32 );
+
+        tt_assert( strcmp( feed.datastreams[ 1 ].datastream_id, "note" ) == 0 );
+        tt_assert( strcmp( feed.datastreams[ 1 ].datapoints[ 0 ].value.str_value, "a, b" ) == 0 );
+        tt_assert( feed.datastreams[ 1 ].datapoints[ 0 ].timestamp.micro == 1 );
+
+        tt_assert( strcmp( feed.datastreams[ 2 ].datastream_id, "count" ) == 0 );
+        tt_assert( feed.datastreams[ 2 ].datapoints[ 0 ].value.i32_value == -7 );
+    }
+
+    { // a line without a timestamp doesn't borrow the fields of the next one
+        const char test_data[] =
+            "temp,21.5\n"
+            "count,2013-01-01T18:44:23.000000Z,-7";
+
+        tt_assert( csv_decode_feed( test_data, &feed ) == 0 );
+        tt_assert( XI_CSV_DECODE_FEED_PARSER_ERROR == xi_get_last_error() );
+    }
+
+    { // the lines of one datastream make one datastream with all their datapoints
+        const char test_data[] =
+            "temp,2013-01-01T18:44:21.000000Z,21.5\n"
+            "temp,2013-01-01T18:44:22.000000Z,21.6\n"
+            "temp,2013-01-01T18:44:23.000000Z,21.7\n"
+            "count,2013-01-01T18:44:23.000000Z,-7\n"
+            "temp,2013-01-01T18:44:24.000000Z,21.8";
+
+        tt_assert( csv_decode_feed( test_data, &feed ) == &feed );
+        tt_assert( feed.datastream_count == 3 );
+
+        tt_assert( strcmp( feed.datastreams[ 0 ].datastream_id, "temp" ) == 0 );
+        tt_assert( feed.datastreams[ 0 ].datapoint_count == 3 );
+        tt_assert( feed.datastreams[ 0 ].datapoints[ 2 ].value.f32_value == 21.7f );
+        tt_assert( feed.datastreams[ 0 ].datapoints[ 2 ].timestamp.timestamp == 1357065863 );
+
+        tt_assert( feed.datastreams[ 1 ].datapoint_count == 1 );
+        tt_assert( feed.datastreams[ 2 ].datapoint_count == 1 );
+    }
+
+    { // as many datastreams and datapoints as there is room for, but not more
+        char test_data[ ( XI_MAX_DATAPOINTS + XI_MAX_DATASTREAMS + 1 ) * 40 ];
+        size_t offset = 0;
+
+        for( int i = 0; i < XI_MAX_DATAPOINTS; ++i )
+        {
+            offset += sprintf( test_data + offset, "a,2013-01-01T18:44:%02d.000000Z,%d\n", i, i );
+        }
+
+        for( int i = 1; i < XI_MAX_DATASTREAMS; ++i )
+        {
+            offset += sprintf( test_data + offset, "s%d,2013-01-01T18:44:21.000000Z,%d\n", i, i );
+        }
+
+        test_data[ offset - 1 ] = '\0';
+
+        tt_assert( csv_decode_feed( test_data, &feed ) == &feed );
+        tt_assert( feed.datastream_count == XI_MAX_DATASTREAMS );
+        tt_assert( feed.datastreams[ 0 ].datapoint_count == XI_MAX_DATAPOINTS );
+        tt_assert( feed.datastreams[ 0 ].datapoints[ XI_MAX_DATAPOINTS - 1 ].value.i32_value == XI_MAX_DATAPOINTS - 1 );
+
+        sprintf( test_data + offset - 1, "\nx,2013-01-01T18:44:21.000000Z,1" );
+
+        tt_assert( csv_decode_feed( test_data, &feed ) == 0 );
+        tt_assert( XI_CSV_DECODE_FEED_PARSER_ERROR == xi_get_last_error() );
+        xi_set_err( XI_NO_ERR );
+
+        sprintf( test_data, "b,2013-01-01T18:44:21.000000Z,1\n" );
+        offset = strlen( test_data );
+
+        for( int i = 0; i <= XI_MAX_DATAPOINTS; ++i )
+        {
+            offset += sprintf( test_data + offset, "%sa,2013-01-01T18:44:21.000000Z,%d", i ? "\n" : "", i );
+        }
+
+        tt_assert( csv_decode_feed( test_data, &feed ) == 0 );
+        tt_assert( XI_CSV_DECODE_FEED_PARSER_ERROR == xi_get_last_error() );
     }
 
-    /* Every test-case function needs to finish with an "end:"
-       label and (optionally) code to clean up local variables. */
  end:
     xi_set_err( XI_NO_ERR );
     ;
@@ -481,6 +2887,413 @@ void test_csv_encode_datapoint( void* data )
     ;
 }
 
+void test_json_encode( void* data )
+{
+    (void)(data);
+
+    xi_datapoint_t data_point;
+    memset( &data_point, 0, sizeof( xi_datapoint_t ) );
+
+    { // the value goes as a string, the way the API echoes it back
+        xi_set_value_f32( &data_point, 21.5f );
+        data_point.timestamp.timestamp  = 1365970801;
+        data_point.timestamp.micro      = 0;
+
+        const char* o = json_encode_datapoint( &data_point );
+
+        tt_assert( o != 0 );
+        tt_assert( strcmp( o, "{\"current_value\":\"21.5\",\"at\":\"2013-04-14T20:20:01.000000Z\"}" ) == 0 );
+    }
+
+    { // strings are escaped, no timestamp means no "at"
+        memset( &data_point, 0, sizeof( xi_datapoint_t ) );
+        xi_set_value_str( &data_point, "a \"b\"\n" );
+
+        const char* o = json_encode_create_datastream( "temp", &data_point );
+
+        tt_assert( o != 0 );
+        tt_assert( strcmp( o, "{\"version\":\"1.0.0\",\"datastreams\":[{\"id\":\"temp\",\"current_value\":\"a \\\"b\\\"\\n\"}]}" ) == 0 );
+    }
+
+    { // the buffer is too small
+        char buffer[ 16 ];
+        xi_set_value_i32( &data_point, 216 );
+
+        tt_assert( json_encode_datapoint_in_place( buffer, sizeof( buffer ), &data_point ) == -1 );
+        tt_assert( XI_JSON_ENCODE_DATAPOINT_BUFFER_OVERRUN == xi_get_last_error() );
+    }
+
+ end:
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+
+void test_json_decode( void* data )
+{
+    (void)(data);
+
+    xi_feed_t feed;
+    memset( &feed, 0, sizeof( xi_feed_t ) );
+
+    xi_datapoint_t data_point;
+    memset( &data_point, 0, sizeof( xi_datapoint_t ) );
+
+    { // the fields which aren't kept are skipped, whatever they hold
+        const char test_data[] =
+            "{\"id\":504,\"title\":\"t\",\"datastreams\":["
+                "{\"id\":\"temp\",\"current_value\":\"21.5\",\"at\":\"2013-01-01T18:44:21.423452Z\""
+                    ",\"tags\":[\"a\",\"b\"],\"unit\":{\"label\":\"C\",\"x\":[{},[]]}},"
+                "{ \"id\" : \"n\\u00e9\\ud83d\\ude00\" , \"current_value\" : -7 },"
+                "{\"id\":\"big\",\"current_value\":1e3,\"private\":false}"
+            "]}";
+
+        tt_assert( json_decode_feed( test_data, &feed ) == &feed );
+        tt_assert( feed.datastream_count == 3 );
+
+        tt_assert( strcmp( feed.datastreams[ 0 ].datastream_id, "temp" ) == 0 );
+        tt_assert( feed.datastreams[ 0 ].datapoint_count == 1 );
+        tt_assert( feed.datastreams[ 0 ].datapoints[ 0 ].value_type == XI_VALUE_TYPE_F32 );
+        tt_assert( feed.datastreams[ 0 ].datapoints[ 0 ].timestamp.timestamp == 1357065861 );
+        tt_assert( feed.datastreams[ 0 ].datapoints[ 0 ].timestamp.micro == 423452 );
+
+        tt_assert( strcmp( feed.datastreams[ 1 ].datastream_id, "n\xc3\xa9\xf0\x9f\x98\x80" ) == 0 );
+        tt_assert( feed.datastreams[ 1 ].datapoints[ 0 ].value_type == XI_VALUE_TYPE_I32 );
+        tt_assert( feed.datastreams[ 1 ].datapoints[ 0 ].value.i32_value == -7 );
+
+        tt_assert( feed.datastreams[ 2 ].datapoints[ 0 ].value_type == XI_VALUE_TYPE_F32 );
+        tt_assert( feed.datastreams[ 2 ].datapoints[ 0 ].value.f32_value == 1000.0f );
+    }
+
+    { // a datapoint as it comes from the datapoints resource
+        const char test_data[] = "{\"value\":\"42\",\"at\":\"2013-01-01T18:44:21.000001Z\"}";
+
+        tt_assert( json_decode_datapoint( test_data, &data_point ) == &data_point );
+        tt_assert( data_point.value_type == XI_VALUE_TYPE_I32 );
+        tt_assert( data_point.value.i32_value == 42 );
+        tt_assert( data_point.timestamp.micro == 1 );
+    }
+
+    { // broken documents are refused before anything is taken from them
+        const char* broken[] = {
+              "{\"value\":\"42\""
+            , "{\"value\":\"42\",}"
+            , "{\"value\" \"42\"}"
+            , "{\"value\":\"42\"}}"
+            , "{\"value\":\"4\\x\"}"
+            , "{\"value\":01}"
+            , "{\"value\":tru}"
+            , "{\"at\":\"2013-01-01T18:44:21Z\"}"
+        };
+
+        for( size_t i = 0; i < sizeof( broken ) / sizeof( broken[ 0 ] ); ++i )
+        {
+            tt_assert( json_decode_datapoint( broken[ i ], &data_point ) == 0 );
+            tt_assert( XI_JSON_DECODE_DATAPOINT_PARSER_ERROR == xi_get_last_error() );
+            xi_set_err( XI_NO_ERR );
+        }
+
+        tt_assert( json_decode_feed( "{\"datastreams\":[{\"id\":\"a\"]}", &feed ) == 0 );
+        tt_assert( XI_JSON_DECODE_FEED_PARSER_ERROR == xi_get_last_error() );
+    }
+
+    { // nesting deeper than the tokenizer can follow
+        char test_data[ 2 * 40 + 1 ];
+        memset( test_data, '[', 40 );
+        memset( test_data + 40, ']', 40 );
+        test_data[ 80 ] = '\0';
+
+        json_tokenizer_t tokenizer;
+        json_token_t token;
+        json_token_type_t type;
+
+        json_tokenizer_init( &tokenizer, test_data, 80 );
+
+        while( ( type = json_next_token( &tokenizer, &token ) ) == XI_JSON_TOKEN_ARRAY_BEGIN ) { ; }
+
+        tt_assert( type == XI_JSON_TOKEN_ERROR );
+        tt_assert( tokenizer.depth == 32 );
+    }
+
+ end:
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+
+void test_cbor_encode( void* data )
+{
+    (void)(data);
+
+    xi_datapoint_t data_point;
+    memset( &data_point, 0, sizeof( xi_datapoint_t ) );
+
+    { // the timestamp takes the same room whatever it is
+        const char expected[] =
+            "\x83" "\xfa\x41\xac\x00\x00" "\x1a\x51\x6b\x0f\x71" "\x1a\x00\x00\x00\x07";
+
+        xi_set_value_f32( &data_point, 21.5f );
+        data_point.timestamp.timestamp  = 1365970801;
+        data_point.timestamp.micro      = 7;
+
+        const char* o = cbor_encode_datapoint( &data_point );
+
+        tt_assert( o != 0 );
+        tt_assert( cbor_get_encoded_size() == sizeof( expected ) - 1 );
+        tt_assert( memcmp( o, expected, sizeof( expected ) - 1 ) == 0 );
+    }
+
+    { // integers in their shortest form
+        char buffer[ 16 ];
+        memset( &data_point, 0, sizeof( xi_datapoint_t ) );
+
+        xi_set_value_i32( &data_point, 23 );
+        tt_assert( cbor_encode_datapoint_in_place( buffer, sizeof( buffer ), &data_point ) == 2 );
+        tt_assert( memcmp( buffer, "\x81\x17", 2 ) == 0 );
+
+        xi_set_value_i32( &data_point, -500 );
+        tt_assert( cbor_encode_datapoint_in_place( buffer, sizeof( buffer ), &data_point ) == 4 );
+        tt_assert( memcmp( buffer, "\x81\x39\x01\xf3", 4 ) == 0 );
+
+        xi_set_value_i32( &data_point, INT32_MIN );
+        tt_assert( cbor_encode_datapoint_in_place( buffer, sizeof( buffer ), &data_point ) == 6 );
+        tt_assert( memcmp( buffer, "\x81\x3a\x7f\xff\xff\xff", 6 ) == 0 );
+
+        tt_assert( cbor_encode_datapoint_in_place( buffer, 5, &data_point ) == -1 );
+        tt_assert( XI_CBOR_ENCODE_DATAPOINT_BUFFER_OVERRUN == xi_get_last_error() );
+        xi_set_err( XI_NO_ERR );
+    }
+
+    { // a datastream is created with a feed of its own
+        xi_set_value_str( &data_point, "on" );
+
+        const char* o = cbor_encode_create_datastream( "led", &data_point );
+
+        tt_assert( o != 0 );
+        tt_assert( cbor_get_encoded_size() == 10 );
+        tt_assert( memcmp( o, "\x81\x82\x63led\x81\x62on", 10 ) == 0 );
+    }
+
+ end:
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+
+static int test_cbor_count_datastream( const char* datastream_id, void* user_data )
+{
+    (void)(datastream_id);
+
+    *( int* ) user_data += 1;
+
+    return 0;
+}
+
+void test_cbor_decode( void* data )
+{
+    (void)(data);
+
+    static xi_feed_t feed;
+    static xi_feed_t decoded;
+    char buffer[ 256 ];
+
+    memset( &feed, 0, sizeof( xi_feed_t ) );
+    memset( &decoded, 0, sizeof( xi_feed_t ) );
+
+    { // whatever is encoded comes back the same
+        feed.datastream_count = 2;
+
+        strcpy( feed.datastreams[ 0 ].datastream_id, "temp" );
+        feed.datastreams[ 0 ].datapoint_count = 3;
+        xi_set_value_f32( &feed.datastreams[ 0 ].datapoints[ 0 ], -0.125f );
+        xi_set_value_i32( &feed.datastreams[ 0 ].datapoints[ 1 ], -2147483647 - 1 );
+        xi_set_value_str( &feed.datastreams[ 0 ].datapoints[ 2 ], "a,b\n" );
+        feed.datastreams[ 0 ].datapoints[ 1 ].timestamp.timestamp   = 4294967296LL;
+        feed.datastreams[ 0 ].datapoints[ 1 ].timestamp.micro       = 999999;
+
+        strcpy( feed.datastreams[ 1 ].datastream_id, "empty" );
+
+        int s = cbor_encode_feed( buffer, sizeof( buffer ), &feed );
+
+        tt_assert( s > 0 );
+        tt_assert( cbor_decode_feed_n( buffer, s, &decoded ) == &decoded );
+        tt_assert( decoded.datastream_count == 2 );
+        tt_assert( decoded.datastreams[ 1 ].datapoint_count == 0 );
+        tt_assert( strcmp( decoded.datastreams[ 1 ].datastream_id, "empty" ) == 0 );
+        tt_assert( memcmp( &decoded.datastreams[ 0 ], &feed.datastreams[ 0 ], sizeof( xi_datastream_t ) ) == 0 );
+
+        tt_assert( cbor_decode_feed( buffer, &decoded ) == &decoded );
+        tt_assert( decoded.datastreams[ 0 ].datapoints[ 2 ].value_type == XI_VALUE_TYPE_STR );
+
+        tt_assert( cbor_encode_feed( buffer, s - 1, &feed ) == -1 );
+        tt_assert( XI_CBOR_ENCODE_FEED_BUFFER_OVERRUN == xi_get_last_error() );
+        xi_set_err( XI_NO_ERR );
+
+        // cut anywhere, the rest isn't read
+        for( int i = 0; i < s; ++i )
+        {
+            tt_assert( cbor_decode_feed_n( buffer, i, &decoded ) == 0 );
+            tt_assert( XI_CBOR_DECODE_FEED_PARSER_ERROR == xi_get_last_error() );
+        }
+
+        xi_set_err( XI_NO_ERR );
+    }
+
+    { // floats of any precision, integer timestamps of any width
+        xi_datapoint_t data_point;
+
+        tt_assert( cbor_decode_datapoint_n( "\x81\xf9\x3e\x00", 4, &data_point ) == &data_point );
+        tt_assert( data_point.value_type == XI_VALUE_TYPE_F32 );
+        tt_assert( data_point.value.f32_value == 1.5f );
+
+        tt_assert( cbor_decode_datapoint_n( "\x83\xfb\x3f\xd0\x00\x00\x00\x00\x00\x00\x18\x64\x01", 13, &data_point ) == &data_point );
+        tt_assert( data_point.value.f32_value == 0.25f );
+        tt_assert( data_point.timestamp.timestamp == 100 );
+        tt_assert( data_point.timestamp.micro == 1 );
+
+        const char* const broken[] = {
+              "\x82\x01\x01"            // neither one nor three items
+            , "\x9f\x01\xff"            // indefinite length
+            , "\x81\xf5"                // true isn't a value
+            , "\x81\x1a\x80\x00\x00\x00"  // doesn't fit in 32 bits
+            , "\x83\x01\x01\x1a\x00\x0f\x42\x40"  // a million microseconds
+        };
+        const size_t sizes[] = { 3, 3, 2, 6, 8 };
+
+        for( size_t i = 0; i < sizeof( sizes ) / sizeof( sizes[ 0 ] ); ++i )
+        {
+            tt_assert( cbor_decode_datapoint_n( broken[ i ], sizes[ i ], &data_point ) == 0 );
+            tt_assert( XI_CBOR_DECODE_DATAPOINT_PARSER_ERROR == xi_get_last_error() );
+        }
+
+        // nothing may follow
+        tt_assert( cbor_decode_datapoint_n( "\x81\x01\x01", 3, &data_point ) == 0 );
+    }
+
+    // the unsized decoders don't read past XI_CBOR_DECODE_MAX_SIZE, whatever the item says
+    {
+        const xi_feed_visitor_t visitor = { test_cbor_count_datastream, 0 };
+        unsigned char forged[ XI_CBOR_DECODE_MAX_SIZE ];
+        xi_datapoint_t data_point;
+        int count = 0;
+
+        // a feed of 2^32 - 1 datastreams named "a" up to the end of the buffer
+        memcpy( forged, "\x9a\xff\xff\xff\xff", 5 );
+
+        for( size_t i = 5; i < sizeof( forged ); ++i )
+        {
+            forged[ i ] = "\x81\x61\x61"[ ( i - 5 ) % 3 ];
+        }
+
+        tt_assert( cbor_visit_feed( ( const char* ) forged, &visitor, &count ) == -1 );
+        tt_assert( XI_CBOR_DECODE_FEED_PARSER_ERROR == xi_get_last_error() );
+        tt_assert( count == ( XI_CBOR_DECODE_MAX_SIZE - 5 ) / 3 );
+
+        // a string longer than the buffer
+        memset( forged, 0, sizeof( forged ) );
+        memcpy( forged, "\x81\x7a\x00\x01\x00\x00", 6 );
+
+        tt_assert( cbor_decode_datapoint( ( const char* ) forged, &data_point ) == 0 );
+        tt_assert( XI_CBOR_DECODE_DATAPOINT_PARSER_ERROR == xi_get_last_error() );
+    }
+
+ end:
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+
+typedef struct
+{
+    int     datastreams;
+    int     datapoints;
+    int     stop_after;
+    float   sum;
+    char    ids[ 64 ];
+} test_visit_t;
+
+static int test_visit_datastream( const char* datastream_id, void* user_data )
+{
+    test_visit_t* v = ( test_visit_t* ) user_data;
+
+    strcat( v->ids, datastream_id );
+    strcat( v->ids, ";" );
+
+    return ++v->datastreams == v->stop_after;
+}
+
+static int test_visit_datapoint( const char* datastream_id, const xi_datapoint_t* dp, void* user_data )
+{
+    test_visit_t* v = ( test_visit_t* ) user_data;
+
+    v->datapoints += 1;
+    v->sum        += dp->value_type == XI_VALUE_TYPE_I32 ? dp->value.i32_value : dp->value.f32_value;
+
+    return strcmp( datastream_id, "stop" ) == 0;
+}
+
+void test_data_layer_visit_feed( void* data )
+{
+    (void)(data);
+
+    const xi_feed_visitor_t visitor = { test_visit_datastream, test_visit_datapoint };
+    test_visit_t v;
+
+    static xi_feed_t feed;
+    char cbor[ 256 ];
+
+    const char csv_feed[] =
+        "a,2013-01-01T18:44:21.000000Z,1\n"
+        "a,2013-01-01T18:44:22.000000Z,2\n"
+        "b,2013-01-01T18:44:21.000000Z,0.5\n"
+        "stop,2013-01-01T18:44:21.000000Z,4\n"
+        "c,2013-01-01T18:44:21.000000Z,8";
+
+    const char json_feed[] =
+        "{\"datastreams\":[{\"id\":\"a\",\"current_value\":\"3\"},{\"current_value\":\"0.5\",\"id\":\"b\"}"
+        ",{\"id\":\"stop\",\"current_value\":\"4\"},{\"id\":\"c\",\"current_value\":\"8\"}]}";
+
+    tt_assert( csv_decode_feed( csv_feed, &feed ) == &feed );
+    int cbor_size = cbor_encode_feed( cbor, sizeof( cbor ), &feed );
+    tt_assert( cbor_size > 0 );
+
+    const struct { const data_layer_t* data_layer; const char* data; } feeds[] = {
+          { get_csv_data_layer(), csv_feed }
+        , { get_json_data_layer(), json_feed }
+        , { get_cbor_data_layer(), cbor }
+    };
+
+    for( size_t i = 0; i < sizeof( feeds ) / sizeof( feeds[ 0 ] ); ++i )
+    {
+        const data_layer_t* data_layer = feeds[ i ].data_layer;
+
+        // a datastream is visited once, its datapoints follow it
+        memset( &v, 0, sizeof( v ) );
+        tt_assert( data_layer->visit_feed( feeds[ i ].data, &visitor, &v ) == 1 );
+        tt_assert( strcmp( v.ids, "a;b;stop;" ) == 0 );
+        tt_assert( v.sum == 7.5f );
+
+        memset( &v, 0, sizeof( v ) );
+        v.stop_after = 2;
+        tt_assert( data_layer->visit_feed( feeds[ i ].data, &visitor, &v ) == 1 );
+        tt_assert( strcmp( v.ids, "a;b;" ) == 0 );
+        tt_assert( v.sum == 3.0f );
+
+        // what decode_feed gives is the same as visiting it all
+        const xi_feed_visitor_t datastreams_only = { test_visit_datastream, 0 };
+
+        memset( &v, 0, sizeof( v ) );
+        tt_assert( data_layer->visit_feed( feeds[ i ].data, &datastreams_only, &v ) == 0 );
+        tt_assert( data_layer->decode_feed( feeds[ i ].data, &feed ) == &feed );
+        tt_assert( feed.datastream_count == 4 );
+        tt_assert( ( int ) feed.datastream_count == v.datastreams );
+        tt_assert( strcmp( feed.datastreams[ 3 ].datastream_id, "c" ) == 0 );
+    }
+
+    tt_assert( get_csv_data_layer()->visit_feed( "a,b", &visitor, &v ) == -1 );
+    tt_assert( XI_CSV_DECODE_FEED_PARSER_ERROR == xi_get_last_error() );
+
+ end:
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+
 void test_helpers_copy_until( void* data )
 {
     (void)(data);
@@ -531,6 +3344,241 @@ void test_helpers_copy_until( void* data )
     ;
 }
 
+void test_helpers_float_to_str( void* data )
+{
+    (void)(data);
+
+    char buffer[ 64 ];
+
+    // the shortest that reads back the same, never in exponent notation
+    static const struct { float value; const char* expected; } cases[] =
+    {
+          { 21.5f,          "21.5" }
+        , { 0.1f,           "0.1" }
+        , { -0.3f,          "-0.3" }
+        , { 1.0f / 3.0f,    "0.33333334" }
+        , { 100.0f,         "100.0" }
+        , { 16777216.0f,    "16777216.0" }
+        , { 3e10f,          "30000000000.0" }
+        , { 1e-10f,         "0.0000000001" }
+        , { 0.0f,           "0.0" }
+        , { -0.0f,          "-0.0" }
+        , { FLT_MAX,        "340282350000000000000000000000000000000.0" }
+        , { FLT_MIN,        "0.000000000000000000000000000000000000011754944" }
+    };
+
+    for( size_t i = 0; i < sizeof( cases ) / sizeof( cases[ 0 ] ); ++i )
+    {
+        int s = xi_float_to_str( buffer, sizeof( buffer ), cases[ i ].value );
+
+        tt_assert( strcmp( buffer, cases[ i ].expected ) == 0 );
+        tt_assert( s == ( int ) strlen( cases[ i ].expected ) );
+        tt_assert( strtof( buffer, 0 ) == cases[ i ].value );
+    }
+
+    xi_float_to_str( buffer, sizeof( buffer ), 1.0f / 0.0f );
+    tt_assert( strcmp( buffer, "inf" ) == 0 );
+
+    xi_float_to_str( buffer, sizeof( buffer ), -1.0f / 0.0f );
+    tt_assert( strcmp( buffer, "-inf" ) == 0 );
+
+    xi_float_to_str( buffer, sizeof( buffer ), 0.0f / 0.0f );
+    tt_assert( strcmp( buffer, "nan" ) == 0 );
+
+    // like snprintf(), the size is what it would take
+    tt_assert( xi_float_to_str( buffer, 4, 123.25f ) == 6 );
+    tt_assert( strcmp( buffer, "123" ) == 0 );
+
+ end:
+    ;
+}
+
+void test_helpers_gmtime_mktime( void* data )
+{
+    (void)(data);
+
+    struct tm expected;
+    struct tm result;
+
+    // the same as the C library on both sides of the epoch, across leap days and centuries
+    for( time_t t = -4102444800; t < 7258118400; t += 86400 * 29 + 3607 )
+    {
+        gmtime_r( &t, &expected );
+
+        tt_assert( xi_gmtime_r( &t, &result ) == &result );
+        tt_assert( result.tm_year == expected.tm_year );
+        tt_assert( result.tm_mon == expected.tm_mon );
+        tt_assert( result.tm_mday == expected.tm_mday );
+        tt_assert( result.tm_hour == expected.tm_hour );
+        tt_assert( result.tm_min == expected.tm_min );
+        tt_assert( result.tm_sec == expected.tm_sec );
+        tt_assert( result.tm_yday == expected.tm_yday );
+        tt_assert( result.tm_wday == expected.tm_wday );
+
+        tt_assert( xi_mktime( &result ) == ( t < 0 ? -1 : t ) );
+    }
+
+    { // fields out of range are carried over: 2013-02-28 23:59:60 is 2013-03-01 00:00:00
+        memset( &result, 0, sizeof( result ) );
+        result.tm_year  = 113;
+        result.tm_mon   = 1;
+        result.tm_mday  = 28;
+        result.tm_hour  = 23;
+        result.tm_min   = 59;
+        result.tm_sec   = 60;
+
+        tt_assert( xi_mktime( &result ) == 1362096000 );
+        tt_assert( result.tm_mon == 2 && result.tm_mday == 1 );
+        tt_assert( result.tm_hour == 0 && result.tm_min == 0 && result.tm_sec == 0 );
+        tt_assert( result.tm_yday == 59 && result.tm_wday == 5 );
+    }
+
+    { // and borrowed from: the 0th of January 2013 at -1 minutes
+        memset( &result, 0, sizeof( result ) );
+        result.tm_year  = 113;
+        result.tm_mday  = 0;
+        result.tm_min   = -1;
+
+        tt_assert( xi_mktime( &result ) == 1356911940 );
+        tt_assert( result.tm_year == 112 && result.tm_mon == 11 && result.tm_mday == 30 );
+        tt_assert( result.tm_hour == 23 && result.tm_min == 59 );
+    }
+
+    // the static one is the same
+    {
+        time_t t = 1365970801;
+        tt_assert( xi_gmtime( &t )->tm_hour == 20 );
+    }
+
+ end:
+    ;
+}
+
+void test_helpers_timestamp_to_str( void* data )
+{
+    (void)(data);
+
+    char buffer[ 64 ];
+
+    // within a minute, across the minute and back, then past the date
+    static const struct { time_t timestamp; time_t micro; const char* expected; } cases[] =
+    {
+          { 1365970801, 0,          "2013-04-14T20:20:01.000000Z" }
+        , { 1365970859, 999999,     "2013-04-14T20:20:59.999999Z" }
+        , { 1365970860, 5,          "2013-04-14T20:21:00.000005Z" }
+        , { 1365970800, 123456,     "2013-04-14T20:20:00.123456Z" }
+        , { 1366070400, 100,        "2013-04-16T00:00:00.000100Z" }
+        , { 951782400, 0,           "2000-02-29T00:00:00.000000Z" }
+        , { 1, 1,                   "1970-01-01T00:00:01.000001Z" }
+    };
+
+    for( size_t i = 0; i < sizeof( cases ) / sizeof( cases[ 0 ] ); ++i )
+    {
+        int s = xi_timestamp_to_str( buffer, sizeof( buffer ), cases[ i ].timestamp, cases[ i ].micro );
+
+        tt_assert( strcmp( buffer, cases[ i ].expected ) == 0 );
+        tt_assert( s == ( int ) strlen( cases[ i ].expected ) );
+    }
+
+    // micro seconds out of range are written as they are
+    xi_timestamp_to_str( buffer, sizeof( buffer ), 1365970801, 1234567 );
+    tt_assert( strcmp( buffer, "2013-04-14T20:20:01.1234567Z" ) == 0 );
+
+    // like snprintf(), the size is what it would take
+    tt_assert( xi_timestamp_to_str( buffer, 11, 1365970801, 0 ) == 27 );
+    tt_assert( strcmp( buffer, "2013-04-14" ) == 0 );
+
+ end:
+    ;
+}
+
+void test_helpers_str_to_timestamp( void* data )
+{
+    (void)(data);
+
+    char buffer[ 64 ];
+    time_t timestamp    = 0;
+    time_t micro        = 0;
+
+    static const struct { const char* str; time_t timestamp; time_t micro; int size; } cases[] =
+    {
+          { "2013-04-14T20:20:01.123456Z",      1365970801, 123456, 27 }
+        , { "2013-04-14T20:20:01.5Z,21",        1365970801, 500000, 22 }
+        , { "2013-04-14T20:20:01Z",             1365970801, 0,      20 }
+        , { "2013-04-14T20:20:01.12345678Z",    1365970801, 123456, 29 }
+        , { "2000-02-29T23:59:60.000000Z",      951868800,  0,      27 }
+        , { "1970-01-01T00:00:00.000000Z",      0,          0,      27 }
+    };
+
+    for( size_t i = 0; i < sizeof( cases ) / sizeof( cases[ 0 ] ); ++i )
+    {
+        tt_assert( xi_str_to_timestamp( cases[ i ].str, &timestamp, &micro ) == cases[ i ].size );
+        tt_assert( timestamp == cases[ i ].timestamp );
+        tt_assert( micro == cases[ i ].micro );
+    }
+
+    static const struct { const char* str; int error; } invalid[] =
+    {
+          { "2013-04-14T20:20:01.123456",   -2 }
+        , { "2013-04-14T20:20:01.",         -2 }
+        , { "2013-04-14T20:20:01",          -2 }
+        , { "2013-04-14 20:20:01Z",         -1 }
+        , { "2013-4-14T20:20:01Z",          -1 }
+        , { "2013-04-14T24:00:00Z",         -1 }
+        , { "2013-13-01T00:00:00Z",         -1 }
+        , { "2013-02-29T00:00:00Z",         -1 }
+        , { "1969-12-31T23:59:59Z",         -1 }
+        , { "2013-04-14T20:2",              -1 }
+        , { "",                             -1 }
+    };
+
+    for( size_t i = 0; i < sizeof( invalid ) / sizeof( invalid[ 0 ] ); ++i )
+    {
+        tt_assert( xi_str_to_timestamp( invalid[ i ].str, &timestamp, &micro ) == invalid[ i ].error );
+    }
+
+    // reads back what the encoders write, a day and a bit apart for about 130 years
+    for( time_t t = 0; t < 4102444800; t += 86400 + 3607 )
+    {
+        xi_timestamp_to_str( buffer, sizeof( buffer ), t, t % 1000000 );
+
+        tt_assert( xi_str_to_timestamp( buffer, &timestamp, &micro ) == 27 );
+        tt_assert( timestamp == t );
+        tt_assert( micro == t % 1000000 );
+    }
+
+ end:
+    ;
+}
+
+void test_helpers_int_to_str( void* data )
+{
+    (void)(data);
+
+    char buffer[ 16 ];
+    char expected[ 16 ];
+
+    static const int32_t cases[] =
+        { 0, 7, -7, 10, 99, 100, -100, 12345, 1000000, 2147483647, -2147483647 - 1 };
+
+    for( size_t i = 0; i < sizeof( cases ) / sizeof( cases[ 0 ] ); ++i )
+    {
+        int s = xi_int_to_str( buffer, sizeof( buffer ), cases[ i ] );
+
+        snprintf( expected, sizeof( expected ), "%d", cases[ i ] );
+
+        tt_assert( strcmp( buffer, expected ) == 0 );
+        tt_assert( s == ( int ) strlen( expected ) );
+    }
+
+    // like snprintf(), the size is what it would take
+    tt_assert( xi_int_to_str( buffer, 4, -12345 ) == 6 );
+    tt_assert( strcmp( buffer, "-12" ) == 0 );
+
+ end:
+    ;
+}
+
 //decl
 
 extern xi_datapoint_t* csv_decode_value(
@@ -572,6 +3620,66 @@ void test_helpers_decode_value( void* data )
     tt_assert( p.value_type         == XI_VALUE_TYPE_F32 );
     tt_assert( p.value.f32_value     == -.123f );
 
+    // the value ends with the line, odd ones are strings
+    csv_decode_value( "42\r\n43", &p );
+    tt_assert( p.value_type         == XI_VALUE_TYPE_I32 );
+    tt_assert( p.value.i32_value     == 42 );
+
+    csv_decode_value( "1.2.3", &p );
+    tt_assert( p.value_type         == XI_VALUE_TYPE_STR );
+
+    csv_decode_value( "--1", &p );
+    tt_assert( p.value_type         == XI_VALUE_TYPE_STR );
+
+    csv_decode_value( "12\xB0", &p );
+    tt_assert( p.value_type         == XI_VALUE_TYPE_STR );
+    tt_assert( strcmp( p.value.str_value, "12\xB0" ) == 0 );
+
+ end:
+    ;
+}
+
+typedef struct
+{
+    uint32_t    key;
+    uint32_t    value;
+    uint32_t    used;
+} test_lru_slot_t;
+
+void test_helpers_lru_slot( void* data )
+{
+    (void)(data);
+
+    test_lru_slot_t slots[ 2 ];
+    int found = 0;
+
+    memset( slots, 0, sizeof( slots ) );
+
+    #define TEST_LRU_SLOT( k, now ) ( ( test_lru_slot_t* ) xi_lru_slot( slots, 2, sizeof( test_lru_slot_t ) \
+        , offsetof( test_lru_slot_t, key ), offsetof( test_lru_slot_t, used ), ( k ), ( now ), &found ) )
+
+    // free slots go first
+    test_lru_slot_t* a = TEST_LRU_SLOT( 10, 0xFFFFFFF0 );
+    tt_assert( a == &slots[ 0 ] && !found );
+    a->value = 1;
+
+    test_lru_slot_t* b = TEST_LRU_SLOT( 20, 0xFFFFFFF8 );
+    tt_assert( b == &slots[ 1 ] && !found );
+
+    // lookups keep the slot and its contents
+    tt_assert( TEST_LRU_SLOT( 10, 0xFFFFFFFF ) == a && found );
+    tt_assert( a->value == 1 );
+
+    // the one unused for longest is taken over, the clock wrapped around in between
+    tt_assert( TEST_LRU_SLOT( 30, 4 ) == b && !found );
+    tt_assert( b->key == 30 && b->used == 4 );
+
+    #undef TEST_LRU_SLOT
+
+    tt_assert( xi_time_after( 4, 0xFFFFFFFF ) );
+    tt_assert( !xi_time_after( 0xFFFFFFFF, 4 ) );
+    tt_assert( xi_hash_key( xi_hash( XI_HASH_SEED, "a", 1 ) ) != xi_hash_key( xi_hash( XI_HASH_SEED, "b", 1 ) ) );
+
  end:
     ;
 }
@@ -606,18 +3714,73 @@ struct testcase_t demo_tests[] = {
     { "test_parse_http_status", test_parse_http_status, TT_ENABLED_, 0, 0 },
     { "test_parse_http_header", test_parse_http_header, TT_ENABLED_, 0, 0 },
     { "test_parse_http", test_parse_http, TT_ENABLED_, 0, 0 },
+    { "test_parse_http_header_types", test_parse_http_header_types, TT_ENABLED_, 0, 0 },
+    { "test_parse_http_lazy", test_parse_http_lazy, TT_ENABLED_, 0, 0 },
+    { "test_parse_http_reply_size", test_parse_http_reply_size, TT_ENABLED_, 0, 0 },
+#ifdef XI_ZLIB
+    { "test_parse_http_gzip", test_parse_http_gzip, TT_ENABLED_, 0, 0 },
+#endif
 
     { "test_http_construct_request", test_http_construct_request, TT_ENABLED_, 0, 0 },
+    { "test_http_construct_request_conditional", test_http_construct_request_conditional, TT_ENABLED_, 0, 0 },
+#ifdef XI_ZLIB
+    { "test_http_construct_request_accept_encoding", test_http_construct_request_accept_encoding, TT_ENABLED_, 0, 0 },
+#endif
     { "test_http_construct_content", test_http_construct_content, TT_ENABLED_, 0, 0 },
+    { "test_http_encode_update_datastream_static", test_http_encode_update_datastream_static, TT_ENABLED_, 0, 0 },
+    { "test_encode_get_datastream_history", test_encode_get_datastream_history, TT_ENABLED_, 0, 0 },
+#ifdef XI_ZLIB
+    { "test_http_encode_update_feed_gzip", test_http_encode_update_feed_gzip, TT_ENABLED_, 0, 0 },
+#endif
+    { "test_http_encode_update_feed_streamed", test_http_encode_update_feed_streamed, TT_ENABLED_, 0, 0 },
+    { "test_http_feed_get_poll_cached", test_http_feed_get_poll_cached, TT_ENABLED_, 0, 0 },
+#ifdef XI_ZLIB
+    { "test_http_feed_get_gzip", test_http_feed_get_gzip, TT_ENABLED_, 0, 0 },
+#endif
+
+#ifdef XI_TRANSPORT_WS
+    { "test_ws_compute_accept", test_ws_compute_accept, TT_ENABLED_, 0, 0 },
+    { "test_ws_check_handshake", test_ws_check_handshake, TT_ENABLED_, 0, 0 },
+    { "test_ws_transport_session", test_ws_transport_session, TT_ENABLED_, 0, 0 },
+#endif
+
+#ifdef XI_TRANSPORT_TCP
+    { "test_socket_api_encode_escaped", test_socket_api_encode_escaped, TT_ENABLED_, 0, 0 },
+    { "test_tcp_transport_out_of_order", test_tcp_transport_out_of_order, TT_ENABLED_, 0, 0 },
+    { "test_tcp_feeds_update_unrelated_reply", test_tcp_feeds_update_unrelated_reply, TT_ENABLED_, 0, 0 },
+    { "test_tcp_history_stop_prefetched", test_tcp_history_stop_prefetched, TT_ENABLED_, 0, 0 },
+    { "test_tcp_session_left_with_unread_data", test_tcp_session_left_with_unread_data, TT_ENABLED_, 0, 0 },
+#endif
+
+#ifdef XI_TRANSPORT_MQTT
+    { "test_mqtt_transport_publish", test_mqtt_transport_publish, TT_ENABLED_, 0, 0 },
+    { "test_mqtt_immediate_reply_closes_circuit", test_mqtt_immediate_reply_closes_circuit, TT_ENABLED_, 0, 0 },
+#endif
+
+    { "test_rate_limiter", test_rate_limiter, TT_ENABLED_, 0, 0 },
+    { "test_retry_policy", test_retry_policy, TT_ENABLED_, 0, 0 },
+    { "test_circuit_breaker", test_circuit_breaker, TT_ENABLED_, 0, 0 },
 
     { "test_csv_decode_datapoint", test_csv_decode_datapoint, TT_ENABLED_, 0, 0 },
     { "test_csv_decode_datapoint_error", test_csv_decode_datapoint_error, TT_ENABLED_, 0, 0 },
+    { "test_csv_decode_feed", test_csv_decode_feed, TT_ENABLED_, 0, 0 },
     { "test_csv_encode_create_datastream", test_csv_encode_create_datastream, TT_ENABLED_, 0, 0 },
     { "test_csv_encode_create_datastream_error", test_csv_encode_create_datastream_error, TT_ENABLED_, 0, 0 },
     { "test_csv_encode_datapoint", test_csv_encode_datapoint, TT_ENABLED_, 0, 0 },
+    { "test_json_encode", test_json_encode, TT_ENABLED_, 0, 0 },
+    { "test_json_decode", test_json_decode, TT_ENABLED_, 0, 0 },
+    { "test_cbor_encode", test_cbor_encode, TT_ENABLED_, 0, 0 },
+    { "test_cbor_decode", test_cbor_decode, TT_ENABLED_, 0, 0 },
+    { "test_data_layer_visit_feed", test_data_layer_visit_feed, TT_ENABLED_, 0, 0 },
 
     { "test_helpers_copy_until", test_helpers_copy_until, TT_ENABLED_, 0, 0 },
     { "test_helpers_decode_value", test_helpers_decode_value, TT_ENABLED_, 0, 0 },
+    { "test_helpers_float_to_str", test_helpers_float_to_str, TT_ENABLED_, 0, 0 },
+    { "test_helpers_int_to_str", test_helpers_int_to_str, TT_ENABLED_, 0, 0 },
+    { "test_helpers_gmtime_mktime", test_helpers_gmtime_mktime, TT_ENABLED_, 0, 0 },
+    { "test_helpers_timestamp_to_str", test_helpers_timestamp_to_str, TT_ENABLED_, 0, 0 },
+    { "test_helpers_str_to_timestamp", test_helpers_str_to_timestamp, TT_ENABLED_, 0, 0 },
+    { "test_helpers_lru_slot", test_helpers_lru_slot, TT_ENABLED_, 0, 0 },
 
     { "test_create_and_delete_context", test_create_and_delete_context, TT_ENABLED_, 0, 0 },
     /* The array has to end with END_OF_TESTCASES. */
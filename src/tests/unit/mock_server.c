@@ -0,0 +1,118 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    mock_server.c
+ * \brief   Local single-connection server for tests [see mock_server.h]
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "mock_server.h"
+
+int mock_server_start( mock_server_handler_t handler, void* arg, pid_t* pid )
+{
+    return mock_server_start_many( handler, arg, 1, pid );
+}
+
+int mock_server_start_many( mock_server_handler_t handler, void* arg
+    , size_t connections, pid_t* pid )
+{
+    struct sockaddr_in name;
+    socklen_t name_size = sizeof( name );
+
+    int fd = socket( AF_INET, SOCK_STREAM, 0 );
+    if( fd == -1 ) { return -1; }
+
+    memset( &name, 0, sizeof( name ) );
+    name.sin_family         = AF_INET;
+    name.sin_addr.s_addr    = inet_addr( MOCK_SERVER_ADDRESS );
+    name.sin_port           = 0;
+
+    // the port is known before the fork, so the client can connect straight away
+    if( bind( fd, ( struct sockaddr* ) &name, sizeof( name ) ) == -1
+     || listen( fd, 16 ) == -1
+     || getsockname( fd, ( struct sockaddr* ) &name, &name_size ) == -1 )
+    {
+        close( fd );
+        return -1;
+    }
+
+    *pid = fork();
+
+    if( *pid == 0 )
+    {
+        int ret = 0;
+
+        for( size_t i = 0; i < connections && ret == 0; ++i )
+        {
+            int client = accept( fd, 0, 0 );
+            ret = client == -1 ? -1 : handler( client, arg );
+
+            if( client != -1 )
+            {
+                shutdown( client, SHUT_RDWR );
+                close( client );
+            }
+        }
+
+        close( fd );
+        _exit( ret );
+    }
+
+    close( fd );
+
+    return *pid == -1 ? -1 : ntohs( name.sin_port );
+}
+
+int mock_server_wait( pid_t pid )
+{
+    int status = 0;
+
+    if( waitpid( pid, &status, 0 ) == -1 || !WIFEXITED( status ) )
+    {
+        return -1;
+    }
+
+    return WEXITSTATUS( status );
+}
+
+int mock_server_read_http( int fd, char* buffer, size_t buffer_size, const char** body )
+{
+    size_t size = 0;
+    const char* headers_end = 0;
+
+    memset( buffer, 0, buffer_size );
+
+    for( ;; )
+    {
+        if( headers_end )
+        {
+            const char* length = strcasestr( buffer, "Content-Length:" );
+            size_t body_size = length && length < headers_end ? atoi( length + 15 ) : 0;
+
+            if( size >= ( size_t ) ( headers_end + 4 - buffer ) + body_size )
+            {
+                *body = headers_end + 4;
+                return ( int ) size;
+            }
+        }
+
+        if( size + 1 >= buffer_size ) { return -1; }
+
+        int r = read( fd, buffer + size, buffer_size - size - 1 );
+        if( r <= 0 ) { return -1; }
+        size += r;
+
+        headers_end = strstr( buffer, "\r\n\r\n" );
+    }
+}
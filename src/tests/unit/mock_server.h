@@ -0,0 +1,54 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    mock_server.h
+ * \brief   Local single-connection server for tests that need a remote endpoint
+ *
+ *    The server listens on an ephemeral port of the loopback interface and runs
+ *    in a forked process, it accepts one connection and passes it to the handler.
+ *    Exit status of the process is the value returned by the handler, so the test
+ *    can assert on what the server has seen.
+ */
+
+#ifndef __MOCK_SERVER_H__
+#define __MOCK_SERVER_H__
+
+#include <stdlib.h>
+#include <sys/types.h>
+
+#define MOCK_SERVER_ADDRESS "127.0.0.1"
+
+/**
+ * \brief   Handler of the accepted connection
+ * \return  0 on success, any other value is a failure
+ */
+typedef int ( *mock_server_handler_t )( int fd, void* arg );
+
+/**
+ * \brief   Forks the server process
+ * \return  Port number or -1 if an error occurred
+ */
+int mock_server_start( mock_server_handler_t handler, void* arg, pid_t* pid );
+
+/**
+ * \brief   Same as `mock_server_start()`, but accepts the given number of connections
+ *          one after another, the server stops at the first handler that fails
+ * \return  Port number or -1 if an error occurred
+ */
+int mock_server_start_many( mock_server_handler_t handler, void* arg
+    , size_t connections, pid_t* pid );
+
+/**
+ * \brief   Waits for the server process to finish
+ * \return  Value returned by the handler or -1 if the server crashed
+ */
+int mock_server_wait( pid_t pid );
+
+/**
+ * \brief   Reads an HTTP request or response along with its body (using `Content-Length`)
+ * \return  Size of the message, the body starts at `*body` or -1 if an error occurred
+ */
+int mock_server_read_http( int fd, char* buffer, size_t buffer_size, const char** body );
+
+#endif // __MOCK_SERVER_H__